@@ -7,6 +7,7 @@
 #include "libCacheSim/cache.h"
 #include "libCacheSim/plugin.h"
 #include "libCacheSim/reader.h"
+#include "libCacheSim/requestSink.h"
 #include "libCacheSim/simulator.h"
 
 using namespace std;
@@ -14,7 +15,8 @@ using namespace std;
 double Simulator::gen_miss_trace(string algo, uint64_t cache_size,
                                  string trace_path, string miss_output_path) {
   uint64_t n_req = 0, n_hit = 0;
-  std::ofstream miss_ofs(miss_output_path);
+  request_sink_t *miss_sink =
+      open_request_sink(miss_output_path.c_str(), CSV_TRACE);
 
   reader_init_param_t reader_init_params = {
       .time_field = 1, .obj_id_field = 2, .obj_size_field = 3};
@@ -33,14 +35,13 @@ double Simulator::gen_miss_trace(string algo, uint64_t cache_size,
     n_req += 1;
     hit = cache->get(cache, req);
     if (!hit)
-      miss_ofs << req->clock_time << "," << (uint64_t)req->obj_id << ","
-               << req->obj_size << std::endl;
+      request_sink_write(miss_sink, req);
     else
       n_hit += 1;
     read_one_req(reader, req);
   }
 
-  miss_ofs.close();
+  close_request_sink(miss_sink);
   std::cout << trace_path << ", object miss ratio "
             << 1.0 - (double)n_hit / n_req << std::endl;
 
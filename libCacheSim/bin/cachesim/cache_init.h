@@ -52,7 +52,6 @@ static inline cache_t *create_cache(const char *trace_path, const char *eviction
   } else if (strcasecmp(eviction_algo, "slruv0") == 0) {
     cache = SLRUv0_init(cc_params, eviction_params);
   } else if (strcasecmp(eviction_algo, "hyperbolic") == 0) {
-    cc_params.hashpower = MAX(cc_params.hashpower - 8, 16);
     cache = Hyperbolic_init(cc_params, eviction_params);
   } else if (strcasecmp(eviction_algo, "lecar") == 0) {
     cache = LeCaR_init(cc_params, eviction_params);
@@ -81,30 +80,19 @@ static inline cache_t *create_cache(const char *trace_path, const char *eviction
     }
   } else if (strcasecmp(eviction_algo, "wtinyLFU") == 0) {
     cache = WTinyLFU_init(cc_params, eviction_params);
-  } else if (strcasecmp(eviction_algo, "belady") == 0 && strcasestr(trace_path, "lcs") == NULL) {
-    if (strcasestr(trace_path, "oracleGeneral") == NULL) {
-      WARN("belady is only supported for oracleGeneral and lcs trace\n");
-      WARN("to convert a trace to lcs format\n");
-      WARN("./bin/traceConv input_trace trace_format output_trace\n");
-      WARN("./bin/traceConv ../data/cloudPhysicsIO.txt txt\n");
-      exit(1);
-    }
+  } else if (strcasecmp(eviction_algo, "belady") == 0) {
+    /* the simulator computes the next access time if the trace does not have it */
     cache = Belady_init(cc_params, eviction_params);
   } else if (strcasecmp(eviction_algo, "nop") == 0) {
     cache = nop_init(cc_params, eviction_params);
   } else if (strcasecmp(eviction_algo, "beladySize") == 0) {
-    if (strcasestr(trace_path, "oracleGeneral") == NULL && strcasestr(trace_path, "lcs") == NULL) {
-      WARN("beladySize is only supported for oracleGeneral and lcs trace\n");
-      WARN("to convert a trace to lcs format\n");
-      WARN("./bin/traceConv input_trace trace_format output_trace\n");
-      WARN("./bin/traceConv ../data/cloudPhysicsIO.txt txt\n");
-      exit(1);
-    }
     cc_params.hashpower = MAX(cc_params.hashpower - 8, 16);
     cache = BeladySize_init(cc_params, eviction_params);
   } else if (strcasecmp(eviction_algo, "fifo-reinsertion") == 0 || strcasecmp(eviction_algo, "clock") == 0 ||
              strcasecmp(eviction_algo, "second-chance") == 0) {
     cache = Clock_init(cc_params, eviction_params);
+  } else if (strcasecmp(eviction_algo, "clockArray") == 0) {
+    cache = ClockArray_init(cc_params, eviction_params);
   } else if (strcasecmp(eviction_algo, "lirs") == 0) {
     cache = LIRS_init(cc_params, eviction_params);
   } else if (strcasecmp(eviction_algo, "fifomerge") == 0 || strcasecmp(eviction_algo, "fifo-merge") == 0) {
@@ -114,6 +102,11 @@ static inline cache_t *create_cache(const char *trace_path, const char *eviction
   } else if (strcasecmp(eviction_algo, "flashProb") == 0) {
     // used to measure application level write amp
     cache = flashProb_init(cc_params, eviction_params);
+  } else if (strcasecmp(eviction_algo, "flashRegion") == 0) {
+    // region-based flash cache, used to measure device level write amp
+    cache = flashRegion_init(cc_params, eviction_params);
+  } else if (strcasecmp(eviction_algo, "tiered") == 0) {
+    cache = tiered_init(cc_params, eviction_params);
   } else if (strcasecmp(eviction_algo, "sfifo") == 0) {
     cache = SFIFO_init(cc_params, eviction_params);
   } else if (strcasecmp(eviction_algo, "sfifov0") == 0) {
@@ -138,6 +131,8 @@ static inline cache_t *create_cache(const char *trace_path, const char *eviction
     cache = QDLP_init(cc_params, eviction_params);
   } else if (strcasecmp(eviction_algo, "sieve") == 0) {
     cache = Sieve_init(cc_params, eviction_params);
+  } else if (strcasecmp(eviction_algo, "sieveArray") == 0) {
+    cache = SieveArray_init(cc_params, eviction_params);
 #ifdef ENABLE_3L_CACHE
   } else if (strcasecmp(eviction_algo, "3LCache") == 0) {
     cache = ThreeLCache_init(cc_params, eviction_params);
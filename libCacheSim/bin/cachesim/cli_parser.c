@@ -48,6 +48,9 @@ enum argp_option_short {
   OPTION_PREFETCH_ALGO = 'p',
   OPTION_PREFETCH_PARAMS = 0x109,
   OPTION_PRINT_HEAD_REQ = 0x10a,
+  OPTION_CONCURRENT_CLIENT = 0x10b,
+  OPTION_TIMING_PARAMS = 0x10c,
+  OPTION_DIST_CACHE_DIR = 0x10d,
 };
 
 /*
@@ -84,6 +87,17 @@ static struct argp_option options[] = {
     {"output", OPTION_OUTPUT_PATH, "output", 0, "Output path", 6},
     {"num-thread", OPTION_NUM_THREAD, "16", 0,
      "Number of threads if running when using default cache sizes", 6},
+    {"concurrent-client", OPTION_CONCURRENT_CLIENT, "16", 0,
+     "Replay with 1, 2, 4 ... up to this many client threads sharing one "
+     "thread-safe cache and report the throughput, supports "
+     "FIFO/LRU/Clock/Sieve/S3FIFO",
+     6},
+    {"timing", OPTION_TIMING_PARAMS,
+     "\"tier-latency=1,backend-latency=1000,backend-channel=16\"", 0,
+     "Time each request with a queueing model of the cache tiers and the "
+     "backend, report the latency percentiles and the backend bandwidth, "
+     "use \"\" for the default model",
+     6},
 
     {0, 0, 0, 0, "Other less common options:"},
     {"report-interval", OPTION_REPORT_INTERVAL, "3600", 0,
@@ -96,6 +110,10 @@ static struct argp_option options[] = {
     {"verbose", OPTION_VERBOSE, "1", 0, "Produce verbose output", 10},
     {"print-head-req", OPTION_PRINT_HEAD_REQ, "false", 0,
      "Print the first few requests", 10},
+    {"dist-cache-dir", OPTION_DIST_CACHE_DIR, "dir", 0,
+     "Cache the next access distances used by the Belady algorithms in this "
+     "directory, so later runs on the same trace do not recompute them",
+     10},
 
     {0}};
 
@@ -170,6 +188,17 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state) {
     case OPTION_PRINT_HEAD_REQ:
       arguments->print_head_req = is_true(arg) ? true : false;
       break;
+    case OPTION_CONCURRENT_CLIENT:
+      arguments->n_concurrent_client = atoi(arg);
+      break;
+    case OPTION_TIMING_PARAMS:
+      arguments->timing_params = strdup(arg);
+      replace_char(arguments->timing_params, ';', ',');
+      replace_char(arguments->timing_params, '_', '-');
+      break;
+    case OPTION_DIST_CACHE_DIR:
+      set_dist_cache_dir(arg);
+      break;
     case ARGP_KEY_ARG:
       if (state->arg_num >= N_ARGS) {
         printf("found too many arguments, current %s\n", arg);
@@ -221,6 +250,7 @@ static void init_arg(struct arguments *args) {
   args->prefetch_algo = NULL;
   args->admission_params = NULL;
   args->prefetch_params = NULL;
+  args->timing_params = NULL;
   args->trace_type_str = NULL;
   args->trace_type_params = NULL;
   args->verbose = true;
@@ -253,6 +283,9 @@ void free_arg(struct arguments *args) {
   if (args->admission_params) {
     free(args->admission_params);
   }
+  if (args->timing_params) {
+    free(args->timing_params);
+  }
 
   for (int i = 0; i < args->n_eviction_algo; i++) {
     free(args->eviction_algo[i]);
@@ -548,6 +581,10 @@ void print_parsed_args(struct arguments *args) {
     n += snprintf(output_str + n, OUTPUT_STR_LEN - n - 1,
                   ", consider object metadata");
 
+  if (args->timing_params != NULL)
+    n += snprintf(output_str + n, OUTPUT_STR_LEN - n - 1, ", timing: %s",
+                  args->timing_params);
+
   snprintf(output_str + n, OUTPUT_STR_LEN - n - 1, "\n");
 
   INFO("%s", output_str);
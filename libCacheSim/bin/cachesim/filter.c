@@ -4,6 +4,7 @@
 
 #include "../../include/libCacheSim/cache.h"
 #include "../../include/libCacheSim/reader.h"
+#include "../../include/libCacheSim/requestSink.h"
 #include "../../utils/include/mymath.h"
 #include "../../utils/include/mystr.h"
 #include "../../utils/include/mysys.h"
@@ -15,13 +16,6 @@ extern "C" {
 
 #define REPORT_INTERVAL (24 * 3600)
 
-struct output_format {
-  uint32_t clock_time;
-  uint64_t obj_id;
-  uint32_t obj_size;
-  int64_t next_access_vtime;
-} __attribute__((packed));
-
 void filter(reader_t *reader, cache_t *cache) {
   /* random seed */
   srand(time(NULL));
@@ -32,9 +26,7 @@ void filter(reader_t *reader, cache_t *cache) {
           cache->cache_name);
   request_t *req = new_request();
 
-  FILE *output_file = fopen(ofilepath, "wb");
-  struct output_format output_req;
-  output_req.next_access_vtime = -2;
+  request_sink_t *sink = open_request_sink(ofilepath, ORACLE_GENERAL_TRACE);
 
   read_one_req(reader, req);
   uint64_t start_ts = (uint64_t)req->clock_time;
@@ -44,10 +36,7 @@ void filter(reader_t *reader, cache_t *cache) {
     n_req++;
     req->clock_time -= start_ts;
     if (cache->get(cache, req) == false) {
-      output_req.clock_time = req->clock_time;
-      output_req.obj_id = req->obj_id;
-      output_req.obj_size = req->obj_size;
-      fwrite(&output_req, sizeof(struct output_format), 1, output_file);
+      request_sink_write(sink, req);
       n_written_req++;
     }
 
@@ -56,7 +45,8 @@ void filter(reader_t *reader, cache_t *cache) {
 
   INFO("write %ld/%ld %.4lf requests to %s file\n", n_written_req, n_req,
        (double)n_written_req / n_req, ofilepath);
-  fclose(output_file);
+  close_request_sink(sink);
+  free_request(req);
 }
 
 int main(int argc, char *argv[]) {
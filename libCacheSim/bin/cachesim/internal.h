@@ -39,6 +39,8 @@ struct arguments {
   char *prefetch_params;
   double sample_ratio;
   int n_thread;
+  int n_concurrent_client; /* 0 means not replaying with concurrent clients */
+  char *timing_params;     /* NULL means not timing the requests */
   int64_t n_req; /* number of requests to process */
 
   bool verbose;
@@ -61,6 +63,12 @@ void simulate(reader_t *reader, cache_t *cache, int report_interval,
               int warmup_sec, char *ofilepath, bool ignore_obj_size,
               bool print_head_req);
 
+void simulate_concurrent_clients(reader_t *reader, cache_t *cache,
+                                 int max_n_client, char *ofilepath);
+
+void simulate_timing(reader_t *reader, cache_t *cache,
+                     const char *timing_params, char *ofilepath);
+
 void print_parsed_args(struct arguments *args);
 
 #ifdef __cplusplus
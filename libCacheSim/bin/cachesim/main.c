@@ -19,6 +19,28 @@ int main(int argc, char **argv) {
   if (args.n_cache_size == 0) {
     ERROR("no cache size found\n");
   }
+  if (args.n_concurrent_client > 0) {
+    for (int i = 0; i < args.n_cache_size * args.n_eviction_algo; i++) {
+      simulate_concurrent_clients(args.reader, args.caches[i],
+                                  args.n_concurrent_client, args.ofilepath);
+      args.caches[i]->cache_free(args.caches[i]);
+    }
+
+    free_arg(&args);
+    return 0;
+  }
+
+  if (args.timing_params != NULL) {
+    for (int i = 0; i < args.n_cache_size * args.n_eviction_algo; i++) {
+      simulate_timing(args.reader, args.caches[i], args.timing_params,
+                      args.ofilepath);
+      args.caches[i]->cache_free(args.caches[i]);
+    }
+
+    free_arg(&args);
+    return 0;
+  }
+
   if (args.n_cache_size * args.n_eviction_algo == 1) {
     simulate(args.reader, args.caches[0], args.report_interval, args.warmup_sec, args.ofilepath, args.ignore_obj_size,
              args.print_head_req);
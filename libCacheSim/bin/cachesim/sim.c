@@ -1,5 +1,9 @@
 #include "../../include/libCacheSim/cache.h"
+#include "../../include/libCacheSim/dist.h"
+#include "../../include/libCacheSim/evictionAlgo.h"
 #include "../../include/libCacheSim/reader.h"
+#include "../../include/libCacheSim/simulator.h"
+#include "../../include/libCacheSim/timingModel.h"
 #include "../../utils/include/mymath.h"
 #include "../../utils/include/mystr.h"
 #include "../../utils/include/mysys.h"
@@ -21,11 +25,16 @@ void simulate(reader_t *reader, cache_t *cache, int report_interval, int warmup_
   set_rand_seed(rand());
 
   request_t *req = new_request();
+  cache_get_func_ptr get = cache_get_func(cache);
   uint64_t req_cnt = 0, miss_cnt = 0;
   uint64_t last_req_cnt = 0, last_miss_cnt = 0;
   uint64_t req_byte = 0, miss_byte = 0;
 
+  int64_t n_next_access_dist = 0, req_idx = 0;
+  int32_t *next_access_dist = load_next_access_dist(reader, &cache, 1, &n_next_access_dist);
+
   read_one_req(reader, req);
+  cache_set_next_access_vtime(cache, req, req_idx++);
   uint64_t start_ts = (uint64_t)req->clock_time;
   uint64_t last_report_ts = warmup_sec;
 
@@ -37,8 +46,9 @@ void simulate(reader_t *reader, cache_t *cache, int report_interval, int warmup_
 
     req->clock_time -= start_ts;
     if (req->clock_time <= warmup_sec) {
-      cache->get(cache, req);
+      get(cache, req);
       read_one_req(reader, req);
+      cache_set_next_access_vtime(cache, req, req_idx++);
       continue;
     } else {
       if (start_time < 0) {
@@ -48,7 +58,7 @@ void simulate(reader_t *reader, cache_t *cache, int report_interval, int warmup_
 
     req_cnt++;
     req_byte += req->obj_size;
-    if (cache->get(cache, req) == false) {
+    if (get(cache, req) == false) {
       miss_cnt++;
       miss_byte += req->obj_size;
     }
@@ -68,6 +78,7 @@ void simulate(reader_t *reader, cache_t *cache, int report_interval, int warmup_
     }
 
     read_one_req(reader, req);
+    cache_set_next_access_vtime(cache, req, req_idx++);
   }
 
   double runtime = gettime() - start_time;
@@ -119,6 +130,133 @@ void simulate(reader_t *reader, cache_t *cache, int report_interval, int warmup_
 #endif
   free_request(req);
   cache->cache_free(cache);
+  if (next_access_dist != NULL) release_dist_cached(next_access_dist, n_next_access_dist);
+}
+
+/**
+ * @brief replay the trace with 1, 2, 4 ... max_n_client clients sharing one
+ * thread-safe copy of the cache and report the throughput
+ */
+void simulate_concurrent_clients(reader_t *reader, cache_t *cache,
+                                 int max_n_client, char *ofilepath) {
+  /* more stripes than clients so that few requests wait for a lock,
+   * the same number for all runs so the miss ratio is comparable */
+  int n_stripe = (int)next_power_of_2(max_n_client) * 16;
+
+  char *output_dir = rindex(ofilepath, '/');
+  if (output_dir != NULL) {
+    size_t dir_length = output_dir - ofilepath;
+    char dir_path[1024];
+    snprintf(dir_path, dir_length + 1, "%s", ofilepath);
+    create_dir(dir_path);
+  }
+  FILE *output_file = fopen(ofilepath, "a");
+  if (output_file == NULL) {
+    ERROR("cannot open file %s %s\n", ofilepath, strerror(errno));
+    exit(1);
+  }
+
+  char output_str[1024];
+  for (int n_client = 1; n_client <= max_n_client; n_client *= 2) {
+    if (n_client * 2 > max_n_client) n_client = max_n_client;
+    double start_time = gettime();
+    cache_stat_t *stat =
+        simulate_with_concurrent_clients(reader, cache, n_stripe, n_client);
+    double runtime = gettime() - start_time;
+
+    snprintf(output_str, 1024,
+             "%s %s cache size %8ld, %3d clients, %16lu req, miss ratio "
+             "%.4lf, throughput %.2lf MQPS\n",
+             reader->trace_path, stat->cache_name, (long)stat->cache_size,
+             n_client, (unsigned long)stat->n_req,
+             (double)stat->n_miss / (double)stat->n_req,
+             (double)stat->n_req / 1000000.0 / runtime);
+    printf("%s", output_str);
+    fprintf(output_file, "%s", output_str);
+    my_free(sizeof(cache_stat_t), stat);
+  }
+  fclose(output_file);
+}
+
+/**
+ * @brief replay the trace with a timing model (see timingModel.h) and report
+ * the latency percentiles, the backend bandwidth of each window is written
+ * to ofilepath.backendBW
+ */
+void simulate_timing(reader_t *reader, cache_t *cache,
+                     const char *timing_params, char *ofilepath) {
+  timing_model_t model = default_timing_model();
+  parse_timing_model_params(&model, timing_params);
+  if (strncmp(cache->cache_name, "tiered", 6) == 0) {
+    int n_tier = ((tiered_params_t *)cache->eviction_params)->n_tier;
+    if (model.n_tier != n_tier) {
+      ERROR("%s has %d tiers, the timing model has %d, e.g., use --timing "
+            "tier-latency=1:100\n",
+            cache->cache_name, n_tier, model.n_tier);
+    }
+    model.served_tier = tiered_served_tier;
+  }
+
+  double start_time = gettime();
+  timing_stat_t *stat = simulate_with_timing(reader, cache, &model);
+  double runtime = gettime() - start_time;
+
+  int64_t peak_byte = 0;
+  for (int64_t i = 0; i < stat->n_bw_window; i++) {
+    peak_byte = MAX(peak_byte, stat->backend_byte[i]);
+  }
+  double window_sec = (double)stat->bw_window_us / 1000000.0;
+
+  char output_str[1024];
+  snprintf(output_str, 1024,
+           "%s %s cache size %8ld, %16lu req, miss ratio %.4lf, latency (us) "
+           "mean %.2lf p50 %.2lf p99 %.2lf p999 %.2lf, backend MiB/s mean "
+           "%.2lf peak %.2lf, throughput %.2lf MQPS\n",
+           reader->trace_path, stat->cache_name, (long)stat->cache_size,
+           (unsigned long)stat->n_req,
+           (double)stat->n_miss / (double)stat->n_req,
+           stat->latency.sum_ns / 1000.0 / (double)stat->n_req,
+           latency_hist_percentile(&stat->latency, 50),
+           latency_hist_percentile(&stat->latency, 99),
+           latency_hist_percentile(&stat->latency, 99.9),
+           (double)stat->n_miss_byte / MiB /
+               MAX(stat->end_us / 1000000.0, window_sec),
+           (double)peak_byte / MiB / window_sec,
+           (double)stat->n_req / 1000000.0 / runtime);
+  printf("%s", output_str);
+
+  char *output_dir = rindex(ofilepath, '/');
+  if (output_dir != NULL) {
+    size_t dir_length = output_dir - ofilepath;
+    char dir_path[1024];
+    snprintf(dir_path, dir_length + 1, "%s", ofilepath);
+    create_dir(dir_path);
+  }
+  FILE *output_file = fopen(ofilepath, "a");
+  if (output_file == NULL) {
+    ERROR("cannot open file %s %s\n", ofilepath, strerror(errno));
+    exit(1);
+  }
+  fprintf(output_file, "%s", output_str);
+  fclose(output_file);
+
+  /* one line per cache: the name, the window and the bytes of each window */
+  char bw_path[1024];
+  snprintf(bw_path, 1024, "%s.backendBW", ofilepath);
+  FILE *bw_file = fopen(bw_path, "a");
+  if (bw_file == NULL) {
+    ERROR("cannot open file %s %s\n", bw_path, strerror(errno));
+    exit(1);
+  }
+  fprintf(bw_file, "%s %ld %ld", stat->cache_name, (long)stat->cache_size,
+          (long)stat->bw_window_us);
+  for (int64_t i = 0; i < stat->n_bw_window; i++) {
+    fprintf(bw_file, " %ld", (long)stat->backend_byte[i]);
+  }
+  fprintf(bw_file, "\n");
+  fclose(bw_file);
+
+  free_timing_stat(stat);
 }
 
 #ifdef __cplusplus
@@ -25,6 +25,7 @@ enum argp_option_short {
   // OPTION_OUTPUT_PATH = 'o',
   OPTION_NUM_REQ = 'n',
   OPTION_VERBOSE = 'v',
+  OPTION_DIST_CACHE_DIR = 0x100,
 };
 
 /*
@@ -40,6 +41,9 @@ static struct argp_option options[] = {
 
     // {"output", OPTION_OUTPUT_PATH, "output", 0, "Output path", 5},
     {"verbose", OPTION_VERBOSE, "1", 0, "Produce verbose output"},
+    {"dist-cache-dir", OPTION_DIST_CACHE_DIR, "dir", 0,
+     "Cache the computed distances in this directory, so later runs on the "
+     "same trace map the cached array"},
 
     {0}};
 
@@ -63,6 +67,9 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state) {
     case OPTION_VERBOSE:
       arguments->verbose = is_true(arg) ? true : false;
       break;
+    case OPTION_DIST_CACHE_DIR:
+      set_dist_cache_dir(arg);
+      break;
     case ARGP_KEY_ARG:
       if (state->arg_num >= N_ARGS) {
         printf("found too many arguments, current %s\n", arg);
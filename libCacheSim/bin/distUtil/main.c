@@ -17,11 +17,13 @@ int main(int argc, char **argv) {
 
   int32_t *dist_array = NULL;
   int64_t array_size = 0;
-  if (args.dist_type == STACK_DIST || args.dist_type == FUTURE_STACK_DIST) {
-    dist_array = get_stack_dist(args.reader, args.dist_type, &array_size);
-  } else if (args.dist_type == DIST_SINCE_LAST_ACCESS ||
-             args.dist_type == DIST_SINCE_FIRST_ACCESS) {
-    dist_array = get_access_dist(args.reader, args.dist_type, &array_size);
+  if (args.dist_type == STACK_DIST || args.dist_type == FUTURE_STACK_DIST ||
+      args.dist_type == DIST_SINCE_LAST_ACCESS ||
+      args.dist_type == DIST_SINCE_FIRST_ACCESS) {
+    /* repeated runs on the same trace map the cached array if
+     * --dist-cache-dir is given */
+    dist_array =
+        get_dist_cached(args.reader, args.dist_type, &array_size, NULL);
   } else {
     ERROR("Unknown distance type %d\n", args.dist_type);
   }
@@ -38,5 +40,6 @@ int main(int argc, char **argv) {
                          args.dist_type);
   }
 
+  release_dist_cached(dist_array, array_size);
   return 0;
 }
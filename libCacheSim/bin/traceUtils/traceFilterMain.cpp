@@ -1,19 +1,19 @@
 /**
  * Filter the trace to generate a second-layer cache trace.
  * only support single algorithm (without params), e.g., FIFO and LRU, at this
- * moment. The output format is lcs format (oracleGeneral).
+ * moment. The output format is lcs format (oracleGeneral), it is compressed
+ * with zstd if the output path ends with .zst
  *
  */
 
 #include <libgen.h>
 
-#include <fstream>
-#include <iostream>
 #include <string>
 
 #include "../../include/libCacheSim/cache.h"
 #include "../../include/libCacheSim/evictionAlgo.h"
 #include "../../include/libCacheSim/reader.h"
+#include "../../include/libCacheSim/requestSink.h"
 #include "../../utils/include/mymath.h"
 #include "../../utils/include/mystr.h"
 #include "../../utils/include/mysys.h"
@@ -21,19 +21,10 @@
 #include "internal.hpp"
 
 namespace TraceFilter {
-struct output_format {
-  uint32_t clock_time;
-  uint64_t obj_id;
-  uint32_t obj_size;
-  int64_t next_access_vtime;
-} __attribute__((packed));
-
 void filter(reader_t *reader, cache_t *cache, std::string ofilepath) {
   request_t *req = new_request();
 
-  std::ofstream output_file(ofilepath, std::ios::binary);
-  struct output_format output_req;
-  output_req.next_access_vtime = -2;
+  request_sink_t *sink = open_request_sink(ofilepath.c_str(), ORACLE_GENERAL_TRACE);
 
   read_one_req(reader, req);
   uint64_t start_ts = (uint64_t)req->clock_time;
@@ -43,10 +34,7 @@ void filter(reader_t *reader, cache_t *cache, std::string ofilepath) {
     n_req++;
     req->clock_time -= start_ts;
     if (cache->get(cache, req) == false) {
-      output_req.clock_time = req->clock_time;
-      output_req.obj_id = req->obj_id;
-      output_req.obj_size = req->obj_size;
-      output_file.write((char *)&output_req, sizeof(struct output_format));
+      request_sink_write(sink, req);
       n_written_req++;
     }
 
@@ -56,7 +44,7 @@ void filter(reader_t *reader, cache_t *cache, std::string ofilepath) {
   INFO("write %ld/%ld %.4lf requests to file %s\n", (long) n_written_req, (long) n_req,
        (double)n_written_req / n_req, ofilepath.c_str());
   free_request(req);
-  output_file.close();
+  close_request_sink(sink);
 }
 }  // namespace TraceFilter
 
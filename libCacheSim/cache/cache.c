@@ -34,8 +34,8 @@ cache_t *cache_struct_init(const char *const cache_name,
   cache->eviction_params = NULL;
   cache->admissioner = NULL;
   cache->prefetcher = NULL;
-  cache->future_stack_dist = NULL;
-  cache->future_stack_dist_array_size = 0;
+  cache->next_access_dist = NULL;
+  cache->next_access_dist_array_size = 0;
   cache->default_ttl = params.default_ttl;
   cache->n_req = 0;
   cache->to_evict_candidate = NULL;
@@ -95,11 +95,75 @@ cache_t *clone_cache(const cache_t *old_cache) {
   if (old_cache->admissioner != NULL) {
     cache->admissioner = old_cache->admissioner->clone(old_cache->admissioner);
   }
-  cache->future_stack_dist = old_cache->future_stack_dist;
-  cache->future_stack_dist_array_size = old_cache->future_stack_dist_array_size;
+  cache->next_access_dist = old_cache->next_access_dist;
+  cache->next_access_dist_array_size = old_cache->next_access_dist_array_size;
 
   return cache;
 }
+/**
+ * @brief fork a warm cache, the new cache has the same objects and eviction
+ * state as the old cache
+ *
+ * @param old_cache
+ * @param cache_specific_params NULL means the same parameters
+ * @return cache_t* or NULL if the algorithm does not support fork
+ */
+cache_t *fork_cache(const cache_t *old_cache,
+                    const char *cache_specific_params) {
+  if (old_cache->copy_state == NULL) {
+    WARN("%s does not support fork\n", old_cache->cache_name);
+    return NULL;
+  }
+
+  common_cache_params_t cc_params = {
+      .cache_size = old_cache->cache_size,
+      .hashpower = old_cache->hashtable->hashpower,
+      .default_ttl = old_cache->default_ttl,
+      .consider_obj_metadata = old_cache->obj_md_size == 0 ? false : true,
+  };
+  if (cache_specific_params == NULL) {
+    cache_specific_params = old_cache->init_params;
+  }
+  cache_t *cache = old_cache->cache_init(cc_params, cache_specific_params);
+  if (old_cache->admissioner != NULL) {
+    cache->admissioner = old_cache->admissioner->clone(old_cache->admissioner);
+  }
+  cache->next_access_dist = old_cache->next_access_dist;
+  cache->next_access_dist_array_size = old_cache->next_access_dist_array_size;
+
+  cache->n_req = old_cache->n_req;
+  cache->copy_state(cache, old_cache);
+
+  return cache;
+}
+
+/**
+ * @brief copy a queue of objects to an empty cache
+ *
+ * @param cache the new cache
+ * @param src_q_tail the tail of the queue in the old cache
+ * @param q_head the head of the queue in the new cache
+ * @param q_tail the tail of the queue in the new cache
+ */
+void cache_copy_queue_base(cache_t *cache, const cache_obj_t *src_q_tail,
+                           cache_obj_t **q_head, cache_obj_t **q_tail) {
+  request_t *req = new_request();
+  /* walk from the tail and prepend, so the new queue has the same order */
+  for (const cache_obj_t *obj = src_q_tail; obj != NULL;
+       obj = obj->queue.prev) {
+    copy_cache_obj_to_request(req, obj);
+    cache_obj_t *new_obj = cache_insert_base(cache, req);
+    cache_obj_t *hash_next = new_obj->hash_next;
+    /* copy the per-object metadata, e.g., frequency and expiration time */
+    memcpy(new_obj, obj, sizeof(cache_obj_t));
+    new_obj->hash_next = hash_next;
+    new_obj->queue.prev = NULL;
+    new_obj->queue.next = NULL;
+    prepend_obj_to_head(q_head, q_tail, new_obj);
+  }
+  free_request(req);
+}
+
 /**
  * @brief this function is called by all eviction algorithms to clone old cache
  * with new size
@@ -125,8 +189,8 @@ cache_t *create_cache_with_new_size(const cache_t *old_cache,
     cache->prefetcher =
         old_cache->prefetcher->clone(old_cache->prefetcher, new_size);
   }
-  cache->future_stack_dist = old_cache->future_stack_dist;
-  cache->future_stack_dist_array_size = old_cache->future_stack_dist_array_size;
+  cache->next_access_dist = old_cache->next_access_dist;
+  cache->next_access_dist_array_size = old_cache->next_access_dist_array_size;
   return cache;
 }
 
@@ -175,7 +239,22 @@ bool cache_can_insert_default(cache_t *cache, const request_t *req) {
 cache_obj_t *cache_find_base(cache_t *cache, const request_t *req,
                              const bool update_cache) {
   cache_obj_t *cache_obj = hashtable_find(cache->hashtable, req);
+  return cache_find_obj_base(cache, req, cache_obj, update_cache);
+}
 
+/**
+ * @brief update the prefetcher and the object found in the hashtable,
+ * see cache_find_base
+ *
+ * @param cache
+ * @param req
+ * @param cache_obj the object found in the hashtable or NULL
+ * @param update_cache
+ * @return cache_obj or NULL if it is NULL or expired
+ */
+cache_obj_t *cache_find_obj_base(cache_t *cache, const request_t *req,
+                                 cache_obj_t *cache_obj,
+                                 const bool update_cache) {
   // "update_cache = true" means that it is a real user request, use handle_find
   // to update prefetcher's state
   if (cache->prefetcher && cache->prefetcher->handle_find && update_cache) {
@@ -190,7 +269,7 @@ cache_obj_t *cache_find_base(cache_t *cache, const request_t *req,
         cache->remove(cache, cache_obj->obj_id);
       }
 
-      cache_obj = NULL;
+      return NULL;
     }
 #endif
 
@@ -301,6 +380,9 @@ void cache_evict_base(cache_t *cache, cache_obj_t *obj,
     record_eviction_age(cache, obj, CURR_TIME(cache, req) - obj->create_time);
   }
 #endif
+  if (cache->evict_hook != NULL) {
+    cache->evict_hook(cache, obj, cache->evict_hook_data);
+  }
   if (cache->prefetcher && cache->prefetcher->handle_evict) {
     request_t *check_req = new_request();
     check_req->obj_id = obj->obj_id;
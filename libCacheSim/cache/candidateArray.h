@@ -0,0 +1,125 @@
+//
+//  candidateArray.h
+//  a dense array of the cached objects used by sampling based eviction
+//  algorithms, e.g., Random and Hyperbolic
+//
+//  sampling from the hashtable picks a random bucket, retries when the bucket
+//  is empty and walks the chain, and the sampled objects are not uniform,
+//  sampling from the candidate array is one random read per object,
+//  each object stores its index in the array (at idx_offset) so that
+//  removing an object is a swap with the last object
+//
+//  libCacheSim
+//
+
+#ifndef libCacheSim_CANDIDATEARRAY_H
+#define libCacheSim_CANDIDATEARRAY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <string.h>
+
+#include "../include/libCacheSim/cacheObj.h"
+#include "../include/libCacheSim/logging.h"
+#include "../include/libCacheSim/macro.h"
+#include "../utils/include/mymath.h"
+
+typedef struct {
+  cache_obj_t **objs;
+  int64_t n_obj;
+  int64_t capacity;
+  /* the byte offset of the int64_t index field in cache_obj_t */
+  size_t idx_offset;
+} candidate_array_t;
+
+static inline void candidate_array_init(candidate_array_t *arr,
+                                        const size_t idx_offset) {
+  arr->capacity = 1024;
+  arr->n_obj = 0;
+  arr->objs = (cache_obj_t **)malloc(sizeof(cache_obj_t *) * arr->capacity);
+  arr->idx_offset = idx_offset;
+}
+
+static inline void candidate_array_free(candidate_array_t *arr) {
+  free(arr->objs);
+  arr->objs = NULL;
+  arr->n_obj = 0;
+  arr->capacity = 0;
+}
+
+/* cache_obj_t is packed, so the index is accessed with memcpy */
+static inline void _candidate_array_set_idx(const candidate_array_t *arr,
+                                            cache_obj_t *obj, int64_t idx) {
+  memcpy((char *)obj + arr->idx_offset, &idx, sizeof(int64_t));
+}
+
+static inline int64_t _candidate_array_get_idx(const candidate_array_t *arr,
+                                               const cache_obj_t *obj) {
+  int64_t idx;
+  memcpy(&idx, (const char *)obj + arr->idx_offset, sizeof(int64_t));
+  return idx;
+}
+
+static inline void candidate_array_add(candidate_array_t *arr,
+                                       cache_obj_t *obj) {
+  if (arr->n_obj == arr->capacity) {
+    arr->capacity *= 2;
+    arr->objs = (cache_obj_t **)realloc(arr->objs,
+                                        sizeof(cache_obj_t *) * arr->capacity);
+    if (arr->objs == NULL) {
+      ERROR("fail to grow candidate array to %ld objects\n",
+            (long)arr->capacity);
+    }
+  }
+  arr->objs[arr->n_obj] = obj;
+  _candidate_array_set_idx(arr, obj, arr->n_obj);
+  arr->n_obj += 1;
+}
+
+/**
+ * @brief remove the object by moving the last object to its slot
+ */
+static inline void candidate_array_remove(candidate_array_t *arr,
+                                          cache_obj_t *obj) {
+  int64_t idx = _candidate_array_get_idx(arr, obj);
+  DEBUG_ASSERT(idx >= 0 && idx < arr->n_obj && arr->objs[idx] == obj);
+
+  arr->n_obj -= 1;
+  cache_obj_t *last_obj = arr->objs[arr->n_obj];
+  arr->objs[idx] = last_obj;
+  _candidate_array_set_idx(arr, last_obj, idx);
+}
+
+static inline cache_obj_t *candidate_array_rand_obj(
+    const candidate_array_t *arr) {
+  DEBUG_ASSERT(arr->n_obj > 0);
+  return arr->objs[next_rand() % (uint64_t)arr->n_obj];
+}
+
+/**
+ * @brief sample n_sample objects (with replacement), the objects are
+ * prefetched so that the caller can compute the scores without stalling
+ * on each object
+ *
+ * @param arr
+ * @param n_sample
+ * @param sampled_objs the output array with n_sample elements
+ */
+static inline void candidate_array_sample(const candidate_array_t *arr,
+                                          const int n_sample,
+                                          cache_obj_t **sampled_objs) {
+  DEBUG_ASSERT(arr->n_obj > 0);
+  for (int i = 0; i < n_sample; i++) {
+    sampled_objs[i] = arr->objs[next_rand() % (uint64_t)arr->n_obj];
+    __builtin_prefetch(sampled_objs[i], 0, 1);
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // libCacheSim_CANDIDATEARRAY_H
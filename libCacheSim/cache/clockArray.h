@@ -0,0 +1,400 @@
+//
+//  clockArray.h
+//  an array of slots in the order a circular hand visits them, used by the
+//  array-backed Clock and Sieve (ClockArray.c and SieveArray.c),
+//  Sieve appends new objects after the newest slot and Clock inserts them
+//  right behind the hand
+//
+//  the linked-list Clock and Sieve read the counter of each scanned object
+//  and follow queue.prev, which is a cache miss per object,
+//  the array keeps the objects in slots, a bitmap of the occupied slots,
+//  and the counters out of the objects: 1-bit counters are a visited bitmap
+//  so a hand can skip 64 visited (or empty) slots per word,
+//  n-bit counters (n <= 4) are packed nibbles
+//
+//  removing an object leaves an empty slot, the array is compacted when it
+//  is full and less than half of the slots are occupied (or when there is no
+//  empty slot behind the hand for Clock),
+//  each object stores its slot index (at idx_offset)
+//
+//  libCacheSim
+//
+
+#ifndef libCacheSim_CLOCKARRAY_H
+#define libCacheSim_CLOCKARRAY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <string.h>
+
+#include "../include/libCacheSim/cache.h"
+#include "../include/libCacheSim/cacheObj.h"
+#include "../include/libCacheSim/logging.h"
+#include "../include/libCacheSim/macro.h"
+
+#define CLOCK_ARRAY_INVALID_IDX (-1)
+
+typedef struct {
+  cache_obj_t **slots;
+  /* one bit per slot, set if the slot holds an object */
+  uint64_t *occupied;
+  /* one bit per slot if n_bit_counter is 1 */
+  uint64_t *visited;
+  /* one nibble per slot if n_bit_counter is larger than 1 */
+  uint8_t *counters;
+  int n_bit_counter;
+
+  /* slots before head and from tail are empty */
+  int64_t head;
+  int64_t tail;
+  int64_t capacity;
+  int64_t n_obj;
+
+  /* the occupied slot the hand points to, CLOCK_ARRAY_INVALID_IDX means the
+   * hand starts from head, it is updated on compaction and removal */
+  int64_t hand;
+  /* the empty slot behind the hand for the next object inserted by
+   * clock_array_insert_behind_hand, CLOCK_ARRAY_INVALID_IDX if it needs to be
+   * found, it is reset when the hand moves or the array is compacted */
+  int64_t insert_idx;
+
+  /* the byte offset of the int64_t slot index field in cache_obj_t */
+  size_t idx_offset;
+} clock_array_t;
+
+static inline int64_t _clock_array_n_word(int64_t capacity) {
+  return (capacity + 63) / 64;
+}
+
+static inline void _clock_array_alloc(clock_array_t *arr, int64_t capacity) {
+  int64_t n_word = _clock_array_n_word(capacity);
+  arr->slots = (cache_obj_t **)realloc(arr->slots,
+                                       sizeof(cache_obj_t *) * capacity);
+  arr->occupied =
+      (uint64_t *)realloc(arr->occupied, sizeof(uint64_t) * n_word);
+  if (arr->n_bit_counter == 1) {
+    arr->visited = (uint64_t *)realloc(arr->visited, sizeof(uint64_t) * n_word);
+  } else {
+    arr->counters = (uint8_t *)realloc(arr->counters, (capacity + 1) / 2);
+  }
+  if (arr->slots == NULL || arr->occupied == NULL ||
+      (arr->visited == NULL && arr->counters == NULL)) {
+    ERROR("fail to allocate clock array of %ld slots\n", (long)capacity);
+  }
+
+  /* clear the new part */
+  int64_t old_n_word = _clock_array_n_word(arr->capacity);
+  memset(arr->occupied + old_n_word, 0,
+         sizeof(uint64_t) * (n_word - old_n_word));
+  if (arr->n_bit_counter == 1) {
+    memset(arr->visited + old_n_word, 0,
+           sizeof(uint64_t) * (n_word - old_n_word));
+  } else {
+    int64_t old_n_byte = (arr->capacity + 1) / 2;
+    memset(arr->counters + old_n_byte, 0, (capacity + 1) / 2 - old_n_byte);
+  }
+  arr->capacity = capacity;
+}
+
+static inline void clock_array_init(clock_array_t *arr, int n_bit_counter,
+                                    size_t idx_offset) {
+  if (n_bit_counter < 1 || n_bit_counter > 4) {
+    ERROR("clock array supports 1 to 4-bit counters, %d is given\n",
+          n_bit_counter);
+  }
+  memset(arr, 0, sizeof(clock_array_t));
+  arr->n_bit_counter = n_bit_counter;
+  arr->idx_offset = idx_offset;
+  arr->hand = CLOCK_ARRAY_INVALID_IDX;
+  arr->insert_idx = CLOCK_ARRAY_INVALID_IDX;
+  _clock_array_alloc(arr, 1024);
+}
+
+static inline void clock_array_free(clock_array_t *arr) {
+  free(arr->slots);
+  free(arr->occupied);
+  free(arr->visited);
+  free(arr->counters);
+  memset(arr, 0, sizeof(clock_array_t));
+}
+
+/* cache_obj_t is packed, so the index is accessed with memcpy */
+static inline void _clock_array_set_idx(const clock_array_t *arr,
+                                        cache_obj_t *obj, int64_t idx) {
+  memcpy((char *)obj + arr->idx_offset, &idx, sizeof(int64_t));
+}
+
+static inline int64_t clock_array_get_idx(const clock_array_t *arr,
+                                          const cache_obj_t *obj) {
+  int64_t idx;
+  memcpy(&idx, (const char *)obj + arr->idx_offset, sizeof(int64_t));
+  return idx;
+}
+
+static inline bool _clock_array_is_occupied(const clock_array_t *arr,
+                                            int64_t idx) {
+  return (arr->occupied[idx >> 6] >> (idx & 63)) & 1;
+}
+
+static inline int clock_array_get_counter(const clock_array_t *arr,
+                                          int64_t idx) {
+  if (arr->n_bit_counter == 1) {
+    return (int)((arr->visited[idx >> 6] >> (idx & 63)) & 1);
+  }
+  return (arr->counters[idx >> 1] >> ((idx & 1) * 4)) & 0xf;
+}
+
+static inline void clock_array_set_counter(clock_array_t *arr, int64_t idx,
+                                           int counter) {
+  DEBUG_ASSERT(counter >= 0 && counter < (1 << arr->n_bit_counter));
+  if (arr->n_bit_counter == 1) {
+    uint64_t bit = 1ULL << (idx & 63);
+    arr->visited[idx >> 6] =
+        counter ? arr->visited[idx >> 6] | bit : arr->visited[idx >> 6] & ~bit;
+  } else {
+    int shift = (int)(idx & 1) * 4;
+    arr->counters[idx >> 1] = (uint8_t)((arr->counters[idx >> 1] &
+                                         ~(0xf << shift)) |
+                                        (counter << shift));
+  }
+}
+
+/**
+ * @brief the first occupied slot at or after idx, tail if there is none
+ */
+static inline int64_t clock_array_next_occupied(const clock_array_t *arr,
+                                                int64_t idx) {
+  while (idx < arr->tail) {
+    uint64_t word = arr->occupied[idx >> 6] >> (idx & 63);
+    if (word != 0) return idx + __builtin_ctzll(word);
+    idx = (idx | 63) + 1;
+  }
+  return arr->tail;
+}
+
+/**
+ * @brief the first occupied and not visited slot at or after idx, tail if
+ * there is none, only for 1-bit counters
+ *
+ * @param clear_visited whether to clear the visited bits of the skipped slots
+ */
+static inline int64_t clock_array_next_unvisited(clock_array_t *arr,
+                                                 int64_t idx,
+                                                 bool clear_visited) {
+  DEBUG_ASSERT(arr->n_bit_counter == 1);
+  while (idx < arr->tail) {
+    int64_t w = idx >> 6;
+    uint64_t mask = ~0ULL << (idx & 63);
+    uint64_t candidates = arr->occupied[w] & ~arr->visited[w] & mask;
+    if (candidates != 0) {
+      int bit = __builtin_ctzll(candidates);
+      if (clear_visited) {
+        arr->visited[w] &= ~(mask & ((1ULL << bit) - 1));
+      }
+      return (w << 6) + bit;
+    }
+    if (clear_visited) arr->visited[w] &= ~mask;
+    idx = (w + 1) << 6;
+  }
+  return arr->tail;
+}
+
+static inline cache_obj_t *clock_array_get(const clock_array_t *arr,
+                                           int64_t idx) {
+  DEBUG_ASSERT(idx >= arr->head && idx < arr->tail);
+  return arr->slots[idx];
+}
+
+/* move the object and its counter from slot from to the empty slot to */
+static inline void _clock_array_move(clock_array_t *arr, int64_t from,
+                                     int64_t to) {
+  cache_obj_t *obj = arr->slots[from];
+  int counter = clock_array_get_counter(arr, from);
+  clock_array_set_counter(arr, from, 0);
+  arr->occupied[from >> 6] &= ~(1ULL << (from & 63));
+
+  arr->slots[to] = obj;
+  clock_array_set_counter(arr, to, counter);
+  arr->occupied[to >> 6] |= 1ULL << (to & 63);
+  _clock_array_set_idx(arr, obj, to);
+}
+
+/* move the objects to the front of the array, keep their order */
+static inline void _clock_array_compact(clock_array_t *arr) {
+  int64_t new_hand = CLOCK_ARRAY_INVALID_IDX;
+  int64_t n = 0;
+  for (int64_t idx = clock_array_next_occupied(arr, arr->head);
+       idx < arr->tail; idx = clock_array_next_occupied(arr, idx + 1)) {
+    if (idx == arr->hand) new_hand = n;
+    /* n <= idx and the slots before idx have been moved */
+    _clock_array_move(arr, idx, n);
+    n += 1;
+  }
+  DEBUG_ASSERT(n == arr->n_obj);
+  arr->head = 0;
+  arr->tail = n;
+  arr->hand = new_hand;
+  arr->insert_idx = CLOCK_ARRAY_INVALID_IDX;
+}
+
+/* move the objects before the hand to the front and the objects from the
+ * hand to the end of the array, keep their order, so all empty slots are
+ * right behind the hand */
+static inline void _clock_array_compact_around_hand(clock_array_t *arr) {
+  DEBUG_ASSERT(arr->hand != CLOCK_ARRAY_INVALID_IDX);
+  int64_t n_front = 0;
+  for (int64_t idx = clock_array_next_occupied(arr, arr->head);
+       idx < arr->hand; idx = clock_array_next_occupied(arr, idx + 1)) {
+    _clock_array_move(arr, idx, n_front);
+    n_front += 1;
+  }
+  /* from the end so that an object is not moved to an occupied slot */
+  int64_t n = arr->capacity;
+  for (int64_t idx = arr->tail - 1; idx >= arr->hand; idx--) {
+    if (_clock_array_is_occupied(arr, idx)) {
+      n -= 1;
+      _clock_array_move(arr, idx, n);
+    }
+  }
+  arr->hand = n;
+  arr->head = n_front > 0 ? 0 : n;
+  arr->tail = arr->capacity;
+  arr->insert_idx = n_front;
+}
+
+/**
+ * @brief the last occupied slot before idx, -1 if there is none
+ */
+static inline int64_t _clock_array_prev_occupied(const clock_array_t *arr,
+                                                 int64_t idx) {
+  while (idx > arr->head) {
+    int64_t w = (idx - 1) >> 6;
+    /* the bits of the slots from w * 64 to idx - 1 */
+    uint64_t word = arr->occupied[w] & (~0ULL >> (63 - ((idx - 1) & 63)));
+    if (word != 0) return (w << 6) + 63 - __builtin_clzll(word);
+    idx = w << 6;
+  }
+  return -1;
+}
+
+/**
+ * @brief append an object after the newest object
+ */
+static inline void clock_array_append(clock_array_t *arr, cache_obj_t *obj,
+                                      int counter) {
+  if (arr->tail == arr->capacity) {
+    if (arr->n_obj <= arr->capacity / 2) {
+      _clock_array_compact(arr);
+    } else {
+      _clock_array_alloc(arr, arr->capacity * 2);
+    }
+  }
+
+  int64_t idx = arr->tail++;
+  arr->slots[idx] = obj;
+  arr->occupied[idx >> 6] |= 1ULL << (idx & 63);
+  clock_array_set_counter(arr, idx, counter);
+  _clock_array_set_idx(arr, obj, idx);
+  arr->n_obj += 1;
+}
+
+/**
+ * @brief insert an object behind the hand, the hand reaches it after all
+ * other objects, as a new object at the head of the linked-list Clock,
+ * it is appended if the hand starts from head
+ */
+static inline void clock_array_insert_behind_hand(clock_array_t *arr,
+                                                  cache_obj_t *obj,
+                                                  int counter) {
+  if (arr->hand == CLOCK_ARRAY_INVALID_IDX) {
+    clock_array_append(arr, obj, counter);
+    return;
+  }
+
+  /* after the objects the hand has passed, an eviction usually leaves the
+   * slot empty, later objects go to the next slots until the hand moves */
+  if (arr->insert_idx == CLOCK_ARRAY_INVALID_IDX) {
+    arr->insert_idx = _clock_array_prev_occupied(arr, arr->hand) + 1;
+  }
+  if (arr->insert_idx == arr->hand) {
+    if (arr->n_obj > arr->capacity / 2) {
+      _clock_array_alloc(arr, arr->capacity * 2);
+    }
+    _clock_array_compact_around_hand(arr);
+  }
+  int64_t idx = arr->insert_idx++;
+
+  arr->slots[idx] = obj;
+  arr->occupied[idx >> 6] |= 1ULL << (idx & 63);
+  clock_array_set_counter(arr, idx, counter);
+  _clock_array_set_idx(arr, obj, idx);
+  arr->n_obj += 1;
+  if (idx < arr->head) arr->head = idx;
+}
+
+/**
+ * @brief remove an object, the slot becomes empty, if the hand points to the
+ * object, it moves to the next object (or head if there is none)
+ */
+static inline void clock_array_remove(clock_array_t *arr, cache_obj_t *obj) {
+  int64_t idx = clock_array_get_idx(arr, obj);
+  DEBUG_ASSERT(idx >= arr->head && idx < arr->tail && arr->slots[idx] == obj);
+
+  clock_array_set_counter(arr, idx, 0);
+  arr->occupied[idx >> 6] &= ~(1ULL << (idx & 63));
+  arr->slots[idx] = NULL;
+  _clock_array_set_idx(arr, obj, CLOCK_ARRAY_INVALID_IDX);
+  arr->n_obj -= 1;
+
+  /* shrink the occupied range */
+  if (idx == arr->head) {
+    arr->head = clock_array_next_occupied(arr, idx + 1);
+  }
+  if (idx == arr->tail - 1) {
+    while (arr->tail > arr->head &&
+           !_clock_array_is_occupied(arr, arr->tail - 1)) {
+      arr->tail -= 1;
+    }
+  }
+  if (arr->n_obj == 0) {
+    arr->head = arr->tail = 0;
+  }
+
+  if (arr->hand == idx) {
+    int64_t next = clock_array_next_occupied(arr, idx + 1);
+    arr->hand = next < arr->tail ? next : CLOCK_ARRAY_INVALID_IDX;
+    arr->insert_idx = CLOCK_ARRAY_INVALID_IDX;
+  }
+}
+
+/**
+ * @brief copy the objects (with their counters) in src_arr to an empty cache
+ * and its empty array, used by copy_state
+ */
+static inline void clock_array_copy(cache_t *cache, clock_array_t *arr,
+                                    const clock_array_t *src_arr) {
+  DEBUG_ASSERT(arr->n_obj == 0);
+  request_t *req = new_request();
+  for (int64_t idx = clock_array_next_occupied(src_arr, src_arr->head);
+       idx < src_arr->tail;
+       idx = clock_array_next_occupied(src_arr, idx + 1)) {
+    const cache_obj_t *obj = src_arr->slots[idx];
+    copy_cache_obj_to_request(req, obj);
+    cache_obj_t *new_obj = cache_insert_base(cache, req);
+    cache_obj_t *hash_next = new_obj->hash_next;
+    memcpy(new_obj, obj, sizeof(cache_obj_t));
+    new_obj->hash_next = hash_next;
+    if (idx == src_arr->hand) arr->hand = arr->tail;
+    clock_array_append(arr, new_obj, clock_array_get_counter(src_arr, idx));
+  }
+  free_request(req);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // libCacheSim_CLOCKARRAY_H
@@ -0,0 +1,89 @@
+//
+//  compositeQueue.h
+//  queues of a composite cache, e.g., the small, main and ghost FIFO in
+//  S3FIFO, all queues share the hashtable of the composite cache, so a
+//  request probes one hashtable, and moving an object between queues only
+//  relinks the object, it does not free and allocate the object
+//
+//  the composite cache records the queue of each object in its own
+//  per-object metadata (e.g., S3FIFO.queue_id)
+//
+//  libCacheSim
+//
+
+#ifndef libCacheSim_COMPOSITEQUEUE_H
+#define libCacheSim_COMPOSITEQUEUE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../include/libCacheSim/cacheObj.h"
+#include "../include/libCacheSim/macro.h"
+
+typedef struct {
+  cache_obj_t *q_head;
+  cache_obj_t *q_tail;
+  int64_t n_obj;
+  int64_t occupied_byte;
+  int64_t cache_size;
+} sub_queue_t;
+
+static inline void sub_queue_init(sub_queue_t *q, const int64_t cache_size) {
+  q->q_head = NULL;
+  q->q_tail = NULL;
+  q->n_obj = 0;
+  q->occupied_byte = 0;
+  q->cache_size = cache_size;
+}
+
+/**
+ * @brief add the object to the head of the queue
+ *
+ * @param q
+ * @param obj an object that is not in any queue
+ * @param obj_md_size the metadata size of the composite cache
+ */
+static inline void sub_queue_prepend(sub_queue_t *q, cache_obj_t *obj,
+                                     const int32_t obj_md_size) {
+  prepend_obj_to_head(&q->q_head, &q->q_tail, obj);
+  q->n_obj += 1;
+  q->occupied_byte += (int64_t)obj->obj_size + obj_md_size;
+}
+
+/**
+ * @brief unlink the object from the queue, the object is not freed
+ *
+ * @param q
+ * @param obj
+ * @param obj_md_size the metadata size of the composite cache
+ */
+static inline void sub_queue_unlink(sub_queue_t *q, cache_obj_t *obj,
+                                    const int32_t obj_md_size) {
+  DEBUG_ASSERT(q->n_obj > 0);
+  remove_obj_from_list(&q->q_head, &q->q_tail, obj);
+  q->n_obj -= 1;
+  q->occupied_byte -= (int64_t)obj->obj_size + obj_md_size;
+}
+
+/**
+ * @brief move the object from the src queue to the head of the dst queue,
+ * src and dst can be the same queue
+ *
+ * @param src
+ * @param dst
+ * @param obj
+ * @param obj_md_size the metadata size of the composite cache
+ */
+static inline void sub_queue_move_to_head(sub_queue_t *src, sub_queue_t *dst,
+                                          cache_obj_t *obj,
+                                          const int32_t obj_md_size) {
+  sub_queue_unlink(src, obj, obj_md_size);
+  sub_queue_prepend(dst, obj, obj_md_size);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // libCacheSim_COMPOSITEQUEUE_H
@@ -0,0 +1,271 @@
+//
+//  a thread-safe cache built from the single-threaded eviction algorithms,
+//  the key space is split into stripes by the hash of the object id,
+//  each stripe is an independent cache of the same algorithm with
+//  1/n_stripe of the cache size, its own hashtable and its own lock,
+//  so requests to different stripes do not contend
+//
+//  because each stripe evicts independently, the result is close to but not
+//  the same as one cache of the full size, with one stripe it is the same
+//
+//  concurrentCache.c
+//  libCacheSim
+//
+
+#include <pthread.h>
+
+#include "../dataStructure/hashtable/hashtable.h"
+#include "../include/libCacheSim/cache.h"
+#include "../utils/include/mymath.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* a stripe takes a cache line so that the locks do not share cache lines */
+typedef struct {
+  pthread_mutex_t lock;
+  cache_t *cache;
+  cache_get_func_ptr get;
+} __attribute__((aligned(64))) cache_stripe_t;
+
+typedef struct {
+  cache_stripe_t *stripes;
+  int n_stripe;
+  int stripe_power;
+} concurrent_cache_params_t;
+
+static void concurrent_cache_free(cache_t *cache);
+static bool concurrent_cache_get(cache_t *cache, const request_t *req);
+static cache_obj_t *concurrent_cache_find(cache_t *cache, const request_t *req,
+                                          const bool update_cache);
+static bool concurrent_cache_can_insert(cache_t *cache, const request_t *req);
+static cache_obj_t *concurrent_cache_insert(cache_t *cache,
+                                            const request_t *req);
+static cache_obj_t *concurrent_cache_to_evict(cache_t *cache,
+                                              const request_t *req);
+static void concurrent_cache_evict(cache_t *cache, const request_t *req);
+static bool concurrent_cache_remove(cache_t *cache, const obj_id_t obj_id);
+static int64_t concurrent_cache_get_occupied_byte(const cache_t *cache);
+static int64_t concurrent_cache_get_n_obj(const cache_t *cache);
+
+/**
+ * @brief the stripe of an object, it uses the high bits of a multiplicative
+ * hash because the hashtable in each stripe uses the low bits of the object
+ * hash, using the same bits would leave most buckets of a stripe empty
+ */
+static inline cache_stripe_t *get_stripe(const concurrent_cache_params_t *params,
+                                         const obj_id_t obj_id) {
+  if (params->stripe_power == 0) return &params->stripes[0];
+
+  uint64_t hv = (uint64_t)obj_id * 0x9e3779b97f4a7c15ULL;
+  return &params->stripes[hv >> (64 - params->stripe_power)];
+}
+
+/**
+ * @brief create a thread-safe cache that has the same algorithm, size and
+ * parameters as old_cache
+ *
+ * @param old_cache
+ * @param n_stripe the number of stripes, rounded up to a power of 2,
+ *        it is halved until each stripe has at least one byte
+ * @return cache_t*
+ */
+cache_t *create_concurrent_cache(const cache_t *old_cache, int n_stripe) {
+  if (old_cache->get_specialized == NULL) {
+    ERROR("%s does not support concurrent mode\n", old_cache->cache_name);
+  }
+  if (old_cache->prefetcher != NULL) {
+    ERROR("concurrent mode does not support prefetcher\n");
+  }
+  if (n_stripe < 1) n_stripe = 1;
+  n_stripe = (int)next_power_of_2(n_stripe);
+  /* each stripe needs at least one byte */
+  while (n_stripe > 1 && (int64_t)n_stripe > old_cache->cache_size) {
+    n_stripe /= 2;
+  }
+
+  common_cache_params_t cc_params = {
+      .cache_size = old_cache->cache_size,
+      .hashpower = 4,
+      .default_ttl = old_cache->default_ttl,
+      .consider_obj_metadata = old_cache->obj_md_size == 0 ? false : true,
+  };
+  cache_t *cache = cache_struct_init("concurrent", cc_params, NULL);
+  snprintf(cache->cache_name, CACHE_NAME_ARRAY_LEN, "%s-concurrent-%d",
+           old_cache->cache_name, n_stripe);
+  cache->cache_free = concurrent_cache_free;
+  cache->get = concurrent_cache_get;
+  cache->find = concurrent_cache_find;
+  cache->can_insert = concurrent_cache_can_insert;
+  cache->insert = concurrent_cache_insert;
+  cache->evict = concurrent_cache_evict;
+  cache->remove = concurrent_cache_remove;
+  cache->to_evict = concurrent_cache_to_evict;
+  cache->get_occupied_byte = concurrent_cache_get_occupied_byte;
+  cache->get_n_obj = concurrent_cache_get_n_obj;
+  cache->obj_md_size = old_cache->obj_md_size;
+
+  concurrent_cache_params_t *params = my_malloc(concurrent_cache_params_t);
+  cache->eviction_params = params;
+  params->n_stripe = n_stripe;
+  params->stripe_power = __builtin_ctz(n_stripe);
+  params->stripes = aligned_alloc(64, sizeof(cache_stripe_t) * n_stripe);
+
+  /* each stripe has 1/n_stripe of the objects, so a smaller hashtable */
+  cc_params.hashpower = old_cache->hashtable->hashpower - params->stripe_power;
+  if (cc_params.hashpower < 12) cc_params.hashpower = 12;
+  for (int i = 0; i < n_stripe; i++) {
+    cc_params.cache_size = old_cache->cache_size / n_stripe;
+    if (i < old_cache->cache_size % n_stripe) cc_params.cache_size += 1;
+
+    cache_t *stripe = old_cache->cache_init(cc_params, old_cache->init_params);
+    if (old_cache->admissioner != NULL) {
+      stripe->admissioner =
+          old_cache->admissioner->clone(old_cache->admissioner);
+    }
+    pthread_mutex_init(&params->stripes[i].lock, NULL);
+    params->stripes[i].cache = stripe;
+    params->stripes[i].get = cache_get_func(stripe);
+  }
+
+  return cache;
+}
+
+static void concurrent_cache_free(cache_t *cache) {
+  concurrent_cache_params_t *params =
+      (concurrent_cache_params_t *)cache->eviction_params;
+  for (int i = 0; i < params->n_stripe; i++) {
+    pthread_mutex_destroy(&params->stripes[i].lock);
+    params->stripes[i].cache->cache_free(params->stripes[i].cache);
+  }
+  free(params->stripes);
+  my_free(sizeof(concurrent_cache_params_t), params);
+  cache_struct_free(cache);
+}
+
+/**
+ * @brief the thread-safe get, cache->n_req is not updated because a shared
+ * counter would serialize the threads, each stripe counts its own requests
+ */
+static bool concurrent_cache_get(cache_t *cache, const request_t *req) {
+  cache_stripe_t *stripe = get_stripe(cache->eviction_params, req->obj_id);
+
+  pthread_mutex_lock(&stripe->lock);
+  bool hit = stripe->get(stripe->cache, req);
+  pthread_mutex_unlock(&stripe->lock);
+
+  return hit;
+}
+
+static cache_obj_t *concurrent_cache_find(cache_t *cache, const request_t *req,
+                                          const bool update_cache) {
+  cache_stripe_t *stripe = get_stripe(cache->eviction_params, req->obj_id);
+
+  pthread_mutex_lock(&stripe->lock);
+  cache_obj_t *obj = stripe->cache->find(stripe->cache, req, update_cache);
+  pthread_mutex_unlock(&stripe->lock);
+
+  return obj;
+}
+
+static bool concurrent_cache_can_insert(cache_t *cache, const request_t *req) {
+  cache_stripe_t *stripe = get_stripe(cache->eviction_params, req->obj_id);
+
+  pthread_mutex_lock(&stripe->lock);
+  bool can_insert = stripe->cache->can_insert(stripe->cache, req);
+  pthread_mutex_unlock(&stripe->lock);
+
+  return can_insert;
+}
+
+/**
+ * @brief insert into the stripe of the request, evicting from the stripe
+ * if it is full
+ */
+static cache_obj_t *concurrent_cache_insert(cache_t *cache,
+                                            const request_t *req) {
+  cache_stripe_t *stripe = get_stripe(cache->eviction_params, req->obj_id);
+  cache_t *c = stripe->cache;
+
+  pthread_mutex_lock(&stripe->lock);
+  while (c->get_n_obj(c) > 0 &&
+         c->get_occupied_byte(c) + req->obj_size + c->obj_md_size >
+             c->cache_size) {
+    c->evict(c, req);
+  }
+  cache_obj_t *obj = c->insert(c, req);
+  pthread_mutex_unlock(&stripe->lock);
+
+  return obj;
+}
+
+/**
+ * @brief the object to evict from the stripe of the request, the object may
+ * be evicted by another thread once this returns
+ */
+static cache_obj_t *concurrent_cache_to_evict(cache_t *cache,
+                                              const request_t *req) {
+  cache_stripe_t *stripe = get_stripe(cache->eviction_params, req->obj_id);
+
+  pthread_mutex_lock(&stripe->lock);
+  cache_obj_t *obj = stripe->cache->to_evict(stripe->cache, req);
+  pthread_mutex_unlock(&stripe->lock);
+
+  return obj;
+}
+
+/**
+ * @brief evict one object from the stripe of the request
+ */
+static void concurrent_cache_evict(cache_t *cache, const request_t *req) {
+  cache_stripe_t *stripe = get_stripe(cache->eviction_params, req->obj_id);
+
+  pthread_mutex_lock(&stripe->lock);
+  if (stripe->cache->get_n_obj(stripe->cache) > 0) {
+    stripe->cache->evict(stripe->cache, req);
+  }
+  pthread_mutex_unlock(&stripe->lock);
+}
+
+static bool concurrent_cache_remove(cache_t *cache, const obj_id_t obj_id) {
+  cache_stripe_t *stripe = get_stripe(cache->eviction_params, obj_id);
+
+  pthread_mutex_lock(&stripe->lock);
+  bool removed = stripe->cache->remove(stripe->cache, obj_id);
+  pthread_mutex_unlock(&stripe->lock);
+
+  return removed;
+}
+
+static int64_t concurrent_cache_get_occupied_byte(const cache_t *cache) {
+  const concurrent_cache_params_t *params =
+      (const concurrent_cache_params_t *)cache->eviction_params;
+  int64_t occupied_byte = 0;
+  for (int i = 0; i < params->n_stripe; i++) {
+    cache_stripe_t *stripe = &params->stripes[i];
+    pthread_mutex_lock(&stripe->lock);
+    occupied_byte += stripe->cache->get_occupied_byte(stripe->cache);
+    pthread_mutex_unlock(&stripe->lock);
+  }
+
+  return occupied_byte;
+}
+
+static int64_t concurrent_cache_get_n_obj(const cache_t *cache) {
+  const concurrent_cache_params_t *params =
+      (const concurrent_cache_params_t *)cache->eviction_params;
+  int64_t n_obj = 0;
+  for (int i = 0; i < params->n_stripe; i++) {
+    cache_stripe_t *stripe = &params->stripes[i];
+    pthread_mutex_lock(&stripe->lock);
+    n_obj += stripe->cache->get_n_obj(stripe->cache);
+    pthread_mutex_unlock(&stripe->lock);
+  }
+
+  return n_obj;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -7,46 +7,53 @@ using namespace chrono;
 using namespace std;
 using namespace ThreeLCache;
 
-void ThreeLCacheCache::train() {
+BoosterHandle ThreeLCacheCache::fit(TrainingData *data, double &time_ms) {
     auto timeBegin = chrono::system_clock::now();
-    if (booster) LGBM_BoosterFree(booster);
+    BoosterHandle new_booster;
     DatasetHandle trainData;
-    std::string params_str;
-    for (const auto &pair : training_params) {
-        params_str += pair.first + "=" + pair.second + " ";
-    }
-    params_str.pop_back();  // Remove trailing space
-
-    // Convert to C-style string (const char *)
-    const char *training_params_cstr = params_str.c_str();
-    LGBM_DatasetCreateFromCSR(
-            static_cast<void *>(training_data->indptr.data()),
-            C_API_DTYPE_INT32,
-            training_data->indices.data(),
-            static_cast<void *>(training_data->data.data()),
-            C_API_DTYPE_FLOAT64,
-            training_data->indptr.size(),
-            training_data->data.size(),
-            n_feature, 
-            training_params_cstr,
+    LGBM_DatasetCreateFromMat(
+            static_cast<void *>(data->data.data()),
+            C_API_DTYPE_FLOAT32,
+            data->n_row,
+            n_feature,
+            1,  //row major
+            training_params_str.c_str(),
             nullptr,
             &trainData);
 
     LGBM_DatasetSetField(trainData,
                          "label",
-                         static_cast<void *>(training_data->labels.data()),
-                         training_data->labels.size(),
+                         static_cast<void *>(data->labels.data()),
+                         data->labels.size(),
                          C_API_DTYPE_FLOAT32);
-    LGBM_BoosterCreate(trainData, training_params_cstr, &booster);
-    for (int i = 0; i < stoi(training_params["num_iterations"]); i++) {
+    LGBM_BoosterCreate(trainData, training_params_str.c_str(), &new_booster);
+    for (int i = 0; i < n_iterations; i++) {
         int isFinished;
-        LGBM_BoosterUpdateOneIter(booster, &isFinished);
+        LGBM_BoosterUpdateOneIter(new_booster, &isFinished);
         if (isFinished) {
             break;
         }
     }
     LGBM_DatasetFree(trainData);
+    time_ms = chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now() - timeBegin).count();
+    return new_booster;
+}
 
+void ThreeLCacheCache::update_model(bool block) {
+    if (trainer.joinable()) {
+        if (!block && !model_ready.load(memory_order_acquire))
+            return;
+        trainer.join();
+    }
+    if (!next_booster)
+        return;
+
+    if (booster) LGBM_BoosterFree(booster);
+    booster = next_booster;
+    next_booster = nullptr;
+    training_time = 0.95 * training_time + 0.05 * next_training_time;
+
+    // the predictions of the old model are not used
     pred_map.clear();
     pred_times.clear();
     pred_times.shrink_to_fit();
@@ -64,6 +71,27 @@ void ThreeLCacheCache::train() {
     }
 }
 
+void ThreeLCacheCache::train() {
+    // the previous batch is still in training, wait for it so that one model is trained at a time
+    update_model(true);
+
+    // double buffering, the request path fills one batch while the other is used for training
+    swap(training_data, training_data_in_training);
+    training_data->clear();
+
+    if (!async_training) {
+        next_booster = fit(training_data_in_training, next_training_time);
+        update_model(true);
+        return;
+    }
+
+    model_ready.store(false, memory_order_relaxed);
+    trainer = thread([this]() {
+        next_booster = fit(training_data_in_training, next_training_time);
+        model_ready.store(true, memory_order_release);
+    });
+}
+
 void ThreeLCacheCache::sample() {
     auto rand_idx = _distribution(_generator);
     uint32_t pos = rand_idx % (in_cache.metas.size() + out_cache.metas.size());
@@ -97,7 +125,6 @@ bool ThreeLCacheCache::lookup(const SimpleRequest &req) {
             training_data->emplace_back(meta, sample_time, future_distance, meta._key);
             if (training_data->labels.size() >= batch_size && evict_nums <= 0) {
                 train();
-                training_data->clear();
             }
             meta._sample_times = 0;
         } else {
@@ -144,7 +171,6 @@ void ThreeLCacheCache::erase_out_cache() {
                     
                 if (training_data->labels.size() >= batch_size && evict_nums <= 0) {
                     train();
-                    training_data->clear();
                 }
             }
             key_map.erase(meta._key);
@@ -328,6 +354,9 @@ void ThreeLCacheCache::evict_with_candidate(pair<uint64_t, uint32_t> &epair) {
 }
 
 pair<uint64_t, uint32_t> ThreeLCacheCache::evict_predobj(){
+    // a new model is only used when a new window of candidates is predicted
+    if (evict_nums <= 0 || pred_map.empty())
+        update_model(false);
     {
         auto pos = in_cache.q.head;
         auto &meta = in_cache.metas[pos];
@@ -363,29 +392,20 @@ pair<uint64_t, uint32_t> ThreeLCacheCache::evict_predobj(){
 }
 
 
-void ThreeLCacheCache::prediction(vector<uint32_t> sampled_objects) {
+void ThreeLCacheCache::prediction(const vector<uint32_t> &sampled_objects) {
     uint32_t sample_nums = sampled_objects.size();
-    int32_t indptr[sample_nums + 1];
-    indptr[0] = 0;
-    int32_t indices[sample_nums * n_feature];
-    double data[sample_nums * n_feature];
-    int32_t past_timestamps[sample_nums];
-    uint32_t sizes[sample_nums];
-    uint64_t keys[sample_nums];
-    uint32_t poses[sample_nums];
-    unsigned int idx_feature = 0;
+    if ((size_t) sample_nums * n_feature > inference_data.size()) {
+        inference_data.resize((size_t) sample_nums * n_feature);
+        scores.resize(sample_nums);
+    }
     uint32_t pos;
     unsigned int idx_row = 0;
     for (; idx_row < sample_nums; idx_row++) {
         pos = sampled_objects[idx_row];
         auto &meta = in_cache.metas[pos];
-        keys[idx_row] = meta._key;
-        poses[idx_row] = pos;
-        indices[idx_feature] = 0;
+        float *row = &inference_data[(size_t) idx_row * n_feature];
         // 年龄
-        data[idx_feature++] = current_seq - meta._past_timestamp;
-        
-        past_timestamps[idx_row] = meta._past_timestamp;
+        row[0] = current_seq - meta._past_timestamp;
 
         uint8_t j = 0;
 
@@ -393,64 +413,51 @@ void ThreeLCacheCache::prediction(vector<uint32_t> sampled_objects) {
         if (meta._extra) {
             for (j = 0; j < meta._extra->_past_distance_idx && j < max_n_past_distances; ++j) {
                 uint8_t past_distance_idx = (meta._extra->_past_distance_idx - 1 - j) % max_n_past_distances;
-                uint32_t &past_distance = meta._extra->_past_distances[past_distance_idx];
-                indices[idx_feature] = j + 1;
-                data[idx_feature++] = past_distance;
+                row[j + 1] = meta._extra->_past_distances[past_distance_idx];
             }
         }
+        for (; j < max_n_past_distances; ++j)
+            row[j + 1] = 0;
 
-        indices[idx_feature] = max_n_past_timestamps;
-        data[idx_feature++] = meta._size;
-        sizes[idx_row] = meta._size;
-
-        indices[idx_feature] = max_n_past_timestamps + 1;
-        data[idx_feature++] = n_within;
-
-        indptr[idx_row + 1] = idx_feature;
+        row[max_n_past_timestamps] = meta._size;
+        row[max_n_past_timestamps + 1] = n_within;
     }
     int64_t len = 0;
-    double scores[sample_nums];
-    std::string inference_params_str;
-    for (const auto &param : inference_params) {
-        inference_params_str += param.first + "=" + param.second + " ";
-    }
-    inference_params_str.pop_back();  // Remove trailing space
-    const char *inference_params_cstr = inference_params_str.c_str();
-    LGBM_BoosterPredictForCSR(booster,
-                              static_cast<void *>(indptr),
-                              C_API_DTYPE_INT32,
-                              indices,
-                              static_cast<void *>(data),
-                              C_API_DTYPE_FLOAT64,
-                              idx_row + 1,
-                              idx_feature,
-                              n_feature,  //remove future t
+    // all candidates of the window are predicted in one call
+    LGBM_BoosterPredictForMat(booster,
+                              static_cast<void *>(inference_data.data()),
+                              C_API_DTYPE_FLOAT32,
+                              sample_nums,
+                              n_feature,
+                              1,  //row major
                               C_API_PREDICT_NORMAL,
                               0,
                               0,
-                              inference_params_cstr,
+                              inference_params_str.c_str(),
                               &len,
-                              scores);
+                              scores.data());
     float _distance;
     if (objective == byte_miss_ratio) {
         for (int i = 0; i < sample_nums; ++i) {
+            auto &meta = in_cache.metas[sampled_objects[i]];
             _distance = exp(scores[i]) + uint64_t(current_seq - origin_current_seq);
-            pred_times.push_back({_distance, keys[i]});
+            pred_times.push_back({_distance, meta._key});
             push_heap(pred_times.begin(), pred_times.end(), 
             [](const HeapUint& a, const HeapUint& b) {
                 return a.reuse_time < b.reuse_time;
             });
-            pred_map[keys[i]] = _distance;
+            pred_map[meta._key] = _distance;
         }
     } else {
         for (int i = 0; i < sample_nums; ++i) {
-            _distance = float(sizes[i] * exp(scores[i]));
-            pred_times.push_back({_distance, keys[i]});
+            auto &meta = in_cache.metas[sampled_objects[i]];
+            _distance = float(meta._size * exp(scores[i]));
+            pred_times.push_back({_distance, meta._key});
             push_heap(pred_times.begin(), pred_times.end(), 
             [](const HeapUint& a, const HeapUint& b) {
                 return a.reuse_time < b.reuse_time;
             });
-            pred_map[keys[i]] = _distance;
+            pred_map[meta._key] = _distance;
         }
     }
 }
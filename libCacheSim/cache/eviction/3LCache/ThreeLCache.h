@@ -14,6 +14,8 @@
 #include <fstream>
 #include <list>
 #include <deque>
+#include <thread>
+#include <atomic>
 using namespace webcachesim;
 using namespace std;
 
@@ -162,58 +164,50 @@ public:
 };
 
 
+//a batch of training samples in a dense row-major float matrix, the features that are not available are 0,
+//the matrix is reused across training rounds
 class TrainingData {
 public:
     vector<float> labels;
-    vector<int32_t> indptr;
-    vector<int32_t> indices;
-    vector<double> data;
-    TrainingData(uint32_t n_feature) {
+    vector<float> data;
+    uint32_t n_feature;
+    uint32_t n_row = 0;
+
+    TrainingData(uint32_t n_feature_) {
+        n_feature = n_feature_;
         labels.reserve(batch_size);
-        indptr.reserve(batch_size + 1);
-        indptr.emplace_back(0);
-        indices.reserve(batch_size * n_feature);
-        data.reserve(batch_size * n_feature);
+        data.resize((size_t) batch_size * n_feature);
     }
 
     void emplace_back(Meta &meta, uint64_t &sample_timestamp, uint32_t &future_interval, const uint64_t &key) {
-        int32_t counter = indptr.back();
+        //a batch can be larger than batch_size when training is postponed
+        if ((size_t) (n_row + 1) * n_feature > data.size())
+            data.resize(data.size() * 2);
+        float *row = &data[(size_t) n_row * n_feature];
 
-        indices.emplace_back(0);
         // 等待时间
-        data.emplace_back(sample_timestamp - meta._past_timestamp);
-        ++counter;
+        row[0] = sample_timestamp - meta._past_timestamp;
         int j = 0;
         uint16_t n_within = meta._freq;
         if (meta._extra) {
             for (; j < meta._extra->_past_distance_idx && j < max_n_past_distances; ++j) {
                 uint8_t past_distance_idx = (meta._extra->_past_distance_idx - 1 - j) % max_n_past_distances;
-                const uint32_t &past_distance = meta._extra->_past_distances[past_distance_idx];
-                indices.emplace_back(j + 1);
-                data.emplace_back(past_distance);
+                row[j + 1] = meta._extra->_past_distances[past_distance_idx];
             }
         }
+        for (; j < max_n_past_distances; ++j)
+            row[j + 1] = 0;
 
-        counter += j;
-
-        indices.emplace_back(max_n_past_timestamps);
-        data.push_back(meta._size);
-        ++counter;
-
+        row[max_n_past_timestamps] = meta._size;
+        row[max_n_past_timestamps + 1] = n_within;
 
-        indices.push_back(max_n_past_timestamps + 1);
-        data.push_back(n_within);
-        ++counter;
         labels.push_back(log1p(future_interval));
-        indptr.push_back(counter);
-
+        ++n_row;
     }
 
     void clear() {
         labels.clear();
-        indptr.resize(1);
-        indices.clear();
-        data.clear();
+        n_row = 0;
     }
 };
 
@@ -263,7 +257,9 @@ public:
     CacheUpdateQueue in_cache;
     CacheUpdateQueue out_cache;
 
-    TrainingData *training_data;
+    //the batch being filled, and the batch the trainer thread is using
+    TrainingData *training_data = nullptr;
+    TrainingData *training_data_in_training = nullptr;
 
     double training_loss = 0;
     int32_t n_force_eviction = 0;
@@ -273,6 +269,18 @@ public:
 
     BoosterHandle booster = nullptr;
 
+    //train in a background thread, the model in use is replaced when the new one is ready,
+    //off by default because the miss ratio then depends on the thread timing
+    bool async_training = false;
+    thread trainer;
+    atomic<bool> model_ready{false};
+    BoosterHandle next_booster = nullptr;
+    double next_training_time = 0;
+
+    //the features of the eviction candidates, one row per candidate, reused for every prediction
+    vector<float> inference_data;
+    vector<double> scores;
+
     unordered_map<string, string> training_params = {
             {"boosting",         "gbdt"},
             {"objective",        "regression"},
@@ -287,6 +295,10 @@ public:
     };
 
     unordered_map<string, string> inference_params;
+    //the parameters as strings, so that they are not built for every prediction
+    string training_params_str;
+    string inference_params_str;
+    int n_iterations;
 
     enum ObjectiveT : uint8_t {
         byte_miss_ratio = 0, object_miss_ratio = 1
@@ -312,6 +324,8 @@ public:
                 training_params["num_leaves"] = it.second;
             } else if (it.first == "byte_million_req") {
                 byte_million_req = stoull(it.second);
+            } else if (it.first == "async_training") {
+                async_training = stoi(it.second) != 0;
             } else if(it.first == "sample_rate") {
                 sample_rate = stoull(it.second);
             } else if (it.first == "objective") {
@@ -334,7 +348,31 @@ public:
         memset(evcition_distribution, 0, sizeof(uint64_t) * 4);
         n_feature = max_n_past_timestamps + 2;
         inference_params = training_params;
+        training_params_str = params_to_string(training_params);
+        inference_params_str = params_to_string(inference_params);
+        n_iterations = stoi(training_params["num_iterations"]);
         training_data = new TrainingData(n_feature);
+        training_data_in_training = new TrainingData(n_feature);
+    }
+
+    ~ThreeLCacheCache() override {
+        if (trainer.joinable())
+            trainer.join();
+        if (next_booster) LGBM_BoosterFree(next_booster);
+        if (booster) LGBM_BoosterFree(booster);
+        delete training_data;
+        delete training_data_in_training;
+        free(evcition_distribution);
+        free(object_distribution_n_eviction);
+    }
+
+    static string params_to_string(const unordered_map<string, string> &params) {
+        string params_str;
+        for (const auto &pair : params) {
+            params_str += pair.first + "=" + pair.second + " ";
+        }
+        params_str.pop_back();  // Remove trailing space
+        return params_str;
     }
 
     bool lookup(const SimpleRequest &req) override;
@@ -353,9 +391,17 @@ public:
 
     vector<uint32_t>  quick_demotion();
 
+    //start training on the current batch, in the background if async_training
     void train();
 
-    void prediction(vector<uint32_t> sampled_objects);
+    //train a model on data, it does not change the cache so it can run in the trainer thread
+    BoosterHandle fit(TrainingData *data, double &time_ms);
+
+    //replace the model in use with the model trained in the background if it is ready,
+    //if block, wait for the trainer
+    void update_model(bool block);
+
+    void prediction(const vector<uint32_t> &sampled_objects);
 
     void sample();
 
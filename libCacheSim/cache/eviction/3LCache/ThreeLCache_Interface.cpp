@@ -16,13 +16,15 @@ extern "C" {
 typedef struct {
   void *ThreeLCache_cache;
   char *objective;
+  bool async_training;
   SimpleRequest ThreeLCache_req;
 
   pair<uint64_t, uint32_t> to_evict_pair;
   cache_obj_t obj_tmp;
 } ThreeLCache_params_t;
 
-static const char *DEFAULT_PARAMS = "objective=byte-miss-ratio";
+static const char *DEFAULT_PARAMS =
+    "objective=byte-miss-ratio,async-training=0";
 
 // ***********************************************************************
 // ****                                                               ****
@@ -92,10 +94,9 @@ cache_t *ThreeLCache_init(const common_cache_params_t ccache_params,
   memset(params, 0, sizeof(ThreeLCache_params_t));
   cache->eviction_params = params;
 
+  ThreeLCache_parse_params(cache, DEFAULT_PARAMS);
   if (cache_specific_params != NULL) {
     ThreeLCache_parse_params(cache, cache_specific_params);
-  } else {
-    ThreeLCache_parse_params(cache, DEFAULT_PARAMS);
   }
 
   auto *ThreeLCache = new ThreeLCache::ThreeLCacheCache();
@@ -106,6 +107,7 @@ cache_t *ThreeLCache_init(const common_cache_params_t ccache_params,
   std::map<string, string> params_map;
 
   params_map["objective"] = params->objective;
+  params_map["async_training"] = params->async_training ? "1" : "0";
 
   if (strcmp(params->objective, "object-miss-ratio") == 0) {
     snprintf(cache->cache_name, CACHE_NAME_ARRAY_LEN, "%s", "ThreeLCache-OMR");
@@ -129,6 +131,7 @@ static void ThreeLCache_free(cache_t *cache) {
   auto *params = static_cast<ThreeLCache_params_t *>(cache->eviction_params);
   auto *ThreeLCache = static_cast<ThreeLCache::ThreeLCacheCache *>(params->ThreeLCache_cache);
   delete ThreeLCache;
+  free(params->objective);
   free(cache->to_evict_candidate);
   my_free(sizeof(ThreeLCache_params_t), params);
   cache_struct_free(cache);
@@ -304,7 +307,8 @@ static int64_t ThreeLCache_get_occupied_byte(const cache_t *cache) {
 // ***********************************************************************
 static const char *ThreeLCache_current_params(cache_t *cache, ThreeLCache_params_t *params) {
   static __thread char params_str[128];
-  int n = snprintf(params_str, 128, "objective=%s", params->objective);
+  int n = snprintf(params_str, 128, "objective=%s,async-training=%d",
+                   params->objective, params->async_training);
 
   snprintf(cache->cache_name + n, 128 - n, "\n");
 
@@ -329,10 +333,13 @@ static void ThreeLCache_parse_params(cache_t *cache,
     }
 
     if (strcasecmp(key, "objective") == 0) {
+      free(params->objective);
       params->objective = strdup(value);
       if (params->objective == NULL) {
         ERROR("out of memory %s\n", strerror(errno));
       }
+    } else if (strcasecmp(key, "async-training") == 0) {
+      params->async_training = strtol(value, &end, 0) != 0;
     } else if (strcasecmp(key, "print") == 0) {
       printf("current parameters: %s\n", ThreeLCache_current_params(cache, params));
       exit(0);
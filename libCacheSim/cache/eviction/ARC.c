@@ -8,6 +8,9 @@
 //  we used int as first,
 //  but the implementation above used float, so we have changed to use float
 //
+//  with ghost-fp-rate > 0, B1 and B2 store fingerprints (see
+//  fingerprintGhost.h) instead of the evicted objects, the ghost sizes used
+//  in the adaptation are the sizes of the fingerprint ghosts
 //
 //  libCacheSim
 //
@@ -17,6 +20,7 @@
 
 #include <string.h>
 
+#include "../../dataStructure/fingerprintGhost.h"
 #include "../../dataStructure/hashtable/hashtable.h"
 #include "../../include/libCacheSim/evictionAlgo.h"
 
@@ -45,6 +49,11 @@ typedef struct ARC_params {
   cache_obj_t *L2_ghost_head;
   cache_obj_t *L2_ghost_tail;
 
+  /* used instead of the ghost lists if ghost_fp_rate > 0 */
+  fp_ghost_t *L1_ghost_fp;
+  fp_ghost_t *L2_ghost_fp;
+  double ghost_fp_rate;
+
   double p;
   bool curr_obj_in_L1_ghost;
   bool curr_obj_in_L2_ghost;
@@ -141,6 +150,17 @@ cache_t *ARC_init(const common_cache_params_t ccache_params,
   params->vtime_last_req_in_ghost = -1;
   params->req_local = new_request();
 
+  if (cache_specific_params != NULL) {
+    ARC_parse_params(cache, cache_specific_params);
+  }
+  if (params->ghost_fp_rate > 0) {
+    /* ARC bounds the ghosts, the limit is only a safeguard */
+    params->L1_ghost_fp =
+        fp_ghost_new(cache->cache_size * 2, params->ghost_fp_rate);
+    params->L2_ghost_fp =
+        fp_ghost_new(cache->cache_size * 2, params->ghost_fp_rate);
+  }
+
 #ifdef USE_BELADY
   snprintf(cache->cache_name, CACHE_NAME_ARRAY_LEN, "ARC_Belady");
 #endif
@@ -156,6 +176,10 @@ cache_t *ARC_init(const common_cache_params_t ccache_params,
 static void ARC_free(cache_t *cache) {
   ARC_params_t *ARC_params = (ARC_params_t *)(cache->eviction_params);
   free_request(ARC_params->req_local);
+  if (ARC_params->L1_ghost_fp != NULL) {
+    fp_ghost_free(ARC_params->L1_ghost_fp);
+    fp_ghost_free(ARC_params->L2_ghost_fp);
+  }
   my_free(sizeof(ARC_params_t), ARC_params);
   cache_struct_free(cache);
 }
@@ -206,6 +230,33 @@ static bool ARC_get(cache_t *cache, const request_t *req) {
 // ****                                                               ****
 // ***********************************************************************
 
+/* the ghost hit (case II and III) when the ghosts store fingerprints */
+static void _ARC_hit_on_fp_ghost(cache_t *cache, const request_t *req) {
+  ARC_params_t *params = (ARC_params_t *)(cache->eviction_params);
+
+  params->curr_obj_in_L1_ghost = false;
+  params->curr_obj_in_L2_ghost = false;
+
+  if (fp_ghost_contains(params->L1_ghost_fp, req->obj_id)) {
+    params->curr_obj_in_L1_ghost = true;
+    double delta =
+        MAX((double)params->L2_ghost_size / params->L1_ghost_size, 1);
+    params->p = MIN(params->p + delta, cache->cache_size);
+    fp_ghost_remove(params->L1_ghost_fp, req->obj_id);
+    params->L1_ghost_size = params->L1_ghost_fp->occupied_byte;
+  } else if (fp_ghost_contains(params->L2_ghost_fp, req->obj_id)) {
+    params->curr_obj_in_L2_ghost = true;
+    double delta =
+        MAX((double)params->L1_ghost_size / params->L2_ghost_size, 1);
+    params->p = MAX(params->p - delta, 0);
+    fp_ghost_remove(params->L2_ghost_fp, req->obj_id);
+    params->L2_ghost_size = params->L2_ghost_fp->occupied_byte;
+  } else {
+    return;
+  }
+  params->vtime_last_req_in_ghost = cache->n_req;
+}
+
 /**
  * @brief find an object in the cache
  *
@@ -223,10 +274,13 @@ static cache_obj_t *ARC_find(cache_t *cache, const request_t *req,
   cache_obj_t *obj = cache_find_base(cache, req, update_cache);
 
   if (!update_cache) {
-    return obj->ARC.ghost ? NULL : obj;
+    return obj != NULL && !obj->ARC.ghost ? obj : NULL;
   }
 
   if (obj == NULL) {
+    if (params->L1_ghost_fp != NULL) {
+      _ARC_hit_on_fp_ghost(cache, req);
+    }
     return NULL;
   }
 
@@ -389,6 +443,13 @@ static bool ARC_remove(cache_t *cache, const obj_id_t obj_id) {
   cache_obj_t *obj = hashtable_find_obj_id(cache->hashtable, obj_id);
 
   if (obj == NULL) {
+    if (params->L1_ghost_fp != NULL) {
+      bool removed = fp_ghost_remove(params->L1_ghost_fp, obj_id) ||
+                     fp_ghost_remove(params->L2_ghost_fp, obj_id);
+      params->L1_ghost_size = params->L1_ghost_fp->occupied_byte;
+      params->L2_ghost_size = params->L2_ghost_fp->occupied_byte;
+      return removed;
+    }
     return false;
   }
 
@@ -453,6 +514,16 @@ static void _ARC_evict_L1_data(cache_t *cache, const request_t *req) {
          obj->misc.next_access_vtime);
 #endif
 
+  if (params->L1_ghost_fp != NULL) {
+    remove_obj_from_list(&params->L1_data_head, &params->L1_data_tail, obj);
+    params->L1_data_size -= obj->obj_size + cache->obj_md_size;
+    fp_ghost_insert(params->L1_ghost_fp, obj->obj_id,
+                    obj->obj_size + cache->obj_md_size);
+    params->L1_ghost_size = params->L1_ghost_fp->occupied_byte;
+    cache_evict_base(cache, obj, true);
+    return;
+  }
+
   cache_evict_base(cache, obj, false);
 
   params->L1_data_size -= obj->obj_size + cache->obj_md_size;
@@ -483,6 +554,16 @@ static void _ARC_evict_L2_data(cache_t *cache, const request_t *req) {
   cache_obj_t *obj = params->L2_data_tail;
   DEBUG_ASSERT(obj != NULL);
 
+  if (params->L2_ghost_fp != NULL) {
+    remove_obj_from_list(&params->L2_data_head, &params->L2_data_tail, obj);
+    params->L2_data_size -= obj->obj_size + cache->obj_md_size;
+    fp_ghost_insert(params->L2_ghost_fp, obj->obj_id,
+                    obj->obj_size + cache->obj_md_size);
+    params->L2_ghost_size = params->L2_ghost_fp->occupied_byte;
+    cache_evict_base(cache, obj, true);
+    return;
+  }
+
   params->L2_data_size -= obj->obj_size + cache->obj_md_size;
   params->L2_ghost_size += obj->obj_size + cache->obj_md_size;
   remove_obj_from_list(&params->L2_data_head, &params->L2_data_tail, obj);
@@ -495,6 +576,11 @@ static void _ARC_evict_L2_data(cache_t *cache, const request_t *req) {
 
 static void _ARC_evict_L1_ghost(cache_t *cache, const request_t *req) {
   ARC_params_t *params = (ARC_params_t *)(cache->eviction_params);
+  if (params->L1_ghost_fp != NULL) {
+    fp_ghost_remove_oldest(params->L1_ghost_fp);
+    params->L1_ghost_size = params->L1_ghost_fp->occupied_byte;
+    return;
+  }
   cache_obj_t *obj = params->L1_ghost_tail;
   DEBUG_ASSERT(obj != NULL);
   DEBUG_ASSERT(obj->ARC.ghost);
@@ -506,6 +592,11 @@ static void _ARC_evict_L1_ghost(cache_t *cache, const request_t *req) {
 
 static void _ARC_evict_L2_ghost(cache_t *cache, const request_t *req) {
   ARC_params_t *params = (ARC_params_t *)(cache->eviction_params);
+  if (params->L2_ghost_fp != NULL) {
+    fp_ghost_remove_oldest(params->L2_ghost_fp);
+    params->L2_ghost_size = params->L2_ghost_fp->occupied_byte;
+    return;
+  }
   cache_obj_t *obj = params->L2_ghost_tail;
   DEBUG_ASSERT(obj != NULL);
   DEBUG_ASSERT(obj->ARC.ghost);
@@ -601,7 +692,7 @@ static void _ARC_evict_miss_on_all_queues(cache_t *cache,
 // ***********************************************************************
 static const char *ARC_current_params(ARC_params_t *params) {
   static __thread char params_str[128];
-  snprintf(params_str, 128, "\n");
+  snprintf(params_str, 128, "ghost-fp-rate=%.4lf\n", params->ghost_fp_rate);
   return params_str;
 }
 
@@ -616,14 +707,16 @@ static void ARC_parse_params(cache_t *cache,
     /* different parameters are separated by comma,
      * key and value are separated by = */
     char *key = strsep((char **)&params_str, "=");
-    // char *value = strsep((char **)&params_str, ",");
+    char *value = strsep((char **)&params_str, ",");
 
     // skip the white space
     while (params_str != NULL && *params_str == ' ') {
       params_str++;
     }
 
-    if (strcasecmp(key, "print") == 0) {
+    if (strcasecmp(key, "ghost-fp-rate") == 0) {
+      params->ghost_fp_rate = strtod(value, NULL);
+    } else if (strcasecmp(key, "print") == 0) {
       printf("parameters: %s\n", ARC_current_params(params));
       exit(0);
     } else {
@@ -688,7 +781,7 @@ static void _ARC_sanity_check(cache_t *cache, const request_t *req) {
     DEBUG_ASSERT(params->L1_data_head != NULL);
     DEBUG_ASSERT(params->L1_data_tail != NULL);
   }
-  if (params->L1_ghost_size > 0) {
+  if (params->L1_ghost_size > 0 && params->L1_ghost_fp == NULL) {
     DEBUG_ASSERT(params->L1_ghost_head != NULL);
     DEBUG_ASSERT(params->L1_ghost_tail != NULL);
   }
@@ -696,7 +789,7 @@ static void _ARC_sanity_check(cache_t *cache, const request_t *req) {
     DEBUG_ASSERT(params->L2_data_head != NULL);
     DEBUG_ASSERT(params->L2_data_tail != NULL);
   }
-  if (params->L2_ghost_size > 0) {
+  if (params->L2_ghost_size > 0 && params->L2_ghost_fp == NULL) {
     DEBUG_ASSERT(params->L2_ghost_head != NULL);
     DEBUG_ASSERT(params->L2_ghost_tail != NULL);
   }
@@ -741,7 +834,8 @@ static inline void _ARC_sanity_check_full(cache_t *cache,
     last_obj = obj;
     obj = obj->queue.next;
   }
-  DEBUG_ASSERT(L1_ghost_byte == params->L1_ghost_size);
+  DEBUG_ASSERT(L1_ghost_byte == params->L1_ghost_size ||
+               params->L1_ghost_fp != NULL);
   DEBUG_ASSERT(last_obj == params->L1_ghost_tail);
 
   obj = params->L2_data_head;
@@ -765,7 +859,8 @@ static inline void _ARC_sanity_check_full(cache_t *cache,
     last_obj = obj;
     obj = obj->queue.next;
   }
-  DEBUG_ASSERT(L2_ghost_byte == params->L2_ghost_size);
+  DEBUG_ASSERT(L2_ghost_byte == params->L2_ghost_size ||
+               params->L2_ghost_fp != NULL);
   DEBUG_ASSERT(last_obj == params->L2_ghost_tail);
 }
 
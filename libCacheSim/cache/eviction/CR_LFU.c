@@ -1,10 +1,10 @@
 
-#include <glib.h>
 #include <math.h>
 
 #include "../../dataStructure/hashtable/hashtable.h"
 #include "../../include/libCacheSim/evictionAlgo.h"
 #include "../../include/libCacheSim/evictionAlgo/Cacheus.h"
+#include "../freqBucket.h"
 // CR_LFU is used by Cacheus.
 
 #ifdef __cplusplus
@@ -28,10 +28,6 @@ static cache_obj_t *CR_LFU_to_evict(cache_t *cache, const request_t *req);
 static void CR_LFU_evict(cache_t *cache, const request_t *req);
 static bool CR_LFU_remove(cache_t *cache, const obj_id_t obj_id);
 
-static void free_list_node(void *list_node) {
-  my_free(sizeof(freq_node_t), list_node);
-}
-
 // ***********************************************************************
 // ****                                                               ****
 // ****                   end user facing functions                   ****
@@ -67,20 +63,10 @@ cache_t *CR_LFU_init(const common_cache_params_t ccache_params,
   cache->eviction_params = params;
   params->req_local = new_request();
 
-  params->min_freq = 1;
-  params->max_freq = 1;
   params->other_cache = NULL;  // for Cacheus
 
-  freq_node_t *freq_node = my_malloc_n(freq_node_t, 1);
-  params->freq_one_node = freq_node;
-  freq_node->freq = 1;
-  freq_node->n_obj = 0;
-  freq_node->first_obj = NULL;
-  freq_node->last_obj = NULL;
-
-  params->freq_map = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
-                                           (GDestroyNotify)free_list_node);
-  g_hash_table_insert(params->freq_map, GSIZE_TO_POINTER(1), freq_node);
+  params->freq_buckets = my_malloc(freq_bucket_list_t);
+  freq_bucket_list_init(params->freq_buckets);
 
   return cache;
 }
@@ -93,7 +79,8 @@ cache_t *CR_LFU_init(const common_cache_params_t ccache_params,
 static void CR_LFU_free(cache_t *cache) {
   CR_LFU_params_t *params = (CR_LFU_params_t *)(cache->eviction_params);
   free_request(params->req_local);
-  g_hash_table_destroy(params->freq_map);
+  freq_bucket_list_free(params->freq_buckets);
+  my_free(sizeof(freq_bucket_list_t), params->freq_buckets);
   my_free(sizeof(CR_LFU_params_t), params);
   cache_struct_free(cache);
 }
@@ -143,67 +130,16 @@ static cache_obj_t *CR_LFU_find(cache_t *cache, const request_t *req,
 
   if (cache_obj && likely(update_cache)) {
     CR_LFU_params_t *params = (CR_LFU_params_t *)(cache->eviction_params);
-    /* freq incr and move to next freq node */
+    /* freq incr and move to next freq node, which is either the neighbor or
+     * a new node after it */
+    freq_node_t *old_node = cache_obj->lfu.freq_node;
+    DEBUG_ASSERT(old_node->freq == cache_obj->lfu.freq);
     cache_obj->lfu.freq += 1;
-    if (params->max_freq < cache_obj->lfu.freq) {
-      params->max_freq = cache_obj->lfu.freq;
-    }
-
-    // find the freq_node this object belongs to and update its info
-    freq_node_t *old_node = g_hash_table_lookup(
-        params->freq_map, GSIZE_TO_POINTER(cache_obj->lfu.freq - 1));
-    DEBUG_ASSERT(old_node != NULL);
-    DEBUG_ASSERT(old_node->freq == cache_obj->lfu.freq - 1);
-    DEBUG_ASSERT(old_node->n_obj > 0);
-    old_node->n_obj -= 1;
-    remove_obj_from_list(&old_node->first_obj, &old_node->last_obj, cache_obj);
-
-    // find the new freq_node this object should move to
-    freq_node_t *new_node = g_hash_table_lookup(
-        params->freq_map, GSIZE_TO_POINTER(cache_obj->lfu.freq));
-    if (new_node == NULL) {
-      new_node = my_malloc_n(freq_node_t, 1);
-      memset(new_node, 0, sizeof(freq_node_t));
-      new_node->freq = cache_obj->lfu.freq;
-      g_hash_table_insert(params->freq_map,
-                          GSIZE_TO_POINTER(cache_obj->lfu.freq), new_node);
-    } else {
-      // it could be new_node is empty
-      DEBUG_ASSERT(new_node->freq == cache_obj->lfu.freq);
-    }
-
-    /* add to tail of the list */
-    if (new_node->last_obj != NULL) {
-      new_node->last_obj->queue.next = cache_obj;
-      cache_obj->queue.prev = new_node->last_obj;
-    } else {
-      DEBUG_ASSERT(new_node->first_obj == NULL);
-      DEBUG_ASSERT(new_node->n_obj == 0);
-      new_node->first_obj = cache_obj;
-      cache_obj->queue.prev = NULL;
-    }
 
-    cache_obj->queue.next = NULL;
-    new_node->last_obj = cache_obj;
-    new_node->n_obj += 1;
-
-    // if the old freq_node only has one object, after removing this object, it
-    // will have no object and if it is the min_freq, then we should update
-    // min_freq
-    if (params->min_freq == old_node->freq && old_node->n_obj == 0) {
-      /* update min freq */
-      uint64_t old_min_freq = params->min_freq;
-      for (uint64_t freq = params->min_freq + 1; freq <= params->max_freq;
-           freq++) {
-        freq_node_t *node =
-            g_hash_table_lookup(params->freq_map, GSIZE_TO_POINTER(freq));
-        if (node != NULL && node->n_obj > 0) {
-          params->min_freq = freq;
-          break;
-        }
-      }
-      DEBUG_ASSERT(params->min_freq > old_min_freq);
-    }
+    freq_node_t *new_node = freq_bucket_find_or_create(
+        params->freq_buckets, old_node, cache_obj->lfu.freq);
+    freq_bucket_remove_obj(params->freq_buckets, cache_obj);
+    freq_bucket_add_obj(new_node, cache_obj);
   }
   return cache_obj;
 }
@@ -236,69 +172,12 @@ static cache_obj_t *CR_LFU_insert(cache_t *cache, const request_t *req) {
     }
   }
 
-  // If the obj was new, i.e. not inserted in SR_LRU history
-  if (cache_obj->lfu.freq == 1) {
-    params->min_freq = 1;
-    freq_node_t *freq_one_node = params->freq_one_node;
-    cache_obj->queue.prev = freq_one_node->last_obj;
-    freq_one_node->n_obj += 1;
-
-    if (freq_one_node->last_obj != NULL) {
-      freq_one_node->last_obj->queue.next = cache_obj;
-    } else {
-      DEBUG_ASSERT(freq_one_node->first_obj == NULL);
-      freq_one_node->first_obj = cache_obj;
-    }
-    freq_one_node->last_obj = cache_obj;
-    DEBUG_ASSERT(freq_one_node->first_obj != NULL);
-  } else {
-    // find the new freq_node this object should move to
-    DEBUG_ASSERT(params->other_cache != NULL);
-    freq_node_t *new_node = g_hash_table_lookup(
-        params->freq_map, GSIZE_TO_POINTER(cache_obj->lfu.freq));
-    if (new_node == NULL) {
-      new_node = my_malloc_n(freq_node_t, 1);
-      memset(new_node, 0, sizeof(freq_node_t));
-      new_node->freq = cache_obj->lfu.freq;
-      g_hash_table_insert(params->freq_map,
-                          GSIZE_TO_POINTER(cache_obj->lfu.freq), new_node);
-    } else {
-      // it could be new_node is empty
-      DEBUG_ASSERT(new_node->freq == cache_obj->lfu.freq);
-    }
-    /* add to tail of the list */
-    if (new_node->last_obj != NULL) {
-      new_node->last_obj->queue.next = cache_obj;
-      cache_obj->queue.prev = new_node->last_obj;
-    } else {
-      DEBUG_ASSERT(new_node->first_obj == NULL);
-      DEBUG_ASSERT(new_node->n_obj == 0);
-      new_node->first_obj = cache_obj;
-      cache_obj->queue.prev = NULL;
-    }
-
-    cache_obj->queue.next = NULL;
-    new_node->last_obj = cache_obj;
-    new_node->n_obj += 1;
-  }
-
-  // Update min_freq and max_freq
-  if (params->max_freq < cache_obj->lfu.freq) {
-    params->max_freq = cache_obj->lfu.freq;
-  }
-  if (params->min_freq > cache_obj->lfu.freq || params->min_freq == -1) {
-    // when considering object size, it is possible that
-    // one object evicts all other objects
-    // and it has a frequency more than 1
-    // because the history is kept in SR-LRU
-    params->min_freq = cache_obj->lfu.freq;
-  }
-
-  freq_node_t *min_freq_node =
-      g_hash_table_lookup(params->freq_map, GSIZE_TO_POINTER(params->min_freq));
-  DEBUG_ASSERT(min_freq_node != NULL);
-  DEBUG_ASSERT(min_freq_node->last_obj != NULL);
-  DEBUG_ASSERT(min_freq_node->n_obj > 0);
+  // the obj was new if it was not in SR_LRU history, a loaded frequency
+  // can be smaller than the min freq, because when considering object size,
+  // one object can evict all other objects
+  freq_node_t *new_node = freq_bucket_find_or_create(params->freq_buckets,
+                                                     NULL, cache_obj->lfu.freq);
+  freq_bucket_add_obj(new_node, cache_obj);
 
   return cache_obj;
 }
@@ -306,8 +185,7 @@ static cache_obj_t *CR_LFU_insert(cache_t *cache, const request_t *req) {
 static cache_obj_t *CR_LFU_to_evict(cache_t *cache, const request_t *req) {
   CR_LFU_params_t *params = (CR_LFU_params_t *)(cache->eviction_params);
 
-  freq_node_t *min_freq_node =
-      g_hash_table_lookup(params->freq_map, GSIZE_TO_POINTER(params->min_freq));
+  freq_node_t *min_freq_node = params->freq_buckets->head;
   DEBUG_ASSERT(min_freq_node != NULL);
   DEBUG_ASSERT(min_freq_node->last_obj != NULL);
   DEBUG_ASSERT(min_freq_node->n_obj > 0);
@@ -321,13 +199,11 @@ static cache_obj_t *CR_LFU_to_evict(cache_t *cache, const request_t *req) {
 static void CR_LFU_evict(cache_t *cache, const request_t *req) {
   CR_LFU_params_t *params = (CR_LFU_params_t *)(cache->eviction_params);
 
-  freq_node_t *min_freq_node =
-      g_hash_table_lookup(params->freq_map, GSIZE_TO_POINTER(params->min_freq));
+  freq_node_t *min_freq_node = params->freq_buckets->head;
   DEBUG_ASSERT(min_freq_node != NULL);
   DEBUG_ASSERT(min_freq_node->last_obj != NULL);
   DEBUG_ASSERT(min_freq_node->n_obj > 0);
 
-  min_freq_node->n_obj--;
   cache_obj_t *obj_to_evict = min_freq_node->last_obj;
   copy_cache_obj_to_request(params->req_local, obj_to_evict);
 
@@ -342,44 +218,8 @@ static void CR_LFU_evict(cache_t *cache, const request_t *req) {
     obj_other_cache->CR_LFU.freq = obj_to_evict->lfu.freq;
   }
 
-  if (obj_to_evict->queue.prev == NULL) {
-    /* the only obj of curr freq */
-    DEBUG_ASSERT(min_freq_node->first_obj == obj_to_evict);
-    DEBUG_ASSERT(min_freq_node->n_obj == 0);
-    min_freq_node->first_obj = NULL;
-    min_freq_node->last_obj = NULL;
-
-    /* update min freq */
-    uint64_t old_min_freq = params->min_freq;
-    for (uint64_t freq = params->min_freq + 1; freq <= params->max_freq;
-         freq++) {
-      freq_node_t *node =
-          g_hash_table_lookup(params->freq_map, GSIZE_TO_POINTER(freq));
-      if (node != NULL && node->n_obj > 0) {
-        params->min_freq = freq;
-        break;
-      }
-    }
-    if (params->min_freq == old_min_freq) {
-      params->min_freq = -1;
-      DEBUG_ASSERT(cache->n_obj == 1);
-    } else {
-      DEBUG_ASSERT(params->min_freq > old_min_freq);
-    }
-
-  } else {
-    min_freq_node->last_obj = obj_to_evict->queue.prev;
-    obj_to_evict->queue.prev->queue.next = NULL;
-  }
+  freq_bucket_remove_obj(params->freq_buckets, obj_to_evict);
   cache_remove_obj_base(cache, obj_to_evict, true);
-
-  if (params->min_freq != -1) {
-    min_freq_node = g_hash_table_lookup(params->freq_map,
-                                        GSIZE_TO_POINTER(params->min_freq));
-    DEBUG_ASSERT(min_freq_node != NULL);
-    DEBUG_ASSERT(min_freq_node->last_obj != NULL);
-    DEBUG_ASSERT(min_freq_node->n_obj > 0);
-  }
 }
 
 static bool CR_LFU_remove(cache_t *cache, const obj_id_t obj_id) {
@@ -405,44 +245,9 @@ static bool CR_LFU_remove(cache_t *cache, const obj_id_t obj_id) {
     obj_other_cache->CR_LFU.freq = obj->lfu.freq;
   }
 
-  freq_node_t *freq_node =
-      g_hash_table_lookup(params->freq_map, GSIZE_TO_POINTER(obj->lfu.freq));
-  DEBUG_ASSERT(freq_node->freq == obj->lfu.freq);
-  DEBUG_ASSERT(freq_node->n_obj > 0);
-
-  freq_node->n_obj--;
-  remove_obj_from_list(&freq_node->first_obj, &freq_node->last_obj, obj);
-
+  freq_bucket_remove_obj(params->freq_buckets, obj);
   cache_remove_obj_base(cache, obj, true);
 
-  freq_node_t *min_freq_node =
-      g_hash_table_lookup(params->freq_map, GSIZE_TO_POINTER(params->min_freq));
-
-  if (min_freq_node->n_obj == 0) {
-    /* the only obj of min freq */
-    min_freq_node->first_obj = NULL;
-    min_freq_node->last_obj = NULL;
-
-    /* update min freq */
-    uint64_t old_min_freq = params->min_freq;
-    for (uint64_t freq = params->min_freq + 1; freq <= params->max_freq;
-         freq++) {
-      freq_node_t *node =
-          g_hash_table_lookup(params->freq_map, GSIZE_TO_POINTER(freq));
-      if (node != NULL && node->n_obj > 0) {
-        params->min_freq = freq;
-        break;
-      }
-    }
-    DEBUG_ASSERT(params->min_freq > old_min_freq);
-  }
-
-  min_freq_node =
-      g_hash_table_lookup(params->freq_map, GSIZE_TO_POINTER(params->min_freq));
-  DEBUG_ASSERT(min_freq_node != NULL);
-  DEBUG_ASSERT(min_freq_node->last_obj != NULL);
-  DEBUG_ASSERT(min_freq_node->n_obj > 0);
-
   return true;
 }
 
@@ -452,26 +257,25 @@ static bool CR_LFU_remove(cache_t *cache, const obj_id_t obj_id) {
 // ****                                                               ****
 // ***********************************************************************
 static int _verify(cache_t *cache) {
-  CR_LFU_params_t *CR_LFUDA_params =
-      (CR_LFU_params_t *)(cache->eviction_params);
+  CR_LFU_params_t *params = (CR_LFU_params_t *)(cache->eviction_params);
   cache_obj_t *cache_obj, *prev_obj;
-  /* update min freq */
-  for (uint64_t freq = 1; freq <= CR_LFUDA_params->max_freq; freq++) {
-    freq_node_t *freq_node =
-        g_hash_table_lookup(CR_LFUDA_params->freq_map, GSIZE_TO_POINTER(freq));
-    if (freq_node != NULL) {
-      uint32_t n_obj = 0;
-      cache_obj = freq_node->first_obj;
-      prev_obj = NULL;
-      while (cache_obj != NULL) {
-        n_obj++;
-        DEBUG_ASSERT(cache_obj->lfu.freq == freq);
-        DEBUG_ASSERT(cache_obj->queue.prev == prev_obj);
-        prev_obj = cache_obj;
-        cache_obj = cache_obj->queue.next;
-      }
-      DEBUG_ASSERT(freq_node->n_obj == n_obj);
+  int64_t prev_freq = 0;
+  for (freq_node_t *freq_node = params->freq_buckets->head; freq_node != NULL;
+       freq_node = freq_node->next) {
+    DEBUG_ASSERT(freq_node->freq > prev_freq);
+    prev_freq = freq_node->freq;
+    uint32_t n_obj = 0;
+    cache_obj = freq_node->first_obj;
+    prev_obj = NULL;
+    while (cache_obj != NULL) {
+      n_obj++;
+      DEBUG_ASSERT(cache_obj->lfu.freq == freq_node->freq);
+      DEBUG_ASSERT(cache_obj->lfu.freq_node == freq_node);
+      DEBUG_ASSERT(cache_obj->queue.prev == prev_obj);
+      prev_obj = cache_obj;
+      cache_obj = cache_obj->queue.next;
     }
+    DEBUG_ASSERT(freq_node->n_obj == n_obj);
   }
   return 0;
 }
@@ -1,10 +1,14 @@
-/* Cacheus: FAST'21 */
+/* Cacheus: FAST'21
+ *
+ * with ghost-fp-rate > 0, the eviction histories store fingerprints (see
+ * fingerprintGhost.h) instead of LRU caches of the evicted objects */
 
 #include "../../include/libCacheSim/evictionAlgo/Cacheus.h"
 
 #include <assert.h>
 #include <math.h>
 
+#include "../../dataStructure/fingerprintGhost.h"
 #include "../../dataStructure/hashtable/hashtable.h"
 #include "../../include/libCacheSim/evictionAlgo.h"
 
@@ -17,12 +21,17 @@ typedef struct Cacheus_params {
   cache_t *LRU_g;      // eviction history of LRU
   cache_t *LFU;        // LFU
   cache_t *LFU_g;      // eviction history of LFU
+  /* used instead of LRU_g and LFU_g if ghost_fp_rate > 0 */
+  fp_ghost_t *LRU_fp_g;
+  fp_ghost_t *LFU_fp_g;
   double w_lru;        // Weight for LRU
   double w_lfu;        // Weight for LFU
   double lr;           // learning rate
   double lr_previous;  // previous learning rate
+  double lr_discount;  // exp(-lr), updated when lr changes
 
   double ghost_list_factor;  // size(ghost_list)/size(cache), default 1
+  double ghost_fp_rate;
   int64_t unlearn_count;
 
   int64_t num_hit;
@@ -51,9 +60,11 @@ static inline int64_t Cacheus_get_occupied_byte(const cache_t *cache);
 static inline int64_t Cacheus_get_n_obj(const cache_t *cache);
 
 /* internal functions */
-static void update_weight(cache_t *cache, const request_t *req);
+static void update_weight(cache_t *cache, bool hit_lru_g, bool hit_lfu_g);
 static void update_lr(cache_t *cache, const request_t *req);
 static void check_and_update_history(cache_t *cache, const request_t *req);
+static void Cacheus_parse_params(cache_t *cache,
+                                 const char *cache_specific_params);
 
 // ***********************************************************************
 // ****                                                               ****
@@ -66,7 +77,8 @@ static void check_and_update_history(cache_t *cache, const request_t *req);
  * @brief initialize a Cacheus cache
  *
  * @param ccache_params some common cache parameters
- * @param cache_specific_params Cacheus specific parameters, should be NULL
+ * @param cache_specific_params Cacheus specific parameters, see parse_params
+ * function or use -e "print" with the cachesim binary
  */
 cache_t *Cacheus_init(const common_cache_params_t ccache_params,
                       const char *cache_specific_params) {
@@ -102,11 +114,15 @@ cache_t *Cacheus_init(const common_cache_params_t ccache_params,
   // val or diff value, the repo differs from their paper. I followed paper.
   params->lr = 0.001 + ((double)(next_rand() % 1000)) / 1000;
   params->lr_previous = 0;
+  params->lr_discount = exp(-params->lr);
 
   params->w_lru = params->w_lfu = 0.50;  // weights for LRU and LFU
   params->num_hit = 0;
   params->hit_rate_prev = 0;
   params->req_local = new_request();
+  if (cache_specific_params != NULL) {
+    Cacheus_parse_params(cache, cache_specific_params);
+  }
 
   params->LRU = SR_LRU_init(ccache_params, NULL);
   params->LFU = CR_LFU_init(ccache_params, NULL);
@@ -123,8 +139,15 @@ cache_t *Cacheus_init(const common_cache_params_t ccache_params,
   ccache_params_g.cache_size = (uint64_t)((double)ccache_params.cache_size / 2 *
                                           params->ghost_list_factor);
 
-  params->LRU_g = LRU_init(ccache_params_g, NULL);  // LRU_history
-  params->LFU_g = LRU_init(ccache_params_g, NULL);  // LFU_history
+  if (params->ghost_fp_rate > 0) {
+    params->LRU_fp_g =
+        fp_ghost_new(ccache_params_g.cache_size, params->ghost_fp_rate);
+    params->LFU_fp_g =
+        fp_ghost_new(ccache_params_g.cache_size, params->ghost_fp_rate);
+  } else {
+    params->LRU_g = LRU_init(ccache_params_g, NULL);  // LRU_history
+    params->LFU_g = LRU_init(ccache_params_g, NULL);  // LFU_history
+  }
   return cache;
 }
 
@@ -132,9 +155,14 @@ static void Cacheus_free(cache_t *cache) {
   Cacheus_params_t *params = (Cacheus_params_t *)(cache->eviction_params);
   free_request(params->req_local);
   params->LRU->cache_free(params->LRU);
-  params->LRU_g->cache_free(params->LRU_g);
   params->LFU->cache_free(params->LFU);
-  params->LFU_g->cache_free(params->LFU_g);
+  if (params->LRU_fp_g != NULL) {
+    fp_ghost_free(params->LRU_fp_g);
+    fp_ghost_free(params->LFU_fp_g);
+  } else {
+    params->LRU_g->cache_free(params->LRU_g);
+    params->LFU_g->cache_free(params->LFU_g);
+  }
   my_free(sizeof(Cacheus_params_t), params);
   cache_struct_free(cache);
 }
@@ -296,8 +324,13 @@ static void Cacheus_evict(cache_t *cache, const request_t *req) {
     bool removed = lfu->remove(lfu, params->req_local->obj_id);
     DEBUG_ASSERT(removed);
     // insert into ghost
-    bool ghost_hit = lru_g->get(lru_g, params->req_local);
-    DEBUG_ASSERT(!ghost_hit);
+    if (params->LRU_fp_g != NULL) {
+      fp_ghost_insert(params->LRU_fp_g, params->req_local->obj_id,
+                      params->req_local->obj_size);
+    } else {
+      bool ghost_hit = lru_g->get(lru_g, params->req_local);
+      DEBUG_ASSERT(!ghost_hit);
+    }
   } else {
     // Remove first because LFU needs to offload the freq to obj in LRU
     // history
@@ -307,8 +340,13 @@ static void Cacheus_evict(cache_t *cache, const request_t *req) {
     DEBUG_ASSERT(removed);
     lfu->evict(lfu, req);
     // insert into ghost
-    bool ghost_hit = lfu_g->get(lfu_g, params->req_local);
-    DEBUG_ASSERT(!ghost_hit);
+    if (params->LFU_fp_g != NULL) {
+      fp_ghost_insert(params->LFU_fp_g, params->req_local->obj_id,
+                      params->req_local->obj_size);
+    } else {
+      bool ghost_hit = lfu_g->get(lfu_g, params->req_local);
+      DEBUG_ASSERT(!ghost_hit);
+    }
   }
 
   cache->to_evict_candidate_gen_vtime = -1;
@@ -343,19 +381,13 @@ static inline int64_t Cacheus_get_n_obj(const cache_t *cache) {
 // ****                                                               ****
 // ***********************************************************************
 
-static void update_weight(cache_t *cache, const request_t *req) {
+static void update_weight(cache_t *cache, bool hit_lru_g, bool hit_lfu_g) {
   Cacheus_params_t *params = (Cacheus_params_t *)(cache->eviction_params);
-  bool cache_hit_lru_g, cache_hit_lfu_g;
 
-  cache_hit_lru_g = params->LRU_g->find(params->LRU_g, req, false) != NULL;
-  cache_hit_lfu_g = params->LFU_g->find(params->LFU_g, req, false) != NULL;
-  /* can only be evicted by one of the two experts, but is this true? (TODO) */
-  DEBUG_ASSERT((cache_hit_lru_g ? 1 : 0) + (cache_hit_lfu_g ? 1 : 0) <= 1);
-
-  if (cache_hit_lru_g) {
-    params->w_lru = params->w_lru * exp(-params->lr);  // decrease weight_LRU
-  } else if (cache_hit_lfu_g) {
-    params->w_lfu = params->w_lfu * exp(-params->lr);  // decrease weight_LFU
+  if (hit_lru_g) {
+    params->w_lru = params->w_lru * params->lr_discount;  // decrease weight_LRU
+  } else if (hit_lfu_g) {
+    params->w_lfu = params->w_lfu * params->lr_discount;  // decrease weight_LFU
   }
   // normalize
   params->w_lru = params->w_lru / (params->w_lru + params->w_lfu);
@@ -404,6 +436,7 @@ static void update_lr(cache_t *cache, const request_t *req) {
                       1000;  // learning rate chooses randomly between 10-3 & 1
     }
   }
+  params->lr_discount = exp(-params->lr);
   params->num_hit = 0;
 }
 
@@ -411,14 +444,71 @@ static void update_lr(cache_t *cache, const request_t *req) {
 static void check_and_update_history(cache_t *cache, const request_t *req) {
   Cacheus_params_t *params = (Cacheus_params_t *)(cache->eviction_params);
 
+  if (params->LRU_fp_g != NULL) {
+    /* a false positive may hit both, count it as one hit */
+    bool hit_lru_g = fp_ghost_remove(params->LRU_fp_g, req->obj_id);
+    bool hit_lfu_g =
+        !hit_lru_g && fp_ghost_remove(params->LFU_fp_g, req->obj_id);
+    update_weight(cache, hit_lru_g, hit_lfu_g);
+    return;
+  }
+
   bool hit_lru_g = params->LRU_g->find(params->LRU_g, req, false) != NULL;
   bool hit_lfu_g = params->LFU_g->find(params->LFU_g, req, false) != NULL;
+  /* can only be evicted by one of the two experts, but is this true? (TODO) */
   DEBUG_ASSERT((hit_lru_g ? 1 : 0) + (hit_lfu_g ? 1 : 0) <= 1);
 
-  update_weight(cache, req);
+  update_weight(cache, hit_lru_g, hit_lfu_g);
+
+  if (hit_lru_g) {
+    params->LRU_g->remove(params->LRU_g, req->obj_id);
+  }
+  if (hit_lfu_g) {
+    params->LFU_g->remove(params->LFU_g, req->obj_id);
+  }
+}
+
+// ***********************************************************************
+// ****                                                               ****
+// ****                parameter set up functions                     ****
+// ****                                                               ****
+// ***********************************************************************
+static const char *Cacheus_current_params(Cacheus_params_t *params) {
+  static __thread char params_str[128];
+  snprintf(params_str, 128, "ghost-fp-rate=%.4lf\n", params->ghost_fp_rate);
+  return params_str;
+}
+
+static void Cacheus_parse_params(cache_t *cache,
+                                 const char *cache_specific_params) {
+  Cacheus_params_t *params = (Cacheus_params_t *)(cache->eviction_params);
+
+  char *params_str = strdup(cache_specific_params);
+  char *old_params_str = params_str;
+
+  while (params_str != NULL && params_str[0] != '\0') {
+    /* different parameters are separated by comma,
+     * key and value are separated by = */
+    char *key = strsep((char **)&params_str, "=");
+    char *value = strsep((char **)&params_str, ",");
+
+    // skip the white space
+    while (params_str != NULL && *params_str == ' ') {
+      params_str++;
+    }
+
+    if (strcasecmp(key, "ghost-fp-rate") == 0) {
+      params->ghost_fp_rate = strtod(value, NULL);
+    } else if (strcasecmp(key, "print") == 0) {
+      printf("parameters: %s\n", Cacheus_current_params(params));
+      exit(0);
+    } else {
+      ERROR("%s does not have parameter %s\n", cache->cache_name, key);
+      exit(1);
+    }
+  }
 
-  params->LRU_g->remove(params->LRU_g, req->obj_id);
-  params->LFU_g->remove(params->LFU_g, req->obj_id);
+  free(old_params_str);
 }
 
 #ifdef __cplusplus
@@ -12,6 +12,7 @@
 
 #include "../../dataStructure/hashtable/hashtable.h"
 #include "../../include/libCacheSim/evictionAlgo.h"
+#include "../getSpecialized.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -36,6 +37,9 @@ static cache_obj_t *Clock_insert(cache_t *cache, const request_t *req);
 static cache_obj_t *Clock_to_evict(cache_t *cache, const request_t *req);
 static void Clock_evict(cache_t *cache, const request_t *req);
 static bool Clock_remove(cache_t *cache, const obj_id_t obj_id);
+static void Clock_copy_state(cache_t *cache, const cache_t *src_cache);
+
+DEFINE_CACHE_GET_SPECIALIZED(Clock, cache_can_insert_no_admissioner, cache_get_occupied_byte_default)
 
 // ***********************************************************************
 // ****                                                               ****
@@ -54,6 +58,7 @@ cache_t *Clock_init(const common_cache_params_t ccache_params, const char *cache
   cache->cache_init = Clock_init;
   cache->cache_free = Clock_free;
   cache->get = Clock_get;
+  cache->get_specialized = Clock_get_specialized;
   cache->find = Clock_find;
   cache->insert = Clock_insert;
   cache->evict = Clock_evict;
@@ -62,6 +67,7 @@ cache_t *Clock_init(const common_cache_params_t ccache_params, const char *cache
   cache->get_n_obj = cache_get_n_obj_default;
   cache->get_occupied_byte = cache_get_occupied_byte_default;
   cache->to_evict = Clock_to_evict;
+  cache->copy_state = Clock_copy_state;
   cache->obj_md_size = 0;
 
 #ifdef USE_BELADY
@@ -276,6 +282,22 @@ static bool Clock_remove(cache_t *cache, const obj_id_t obj_id) {
   return true;
 }
 
+/**
+ * @brief copy the objects (with their counters) and the clock queue from
+ * src_cache to an empty cache
+ *
+ * @param cache
+ * @param src_cache
+ */
+static void Clock_copy_state(cache_t *cache, const cache_t *src_cache) {
+  Clock_params_t *params = (Clock_params_t *)cache->eviction_params;
+  const Clock_params_t *src_params = (const Clock_params_t *)src_cache->eviction_params;
+
+  cache_copy_queue_base(cache, src_params->q_tail, &params->q_head, &params->q_tail);
+  params->n_obj_rewritten = src_params->n_obj_rewritten;
+  params->n_byte_rewritten = src_params->n_byte_rewritten;
+}
+
 // ***********************************************************************
 // ****                                                               ****
 // ****                  parameter set up functions                   ****
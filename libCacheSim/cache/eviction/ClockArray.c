@@ -0,0 +1,364 @@
+//
+//  ClockArray is Clock with the objects in an array (see clockArray.h)
+//  instead of a linked list, the counters are kept out of the objects
+//  (a bitmap for 1-bit counters, packed nibbles for 2 to 4-bit counters),
+//  and a circular hand decreases the counters in place instead of moving
+//  the objects, so finding the next object to evict reads the array and not
+//  the objects, with 1-bit counters the hand skips 64 visited or empty slots
+//  per word
+//
+//  as in the linked-list Clock (FIFO-Reinsertion), a new object is inserted
+//  right behind the hand, so the hand reaches it after the objects it has
+//  passed, and ClockArray evicts the same objects as Clock
+//
+//
+//  ClockArray.c
+//  libCacheSim
+//
+
+#include "../../dataStructure/hashtable/hashtable.h"
+#include "../../include/libCacheSim/evictionAlgo.h"
+#include "../clockArray.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  clock_array_t arr;
+
+  int32_t n_bit_counter;
+  int32_t max_freq;
+  int32_t init_freq;
+} ClockArray_params_t;
+
+static const char *DEFAULT_PARAMS = "init-freq=0,n-bit-counter=1";
+
+// ***********************************************************************
+// ****                                                               ****
+// ****                   function declarations                       ****
+// ****                                                               ****
+// ***********************************************************************
+
+static void ClockArray_parse_params(cache_t *cache, const char *cache_specific_params);
+static void ClockArray_free(cache_t *cache);
+static bool ClockArray_get(cache_t *cache, const request_t *req);
+static cache_obj_t *ClockArray_find(cache_t *cache, const request_t *req, const bool update_cache);
+static cache_obj_t *ClockArray_insert(cache_t *cache, const request_t *req);
+static cache_obj_t *ClockArray_to_evict(cache_t *cache, const request_t *req);
+static void ClockArray_evict(cache_t *cache, const request_t *req);
+static bool ClockArray_remove(cache_t *cache, const obj_id_t obj_id);
+static void ClockArray_copy_state(cache_t *cache, const cache_t *src_cache);
+
+// ***********************************************************************
+// ****                                                               ****
+// ****                   end user facing functions                   ****
+// ****                                                               ****
+// ***********************************************************************
+
+/**
+ * @brief initialize a ClockArray cache
+ *
+ * @param ccache_params some common cache parameters
+ * @param cache_specific_params ClockArray specific parameters as a string,
+ *  the same as Clock, n-bit-counter can be 1 to 4
+ */
+cache_t *ClockArray_init(const common_cache_params_t ccache_params, const char *cache_specific_params) {
+  cache_t *cache = cache_struct_init("ClockArray", ccache_params, cache_specific_params);
+  cache->cache_init = ClockArray_init;
+  cache->cache_free = ClockArray_free;
+  cache->get = ClockArray_get;
+  cache->find = ClockArray_find;
+  cache->insert = ClockArray_insert;
+  cache->evict = ClockArray_evict;
+  cache->remove = ClockArray_remove;
+  cache->can_insert = cache_can_insert_default;
+  cache->get_n_obj = cache_get_n_obj_default;
+  cache->get_occupied_byte = cache_get_occupied_byte_default;
+  cache->to_evict = ClockArray_to_evict;
+  cache->copy_state = ClockArray_copy_state;
+  cache->obj_md_size = 0;
+
+  cache->eviction_params = malloc(sizeof(ClockArray_params_t));
+  memset(cache->eviction_params, 0, sizeof(ClockArray_params_t));
+  ClockArray_params_t *params = (ClockArray_params_t *)cache->eviction_params;
+  params->n_bit_counter = 1;
+  params->max_freq = 1;
+
+  ClockArray_parse_params(cache, DEFAULT_PARAMS);
+  if (cache_specific_params != NULL) {
+    ClockArray_parse_params(cache, cache_specific_params);
+  }
+
+  if (params->init_freq > params->max_freq) {
+    ERROR("init-freq %d is larger than the max frequency %d\n", params->init_freq, params->max_freq);
+  }
+  clock_array_init(&params->arr, params->n_bit_counter, offsetof(cache_obj_t, clock_array.slot_idx));
+
+  if (params->n_bit_counter != 1) {
+    snprintf(cache->cache_name, CACHE_NAME_ARRAY_LEN, "ClockArray-%d-%d", params->n_bit_counter, params->init_freq);
+  }
+
+  return cache;
+}
+
+/**
+ * free resources used by this cache
+ *
+ * @param cache
+ */
+static void ClockArray_free(cache_t *cache) {
+  ClockArray_params_t *params = (ClockArray_params_t *)cache->eviction_params;
+  clock_array_free(&params->arr);
+  free(cache->eviction_params);
+  cache_struct_free(cache);
+}
+
+/**
+ * @brief this function is the user facing API
+ * it performs the following logic
+ *
+ * ```
+ * if obj in cache:
+ *    update_metadata
+ *    return true
+ * else:
+ *    if cache does not have enough space:
+ *        evict until it has space to insert
+ *    insert the object
+ *    return false
+ * ```
+ *
+ * @param cache
+ * @param req
+ * @return true if cache hit, false if cache miss
+ */
+static bool ClockArray_get(cache_t *cache, const request_t *req) { return cache_get_base(cache, req); }
+
+// ***********************************************************************
+// ****                                                               ****
+// ****       developer facing APIs (used by cache developer)         ****
+// ****                                                               ****
+// ***********************************************************************
+
+/**
+ * @brief check whether an object is in the cache
+ *
+ * @param cache
+ * @param req
+ * @param update_cache whether to update the cache,
+ *  if true, the object is promoted
+ *  and if the object is expired, it is removed from the cache
+ * @return true on hit, false on miss
+ */
+static cache_obj_t *ClockArray_find(cache_t *cache, const request_t *req, const bool update_cache) {
+  ClockArray_params_t *params = (ClockArray_params_t *)cache->eviction_params;
+  cache_obj_t *obj = cache_find_base(cache, req, update_cache);
+  if (obj != NULL && update_cache) {
+    int64_t idx = clock_array_get_idx(&params->arr, obj);
+    int freq = clock_array_get_counter(&params->arr, idx);
+    if (freq < params->max_freq) {
+      clock_array_set_counter(&params->arr, idx, freq + 1);
+    }
+  }
+
+  return obj;
+}
+
+/**
+ * @brief insert an object into the cache,
+ * update the hash table and cache metadata
+ * this function assumes the cache has enough space
+ * and eviction is not part of this function
+ *
+ * @param cache
+ * @param req
+ * @return the inserted object
+ */
+static cache_obj_t *ClockArray_insert(cache_t *cache, const request_t *req) {
+  ClockArray_params_t *params = (ClockArray_params_t *)cache->eviction_params;
+
+  cache_obj_t *obj = cache_insert_base(cache, req);
+  clock_array_insert_behind_hand(&params->arr, obj, params->init_freq);
+
+  return obj;
+}
+
+/**
+ * @brief find the object to be evicted
+ * this function does not actually evict the object or update metadata
+ *
+ * @param cache the cache
+ * @return the object to be evicted
+ */
+static cache_obj_t *ClockArray_to_evict(cache_t *cache, const request_t *req) {
+  ClockArray_params_t *params = (ClockArray_params_t *)cache->eviction_params;
+  clock_array_t *arr = &params->arr;
+
+  /* the counter of an object is decreased each time the hand passes it */
+  int n_round = 0;
+  int64_t start = arr->hand == CLOCK_ARRAY_INVALID_IDX ? arr->head : arr->hand;
+  int64_t idx = start;
+  while (clock_array_get_counter(arr, idx) - n_round >= 1) {
+    idx = clock_array_next_occupied(arr, idx + 1);
+    if (idx == arr->tail) {
+      idx = arr->head;
+    }
+    if (idx == start) {
+      n_round += 1;
+    }
+  }
+
+  return clock_array_get(arr, idx);
+}
+
+/**
+ * @brief evict an object from the cache
+ * it needs to call cache_evict_base before returning
+ * which updates some metadata such as n_obj, occupied size, and hash table
+ *
+ * the hand moves from the oldest to the newest slot and wraps around,
+ * it decreases the non-zero counters it passes and evicts the first object
+ * with a zero counter
+ *
+ * @param cache
+ * @param req not used
+ */
+static void ClockArray_evict(cache_t *cache, const request_t *req) {
+  ClockArray_params_t *params = (ClockArray_params_t *)cache->eviction_params;
+  clock_array_t *arr = &params->arr;
+
+  int64_t start = arr->hand == CLOCK_ARRAY_INVALID_IDX ? arr->head : arr->hand;
+  int64_t idx;
+  if (params->n_bit_counter == 1) {
+    idx = clock_array_next_unvisited(arr, start, true);
+    if (idx == arr->tail) {
+      /* all objects from the hand are visited, the hand clears the bits and
+       * comes back */
+      idx = clock_array_next_unvisited(arr, arr->head, true);
+    }
+  } else {
+    idx = start;
+    int freq = clock_array_get_counter(arr, idx);
+    while (freq >= 1) {
+      clock_array_set_counter(arr, idx, freq - 1);
+      idx = clock_array_next_occupied(arr, idx + 1);
+      if (idx == arr->tail) {
+        idx = arr->head;
+      }
+      freq = clock_array_get_counter(arr, idx);
+    }
+  }
+
+  cache_obj_t *obj_to_evict = clock_array_get(arr, idx);
+  /* removing the object moves the hand to the next object */
+  arr->hand = idx;
+  clock_array_remove(arr, obj_to_evict);
+  cache_evict_base(cache, obj_to_evict, true);
+}
+
+/**
+ * @brief remove the given object from the cache
+ *
+ * @param cache
+ * @param obj
+ */
+static void ClockArray_remove_obj(cache_t *cache, cache_obj_t *obj) {
+  ClockArray_params_t *params = (ClockArray_params_t *)cache->eviction_params;
+
+  DEBUG_ASSERT(obj != NULL);
+  clock_array_remove(&params->arr, obj);
+  cache_remove_obj_base(cache, obj, true);
+}
+
+/**
+ * @brief remove an object from the cache
+ * this is different from cache_evict because it is used to for user trigger
+ * remove, and eviction is used by the cache to make space for new objects
+ *
+ * @param cache
+ * @param obj_id
+ * @return true if the object is removed, false if the object is not in the
+ * cache
+ */
+static bool ClockArray_remove(cache_t *cache, const obj_id_t obj_id) {
+  cache_obj_t *obj = hashtable_find_obj_id(cache->hashtable, obj_id);
+  if (obj == NULL) {
+    return false;
+  }
+
+  ClockArray_remove_obj(cache, obj);
+
+  return true;
+}
+
+/**
+ * @brief copy the objects, their counters and the hand from src_cache to an
+ * empty cache
+ *
+ * @param cache
+ * @param src_cache
+ */
+static void ClockArray_copy_state(cache_t *cache, const cache_t *src_cache) {
+  ClockArray_params_t *params = (ClockArray_params_t *)cache->eviction_params;
+  const ClockArray_params_t *src_params = (const ClockArray_params_t *)src_cache->eviction_params;
+  DEBUG_ASSERT(params->n_bit_counter == src_params->n_bit_counter);
+
+  clock_array_copy(cache, &params->arr, &src_params->arr);
+}
+
+// ***********************************************************************
+// ****                                                               ****
+// ****                  parameter set up functions                   ****
+// ****                                                               ****
+// ***********************************************************************
+static const char *ClockArray_current_params(cache_t *cache, ClockArray_params_t *params) {
+  static __thread char params_str[128];
+  snprintf(params_str, 128, "n-bit-counter=%d,init-freq=%d\n", params->n_bit_counter, params->init_freq);
+
+  return params_str;
+}
+
+static void ClockArray_parse_params(cache_t *cache, const char *cache_specific_params) {
+  ClockArray_params_t *params = (ClockArray_params_t *)cache->eviction_params;
+  char *params_str = strdup(cache_specific_params);
+  char *old_params_str = params_str;
+  char *end;
+
+  while (params_str != NULL && params_str[0] != '\0') {
+    /* different parameters are separated by comma,
+     * key and value are separated by = */
+    char *key = strsep((char **)&params_str, "=");
+    char *value = strsep((char **)&params_str, ",");
+
+    // skip the white space
+    while (params_str != NULL && *params_str == ' ') {
+      params_str++;
+    }
+
+    if (strcasecmp(key, "n-bit-counter") == 0) {
+      params->n_bit_counter = (int)strtol(value, &end, 0);
+      params->max_freq = (1 << params->n_bit_counter) - 1;
+      if (strlen(end) > 2) {
+        ERROR("param parsing error, find string \"%s\" after number\n", end);
+      }
+    } else if (strcasecmp(key, "init-freq") == 0) {
+      params->init_freq = (int)strtol(value, &end, 0);
+      if (strlen(end) > 2) {
+        ERROR("param parsing error, find string \"%s\" after number\n", end);
+      }
+    } else if (strcasecmp(key, "print") == 0) {
+      printf("current parameters: %s\n", ClockArray_current_params(cache, params));
+      exit(0);
+    } else {
+      ERROR("%s does not have parameter %s, example parameters %s\n", cache->cache_name, key,
+            ClockArray_current_params(cache, params));
+      exit(1);
+    }
+  }
+  free(old_params_str);
+}
+
+#ifdef __cplusplus
+}
+#endif
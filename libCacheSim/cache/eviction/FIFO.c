@@ -11,6 +11,7 @@
 
 #include "../../dataStructure/hashtable/hashtable.h"
 #include "../../include/libCacheSim/evictionAlgo.h"
+#include "../getSpecialized.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -32,6 +33,10 @@ static cache_obj_t *FIFO_insert(cache_t *cache, const request_t *req);
 static cache_obj_t *FIFO_to_evict(cache_t *cache, const request_t *req);
 static void FIFO_evict(cache_t *cache, const request_t *req);
 static bool FIFO_remove(cache_t *cache, const obj_id_t obj_id);
+static void FIFO_copy_state(cache_t *cache, const cache_t *src_cache);
+
+DEFINE_CACHE_GET_SPECIALIZED(FIFO, cache_can_insert_no_admissioner,
+                             cache_get_occupied_byte_default)
 
 // ***********************************************************************
 // ****                                                               ****
@@ -52,11 +57,13 @@ cache_t *FIFO_init(const common_cache_params_t ccache_params,
   cache->cache_init = FIFO_init;
   cache->cache_free = FIFO_free;
   cache->get = FIFO_get;
+  cache->get_specialized = FIFO_get_specialized;
   cache->find = FIFO_find;
   cache->insert = FIFO_insert;
   cache->evict = FIFO_evict;
   cache->remove = FIFO_remove;
   cache->to_evict = FIFO_to_evict;
+  cache->copy_state = FIFO_copy_state;
   cache->get_occupied_byte = cache_get_occupied_byte_default;
   cache->get_n_obj = cache_get_n_obj_default;
   cache->can_insert = cache_can_insert_default;
@@ -214,6 +221,19 @@ static bool FIFO_remove(cache_t *cache, const obj_id_t obj_id) {
   return true;
 }
 
+/**
+ * @brief copy the objects and the FIFO queue from src_cache to an empty cache
+ *
+ * @param cache
+ * @param src_cache
+ */
+static void FIFO_copy_state(cache_t *cache, const cache_t *src_cache) {
+  FIFO_params_t *params = (FIFO_params_t *)cache->eviction_params;
+  const FIFO_params_t *src_params = (const FIFO_params_t *)src_cache->eviction_params;
+
+  cache_copy_queue_base(cache, src_params->q_tail, &params->q_head, &params->q_tail);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -43,6 +43,7 @@ static void set_default_params(GLCache_params_t *params) {
   params->merge_consecutive_segs = true;
   params->retrain_intvl = 86400;
   params->train_source_y = TRAIN_Y_FROM_ONLINE;
+  params->train_mode = TRAIN_MODE_SYNC;
   params->type = LOGCACHE_LEARNED;
 
   params->curr_evict_bucket_idx = 0;
@@ -53,7 +54,7 @@ const char *GLCache_default_params(void) {
   return "segment-size=100, n-merge=2, "
          "type=learned, rank-intvl=0.02,"
          "merge-consecutive-segs=true, train-source-y=online,"
-         "retrain-intvl=86400";
+         "retrain-intvl=86400, train-mode=sync";
 }
 
 static void GLCache_parse_init_params(const char *cache_specific_params,
@@ -85,6 +86,18 @@ static void GLCache_parse_init_params(const char *cache_specific_params,
         ERROR("Unknown train-source-y %s, support online/oracle\n", value);
         exit(1);
       }
+    } else if (strcasecmp(key, "train-mode") == 0) {
+      if (strcasecmp(value, "sync") == 0) {
+        params->train_mode = TRAIN_MODE_SYNC;
+      } else if (strcasecmp(value, "async") == 0) {
+        params->train_mode = TRAIN_MODE_ASYNC;
+      } else if (strcasecmp(value, "deterministic") == 0) {
+        params->train_mode = TRAIN_MODE_DETERMINISTIC;
+      } else {
+        ERROR("Unknown train-mode %s, support sync/async/deterministic\n",
+              value);
+        exit(1);
+      }
     } else if (strcasecmp(key, "type") == 0) {
       if (strcasecmp(value, "learned") == 0) {
         params->type = LOGCACHE_LEARNED;
@@ -206,6 +219,8 @@ cache_t *GLCache_init(const common_cache_params_t ccache_params,
  */
 static void GLCache_free(cache_t *cache) {
   GLCache_params_t *params = cache->eviction_params;
+  stop_training(cache);
+
   bucket_t *bkt = &params->train_bucket;
   segment_t *seg = bkt->first_seg, *next_seg;
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <pthread.h>
 #include <xgboost/c_api.h>
 
 #include "../../../include/libCacheSim/cache.h"
@@ -31,6 +32,14 @@ typedef enum training_source {
   TRAIN_Y_FROM_ORACLE,
 } train_source_e;
 
+typedef enum training_mode {
+  TRAIN_MODE_SYNC,  // train in the request path
+  TRAIN_MODE_ASYNC, // train in a background thread, use the model when ready
+  // train in a background thread, but wait for the model at the first time
+  // it is needed, so the result is the same as TRAIN_MODE_SYNC
+  TRAIN_MODE_DETERMINISTIC,
+} train_mode_e;
+
 typedef struct {
   /* rolling stat on hits,
    * number of hits in the N_FEATURE_TIME_WINDOW min, 10min, hour */
@@ -73,6 +82,17 @@ typedef struct learner {
   int32_t valid_matrix_n_row;
   int32_t inf_matrix_n_row;
 
+  /* background training, the model being trained and its data,
+   * the booster in use is replaced when trainer_done is set */
+  pthread_t trainer;
+  bool trainer_running;
+  bool trainer_done;
+  BoosterHandle next_booster;
+  DMatrixHandle next_train_dm;
+  DMatrixHandle next_valid_dm;
+  unsigned int next_n_train_samples;
+  unsigned int next_n_valid_samples;
+  int next_n_trees;
 } learner_t;
 
 typedef struct cache_state {
@@ -181,6 +201,7 @@ typedef struct {
   bool merge_consecutive_segs;
   int retrain_intvl;
   train_source_e train_source_y;
+  train_mode_e train_mode;
   GLCache_type_e type;
   double rank_intvl;
 
@@ -279,6 +300,10 @@ void seg_hit_update(GLCache_params_t *params, cache_obj_t *cache_obj);
 /************* learning *****************/
 void train(cache_t *cache);
 
+void wait_for_training(cache_t *cache, bool block);
+
+void stop_training(cache_t *cache);
+
 void inference(cache_t *cache);
 
 /************* data preparation *****************/
@@ -8,6 +8,15 @@
 bucket_t *select_segs_to_evict(cache_t *cache, segment_t **segs) {
   GLCache_params_t *params = cache->eviction_params;
 
+  if (params->type == LOGCACHE_ITEM_ORACLE ||
+      params->type == LOGCACHE_LEARNED) {
+    /* pick up the model trained in the background, the deterministic mode
+     * waits for the first model because it decides whether segments are
+     * selected by FIFO or by the model */
+    wait_for_training(cache, params->train_mode == TRAIN_MODE_DETERMINISTIC &&
+                                 params->learner.n_train <= 0);
+  }
+
   if (params->type == LOGCACHE_ITEM_ORACLE) {
     if (params->learner.n_train <= 0) {
       return select_segs_fifo(cache, segs);
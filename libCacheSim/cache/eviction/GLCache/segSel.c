@@ -94,6 +94,7 @@ void rank_segs(cache_t *cache) {
 
   if (params->type == LOGCACHE_LEARNED ||
       params->type == LOGCACHE_ITEM_ORACLE) {
+    wait_for_training(cache, params->train_mode == TRAIN_MODE_DETERMINISTIC);
     inference(cache);
   } else {
     int n_segs = 0;
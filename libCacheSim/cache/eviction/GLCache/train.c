@@ -19,54 +19,39 @@ static void debug_print_feature_matrix(const DMatrixHandle handle,
   printf("\n");
 }
 
-static void train_xgboost(cache_t *cache) {
-  GLCache_params_t *params = cache->eviction_params;
-  learner_t *learner = &params->learner;
-
-  if (learner->n_train != 0) {
-    safe_call(XGBoosterFree(learner->booster));
-    safe_call(XGDMatrixFree(learner->train_dm));
-    safe_call(XGDMatrixFree(learner->valid_dm));
-  }
-
-  prepare_training_data(cache);
-  // debug_print_feature_matrix(learner->train_dm, 20);
-
-  DMatrixHandle eval_dmats[2] = {learner->train_dm, learner->valid_dm};
+/* train a model on the given data, this does not use the cache so that it can
+ * run in the background trainer */
+static BoosterHandle fit_booster(DMatrixHandle train_dm, DMatrixHandle valid_dm,
+                                 unsigned int n_valid_samples, int *n_trees) {
+  BoosterHandle booster;
+  DMatrixHandle eval_dmats[2] = {train_dm, valid_dm};
   static const char *eval_names[2] = {"train", "valid"};
   const char *eval_result;
   double train_loss, valid_loss, last_valid_loss = 0;
   int n_stable_iter = 0;
 
-  safe_call(XGBoosterCreate(eval_dmats, 1, &learner->booster));
-  safe_call(XGBoosterSetParam(learner->booster, "booster", "gbtree"));
-  safe_call(XGBoosterSetParam(learner->booster, "verbosity", "1"));
-  safe_call(XGBoosterSetParam(learner->booster, "nthread", "1"));
+  safe_call(XGBoosterCreate(eval_dmats, 1, &booster));
+  safe_call(XGBoosterSetParam(booster, "booster", "gbtree"));
+  safe_call(XGBoosterSetParam(booster, "verbosity", "1"));
+  safe_call(XGBoosterSetParam(booster, "nthread", "1"));
 #if OBJECTIVE == REG
-  safe_call(
-      XGBoosterSetParam(learner->booster, "objective", "reg:squarederror"));
+  safe_call(XGBoosterSetParam(booster, "objective", "reg:squarederror"));
 #elif OBJECTIVE == LTR
-  safe_call(XGBoosterSetParam(learner->booster, "objective", "rank:pairwise"));
+  safe_call(XGBoosterSetParam(booster, "objective", "rank:pairwise"));
 #endif
 
   for (int i = 0; i < N_TRAIN_ITER; ++i) {
     // Update the model performance for each iteration
-    safe_call(XGBoosterUpdateOneIter(learner->booster, i, learner->train_dm));
-    if (learner->n_valid_samples < 10) continue;
-    safe_call(XGBoosterEvalOneIter(learner->booster, i, eval_dmats, eval_names,
-                                   2, &eval_result));
+    safe_call(XGBoosterUpdateOneIter(booster, i, train_dm));
+    if (n_valid_samples < 10) continue;
+    safe_call(XGBoosterEvalOneIter(booster, i, eval_dmats, eval_names, 2,
+                                   &eval_result));
 #if OBJECTIVE == REG
     char *train_pos = strstr(eval_result, "train-rmse:") + 11;
     char *valid_pos = strstr(eval_result, "valid-rmse") + 11;
     train_loss = strtof(train_pos, NULL);
     valid_loss = strtof(valid_pos, NULL);
 
-    // DEBUG("%.2lf hour, cache size %.2lf MB, iter %d, train loss %.4lf, valid
-    // loss %.4lf\n",
-    //     (double) params->curr_rtime / 3600.0,
-    //     (double) cache->cache_size / 1024.0 / 1024.0,
-    //     i, train_loss, valid_loss);
-
     if (fabs(last_valid_loss - valid_loss) / valid_loss < 0.01) {
       n_stable_iter += 1;
       if (n_stable_iter > 2) {
@@ -85,16 +70,24 @@ static void train_xgboost(cache_t *cache) {
 #endif
   }
 #ifndef __APPLE__
-  safe_call(XGBoosterBoostedRounds(learner->booster, &learner->n_trees));
+  safe_call(XGBoosterBoostedRounds(booster, n_trees));
 #endif
 
+  return booster;
+}
+
+/* called when a new model replaces the one in use */
+static void model_updated(cache_t *cache) {
+  GLCache_params_t *params = cache->eviction_params;
+  learner_t *learner = &params->learner;
+
   DEBUG(
       "%.2lf hour, cache size %.2lf MB, vtime %ld, train/valid %d/%d samples, "
       "%d trees, "
       "rank intvl %.4lf\n",
       (double)params->curr_rtime / 3600.0,
       (double)cache->cache_size / 1024.0 / 1024.0, (long)params->curr_vtime,
-      (int)learner->n_train_samples, (int)learner->n_valid_samples,
+      (int)learner->next_n_train_samples, (int)learner->next_n_valid_samples,
       learner->n_trees, params->rank_intvl);
 
 #ifdef DUMP_MODEL
@@ -105,6 +98,123 @@ static void train_xgboost(cache_t *cache) {
     INFO("dump model %s\n", s);
   }
 #endif
+
+  learner->n_train += 1;
+}
+
+static void train_xgboost(cache_t *cache) {
+  GLCache_params_t *params = cache->eviction_params;
+  learner_t *learner = &params->learner;
+
+  if (learner->n_train != 0) {
+    safe_call(XGBoosterFree(learner->booster));
+    safe_call(XGDMatrixFree(learner->train_dm));
+    safe_call(XGDMatrixFree(learner->valid_dm));
+  }
+
+  prepare_training_data(cache);
+  // debug_print_feature_matrix(learner->train_dm, 20);
+
+  learner->booster =
+      fit_booster(learner->train_dm, learner->valid_dm,
+                  learner->n_valid_samples, &learner->n_trees);
+
+  learner->next_n_train_samples = learner->n_train_samples;
+  learner->next_n_valid_samples = learner->n_valid_samples;
+  model_updated(cache);
+}
+
+static void *trainer_thread(void *arg) {
+  learner_t *learner = arg;
+
+  learner->next_booster =
+      fit_booster(learner->next_train_dm, learner->next_valid_dm,
+                  learner->next_n_valid_samples, &learner->next_n_trees);
+  __atomic_store_n(&learner->trainer_done, true, __ATOMIC_RELEASE);
+
+  return NULL;
+}
+
+/**
+ * @brief prepare the training data in the request path and train the model in
+ * a background thread, the data is copied into the DMatrix so the cache can
+ * take the next snapshot while the model is trained
+ */
+static void start_training(cache_t *cache) {
+  GLCache_params_t *params = cache->eviction_params;
+  learner_t *learner = &params->learner;
+
+  /* one model is trained at a time */
+  wait_for_training(cache, true);
+
+  /* the data of the model in use is kept until the model is replaced */
+  DMatrixHandle train_dm = learner->train_dm;
+  DMatrixHandle valid_dm = learner->valid_dm;
+  prepare_training_data(cache);
+  learner->next_train_dm = learner->train_dm;
+  learner->next_valid_dm = learner->valid_dm;
+  learner->next_n_train_samples = learner->n_train_samples;
+  learner->next_n_valid_samples = learner->n_valid_samples;
+  learner->train_dm = train_dm;
+  learner->valid_dm = valid_dm;
+
+  learner->trainer_done = false;
+  if (pthread_create(&learner->trainer, NULL, trainer_thread, learner) != 0) {
+    ERROR("fail to create GLCache trainer thread\n");
+    abort();
+  }
+  learner->trainer_running = true;
+}
+
+/**
+ * @brief replace the model in use with the model trained in the background
+ *
+ * @param cache
+ * @param block whether to wait for the model if it is not ready,
+ *  if false, the current model is used until the new one is ready
+ */
+void wait_for_training(cache_t *cache, bool block) {
+  GLCache_params_t *params = cache->eviction_params;
+  learner_t *learner = &params->learner;
+
+  if (!learner->trainer_running) return;
+  if (!block && !__atomic_load_n(&learner->trainer_done, __ATOMIC_ACQUIRE)) {
+    return;
+  }
+
+  pthread_join(learner->trainer, NULL);
+  learner->trainer_running = false;
+
+  if (learner->n_train != 0) {
+    safe_call(XGBoosterFree(learner->booster));
+    safe_call(XGDMatrixFree(learner->train_dm));
+    safe_call(XGDMatrixFree(learner->valid_dm));
+  }
+  learner->booster = learner->next_booster;
+  learner->train_dm = learner->next_train_dm;
+  learner->valid_dm = learner->next_valid_dm;
+  learner->n_trees = learner->next_n_trees;
+  learner->next_booster = NULL;
+
+  model_updated(cache);
+}
+
+/**
+ * @brief wait for the background trainer and free the model it trained,
+ * used when the cache is freed
+ */
+void stop_training(cache_t *cache) {
+  GLCache_params_t *params = cache->eviction_params;
+  learner_t *learner = &params->learner;
+
+  if (!learner->trainer_running) return;
+
+  pthread_join(learner->trainer, NULL);
+  learner->trainer_running = false;
+  safe_call(XGBoosterFree(learner->next_booster));
+  safe_call(XGDMatrixFree(learner->next_train_dm));
+  safe_call(XGDMatrixFree(learner->next_valid_dm));
+  learner->next_booster = NULL;
 }
 
 void train(cache_t *cache) {
@@ -120,12 +230,15 @@ void train(cache_t *cache) {
     INFO("Load model %s\n", s);
   }
 #else
-  train_xgboost(cache);
+  if (params->train_mode == TRAIN_MODE_SYNC) {
+    train_xgboost(cache);
+  } else {
+    start_training(cache);
+  }
 #endif
 
   uint64_t end_time = gettime_usec();
   // INFO("training time %.4lf sec\n", (end_time - start_time) / 1000000.0);
-  params->learner.n_train += 1;
   params->learner.last_train_rtime = params->curr_rtime;
   params->learner.n_train_samples = 0;
   params->learner.n_valid_samples = 0;
@@ -2,6 +2,7 @@
 
 #include "../../dataStructure/hashtable/hashtable.h"
 #include "../../include/libCacheSim/evictionAlgo.h"
+#include "../candidateArray.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -9,6 +10,8 @@ extern "C" {
 
 typedef struct Hyperbolic_params {
   int n_sample;
+  candidate_array_t candidates;
+  cache_obj_t **sampled_objs;
 } Hyperbolic_params_t;
 
 // ***********************************************************************
@@ -42,11 +45,7 @@ static bool Hyperbolic_remove(cache_t *cache, const obj_id_t obj_id);
  */
 cache_t *Hyperbolic_init(const common_cache_params_t ccache_params,
                          const char *cache_specific_params) {
-  // reduce hash table size to make sampling faster
-  common_cache_params_t ccache_params_local = ccache_params;
-  ccache_params_local.hashpower = MAX(12, ccache_params_local.hashpower - 8);
-
-  cache_t *cache = cache_struct_init("Hyperbolic", ccache_params_local, cache_specific_params);
+  cache_t *cache = cache_struct_init("Hyperbolic", ccache_params, cache_specific_params);
   cache->cache_init = Hyperbolic_init;
   cache->cache_free = Hyperbolic_free;
   cache->get = Hyperbolic_get;
@@ -63,6 +62,9 @@ cache_t *Hyperbolic_init(const common_cache_params_t ccache_params,
   if (cache_specific_params != NULL) {
     Hyperbolic_parse_params(cache, cache_specific_params);
   }
+  candidate_array_init(&params->candidates,
+                       offsetof(cache_obj_t, hyperbolic.sample_idx));
+  params->sampled_objs = malloc(sizeof(cache_obj_t *) * params->n_sample);
 
   if (ccache_params.consider_obj_metadata) {
     // freq + age
@@ -81,6 +83,8 @@ cache_t *Hyperbolic_init(const common_cache_params_t ccache_params,
  */
 static void Hyperbolic_free(cache_t *cache) {
   Hyperbolic_params_t *params = cache->eviction_params;
+  candidate_array_free(&params->candidates);
+  free(params->sampled_objs);
   my_free(sizeof(Hyperbolic_params_t), params);
   cache_struct_free(cache);
 }
@@ -147,9 +151,11 @@ static cache_obj_t *Hyperbolic_find(cache_t *cache, const request_t *req,
  * @return the inserted object
  */
 static cache_obj_t *Hyperbolic_insert(cache_t *cache, const request_t *req) {
+  Hyperbolic_params_t *params = cache->eviction_params;
   cache_obj_t *cached_obj = cache_insert_base(cache, req);
   cached_obj->hyperbolic.freq = 1;
   cached_obj->hyperbolic.vtime_enter_cache = cache->n_req;
+  candidate_array_add(&params->candidates, cached_obj);
 
   return cached_obj;
 }
@@ -168,8 +174,10 @@ static cache_obj_t *Hyperbolic_to_evict(cache_t *cache, const request_t *req) {
   Hyperbolic_params_t *params = cache->eviction_params;
   cache_obj_t *best_candidate = NULL, *sampled_obj;
   double best_candidate_score = 1.0e16, sampled_obj_score;
+  candidate_array_sample(&params->candidates, params->n_sample,
+                         params->sampled_objs);
   for (int i = 0; i < params->n_sample; i++) {
-    sampled_obj = hashtable_rand_obj(cache->hashtable);
+    sampled_obj = params->sampled_objs[i];
     double age =
         (double)(cache->n_req - sampled_obj->hyperbolic.vtime_enter_cache);
     sampled_obj_score = 1.0e8 * (double)sampled_obj->hyperbolic.freq / age;
@@ -209,10 +217,15 @@ static void Hyperbolic_evict(cache_t *cache,
     WARN("no object can be evicted\n");
   }
 
+  Hyperbolic_params_t *params = cache->eviction_params;
+  candidate_array_remove(&params->candidates, obj_to_evict);
+
   cache_evict_base(cache, obj_to_evict, true);
 }
 
 static void Hyperbolic_remove_obj(cache_t *cache, cache_obj_t *obj) {
+  Hyperbolic_params_t *params = cache->eviction_params;
+  candidate_array_remove(&params->candidates, obj);
   cache_remove_obj_base(cache, obj, true);
 }
 
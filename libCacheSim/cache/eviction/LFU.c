@@ -14,8 +14,8 @@
  * this implementation uses FIFO to evict objects with the same frequency
  *
  *
- * this module uses linkedList to order requests by frequency,
- * which gives an O(1) time complexity at each request,
+ * this module uses linkedList to order requests by frequency (see
+ * freqBucket.h), which gives an O(1) time complexity at each request,
  * the drawback of this implementation is the memory usage, because two pointers
  * are associated with each obj_id
  *
@@ -23,20 +23,16 @@
  * cache so objects are inserted with frequency 1
  */
 
-#include <glib.h>
-
 #include "../../dataStructure/hashtable/hashtable.h"
 #include "../../include/libCacheSim/evictionAlgo.h"
+#include "../freqBucket.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 typedef struct LFU_params {
-  freq_node_t *freq_one_node;
-  GHashTable *freq_map;
-  uint64_t min_freq;
-  uint64_t max_freq;
+  freq_bucket_list_t freq_buckets;
 } LFU_params_t;
 
 // ***********************************************************************
@@ -55,11 +51,6 @@ static void LFU_evict(cache_t *cache, const request_t *req);
 static bool LFU_remove(cache_t *cache, const obj_id_t obj_id);
 static void LFU_remove_obj(cache_t *cache, cache_obj_t *obj);
 
-/* internal functions */
-static inline void free_freq_node(void *list_node);
-static inline freq_node_t *get_min_freq_node(LFU_params_t *params);
-static inline void update_min_freq(LFU_params_t *params);
-
 // ***********************************************************************
 // ****                                                               ****
 // ****                   end user facing functions                   ****
@@ -94,20 +85,7 @@ cache_t *LFU_init(const common_cache_params_t ccache_params,
   LFU_params_t *params = my_malloc_n(LFU_params_t, 1);
   memset(params, 0, sizeof(LFU_params_t));
   cache->eviction_params = params;
-
-  freq_node_t *freq_node = my_malloc_n(freq_node_t, 1);
-  freq_node->freq = 1;
-  freq_node->n_obj = 0;
-  freq_node->first_obj = NULL;
-  freq_node->last_obj = NULL;
-
-  params->freq_map = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
-                                           (GDestroyNotify)free_freq_node);
-  g_hash_table_insert(params->freq_map, GSIZE_TO_POINTER(1), freq_node);
-
-  params->min_freq = 1;
-  params->max_freq = 1;
-  params->freq_one_node = freq_node;
+  freq_bucket_list_init(&params->freq_buckets);
 
   return cache;
 }
@@ -119,7 +97,7 @@ cache_t *LFU_init(const common_cache_params_t ccache_params,
  */
 static void LFU_free(cache_t *cache) {
   LFU_params_t *params = (LFU_params_t *)(cache->eviction_params);
-  g_hash_table_destroy(params->freq_map);
+  freq_bucket_list_free(&params->freq_buckets);
   my_free(sizeof(LFU_params_t), params);
   cache_struct_free(cache);
 }
@@ -170,50 +148,15 @@ static cache_obj_t *LFU_find(cache_t *cache, const request_t *req,
 
   if (cache_obj && likely(update_cache)) {
     /* freq incr and move to next freq node */
+    freq_node_t *old_node = cache_obj->lfu.freq_node;
+    DEBUG_ASSERT(old_node->freq == cache_obj->lfu.freq);
     cache_obj->lfu.freq += 1;
-    if (params->max_freq < cache_obj->lfu.freq) {
-      params->max_freq = cache_obj->lfu.freq;
-    }
-
-    // find the freq_node this object belongs to and update its info
-    gpointer old_key = GSIZE_TO_POINTER(cache_obj->lfu.freq - 1);
-    freq_node_t *old_node = g_hash_table_lookup(params->freq_map, old_key);
-    DEBUG_ASSERT(old_node != NULL);
-    DEBUG_ASSERT(old_node->freq == cache_obj->lfu.freq - 1);
-    DEBUG_ASSERT(old_node->n_obj > 0);
-    old_node->n_obj -= 1;
-    remove_obj_from_list(&old_node->first_obj, &old_node->last_obj, cache_obj);
-
-    // find the new freq_node this object should move to
-    gpointer new_key = GSIZE_TO_POINTER(cache_obj->lfu.freq);
-    freq_node_t *new_node = g_hash_table_lookup(params->freq_map, new_key);
-    if (new_node == NULL) {
-      new_node = my_malloc_n(freq_node_t, 1);
-      memset(new_node, 0, sizeof(freq_node_t));
-      new_node->freq = cache_obj->lfu.freq;
-      g_hash_table_insert(params->freq_map, new_key, new_node);
-      VVVERBOSE("allocate new %ld %d %p %p\n", new_node->freq, new_node->n_obj,
-                new_node->first_obj, new_node->last_obj);
-    } else {
-      // it could be new_node is empty
-      DEBUG_ASSERT(new_node->freq == cache_obj->lfu.freq);
-    }
-
-    append_obj_to_tail(&new_node->first_obj, &new_node->last_obj, cache_obj);
-    new_node->n_obj += 1;
 
-    if (old_node->n_obj == 0) {
-      if (params->min_freq == old_node->freq) {
-        // if the old freq_node has one object and is the min_freq_node, after
-        // removing this object, the freq_node will have no object,
-        // then we should update min_freq to the new freq
-        update_min_freq(params);
-      }
-
-      if (old_node->freq != 1) {
-        g_hash_table_remove(params->freq_map, old_key);
-      }
-    }
+    // the next freq node is either the neighbor or a new node after it
+    freq_node_t *new_node = freq_bucket_find_or_create(
+        &params->freq_buckets, old_node, cache_obj->lfu.freq);
+    freq_bucket_remove_obj(&params->freq_buckets, cache_obj);
+    freq_bucket_add_obj(new_node, cache_obj);
   }
   return cache_obj;
 }
@@ -230,15 +173,12 @@ static cache_obj_t *LFU_find(cache_t *cache, const request_t *req,
  */
 static cache_obj_t *LFU_insert(cache_t *cache, const request_t *req) {
   LFU_params_t *params = (LFU_params_t *)(cache->eviction_params);
-  params->min_freq = 1;
-  freq_node_t *freq_one_node = params->freq_one_node;
+  freq_node_t *freq_one_node =
+      freq_bucket_find_or_create(&params->freq_buckets, NULL, 1);
 
   cache_obj_t *cache_obj = cache_insert_base(cache, req);
   cache_obj->lfu.freq = 1;
-  freq_one_node->n_obj += 1;
-
-  append_obj_to_tail(&freq_one_node->first_obj, &freq_one_node->last_obj,
-                     cache_obj);
+  freq_bucket_add_obj(freq_one_node, cache_obj);
 
   return cache_obj;
 }
@@ -255,7 +195,8 @@ static cache_obj_t *LFU_insert(cache_t *cache, const request_t *req) {
  */
 static cache_obj_t *LFU_to_evict(cache_t *cache, const request_t *req) {
   LFU_params_t *params = (LFU_params_t *)(cache->eviction_params);
-  freq_node_t *min_freq_node = get_min_freq_node(params);
+  freq_node_t *min_freq_node = params->freq_buckets.head;
+  DEBUG_ASSERT(min_freq_node != NULL && min_freq_node->n_obj > 0);
   return min_freq_node->first_obj;
 }
 
@@ -270,23 +211,8 @@ static cache_obj_t *LFU_to_evict(cache_t *cache, const request_t *req) {
 static void LFU_evict(cache_t *cache, const request_t *req) {
   LFU_params_t *params = (LFU_params_t *)(cache->eviction_params);
 
-  freq_node_t *min_freq_node = get_min_freq_node(params);
-  min_freq_node->n_obj--;
-
-  cache_obj_t *obj_to_evict = min_freq_node->first_obj;
-
-  remove_obj_from_list(&min_freq_node->first_obj, &min_freq_node->last_obj,
-                       obj_to_evict);
-  if (min_freq_node->n_obj == 0) {
-    /* the only obj of curr freq */
-    DEBUG_ASSERT(min_freq_node->first_obj == NULL);
-    DEBUG_ASSERT(min_freq_node->last_obj == NULL);
-
-    // we delay the min_freq update to next eviction
-    params->min_freq = 0;
-    // /* update min freq */
-    // update_min_freq(params);
-  }
+  cache_obj_t *obj_to_evict = LFU_to_evict(cache, req);
+  freq_bucket_remove_obj(&params->freq_buckets, obj_to_evict);
 
   cache_evict_base(cache, obj_to_evict, true);
 }
@@ -295,20 +221,9 @@ void LFU_remove_obj(cache_t *cache, cache_obj_t *obj) {
   assert(obj != NULL);
   LFU_params_t *params = (LFU_params_t *)(cache->eviction_params);
 
-  gpointer key = GSIZE_TO_POINTER(obj->lfu.freq);
-  freq_node_t *freq_node = g_hash_table_lookup(params->freq_map, key);
-  DEBUG_ASSERT(freq_node->freq == obj->lfu.freq);
-  DEBUG_ASSERT(freq_node->n_obj > 0);
-
-  freq_node->n_obj--;
-  remove_obj_from_list(&freq_node->first_obj, &freq_node->last_obj, obj);
+  freq_bucket_remove_obj(&params->freq_buckets, obj);
 
   cache_remove_obj_base(cache, obj, true);
-
-  if (freq_node->freq == params->min_freq && freq_node->n_obj == 0) {
-    /* update min freq */
-    update_min_freq(params);
-  }
 }
 
 /**
@@ -335,48 +250,6 @@ bool LFU_remove(cache_t *cache, obj_id_t obj_id) {
   return true;
 }
 
-// ***********************************************************************
-// ****                                                               ****
-// ****                  cache internal functions                     ****
-// ****                                                               ****
-// ***********************************************************************
-static inline void free_freq_node(void *list_node) {
-  my_free(sizeof(freq_node_t), list_node);
-}
-
-static inline freq_node_t *get_min_freq_node(LFU_params_t *params) {
-  freq_node_t *min_freq_node = NULL;
-  if (params->min_freq == 1) {
-    min_freq_node = params->freq_one_node;
-  } else {
-    if (params->min_freq == 0) {
-      /* update min freq */
-      update_min_freq(params);
-    }
-    min_freq_node = g_hash_table_lookup(params->freq_map,
-                                        GSIZE_TO_POINTER(params->min_freq));
-  }
-
-  DEBUG_ASSERT(min_freq_node != NULL);
-  DEBUG_ASSERT(min_freq_node->first_obj != NULL);
-  DEBUG_ASSERT(min_freq_node->n_obj > 0);
-
-  return min_freq_node;
-}
-
-static inline void update_min_freq(LFU_params_t *params) {
-  uint64_t old_min_freq = params->min_freq;
-  for (uint64_t freq = params->min_freq + 1; freq <= params->max_freq; freq++) {
-    freq_node_t *node =
-        g_hash_table_lookup(params->freq_map, GSIZE_TO_POINTER(freq));
-    if (node != NULL && node->n_obj > 0) {
-      params->min_freq = freq;
-      break;
-    }
-  }
-  DEBUG_ASSERT(params->min_freq > old_min_freq);
-}
-
 #ifdef __cplusplus
 }
 #endif
@@ -1,17 +1,53 @@
 #include "lhd.hpp"
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 #include <sstream>
 
+#include "../../../dataStructure/hashtable/hashtable.h"
 #include "../../../utils/include/mymath.h"
 #include "constants.hpp"
 
 namespace repl {
 
+void LHD::Tags::push_back() {
+  timestamp.push_back(0);
+  lastHitAge.push_back(0);
+  lastLastHitAge.push_back(0);
+  classId.push_back(0);
+  size.push_back(0);
+  explorer.push_back(0);
+  obj.push_back(nullptr);
+}
+
+void LHD::Tags::move(uint64_t from, uint64_t to) {
+  timestamp[to] = timestamp[from];
+  lastHitAge[to] = lastHitAge[from];
+  lastLastHitAge[to] = lastLastHitAge[from];
+  classId[to] = classId[from];
+  size[to] = size[from];
+  explorer[to] = explorer[from];
+  obj[to] = obj[from];
+  obj[to]->LHD.tag_idx = to;
+}
+
+void LHD::Tags::pop_back() {
+  timestamp.pop_back();
+  lastHitAge.pop_back();
+  lastLastHitAge.pop_back();
+  classId.pop_back();
+  size.pop_back();
+  explorer.pop_back();
+  obj.pop_back();
+}
+
 LHD::LHD(int _associativity, int _admissions, cache_t* _cache)
     : ASSOCIATIVITY(_associativity),
       ADMISSIONS(_admissions),
       cache(_cache),
-      recentlyAdmitted(ADMISSIONS, INVALID_CANDIDATE) {
+      recentlyAdmitted(ADMISSIONS, INVALID_CANDIDATE.id) {
   nextReconfiguration = ACCS_PER_RECONFIGURATION;
   explorerBudget = cache->cache_size * EXPLORER_BUDGET_FRACTION;
 
@@ -20,22 +56,63 @@ LHD::LHD(int _associativity, int _admissions, cache_t* _cache)
     auto& cl = classes.back();
     cl.hits.resize(MAX_AGE, 0);
     cl.evictions.resize(MAX_AGE, 0);
-    cl.hitDensities.resize(MAX_AGE, 0);
   }
+  hitDensities.resize(NUM_CLASSES * MAX_AGE, 0);
 
   // Initialize policy to ~GDSF by default.
   // jason: why is this GDSF? and why the index of class is used in density
   for (uint32_t c = 0; c < NUM_CLASSES; c++) {
     for (age_t a = 0; a < MAX_AGE; a++) {
-      classes[c].hitDensities[a] = 1. * (c + 1) / (a + 1);
+      hitDensities[c * MAX_AGE + a] = 1. * (c + 1) / (a + 1);
     }
   }
+
+  uint32_t maxCandidates = std::max(ASSOCIATIVITY, 8u) + ADMISSIONS;
+  candIdx.resize(maxCandidates);
+  candAge.resize(maxCandidates);
+  candDensityIdx.resize(maxCandidates);
+  candRank.resize(maxCandidates);
 }
 
-candidate_t LHD::rank(const request_t* req) {
-  uint64_t victim = -1;
-  rank_t victimRank = std::numeric_limits<rank_t>::max();
+void LHD::getHitDensities(const uint64_t* idx, uint32_t n,
+                          rank_t* densities) {
+  uint32_t* ages = candAge.data();
+  int32_t* densityIdx = candDensityIdx.data();
+  for (uint32_t i = 0; i < n; i++) {
+    ages[i] = getAge(idx[i]);
+    densityIdx[i] = (int32_t)(tags.classId[idx[i]] * MAX_AGE + ages[i]);
+  }
+
+  // the candidates are random objects, so the lookups are scattered over
+  // the hit density table
+  uint32_t i = 0;
+#ifdef __AVX2__
+  for (; i + 8 <= n; i += 8) {
+    __m256i vidx =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(densityIdx + i));
+    _mm256_storeu_ps(densities + i,
+                     _mm256_i32gather_ps(hitDensities.data(), vidx, 4));
+  }
+#endif
+  for (; i < n; i++) {
+    densities[i] = hitDensities[densityIdx[i]];
+  }
 
+  for (i = 0; i < n; i++) {
+    if (ages[i] == MAX_AGE - 1) {
+      densities[i] = std::numeric_limits<rank_t>::lowest();
+      continue;
+    }
+#ifndef BYTE_MISS_RATIO
+    densities[i] /= tags.size[idx[i]];
+#endif
+    if (tags.explorer[idx[i]]) {
+      densities[i] += 1.;
+    }
+  }
+}
+
+cache_obj_t* LHD::rank(const request_t* req) {
   // Sample few candidates early in the trace so that we converge
   // quickly to a reasonable policy.
   //
@@ -44,31 +121,33 @@ candidate_t LHD::rank(const request_t* req) {
   // system.
   uint32_t candidates = (numReconfigurations > 50) ? ASSOCIATIVITY : 8;
 
+  // collect the candidates first so that their hit densities are looked
+  // up together
+  uint32_t n = 0;
+  uint64_t nTags = tags.obj.size();
   for (uint32_t i = 0; i < candidates; i++) {
-    auto idx = next_rand() % tags.size();
-    auto& tag = tags[idx];
-    rank_t rank = getHitDensity(tag);
-
-    if (rank < victimRank) {
-      victim = idx;
-      victimRank = rank;
-    }
+    candIdx[n++] = next_rand() % nTags;
   }
 
   for (uint32_t i = 0; i < ADMISSIONS; i++) {
-    auto itr = indices.find(recentlyAdmitted[i]);
-    if (itr == indices.end()) {
+    cache_obj_t* obj =
+        hashtable_find_obj_id(cache->hashtable, recentlyAdmitted[i]);
+    if (obj == NULL) {
       continue;
     }
 
-    auto idx = itr->second;
-    auto& tag = tags[idx];
-    assert(tag.id == recentlyAdmitted[i]);
-    rank_t rank = getHitDensity(tag);
+    candIdx[n++] = obj->LHD.tag_idx;
+    assert(tags.obj[obj->LHD.tag_idx] == obj);
+  }
+
+  getHitDensities(candIdx.data(), n, candRank.data());
 
-    if (rank < victimRank) {
-      victim = idx;
-      victimRank = rank;
+  uint64_t victim = -1;
+  rank_t victimRank = std::numeric_limits<rank_t>::max();
+  for (uint32_t i = 0; i < n; i++) {
+    if (candRank[i] < victimRank) {
+      victim = candIdx[i];
+      victimRank = candRank[i];
     }
   }
 
@@ -77,59 +156,62 @@ candidate_t LHD::rank(const request_t* req) {
   ewmaVictimHitDensity =
       EWMA_DECAY * ewmaVictimHitDensity + (1 - EWMA_DECAY) * victimRank;
 
-  return tags[victim].id;
+  return tags.obj[victim];
 }
 
-void LHD::update(candidate_t id, const request_t* req) {
-  auto itr = indices.find(id);
-  bool insert = (itr == indices.end());
-
-  Tag* tag;
+void LHD::update(cache_obj_t* obj, const request_t* req, bool insert) {
+  uint64_t idx;
   if (insert) {
-    tags.push_back(Tag{});
-    tag = &tags.back();
-    indices[id] = tags.size() - 1;
+    idx = tags.obj.size();
+    tags.push_back();
+    tags.obj[idx] = obj;
+    obj->LHD.tag_idx = idx;
 
-    tag->lastLastHitAge = MAX_AGE;
-    tag->lastHitAge = 0;
-    tag->id = id;
+    tags.lastLastHitAge[idx] = MAX_AGE;
+    tags.lastHitAge[idx] = 0;
   } else {
-    tag = &tags[itr->second];
-    assert(tag->id == id);
-    auto age = getAge(*tag);
-    auto& cl = getClass(*tag);
+    idx = obj->LHD.tag_idx;
+    assert(tags.obj[idx] == obj);
+    auto age = getAge(idx);
+    auto& cl = getClass(idx);
     cl.hits[age] += 1;
 
-    if (tag->explorer) {
-      explorerBudget += tag->size;
+    if (tags.explorer[idx]) {
+      explorerBudget += tags.size[idx];
     }
 
-    tag->lastLastHitAge = tag->lastHitAge;
-    tag->lastHitAge = age;
+    tags.lastLastHitAge[idx] = tags.lastHitAge[idx];
+    tags.lastHitAge[idx] = age;
   }
 
-  tag->timestamp = timestamp;
-  tag->app = DEFAULT_APP_ID % APP_CLASSES;
-  tag->size = req->obj_size;
+  tags.timestamp[idx] = timestamp;
+  tags.classId[idx] = getClassId(DEFAULT_APP_ID % APP_CLASSES,
+                                 tags.lastHitAge[idx],
+                                 tags.lastLastHitAge[idx]);
+  tags.size[idx] = req->obj_size;
 
   // with some probability, some candidates will never be evicted
   // ... but limit how many resources we spend on doing this
   bool explore = (next_rand() % EXPLORE_INVERSE_PROBABILITY) == 0;
   if (explore && explorerBudget > 0 && numReconfigurations < 50) {
-    tag->explorer = true;
-    explorerBudget -= tag->size;
+    tags.explorer[idx] = true;
+    explorerBudget -= tags.size[idx];
   } else {
-    tag->explorer = false;
+    tags.explorer[idx] = false;
   }
 
   // If this candidate looks like something that should be
   // evicted, track it.
-  if (insert && !explore && getHitDensity(*tag) < ewmaVictimHitDensity) {
-    recentlyAdmitted[recentlyAdmittedHead++ % ADMISSIONS] = id;
+  if (insert && !explore && getHitDensity(idx) < ewmaVictimHitDensity) {
+    recentlyAdmitted[recentlyAdmittedHead++ % ADMISSIONS] = obj->obj_id;
   }
 
   ++timestamp;
 
+  if (nextReconfigClass < NUM_CLASSES) {
+    reconfigureClass(nextReconfigClass++);
+  }
+
   if (--nextReconfiguration == 0) {
     reconfigure();
     nextReconfiguration = ACCS_PER_RECONFIGURATION;
@@ -137,63 +219,72 @@ void LHD::update(candidate_t id, const request_t* req) {
   }
 }
 
-void LHD::replaced(candidate_t id) {
-  auto itr = indices.find(id);
-  assert(itr != indices.end());
-  auto index = itr->second;
+void LHD::replaced(cache_obj_t* obj) {
+  uint64_t idx = obj->LHD.tag_idx;
+  assert(tags.obj[idx] == obj);
 
   // Record stats before removing item
-  auto& tag = tags[index];
-  assert(tag.id == id);
-  auto age = getAge(tag);
-  auto& cl = getClass(tag);
+  auto age = getAge(idx);
+  auto& cl = getClass(idx);
   cl.evictions[age] += 1;
 
-  if (tag.explorer) {
-    explorerBudget += tag.size;
+  if (tags.explorer[idx]) {
+    explorerBudget += tags.size[idx];
   }
 
-  // Remove tag for replaced item and update index
-  indices.erase(itr);
-  tags[index] = tags.back();
-  tags.pop_back();
+  removeTag(idx);
+}
 
-  if (index < tags.size()) {
-    indices[tags[index].id] = index;
+void LHD::remove(cache_obj_t* obj) {
+  assert(tags.obj[obj->LHD.tag_idx] == obj);
+  removeTag(obj->LHD.tag_idx);
+}
+
+void LHD::removeTag(uint64_t idx) {
+  // move the last tag into the hole
+  uint64_t last = tags.obj.size() - 1;
+  if (idx < last) {
+    tags.move(last, idx);
   }
+  tags.pop_back();
 }
 
+// the classes are updated one per request in the next NUM_CLASSES requests
+// (see reconfigureClass) instead of all at once, see nextReconfigClass for
+// the state of the classes in between
 void LHD::reconfigure() {
-  rank_t totalHits = 0;
-  rank_t totalEvictions = 0;
-  for (auto& cl : classes) {
-    updateClass(cl);
-    totalHits += cl.totalHits;
-    totalEvictions += cl.totalEvictions;
+  if (nextReconfigClass < NUM_CLASSES) {
+    // the last reconfiguration has not finished, should not happen
+    // because NUM_CLASSES is much smaller than ACCS_PER_RECONFIGURATION
+    while (nextReconfigClass < NUM_CLASSES) {
+      reconfigureClass(nextReconfigClass++);
+    }
   }
 
   adaptAgeCoarsening();
 
-  modelHitDensity();
+  nextReconfigClass = 0;
+}
+
+void LHD::reconfigureClass(uint32_t c) {
+  auto& cl = classes[c];
+  updateClass(cl);
+  rescaleClass(cl, ageCoarseningDelta);
+  modelHitDensity(c);
 
   // Just printfs ...
-  for (uint32_t c = 0; c < classes.size(); c++) {
-    auto& cl = classes[c];
-    // printf("Class %d | hits %g, evictions %g, hitRate %g\n",
-    //        c,
-    //        cl.totalHits, cl.totalEvictions,
-    //        cl.totalHits / (cl.totalHits + cl.totalEvictions));
-
-    dumpClassRanks(cl);
+  // printf("Class %d | hits %g, evictions %g, hitRate %g\n",
+  //        c,
+  //        cl.totalHits, cl.totalEvictions,
+  //        cl.totalHits / (cl.totalHits + cl.totalEvictions));
+  dumpClassRanks(c);
+
+  if (c == NUM_CLASSES - 1) {
+    // all classes use the new age coarsening now
+    ageCoarseningShift = nextAgeCoarseningShift;
+    ageCoarseningDelta = 0;
+    overflows = 0;
   }
-  //    printf("LHD | hits %g, evictions %g, hitRate %g | overflows %lu (%g) |
-  //    cumulativeHitRate nan\n",
-  //           totalHits, totalEvictions,
-  //           totalHits / (totalHits + totalEvictions),
-  //           (unsigned long) overflows,
-  //           1. * (double) overflows / ACCS_PER_RECONFIGURATION);
-
-  overflows = 0;
 }
 
 void LHD::updateClass(Class& cl) {
@@ -209,48 +300,49 @@ void LHD::updateClass(Class& cl) {
   }
 }
 
-void LHD::modelHitDensity() {
-  for (uint32_t c = 0; c < classes.size(); c++) {
-    rank_t totalEvents =
-        classes[c].hits[MAX_AGE - 1] + classes[c].evictions[MAX_AGE - 1];
-    rank_t totalHits = classes[c].hits[MAX_AGE - 1];
-    rank_t lifetimeUnconditioned = totalEvents;
+void LHD::modelHitDensity(uint32_t c) {
+  auto& cl = classes[c];
+  rank_t* densities = &hitDensities[c * MAX_AGE];
+  rank_t totalEvents = cl.hits[MAX_AGE - 1] + cl.evictions[MAX_AGE - 1];
+  rank_t totalHits = cl.hits[MAX_AGE - 1];
+  rank_t lifetimeUnconditioned = totalEvents;
 
-    // we use a small trick here to compute expectation in O(N) by
-    // accumulating all values at later ages in
-    // lifetimeUnconditioned.
+  // we use a small trick here to compute expectation in O(N) by
+  // accumulating all values at later ages in
+  // lifetimeUnconditioned.
 
-    for (age_t a = MAX_AGE - 2; a < MAX_AGE; a--) {
-      totalHits += classes[c].hits[a];
+  for (age_t a = MAX_AGE - 2; a < MAX_AGE; a--) {
+    totalHits += cl.hits[a];
 
-      totalEvents += classes[c].hits[a] + classes[c].evictions[a];
+    totalEvents += cl.hits[a] + cl.evictions[a];
 
-      lifetimeUnconditioned += totalEvents;
+    lifetimeUnconditioned += totalEvents;
 
-      if (totalEvents > 1e-5) {
-        classes[c].hitDensities[a] = totalHits / lifetimeUnconditioned;
-      } else {
-        classes[c].hitDensities[a] = 0.;
-      }
+    if (totalEvents > 1e-5) {
+      densities[a] = totalHits / lifetimeUnconditioned;
+    } else {
+      densities[a] = 0.;
     }
   }
 }
 
-void LHD::dumpClassRanks(Class& cl) {
+void LHD::dumpClassRanks(uint32_t c) {
   if (!DUMP_RANKS) {
     return;
   }
 
+  auto& cl = classes[c];
+
   // float objectAvgSize = cl.sizeAccumulator / cl.totalHits; // +
   // cl.totalEvictions);
-  float objectAvgSize = 1. * cache->occupied_byte / sizeMap.size();
+  float objectAvgSize = 1. * cache->occupied_byte / tags.obj.size();
   rank_t left;
 
   left = cl.totalHits + cl.totalEvictions;
   std::cout << "Ranks for avg object (" << objectAvgSize << "): ";
   for (age_t a = 0; a < MAX_AGE; a++) {
     std::stringstream rankStr;
-    rank_t density = cl.hitDensities[a] / objectAvgSize;
+    rank_t density = hitDensities[c * MAX_AGE + a] / objectAvgSize;
     rankStr << density << ", ";
     std::cout << rankStr.str();
 
@@ -300,7 +392,7 @@ void LHD::adaptAgeCoarsening() {
   ewmaNumObjects *= EWMA_DECAY;
   ewmaNumObjectsMass *= EWMA_DECAY;
 
-  ewmaNumObjects += sizeMap.size();
+  ewmaNumObjects += tags.obj.size();
   ewmaNumObjectsMass += 1.;
 
   rank_t numObjects = ewmaNumObjects / ewmaNumObjectsMass;
@@ -318,44 +410,14 @@ void LHD::adaptAgeCoarsening() {
       optimalAgeCoarseningLog2 += 1;
     }
 
-    int32_t delta = optimalAgeCoarseningLog2 - ageCoarseningShift;
-    ageCoarseningShift = optimalAgeCoarseningLog2;
+    // the new coarsening is used once all classes are rescaled, see
+    // reconfigureClass
+    ageCoarseningDelta = optimalAgeCoarseningLog2 - ageCoarseningShift;
+    nextAgeCoarseningShift = optimalAgeCoarseningLog2;
 
     // increase weight to delay another shift for a while
     ewmaNumObjects *= 8;
     ewmaNumObjectsMass *= 8;
-
-    // compress or stretch distributions to approximate new scaling
-    // regime
-    if (delta < 0) {
-      // stretch
-      for (auto& cl : classes) {
-        for (age_t a = MAX_AGE >> (-delta); a < MAX_AGE - 1; a++) {
-          cl.hits[MAX_AGE - 1] += cl.hits[a];
-          cl.evictions[MAX_AGE - 1] += cl.evictions[a];
-        }
-        for (age_t a = MAX_AGE - 2; a < MAX_AGE; a--) {
-          cl.hits[a] = cl.hits[a >> (-delta)] / (1 << (-delta));
-          cl.evictions[a] = cl.evictions[a >> (-delta)] / (1 << (-delta));
-        }
-      }
-    } else if (delta > 0) {
-      // compress
-      for (auto& cl : classes) {
-        for (age_t a = 0; a < MAX_AGE >> delta; a++) {
-          cl.hits[a] = cl.hits[a << delta];
-          cl.evictions[a] = cl.evictions[a << delta];
-          for (int i = 1; i < (1 << delta); i++) {
-            cl.hits[a] += cl.hits[(a << delta) + i];
-            cl.evictions[a] += cl.evictions[(a << delta) + i];
-          }
-        }
-        for (age_t a = (MAX_AGE >> delta); a < MAX_AGE - 1; a++) {
-          cl.hits[a] = 0;
-          cl.evictions[a] = 0;
-        }
-      }
-    }
   }
 
   //    printf("LHD at %lu | ageCoarseningShift now %lu | num objects %g |
@@ -366,4 +428,34 @@ void LHD::adaptAgeCoarsening() {
   //           1. * (1 << ageCoarseningShift));
 }
 
+// compress or stretch the distributions of a class to approximate the new
+// scaling regime after the age coarsening changes by delta
+void LHD::rescaleClass(Class& cl, int32_t delta) {
+  if (delta < 0) {
+    // stretch
+    for (age_t a = MAX_AGE >> (-delta); a < MAX_AGE - 1; a++) {
+      cl.hits[MAX_AGE - 1] += cl.hits[a];
+      cl.evictions[MAX_AGE - 1] += cl.evictions[a];
+    }
+    for (age_t a = MAX_AGE - 2; a < MAX_AGE; a--) {
+      cl.hits[a] = cl.hits[a >> (-delta)] / (1 << (-delta));
+      cl.evictions[a] = cl.evictions[a >> (-delta)] / (1 << (-delta));
+    }
+  } else if (delta > 0) {
+    // compress
+    for (age_t a = 0; a < MAX_AGE >> delta; a++) {
+      cl.hits[a] = cl.hits[a << delta];
+      cl.evictions[a] = cl.evictions[a << delta];
+      for (int i = 1; i < (1 << delta); i++) {
+        cl.hits[a] += cl.hits[(a << delta) + i];
+        cl.evictions[a] += cl.evictions[(a << delta) + i];
+      }
+    }
+    for (age_t a = (MAX_AGE >> delta); a < MAX_AGE - 1; a++) {
+      cl.hits[a] = 0;
+      cl.evictions[a] = 0;
+    }
+  }
+}
+
 }  // namespace repl
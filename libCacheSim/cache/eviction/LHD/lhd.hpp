@@ -17,47 +17,55 @@ class LHD {
   typedef uint64_t age_t;
   typedef float rank_t;
 
-  // info we track about each object
-  struct Tag {
-    age_t timestamp;
-    age_t lastHitAge;
-    age_t lastLastHitAge;
-    uint32_t app;
-
-    candidate_t id;
-    rank_t size;  // stored redundantly with cache
-    bool explorer;
+  // info we track about each object, kept as structure of arrays so that
+  // rank() only touches the fields it needs; obj->LHD.tag_idx is the index
+  // of an object in these arrays
+  struct Tags {
+    std::vector<timestamp_t> timestamp;
+    std::vector<age_t> lastHitAge;
+    std::vector<age_t> lastLastHitAge;
+    // the class of the object, computed when the object is referenced
+    std::vector<uint32_t> classId;
+    std::vector<rank_t> size;  // stored redundantly with cache
+    std::vector<uint8_t> explorer;
+    std::vector<cache_obj_t *> obj;
+
+    void push_back();
+    void move(uint64_t from, uint64_t to);
+    void pop_back();
   };
 
-  // info we track about each class of objects
+  // info we track about each class of objects, the hit densities of all
+  // classes are in one array (see hitDensities)
   struct Class {
     std::vector<rank_t> hits;
     std::vector<rank_t> evictions;
     rank_t totalHits = 0;
     rank_t totalEvictions = 0;
-
-    std::vector<rank_t> hitDensities;
   };
 
   LHD(int _associativity, int _admissions, cache_t *cache);
   ~LHD() {}
 
-  // called whenever and object is referenced
-  void update(candidate_t id, const request_t *req);
+  // called whenever and object is referenced, insert is true if the object
+  // is newly admitted
+  void update(cache_obj_t *obj, const request_t *req, bool insert);
 
   // called when an object is evicted
-  void replaced(candidate_t id);
+  void replaced(cache_obj_t *obj);
+
+  // called when an object is removed, no stats are recorded
+  void remove(cache_obj_t *obj);
 
   // called to find a victim upon a cache miss
-  candidate_t rank(const request_t *req);
+  cache_obj_t *rank(const request_t *req);
 
   void dumpStats(LHDCache::Cache *cache) {}
 
-  std::unordered_map<candidate_t, uint32_t> sizeMap;
-  // object metadata; indices maps object id -> metadata
-  std::vector<Tag> tags;
+  Tags tags;
   std::vector<Class> classes;
-  std::unordered_map<candidate_t, uint64_t> indices;
+  // hit density of class c at age a is hitDensities[c * MAX_AGE + a]
+  std::vector<rank_t> hitDensities;
 
  private:
   // CONSTANTS ///////////////////////////
@@ -122,12 +130,34 @@ class LHD {
   //  misc::Rand rand;
 
   // see ADMISSIONS above
-  std::vector<candidate_t> recentlyAdmitted;
+  std::vector<obj_id_t> recentlyAdmitted;
   int recentlyAdmittedHead = 0;
   rank_t ewmaVictimHitDensity = 0;
 
   int64_t explorerBudget = 0;
 
+  // reconfiguration is spread over NUM_CLASSES requests, one class per
+  // request, nextReconfigClass is the next class to update, NUM_CLASSES if
+  // no reconfiguration is in progress; the new age coarsening takes effect
+  // once all classes are updated
+  //
+  // in these NUM_CLASSES requests, the classes below nextReconfigClass have
+  // the new hit densities and the others still have the old ones. if the
+  // age coarsening changes (the 6th and the 26th reconfiguration), the
+  // updated classes are also rescaled to the new coarsening while ages are
+  // still computed with the old ageCoarseningShift, so their densities are
+  // looked up and their hits and evictions are recorded at ages off by
+  // 2^ageCoarseningDelta until the last class is updated
+  uint32_t nextReconfigClass = NUM_CLASSES;
+  timestamp_t nextAgeCoarseningShift = 10;
+  int32_t ageCoarseningDelta = 0;
+
+  // scratch space used by rank()
+  std::vector<uint64_t> candIdx;
+  std::vector<uint32_t> candAge;
+  std::vector<int32_t> candDensityIdx;
+  std::vector<rank_t> candRank;
+
   // METHODS /////////////////////////////
 
   // returns something like log(maxAge - age)
@@ -143,37 +173,35 @@ class LHD {
     return log;
   }
 
-  inline uint32_t getClassId(const Tag &tag) const {
-    uint32_t hitAgeId = hitAgeClass(tag.lastHitAge + tag.lastLastHitAge);
-    // uint32_t hitAgeId = hitAgeClass(tag.lastHitAge);
-    return tag.app * HIT_AGE_CLASSES + hitAgeId;
+  inline uint32_t getClassId(uint32_t app, age_t lastHitAge,
+                             age_t lastLastHitAge) const {
+    uint32_t hitAgeId = hitAgeClass(lastHitAge + lastLastHitAge);
+    // uint32_t hitAgeId = hitAgeClass(lastHitAge);
+    return app * HIT_AGE_CLASSES + hitAgeId;
   }
 
-  inline uint32_t getClassIdBySize(const Tag &tag) const {
-    uint32_t hitSizeId = 0;
-    uint64_t size = (uint64_t)tag.size;
-    return tag.app * HIT_AGE_CLASSES + ((uint64_t)log(size)) % HIT_AGE_CLASSES;
+  inline uint32_t getClassIdBySize(uint32_t app, rank_t objSize) const {
+    uint64_t size = (uint64_t)objSize;
+    return app * HIT_AGE_CLASSES + ((uint64_t)log(size)) % HIT_AGE_CLASSES;
   }
 
-  inline uint32_t getClassIdBySizeAndAge(const Tag &tag) const {
-    if (tag.lastHitAge == 0) return getClassIdBySize(tag);
+  inline uint32_t getClassIdBySizeAndAge(uint32_t app, rank_t objSize,
+                                         age_t lastHitAge) const {
+    if (lastHitAge == 0) return getClassIdBySize(app, objSize);
 
-    uint32_t hitSizeId = 0;
-    uint64_t size = (uint64_t)tag.size;
-    return tag.app * HIT_AGE_CLASSES +
-           ((uint64_t)log(size) + (uint64_t)log(tag.lastHitAge)) %
+    uint64_t size = (uint64_t)objSize;
+    return app * HIT_AGE_CLASSES +
+           ((uint64_t)log(size) + (uint64_t)log(lastHitAge)) %
                HIT_AGE_CLASSES;
   }
 
-  inline Class &getClass(const Tag &tag) {
-    // return classes[getClassIdBySizeAndAge(tag)];
-    // return classes[getClassIdBySize(tag)];
-    return classes[getClassId(tag)];
+  inline Class &getClass(uint64_t idx) {
+    return classes[tags.classId[idx]];
   }
 
-  inline age_t getAge(Tag tag) {
+  inline age_t getAge(uint64_t idx) {
     timestamp_t age =
-        (timestamp - (timestamp_t)tag.timestamp) >> ageCoarseningShift;
+        (timestamp - tags.timestamp[idx]) >> ageCoarseningShift;
 
     if (age >= MAX_AGE) {
       ++overflows;
@@ -183,28 +211,34 @@ class LHD {
     }
   }
 
-  inline rank_t getHitDensity(const Tag &tag) {
-    auto age = getAge(tag);
+  inline rank_t getHitDensity(uint64_t idx) {
+    auto age = getAge(idx);
     if (age == MAX_AGE - 1) {
       return std::numeric_limits<rank_t>::lowest();
     }
-    auto &cl = getClass(tag);
 #ifdef BYTE_MISS_RATIO
-    rank_t density = cl.hitDensities[age];
+    rank_t density = hitDensities[tags.classId[idx] * MAX_AGE + age];
 #else
-    rank_t density = cl.hitDensities[age] / tag.size;
+    rank_t density =
+        hitDensities[tags.classId[idx] * MAX_AGE + age] / tags.size[idx];
 #endif
-    if (tag.explorer) {
+    if (tags.explorer[idx]) {
       density += 1.;
     }
     return density;
   }
 
+  // the hit densities of n tags, the same as getHitDensity on each of them
+  void getHitDensities(const uint64_t *idx, uint32_t n, rank_t *densities);
+
+  void removeTag(uint64_t idx);
   void reconfigure();
+  void reconfigureClass(uint32_t c);
   void adaptAgeCoarsening();
+  void rescaleClass(Class &cl, int32_t delta);
   void updateClass(Class &cl);
-  void modelHitDensity();
-  void dumpClassRanks(Class &cl);
+  void modelHitDensity(uint32_t c);
+  void dumpClassRanks(uint32_t c);
 };
 
 }  // namespace repl
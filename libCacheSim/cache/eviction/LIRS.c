@@ -1,11 +1,24 @@
 //
-// LIRS cache eviction policy implemented by multiple LRUs
+// LIRS cache eviction policy
+//
+// each object has one cache_obj_t in the hashtable of the cache, which is
+// linked into stack S (queue.prev/next), and queue Q or the non-resident
+// list (LIRS.q_prev/q_next), an object moves between them by relinking,
+// and it is freed when it is in none of them
+//
+// with ghost-fp-rate > 0, a resident HIR object in S that is evicted leaves S
+// and is kept in a fingerprint ghost (see fingerprintGhost.h) with its
+// position in S, the entry is still in S if it is above the bottom of S,
+// which is an LIR block after pruning, the ghost entries are removed from
+// the oldest when limiting the size of S, and the pruned entries stay in the
+// ghost (and are counted in the size of S) until they are removed
 //
 // LIRS.c
 // libcachesim
 //
 //
 
+#include "../../dataStructure/fingerprintGhost.h"
 #include "../../dataStructure/hashtable/hashtable.h"
 #include "../../include/libCacheSim/evictionAlgo.h"
 
@@ -16,15 +29,32 @@ extern "C" {
 // #define DEBUG_MODE 1
 
 typedef struct LIRS_params {
-  cache_t *LRU_s;
-  cache_t *LRU_q;
-  cache_t *LRU_nh;
+  /* stack S, the head is the top */
+  cache_obj_t *s_head;
+  cache_obj_t *s_tail;
+  int64_t s_byte;
+  /* queue Q of the resident HIR objects */
+  cache_obj_t *q_head;
+  cache_obj_t *q_tail;
+  /* the non-resident HIR objects in S, in the order of becoming non-resident,
+   * it is used to limit the size of S */
+  cache_obj_t *nh_head;
+  cache_obj_t *nh_tail;
+  /* the s_seq of the object at the top of S */
+  int64_t s_seq;
+  /* stores the non-resident HIR objects if ghost_fp_rate > 0, the value of
+   * an entry is the s_seq of the object */
+  fp_ghost_t *nh_fp;
+  double ghost_fp_rate;
+
   double hirs_ratio;
   uint64_t hirs_limit;
   uint64_t lirs_limit;
   uint64_t hirs_count;
   uint64_t lirs_count;
   uint64_t nonresident;
+
+  request_t *req_local;
 } LIRS_params_t;
 
 // ***********************************************************************
@@ -45,13 +75,13 @@ static bool LIRS_remove(cache_t *cache, const obj_id_t obj_id);
 /* internal functions */
 bool LIRS_can_insert(cache_t *cache, const request_t *req);
 static void LIRS_prune(cache_t *cache);
-static cache_obj_t *hit_RD_HIRinS(cache_t *cache, cache_obj_t *cache_obj_s,
-                                  cache_obj_t *cache_obj_q);
-static cache_obj_t *hit_NR_HIRinS(cache_t *cache, cache_obj_t *cache_obj_s);
-static cache_obj_t *hit_RD_HIRinQ(cache_t *cache, cache_obj_t *cache_obj_q);
+static cache_obj_t *hit_RD_HIRinS(cache_t *cache, cache_obj_t *obj);
+static cache_obj_t *hit_RD_HIRinQ(cache_t *cache, cache_obj_t *obj);
 static void evictLIR(cache_t *cache);
 static bool evictHIR(cache_t *cache);
 static void limitStack(cache_t *cache);
+static void LIRS_parse_params(cache_t *cache,
+                              const char *cache_specific_params);
 
 /* debug functions*/
 static void LIRS_print_cache(cache_t *cache);
@@ -91,6 +121,7 @@ cache_t *LIRS_init(const common_cache_params_t ccache_params,
   }
 
   cache->eviction_params = (LIRS_params_t *)malloc(sizeof(LIRS_params_t));
+  memset(cache->eviction_params, 0, sizeof(LIRS_params_t));
   LIRS_params_t *params = (LIRS_params_t *)(cache->eviction_params);
 
   params->hirs_ratio = 0.01;
@@ -100,17 +131,14 @@ cache_t *LIRS_init(const common_cache_params_t ccache_params,
   params->hirs_count = 0;
   params->lirs_count = 0;
   params->nonresident = 0;
+  params->req_local = new_request();
 
-  // initialize LRU for stack S and stack Q
-  common_cache_params_t ccache_params_s = ccache_params;
-  ccache_params_s.cache_size = params->lirs_limit;
-  common_cache_params_t ccache_params_q = ccache_params;
-  ccache_params_q.cache_size = params->hirs_limit;
-  common_cache_params_t ccache_params_nh = ccache_params;
-
-  params->LRU_s = LRU_init(ccache_params_s, NULL);
-  params->LRU_q = LRU_init(ccache_params_q, NULL);
-  params->LRU_nh = LRU_init(ccache_params_nh, NULL);
+  if (cache_specific_params != NULL) {
+    LIRS_parse_params(cache, cache_specific_params);
+  }
+  if (params->ghost_fp_rate > 0) {
+    params->nh_fp = fp_ghost_new(2 * cache->cache_size, params->ghost_fp_rate);
+  }
 
   return cache;
 }
@@ -122,9 +150,10 @@ cache_t *LIRS_init(const common_cache_params_t ccache_params,
  */
 static void LIRS_free(cache_t *cache) {
   LIRS_params_t *params = (LIRS_params_t *)(cache->eviction_params);
-  params->LRU_s->cache_free(params->LRU_s);
-  params->LRU_q->cache_free(params->LRU_q);
-  params->LRU_nh->cache_free(params->LRU_nh);
+  free_request(params->req_local);
+  if (params->nh_fp != NULL) {
+    fp_ghost_free(params->nh_fp);
+  }
   my_free(sizeof(LIRS_params_t), params);
   cache_struct_free(cache);
 }
@@ -156,25 +185,14 @@ static bool LIRS_get(cache_t *cache, const request_t *req) {
 
 #ifdef DEBUG_MODE
   LIRS_params_t *params = (LIRS_params_t *)(cache->eviction_params);
-  cache_t *LRU_s = params->LRU_s;
   if (cache->n_req >= 2) {
-    // printf("obj:%lu size:%ld ", req->obj_id, req->obj_size);
-    // if (res) {
-    //   printf("hit\n");
-    // } else {
-    //   printf("miss\n");
-    // }
-    // LIRS_print_cache(cache);
     LIRS_print_cache_compared_to_cacheus(cache);
 
     printf("number of requests:%ld \n", cache->n_req);
-    printf("number of objects in S:%ld \n", LRU_s->n_obj);
-    printf("S(%ld):%ld %ld\n", params->lirs_limit, LRU_s->occupied_byte,
+    printf("S(%ld):%ld %ld\n", params->lirs_limit, params->s_byte,
            params->lirs_count);
-    printf("Q(%ld): %ld %ld \n", params->hirs_limit,
-           params->LRU_q->occupied_byte, params->hirs_count);
-    printf("NH: %ld %ld \n", params->LRU_nh->occupied_byte,
-           params->nonresident);
+    printf("Q(%ld): %ld \n", params->hirs_limit, params->hirs_count);
+    printf("NH: %ld \n", params->nonresident);
     printf("\n\n");
   }
 #endif
@@ -182,6 +200,146 @@ static bool LIRS_get(cache_t *cache, const request_t *req) {
   return res;
 }
 
+// ***********************************************************************
+// ****                                                               ****
+// ****                  stack S, queue Q and NH lists                ****
+// ****                                                               ****
+// ***********************************************************************
+
+/* Q and the non-resident list share the LIRS.q_prev/q_next links */
+static void LIRS_list_prepend(cache_obj_t **head, cache_obj_t **tail,
+                              cache_obj_t *obj) {
+  obj->LIRS.q_prev = NULL;
+  obj->LIRS.q_next = *head;
+  if (*head != NULL) {
+    (*head)->LIRS.q_prev = obj;
+  }
+  *head = obj;
+  if (*tail == NULL) {
+    *tail = obj;
+  }
+}
+
+static void LIRS_list_remove(cache_obj_t **head, cache_obj_t **tail,
+                             cache_obj_t *obj) {
+  cache_obj_t *prev = obj->LIRS.q_prev;
+  cache_obj_t *next = obj->LIRS.q_next;
+  if (prev != NULL) {
+    prev->LIRS.q_next = next;
+  } else {
+    *head = next;
+  }
+  if (next != NULL) {
+    next->LIRS.q_prev = prev;
+  } else {
+    *tail = prev;
+  }
+  obj->LIRS.q_prev = NULL;
+  obj->LIRS.q_next = NULL;
+}
+
+static void LIRS_list_move_to_head(cache_obj_t **head, cache_obj_t **tail,
+                                   cache_obj_t *obj) {
+  if (*head == obj) return;
+  LIRS_list_remove(head, tail, obj);
+  LIRS_list_prepend(head, tail, obj);
+}
+
+static void S_push(cache_t *cache, cache_obj_t *obj, bool is_LIR,
+                   bool in_cache) {
+  LIRS_params_t *params = (LIRS_params_t *)(cache->eviction_params);
+  DEBUG_ASSERT(!obj->LIRS.in_s);
+  prepend_obj_to_head(&params->s_head, &params->s_tail, obj);
+  obj->LIRS.s_seq = ++params->s_seq;
+  obj->LIRS.in_s = true;
+  obj->LIRS.is_LIR = is_LIR;
+  obj->LIRS.in_cache = in_cache;
+  params->s_byte += obj->obj_size + cache->obj_md_size;
+}
+
+static void S_move_to_top(cache_t *cache, cache_obj_t *obj) {
+  LIRS_params_t *params = (LIRS_params_t *)(cache->eviction_params);
+  move_obj_to_head(&params->s_head, &params->s_tail, obj);
+  obj->LIRS.s_seq = ++params->s_seq;
+}
+
+static void S_unlink(cache_t *cache, cache_obj_t *obj) {
+  LIRS_params_t *params = (LIRS_params_t *)(cache->eviction_params);
+  DEBUG_ASSERT(obj->LIRS.in_s);
+  remove_obj_from_list(&params->s_head, &params->s_tail, obj);
+  obj->LIRS.in_s = false;
+  params->s_byte -= obj->obj_size + cache->obj_md_size;
+}
+
+static void Q_push(cache_t *cache, cache_obj_t *obj) {
+  LIRS_params_t *params = (LIRS_params_t *)(cache->eviction_params);
+  DEBUG_ASSERT(!obj->LIRS.in_q && !obj->LIRS.in_nh);
+  LIRS_list_prepend(&params->q_head, &params->q_tail, obj);
+  obj->LIRS.in_q = true;
+}
+
+static void Q_unlink(cache_t *cache, cache_obj_t *obj) {
+  LIRS_params_t *params = (LIRS_params_t *)(cache->eviction_params);
+  DEBUG_ASSERT(obj->LIRS.in_q);
+  LIRS_list_remove(&params->q_head, &params->q_tail, obj);
+  obj->LIRS.in_q = false;
+}
+
+static void NH_push(cache_t *cache, cache_obj_t *obj) {
+  LIRS_params_t *params = (LIRS_params_t *)(cache->eviction_params);
+  DEBUG_ASSERT(!obj->LIRS.in_q && !obj->LIRS.in_nh);
+  LIRS_list_prepend(&params->nh_head, &params->nh_tail, obj);
+  obj->LIRS.in_nh = true;
+}
+
+/* remove the object from the non-resident list if it is in the list */
+static void NH_remove(cache_t *cache, cache_obj_t *obj) {
+  LIRS_params_t *params = (LIRS_params_t *)(cache->eviction_params);
+  if (obj->LIRS.in_nh) {
+    LIRS_list_remove(&params->nh_head, &params->nh_tail, obj);
+    obj->LIRS.in_nh = false;
+    params->nonresident -= obj->obj_size;
+  }
+}
+
+/* get the object of the request, create one if it is not in the hashtable */
+static cache_obj_t *LIRS_get_or_create_obj(cache_t *cache,
+                                           const request_t *req) {
+  cache_obj_t *obj = hashtable_find(cache->hashtable, req);
+  if (obj == NULL) {
+    obj = hashtable_insert(cache->hashtable, req);
+    memset(&obj->LIRS, 0, sizeof(obj->LIRS));
+  }
+  return obj;
+}
+
+/* an object in the fingerprint ghost is still in S if it is above the bottom
+ * of S, it becomes a non-resident object at the top of S as find does to the
+ * non-resident objects in S */
+static void NH_fp_restore(cache_t *cache, const request_t *req) {
+  LIRS_params_t *params = (LIRS_params_t *)(cache->eviction_params);
+  int64_t s_seq;
+  if (!fp_ghost_remove_value(params->nh_fp, req->obj_id, &s_seq)) {
+    return;
+  }
+  if (params->s_tail == NULL || s_seq <= params->s_tail->LIRS.s_seq) {
+    // pruned from S
+    return;
+  }
+
+  cache_obj_t *obj = LIRS_get_or_create_obj(cache, req);
+  S_push(cache, obj, false, false);
+  NH_push(cache, obj);
+  params->nonresident += obj->obj_size;
+}
+
+/* free the object if it is not in S, Q or the non-resident list */
+static void LIRS_free_obj_if_unused(cache_t *cache, cache_obj_t *obj) {
+  if (!obj->LIRS.in_s && !obj->LIRS.in_q && !obj->LIRS.in_nh) {
+    hashtable_delete(cache->hashtable, obj);
+  }
+}
+
 // ***********************************************************************
 // ****                                                               ****
 // ****       developer facing APIs (used by cache developer)         ****
@@ -202,58 +360,48 @@ static cache_obj_t *LIRS_find(cache_t *cache, const request_t *req,
                               const bool update_cache) {
   LIRS_params_t *params = (LIRS_params_t *)(cache->eviction_params);
 
-  cache_obj_t *obj_s = NULL;
-  cache_obj_t *obj_q = NULL;
-
-  // find the object in S and Q,
-  // and they will be promoted to the top of the stacks
-  obj_s = params->LRU_s->find(params->LRU_s, req, update_cache);
-  obj_q = params->LRU_q->find(params->LRU_q, req, update_cache);
+  cache_obj_t *obj = hashtable_find(cache->hashtable, req);
+  if (obj == NULL) {
+    if (update_cache && params->nh_fp != NULL) {
+      NH_fp_restore(cache, req);
+    }
+    return NULL;  // miss
+  }
 
   if (update_cache == false) {
-    if (obj_s != NULL) {
-      if (obj_s->LIRS.is_LIR || obj_s->LIRS.in_cache) {
-        return obj_s;
-      } else {
-        return NULL;
-      }
-    } else if (obj_q != NULL) {
-      if (obj_q->LIRS.in_cache) {
-        return obj_q;
-      } else {
-        return NULL;
-      }
-    } else {
-      return NULL;
+    if (obj->LIRS.in_s) {
+      return obj->LIRS.is_LIR || obj->LIRS.in_cache ? obj : NULL;
     }
+    /* objects in Q are resident */
+    return obj->LIRS.in_q ? obj : NULL;
   }
 
-  // cache_obj_t *res = NULL;
-  if (obj_s != NULL) {
-    if (obj_s->LIRS.is_LIR) {
+  // the object is promoted to the top of S and Q
+  if (obj->LIRS.in_s) {
+    S_move_to_top(cache, obj);
+  }
+  if (obj->LIRS.in_q) {
+    LIRS_list_move_to_head(&params->q_head, &params->q_tail, obj);
+  }
+
+  if (obj->LIRS.in_s) {
+    if (obj->LIRS.is_LIR) {
       // accessing an LIR block (hit)
       LIRS_prune(cache);
-      return obj_s;
+      return obj;
+    } else if (obj->LIRS.in_cache) {
+      // accessing a resident HIR block in S (hit)
+      return hit_RD_HIRinS(cache, obj);
     } else {
-      // accessing an HIR block in S (resident and non-resident)
-      if (obj_s->LIRS.in_cache) {
-        return hit_RD_HIRinS(cache, obj_s, obj_q);  // hit
-      } else {
-        return NULL;
-      }
-    }
-  } else if (obj_q != NULL) {
-    // accessing an HIR blocks in Q (resident)
-    // LRU_q->find already did the movement
-    if (obj_q->LIRS.in_cache) {
-      return hit_RD_HIRinQ(cache, obj_q);  // hit
-    } else {
-      assert(false);
+      // accessing a non-resident HIR block in S (miss)
       return NULL;
     }
-  } else {
-    return NULL;  // miss
+  } else if (obj->LIRS.in_q) {
+    // accessing an HIR block only in Q (hit)
+    return hit_RD_HIRinQ(cache, obj);
   }
+
+  return NULL;
 }
 
 /**
@@ -270,76 +418,41 @@ static cache_obj_t *LIRS_find(cache_t *cache, const request_t *req,
 static cache_obj_t *LIRS_insert(cache_t *cache, const request_t *req) {
   LIRS_params_t *params = (LIRS_params_t *)(cache->eviction_params);
 
-  cache_obj_t *obj_s = params->LRU_s->find(params->LRU_s, req, false);
-  cache_obj_t *obj_q = params->LRU_q->find(params->LRU_q, req, false);
+  cache_obj_t *obj = hashtable_find(cache->hashtable, req);
 
   // Upon accessing an HIR non-resident in S
-  if (obj_s != NULL && obj_s->LIRS.is_LIR == false &&
-      obj_s->LIRS.in_cache == false) {
-    // change status of the block to be LIR (obj_s is already promoted to top)
-    obj_s->LIRS.is_LIR = true;
-    obj_s->LIRS.in_cache = true;
-    params->lirs_count += obj_s->obj_size;
-    cache->occupied_byte += obj_s->obj_size + cache->obj_md_size;
-    cache->n_obj += 1;
-  }
-
-  // Upon accessing an HIR non-resident in Q
-  if (obj_s == NULL && obj_q != NULL && obj_q->LIRS.in_cache == false) {
-    // insert the req into S and place it on the top of S
-    cache_obj_t *inserted_obj_s = params->LRU_s->insert(params->LRU_s, req);
-    inserted_obj_s->LIRS.is_LIR = false;
-    inserted_obj_s->LIRS.in_cache = true;
-
-    cache_obj_t *inserted_obj_q = params->LRU_q->insert(params->LRU_q, req);
-    inserted_obj_q->LIRS.is_LIR = false;
-    inserted_obj_q->LIRS.in_cache = true;
-
-    params->hirs_count += inserted_obj_s->obj_size;
-    cache->occupied_byte += inserted_obj_s->obj_size + cache->obj_md_size;
+  if (obj != NULL && obj->LIRS.in_s) {
+    DEBUG_ASSERT(!obj->LIRS.is_LIR && !obj->LIRS.in_cache);
+    // change status of the block to be LIR (it is already on the top of S)
+    obj->LIRS.is_LIR = true;
+    obj->LIRS.in_cache = true;
+    params->lirs_count += obj->obj_size;
+    cache->occupied_byte += obj->obj_size + cache->obj_md_size;
     cache->n_obj += 1;
+    return obj;
   }
 
   // Upon accessing blocks neither in S nor Q
-  if (obj_s == NULL && obj_q == NULL) {
+  DEBUG_ASSERT(obj == NULL);
+  obj = LIRS_get_or_create_obj(cache, req);
+  if (params->lirs_count + req->obj_size <= params->lirs_limit) {
     // when LIR block set is not full,
     // all reference blocks are given an LIR status
-    if (params->lirs_count + req->obj_size <= params->lirs_limit) {
-      cache_obj_t *inserted_obj_s = params->LRU_s->insert(params->LRU_s, req);
-      inserted_obj_s->LIRS.is_LIR = true;
-      inserted_obj_s->LIRS.in_cache = true;
-      params->lirs_count += inserted_obj_s->obj_size;
-      cache->occupied_byte += inserted_obj_s->obj_size + cache->obj_md_size;
-    } else if (params->hirs_count + req->obj_size <= params->hirs_limit) {
-      // when LIR block set is full,
-      // all reference blocks are given an HIR status
-      cache_obj_t *inserted_obj_s = params->LRU_s->insert(params->LRU_s, req);
-      inserted_obj_s->LIRS.is_LIR = false;
-      inserted_obj_s->LIRS.in_cache = true;
-
-      cache_obj_t *inserted_obj_q = params->LRU_q->insert(params->LRU_q, req);
-      inserted_obj_q->LIRS.is_LIR = false;
-      inserted_obj_q->LIRS.in_cache = true;
-
-      params->hirs_count += inserted_obj_s->obj_size;
-      cache->occupied_byte += inserted_obj_s->obj_size + cache->obj_md_size;
-    } else {
-      // the circumstance is same as accessing an HIR non-resident not in S
-      // insert the req into S and place it on the top of S
-      cache_obj_t *inserted_obj_s = params->LRU_s->insert(params->LRU_s, req);
-      inserted_obj_s->LIRS.is_LIR = false;
-      inserted_obj_s->LIRS.in_cache = true;
-
-      cache_obj_t *inserted_obj_q = params->LRU_q->insert(params->LRU_q, req);
-      inserted_obj_q->LIRS.is_LIR = false;
-      inserted_obj_q->LIRS.in_cache = true;
-
-      params->hirs_count += inserted_obj_s->obj_size;
-      cache->occupied_byte += inserted_obj_s->obj_size + cache->obj_md_size;
-    }
-    cache->n_obj += 1;
+    S_push(cache, obj, true, true);
+    params->lirs_count += obj->obj_size;
+  } else {
+    // when LIR block set is full, all reference blocks are given an HIR
+    // status, and when HIR block set is also full, the circumstance is same as
+    // accessing an HIR non-resident not in S, the space has been made
+    // in LIRS_can_insert
+    S_push(cache, obj, false, true);
+    Q_push(cache, obj);
+    params->hirs_count += obj->obj_size;
   }
-  return NULL;
+  cache->occupied_byte += obj->obj_size + cache->obj_md_size;
+  cache->n_obj += 1;
+
+  return obj;
 }
 
 /**
@@ -368,12 +481,11 @@ static cache_obj_t *LIRS_to_evict(cache_t *cache, const request_t *req) {
 static void LIRS_evict(cache_t *cache, const request_t *req) {
   LIRS_params_t *params = (LIRS_params_t *)(cache->eviction_params);
 
-  cache_obj_t *obj_s = params->LRU_s->find(params->LRU_s, req, false);
-  cache_obj_t *obj_q = params->LRU_q->find(params->LRU_q, req, false);
+  cache_obj_t *obj = hashtable_find(cache->hashtable, req);
 
   // Upon accessing an HIR non-resident in S
-  if (obj_s != NULL && obj_s->LIRS.is_LIR == false &&
-      obj_s->LIRS.in_cache == false) {
+  if (obj != NULL && obj->LIRS.in_s && obj->LIRS.is_LIR == false &&
+      obj->LIRS.in_cache == false) {
     // remove the HIR resident at the front of Q
     while (params->hirs_count >= params->hirs_limit) {
       evictHIR(cache);
@@ -383,16 +495,8 @@ static void LIRS_evict(cache_t *cache, const request_t *req) {
     evictLIR(cache);
   }
 
-  // Upon accessing an HIR non-resident in Q
-  if (obj_s == NULL && obj_q != NULL && obj_q->LIRS.in_cache == false) {
-    // remove the HIR resident at the front of Q
-    while (params->hirs_count >= params->hirs_limit) {
-      evictHIR(cache);
-    }
-  }
-
   // Upon accessing blocks neither in S nor Q
-  if (obj_s == NULL && obj_q == NULL) {
+  if (obj == NULL) {
     if (params->lirs_count + req->obj_size > params->lirs_limit &&
         params->hirs_count + req->obj_size > params->hirs_limit) {
       // when both LIR and HIR block sets are full,
@@ -420,46 +524,46 @@ static void LIRS_evict(cache_t *cache, const request_t *req) {
 static bool LIRS_remove(cache_t *cache, obj_id_t obj_id) {
   LIRS_params_t *params = (LIRS_params_t *)(cache->eviction_params);
 
-  cache_obj_t *obj_s = hashtable_find_obj_id(params->LRU_s->hashtable, obj_id);
-  cache_obj_t *obj_q = hashtable_find_obj_id(params->LRU_q->hashtable, obj_id);
+  cache_obj_t *obj = hashtable_find_obj_id(cache->hashtable, obj_id);
+  if (obj == NULL) {
+    // object neither in S nor Q stack
+    if (params->nh_fp != NULL) {
+      fp_ghost_remove(params->nh_fp, obj_id);
+    }
+    return false;
+  }
 
   // object in S stack (or in Q stack)
-  if (obj_s != NULL) {
-    if (obj_s->LIRS.is_LIR) {
-      params->LRU_s->remove(params->LRU_s, obj_id);
-      params->lirs_count -= obj_s->obj_size;
-      cache->occupied_byte -= obj_s->obj_size;
+  if (obj->LIRS.in_s) {
+    S_unlink(cache, obj);
+    if (obj->LIRS.is_LIR) {
+      params->lirs_count -= obj->obj_size;
+      cache->occupied_byte -= obj->obj_size;
       cache->n_obj--;
+      hashtable_delete(cache->hashtable, obj);
       LIRS_prune(cache);
-    } else {
-      if (obj_s->LIRS.in_cache) {
-        params->LRU_s->remove(params->LRU_s, obj_id);
-        params->hirs_count -= obj_s->obj_size;
-        cache->occupied_byte -= obj_s->obj_size;
-        cache->n_obj--;
-      } else {
-        params->LRU_s->remove(params->LRU_s, obj_id);
-        params->nonresident -= obj_s->obj_size;
-      }
-      if (obj_q != NULL) {
-        params->LRU_q->remove(params->LRU_q, obj_id);
-      }
+      return true;
     }
-  } else if (obj_q != NULL) {
-    // object only in Q stack
-    params->LRU_q->remove(params->LRU_q, obj_id);
-    if (obj_q->LIRS.in_cache) {
-      params->hirs_count -= obj_q->obj_size;
-      cache->occupied_byte -= obj_q->obj_size;
+
+    if (obj->LIRS.in_cache) {
+      params->hirs_count -= obj->obj_size;
+      cache->occupied_byte -= obj->obj_size;
       cache->n_obj--;
     } else {
-      assert(false);
-      return false;
+      NH_remove(cache, obj);
+    }
+    if (obj->LIRS.in_q) {
+      Q_unlink(cache, obj);
     }
   } else {
-    // object neither in S nor Q stack
-    return false;
+    // object only in Q stack
+    DEBUG_ASSERT(obj->LIRS.in_q);
+    Q_unlink(cache, obj);
+    params->hirs_count -= obj->obj_size;
+    cache->occupied_byte -= obj->obj_size;
+    cache->n_obj--;
   }
+  hashtable_delete(cache->hashtable, obj);
 
   return true;
 }
@@ -480,30 +584,25 @@ bool LIRS_can_insert(cache_t *cache, const request_t *req) {
     return false;
   }
   LIRS_params_t *params = (LIRS_params_t *)cache->eviction_params;
-  cache_obj_t *obj_s = params->LRU_s->find(params->LRU_s, req, false);
-  cache_obj_t *obj_q = params->LRU_q->find(params->LRU_q, req, false);
+  cache_obj_t *obj = hashtable_find(cache->hashtable, req);
 
   // accessing an HIR non-resident in S
-  if (obj_s != NULL && obj_s->LIRS.is_LIR == false &&
-      obj_s->LIRS.in_cache == false) {
-    while (params->lirs_count + obj_s->obj_size > params->lirs_limit) {
+  if (obj != NULL && obj->LIRS.in_s && obj->LIRS.is_LIR == false &&
+      obj->LIRS.in_cache == false) {
+    while (params->lirs_count + obj->obj_size > params->lirs_limit) {
       evictLIR(cache);
     }
 
-    bool res = params->LRU_nh->remove(params->LRU_nh, obj_s->obj_id);
-    if (res) {
-      params->nonresident -= obj_s->obj_size;
-    }
+    NH_remove(cache, obj);
 
     return true;
   }
 
   // accessing blocks neither in S nor Q
-  if (obj_s == NULL && obj_q == NULL) {
+  if (obj == NULL) {
     if (req->obj_size > params->lirs_limit ||
         req->obj_size > params->hirs_limit) {
       WARN_ONCE("object size too large\n");
-      // printf("request num: %ld\n", cache->n_req);
       return false;
     }
     if (params->lirs_count + req->obj_size > params->lirs_limit &&
@@ -523,162 +622,194 @@ bool LIRS_can_insert(cache_t *cache, const request_t *req) {
   abort();
 }
 
+/* remove the HIR blocks at the bottom of S until the bottom is an LIR block,
+ * each block is pruned at most once after it is pushed to S */
 static void LIRS_prune(cache_t *cache) {
   LIRS_params_t *params = (LIRS_params_t *)(cache->eviction_params);
-  cache_t *LRU_s = params->LRU_s;
-
-  LRU_params_t *lru_s_params = (LRU_params_t *)(LRU_s->eviction_params);
-  cache_obj_t *obj_to_remove = lru_s_params->q_tail;
 
-  while (obj_to_remove != lru_s_params->q_head) {
+  cache_obj_t *obj_to_remove = params->s_tail;
+  while (obj_to_remove != params->s_head) {
     if (obj_to_remove->LIRS.is_LIR) {
       break;
     }
 
-    // remove obj from LRU_nh
     if (obj_to_remove->LIRS.in_cache == false) {
-      bool res = params->LRU_nh->remove(params->LRU_nh, obj_to_remove->obj_id);
-      if (res) {
-        params->nonresident -= obj_to_remove->obj_size;
-      }
+      NH_remove(cache, obj_to_remove);
     }
-    // remove the obj from stack S
-    LRU_s->evict(LRU_s, NULL);
-    obj_to_remove = lru_s_params->q_tail;
+    // remove the obj from stack S, a resident HIR block stays in Q
+    S_unlink(cache, obj_to_remove);
+    LIRS_free_obj_if_unused(cache, obj_to_remove);
+    obj_to_remove = params->s_tail;
   }
 }
 
-static cache_obj_t *hit_RD_HIRinS(cache_t *cache, cache_obj_t *cache_obj_s,
-                                  cache_obj_t *cache_obj_q) {
+static cache_obj_t *hit_RD_HIRinS(cache_t *cache, cache_obj_t *obj) {
   LIRS_params_t *params = (LIRS_params_t *)(cache->eviction_params);
 
-  if (cache_obj_q != NULL) {
-    params->hirs_count -= cache_obj_q->obj_size;
-    params->LRU_q->remove(params->LRU_q, cache_obj_q->obj_id);
-    cache->occupied_byte -= cache_obj_q->obj_size;
+  if (obj->LIRS.in_q) {
+    params->hirs_count -= obj->obj_size;
+    Q_unlink(cache, obj);
+    cache->occupied_byte -= obj->obj_size;
     cache->n_obj--;
   }
 
-  while (params->lirs_count + cache_obj_s->obj_size > params->lirs_limit) {
+  while (params->lirs_count + obj->obj_size > params->lirs_limit) {
     evictLIR(cache);
   }
-  cache_obj_s->LIRS.is_LIR = true;
-  params->lirs_count += cache_obj_s->obj_size;
+  obj->LIRS.is_LIR = true;
+  params->lirs_count += obj->obj_size;
 
-  cache->occupied_byte += cache_obj_s->obj_size;
+  cache->occupied_byte += obj->obj_size;
   cache->n_obj++;
 
-  return cache_obj_s;
-}
-
-static cache_obj_t *hit_NR_HIRinS(cache_t *cache, cache_obj_t *cache_obj_s) {
-  LIRS_params_t *params = (LIRS_params_t *)(cache->eviction_params);
-
-  bool res = params->LRU_nh->remove(params->LRU_nh, cache_obj_s->obj_id);
-  if (res) {
-    params->nonresident -= cache_obj_s->obj_size;
-  }
-  return NULL;
+  return obj;
 }
 
-static cache_obj_t *hit_RD_HIRinQ(cache_t *cache, cache_obj_t *cache_obj_q) {
+static cache_obj_t *hit_RD_HIRinQ(cache_t *cache, cache_obj_t *obj) {
   LIRS_params_t *params = (LIRS_params_t *)(cache->eviction_params);
 
-  static __thread request_t *req_local = NULL;
-  if (req_local == NULL) {
-    req_local = new_request();
-  }
-  copy_cache_obj_to_request(req_local, cache_obj_q);
+  request_t *req_local = params->req_local;
+  copy_cache_obj_to_request(req_local, obj);
 
-  while (params->lirs_count + cache_obj_q->obj_size > params->lirs_limit) {
+  while (params->lirs_count + req_local->obj_size > params->lirs_limit) {
     evictLIR(cache);
   }
-  params->LRU_s->insert(params->LRU_s, req_local);
-  cache_obj_t *obj_to_update =
-      params->LRU_s->find(params->LRU_s, req_local, false);
-  obj_to_update->LIRS.is_LIR = false;
-  obj_to_update->LIRS.in_cache = true;
+  /* making space may have evicted the object from Q */
+  obj = LIRS_get_or_create_obj(cache, req_local);
+  S_push(cache, obj, false, true);
 
-  return obj_to_update;
+  return obj;
 }
 
+/* move the LIR block at the bottom of S to Q */
 static void evictLIR(cache_t *cache) {
   LIRS_params_t *params = (LIRS_params_t *)(cache->eviction_params);
-  cache_obj_t *obj_to_evict = params->LRU_s->to_evict(params->LRU_s, NULL);
+  cache_obj_t *obj = params->s_tail;
+  DEBUG_ASSERT(obj != NULL);
 
-  static __thread request_t *req_local = NULL;
-  if (req_local == NULL) {
-    req_local = new_request();
-  }
-  copy_cache_obj_to_request(req_local, obj_to_evict);
-  params->lirs_count -= obj_to_evict->obj_size;
-  params->LRU_s->evict(params->LRU_s, NULL);
+  int64_t obj_size = obj->obj_size;
+  params->lirs_count -= obj_size;
+  S_unlink(cache, obj);
 
-  cache->occupied_byte -= (req_local->obj_size + cache->obj_md_size);
+  cache->occupied_byte -= (obj_size + cache->obj_md_size);
   cache->n_obj -= 1;
 
-  if (req_local->obj_size <= params->hirs_limit) {
-    while (params->hirs_count + req_local->obj_size > params->hirs_limit) {
+  /* the bottom of S is an LIR block after pruning unless S has one block */
+  NH_remove(cache, obj);
+  if (obj->LIRS.in_q) {
+    Q_unlink(cache, obj);
+    params->hirs_count -= obj_size;
+  }
+
+  if (obj_size <= params->hirs_limit) {
+    while (params->hirs_count + obj_size > params->hirs_limit) {
       evictHIR(cache);
     }
-    params->LRU_q->insert(params->LRU_q, req_local);
-
-    cache_obj_t *obj_to_update =
-        params->LRU_q->find(params->LRU_q, req_local, false);
-    obj_to_update->LIRS.is_LIR = false;
-    obj_to_update->LIRS.in_cache = true;
+    Q_push(cache, obj);
 
-    params->hirs_count += req_local->obj_size;
-    cache->occupied_byte += (req_local->obj_size + cache->obj_md_size);
+    params->hirs_count += obj_size;
+    cache->occupied_byte += (obj_size + cache->obj_md_size);
     cache->n_obj += 1;
+  } else {
+    LIRS_free_obj_if_unused(cache, obj);
   }
 
   LIRS_prune(cache);
 }
 
+/* evict the HIR block at the front of Q, it becomes non-resident if in S */
 static bool evictHIR(cache_t *cache) {
   LIRS_params_t *params = (LIRS_params_t *)(cache->eviction_params);
-
-  cache_obj_t *obj_to_evict = params->LRU_q->to_evict(params->LRU_q, NULL);
-
-  // update the corresponding block in S to be non-resident
-  static __thread request_t *req_local = NULL;
-  if (req_local == NULL) {
-    req_local = new_request();
-  }
-  copy_cache_obj_to_request(req_local, obj_to_evict);
-
-  params->hirs_count -= obj_to_evict->obj_size;
-  params->LRU_q->evict(params->LRU_q, NULL);
-
-  cache_obj_t *obj_to_update =
-      params->LRU_s->find(params->LRU_s, req_local, false);
-  if (obj_to_update != NULL) {
-    obj_to_update->LIRS.in_cache = false;
-    params->LRU_nh->insert(params->LRU_nh, req_local);
-    params->nonresident += obj_to_update->obj_size;
+  cache_obj_t *obj = params->q_tail;
+  DEBUG_ASSERT(obj != NULL);
+
+  int64_t obj_size = obj->obj_size;
+  params->hirs_count -= obj_size;
+  Q_unlink(cache, obj);
+
+  if (obj->LIRS.in_s && params->nh_fp != NULL) {
+    S_unlink(cache, obj);
+    fp_ghost_insert_value(params->nh_fp, obj->obj_id,
+                          obj_size + cache->obj_md_size, obj->LIRS.s_seq);
+  } else if (obj->LIRS.in_s) {
+    obj->LIRS.in_cache = false;
+    NH_push(cache, obj);
+    params->nonresident += obj_size;
   }
 
-  cache->occupied_byte -= (req_local->obj_size + cache->obj_md_size);
+  cache->occupied_byte -= (obj_size + cache->obj_md_size);
   cache->n_obj -= 1;
 
+  LIRS_free_obj_if_unused(cache, obj);
+
   return true;
 }
 
+/* limit the size of S by removing the oldest non-resident blocks */
 static void limitStack(cache_t *cache) {
   LIRS_params_t *params = (LIRS_params_t *)cache->eviction_params;
 
-  while (params->LRU_s->occupied_byte > (2 * cache->cache_size)) {
-    cache_obj_t *obj_to_evict = params->LRU_nh->to_evict(params->LRU_nh, NULL);
-    if (obj_to_evict) {
-      params->nonresident -= obj_to_evict->obj_size;
-      params->LRU_s->remove(params->LRU_s, obj_to_evict->obj_id);
-      params->LRU_nh->evict(params->LRU_nh, NULL);
-    } else {
+  if (params->nh_fp != NULL) {
+    while (params->s_byte + params->nh_fp->occupied_byte >
+               2 * cache->cache_size &&
+           fp_ghost_remove_oldest(params->nh_fp)) {
+    }
+  }
+
+  while (params->s_byte > (2 * cache->cache_size)) {
+    cache_obj_t *obj = params->nh_tail;
+    if (obj == NULL) {
       break;
     }
+    DEBUG_ASSERT(obj->LIRS.in_s);
+    S_unlink(cache, obj);
+    NH_remove(cache, obj);
+    LIRS_free_obj_if_unused(cache, obj);
   }
 }
+// ***********************************************************************
+// ****                                                               ****
+// ****                parameter set up functions                     ****
+// ****                                                               ****
+// ***********************************************************************
+static const char *LIRS_current_params(LIRS_params_t *params) {
+  static __thread char params_str[128];
+  snprintf(params_str, 128, "ghost-fp-rate=%.4lf\n", params->ghost_fp_rate);
+  return params_str;
+}
+
+static void LIRS_parse_params(cache_t *cache,
+                              const char *cache_specific_params) {
+  LIRS_params_t *params = (LIRS_params_t *)(cache->eviction_params);
+
+  char *params_str = strdup(cache_specific_params);
+  char *old_params_str = params_str;
+
+  while (params_str != NULL && params_str[0] != '\0') {
+    /* different parameters are separated by comma,
+     * key and value are separated by = */
+    char *key = strsep((char **)&params_str, "=");
+    char *value = strsep((char **)&params_str, ",");
+
+    // skip the white space
+    while (params_str != NULL && *params_str == ' ') {
+      params_str++;
+    }
+
+    if (strcasecmp(key, "ghost-fp-rate") == 0) {
+      params->ghost_fp_rate = strtod(value, NULL);
+    } else if (strcasecmp(key, "print") == 0) {
+      printf("parameters: %s\n", LIRS_current_params(params));
+      exit(0);
+    } else {
+      ERROR("%s does not have parameter %s\n", cache->cache_name, key);
+      exit(1);
+    }
+  }
+
+  free(old_params_str);
+}
+
 // ***********************************************************************
 // ****                                                               ****
 // ****                       debug functions                         ****
@@ -690,7 +821,7 @@ static void LIRS_print_cache(cache_t *cache) {
   printf("S Stack:  %lu:%lu %lu:%lu \n", (unsigned long)params->lirs_limit,
          (unsigned long)params->lirs_count, (unsigned long)params->hirs_limit,
          (unsigned long)params->hirs_count);
-  cache_obj_t *obj = ((LRU_params_t *)params->LRU_s->eviction_params)->q_head;
+  cache_obj_t *obj = params->s_head;
   while (obj) {
     printf("%ld(%lu, %s, %s)->", (long)obj->obj_id, obj->obj_size,
            obj->LIRS.in_cache ? "R" : "N", obj->LIRS.is_LIR ? "L" : "H");
@@ -699,21 +830,18 @@ static void LIRS_print_cache(cache_t *cache) {
   printf("\n");
 
   printf("Q Stack: \n");
-  cache_obj_t *obj_q = ((LRU_params_t *)params->LRU_q->eviction_params)->q_head;
+  cache_obj_t *obj_q = params->q_head;
   while (obj_q) {
-    printf("%ld(%lu, %s, %s)->", (long)obj_q->obj_id, obj_q->obj_size,
-           obj_q->LIRS.in_cache ? "R" : "N", obj_q->LIRS.is_LIR ? "L" : "H");
-    obj_q = obj_q->queue.next;
+    printf("%ld(%lu, R, H)->", (long)obj_q->obj_id, obj_q->obj_size);
+    obj_q = obj_q->LIRS.q_next;
   }
   printf("\n");
 
   printf("NH Stack: \n");
-  cache_obj_t *obj_nh =
-      ((LRU_params_t *)params->LRU_nh->eviction_params)->q_head;
+  cache_obj_t *obj_nh = params->nh_head;
   while (obj_nh) {
-    printf("%ld(%lu, %s, %s)->", (long)obj_nh->obj_id, obj_nh->obj_size,
-           obj_nh->LIRS.in_cache ? "R" : "N", obj_nh->LIRS.is_LIR ? "L" : "H");
-    obj_nh = obj_nh->queue.next;
+    printf("%ld(%lu, N, H)->", (long)obj_nh->obj_id, obj_nh->obj_size);
+    obj_nh = obj_nh->LIRS.q_next;
   }
   printf("\n\n");
 }
@@ -722,7 +850,7 @@ static void LIRS_print_cache_compared_to_cacheus(cache_t *cache) {
   LIRS_params_t *params = (LIRS_params_t *)cache->eviction_params;
 
   printf("S:\n");
-  cache_obj_t *obj = ((LRU_params_t *)params->LRU_s->eviction_params)->q_tail;
+  cache_obj_t *obj = params->s_tail;
   while (obj) {
     printf("(o=%ld, is_LIR=%s, in_cache=%s)\n", (long)obj->obj_id,
            obj->LIRS.is_LIR ? "True" : "False",
@@ -731,22 +859,17 @@ static void LIRS_print_cache_compared_to_cacheus(cache_t *cache) {
   }
 
   printf("Q:\n");
-  cache_obj_t *obj_q = ((LRU_params_t *)params->LRU_q->eviction_params)->q_tail;
+  cache_obj_t *obj_q = params->q_tail;
   while (obj_q) {
-    printf("(o=%ld, is_LIR=%s, in_cache=%s)\n", (long)obj_q->obj_id,
-           obj_q->LIRS.is_LIR ? "True" : "False",
-           obj_q->LIRS.in_cache ? "True" : "False");
-    obj_q = obj_q->queue.prev;
+    printf("(o=%ld, is_LIR=False, in_cache=True)\n", (long)obj_q->obj_id);
+    obj_q = obj_q->LIRS.q_prev;
   }
 
   printf("NH:\n");
-  cache_obj_t *obj_nh =
-      ((LRU_params_t *)params->LRU_nh->eviction_params)->q_tail;
+  cache_obj_t *obj_nh = params->nh_tail;
   while (obj_nh) {
-    printf("(o=%ld, is_LIR=%s, in_cache=%s)\n", (long)obj_nh->obj_id,
-           obj_nh->LIRS.is_LIR ? "True" : "False",
-           obj_nh->LIRS.in_cache ? "True" : "False");
-    obj_nh = obj_nh->queue.prev;
+    printf("(o=%ld, is_LIR=False, in_cache=False)\n", (long)obj_nh->obj_id);
+    obj_nh = obj_nh->LIRS.q_prev;
   }
   printf("\n");
 }
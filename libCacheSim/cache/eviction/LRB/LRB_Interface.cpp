@@ -19,13 +19,15 @@ extern "C" {
 typedef struct {
   void *LRB_cache;
   char *objective;
+  bool async_training;
   SimpleRequest lrb_req;
 
   pair<uint64_t, uint32_t> to_evict_pair;
   cache_obj_t obj_tmp;
 } LRB_params_t;
 
-static const char *DEFAULT_PARAMS = "objective=byte-miss-ratio";
+static const char *DEFAULT_PARAMS =
+    "objective=byte-miss-ratio,async-training=0";
 
 // ***********************************************************************
 // ****                                                               ****
@@ -95,10 +97,9 @@ cache_t *LRB_init(const common_cache_params_t ccache_params,
   memset(params, 0, sizeof(LRB_params_t));
   cache->eviction_params = params;
 
+  LRB_parse_params(cache, DEFAULT_PARAMS);
   if (cache_specific_params != NULL) {
     LRB_parse_params(cache, cache_specific_params);
-  } else {
-    LRB_parse_params(cache, DEFAULT_PARAMS);
   }
 
   auto *lrb = new lrb::LRBCache();
@@ -109,6 +110,7 @@ cache_t *LRB_init(const common_cache_params_t ccache_params,
   std::map<string, string> params_map;
 
   params_map["objective"] = params->objective;
+  params_map["async_training"] = params->async_training ? "1" : "0";
 
   if (strcmp(params->objective, "object-miss-ratio") == 0) {
     snprintf(cache->cache_name, CACHE_NAME_ARRAY_LEN, "%s", "LRB-OMR");
@@ -132,6 +134,7 @@ static void LRB_free(cache_t *cache) {
   auto *params = static_cast<LRB_params_t *>(cache->eviction_params);
   auto *LRB = static_cast<lrb::LRBCache *>(params->LRB_cache);
   delete LRB;
+  free(params->objective);
   free(cache->to_evict_candidate);
   my_free(sizeof(LRB_params_t), params);
   cache_struct_free(cache);
@@ -307,7 +310,8 @@ static int64_t LRB_get_occupied_byte(const cache_t *cache) {
 // ***********************************************************************
 static const char *LRB_current_params(cache_t *cache, LRB_params_t *params) {
   static __thread char params_str[128];
-  int n = snprintf(params_str, 128, "objective=%s", params->objective);
+  int n = snprintf(params_str, 128, "objective=%s,async-training=%d",
+                   params->objective, params->async_training);
 
   snprintf(cache->cache_name + n, 128 - n, "\n");
 
@@ -332,10 +336,13 @@ static void LRB_parse_params(cache_t *cache,
     }
 
     if (strcasecmp(key, "objective") == 0) {
+      free(params->objective);
       params->objective = strdup(value);
       if (params->objective == NULL) {
         ERROR("out of memory %s\n", strerror(errno));
       }
+    } else if (strcasecmp(key, "async-training") == 0) {
+      params->async_training = strtol(value, &end, 0) != 0;
     } else if (strcasecmp(key, "print") == 0) {
       printf("current parameters: %s\n", LRB_current_params(cache, params));
       exit(0);
@@ -11,71 +11,103 @@ using namespace chrono;
 using namespace std;
 using namespace lrb;
 
-void LRBCache::train() {
-    ++n_retrain;
+BoosterHandle LRBCache::fit(TrainingData *data, double &loss, double &time_ms) {
     auto timeBegin = chrono::system_clock::now();
-    if (booster) LGBM_BoosterFree(booster);
+    BoosterHandle new_booster;
+    data->pack();
     // create training dataset
     DatasetHandle trainData;
-    LGBM_DatasetCreateFromCSR(
-            static_cast<void *>(training_data->indptr.data()),
-            C_API_DTYPE_INT32,
-            training_data->indices.data(),
-            static_cast<void *>(training_data->data.data()),
+    LGBM_DatasetCreateFromMat(
+            static_cast<void *>(data->data.data()),
             C_API_DTYPE_FLOAT64,
-            training_data->indptr.size(),
-            training_data->data.size(),
+            data->n_row,
             n_feature,  //remove future t
-            map_to_string(training_params).c_str(),
+            0,  //column major
+            training_params_str.c_str(),
             nullptr,
             &trainData);
 
     LGBM_DatasetSetField(trainData,
                          "label",
-                         static_cast<void *>(training_data->labels.data()),
-                         training_data->labels.size(),
+                         static_cast<void *>(data->labels.data()),
+                         data->labels.size(),
                          C_API_DTYPE_FLOAT32);
 
     // init booster
-    LGBM_BoosterCreate(trainData, map_to_string(training_params).c_str(), &booster);
+    LGBM_BoosterCreate(trainData, training_params_str.c_str(), &new_booster);
     // train
-    for (int i = 0; i < stoi(training_params["num_iterations"]); i++) {
+    for (int i = 0; i < n_iterations; i++) {
         int isFinished;
-        LGBM_BoosterUpdateOneIter(booster, &isFinished);
+        LGBM_BoosterUpdateOneIter(new_booster, &isFinished);
         if (isFinished) {
             break;
         }
     }
 
     int64_t len;
-    vector<double> result(training_data->indptr.size() - 1);
-    LGBM_BoosterPredictForCSR(booster,
-                              static_cast<void *>(training_data->indptr.data()),
-                              C_API_DTYPE_INT32,
-                              training_data->indices.data(),
-                              static_cast<void *>(training_data->data.data()),
+    vector<double> result(data->n_row);
+    LGBM_BoosterPredictForMat(new_booster,
+                              static_cast<void *>(data->data.data()),
                               C_API_DTYPE_FLOAT64,
-                              training_data->indptr.size(),
-                              training_data->data.size(),
+                              data->n_row,
                               n_feature,  //remove future t
+                              0,  //column major
                               C_API_PREDICT_NORMAL,
                               0,
-                              atoi(training_params["num_iterations"].c_str()),
-                              map_to_string(training_params).c_str(),
+                              n_iterations,
+                              training_params_str.c_str(),
                               &len,
                               result.data());
 
 
     double se = 0;
     for (int i = 0; i < result.size(); ++i) {
-        auto diff = result[i] - training_data->labels[i];
+        auto diff = result[i] - data->labels[i];
         se += diff * diff;
     }
-    training_loss = training_loss * 0.99 + se / batch_size * 0.01;
+    loss = se / batch_size;
 
     LGBM_DatasetFree(trainData);
-    training_time = 0.95 * training_time +
-                    0.05 * chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now() - timeBegin).count();
+    time_ms = chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now() - timeBegin).count();
+    return new_booster;
+}
+
+void LRBCache::update_model(bool block) {
+    if (trainer.joinable()) {
+        if (!block && !model_ready.load(memory_order_acquire))
+            return;
+        trainer.join();
+    }
+    if (!next_booster)
+        return;
+
+    if (booster) LGBM_BoosterFree(booster);
+    booster = next_booster;
+    next_booster = nullptr;
+    training_loss = training_loss * 0.99 + next_training_loss * 0.01;
+    training_time = 0.95 * training_time + 0.05 * next_training_time;
+}
+
+void LRBCache::train() {
+    ++n_retrain;
+    // the previous batch is still in training, wait for it so that one model is trained at a time
+    update_model(true);
+
+    // double buffering, the request path fills one batch while the other is used for training
+    swap(training_data, training_data_in_training);
+    training_data->clear();
+
+    if (!async_training) {
+        next_booster = fit(training_data_in_training, next_training_loss, next_training_time);
+        update_model(true);
+        return;
+    }
+
+    model_ready.store(false, memory_order_relaxed);
+    trainer = thread([this]() {
+        next_booster = fit(training_data_in_training, next_training_loss, next_training_time);
+        model_ready.store(true, memory_order_release);
+    });
 }
 
 void LRBCache::sample() {
@@ -156,21 +188,20 @@ bool LRBCache::lookup(const SimpleRequest &req) {
             //batch_size ~>= batch_size
             if (training_data->labels.size() >= batch_size) {
                 train();
-                training_data->clear();
             }
             meta._sample_times.clear();
             meta._sample_times.shrink_to_fit();
         }
 
         //make this update after update training, otherwise the last timestamp will change
-        meta.update(current_seq, n_extra_fields, max_hash_edc_idx, edc_windows, hash_edc);
+        meta.update(current_seq, n_extra_fields, max_hash_edc_idx, edc_windows, hash_edc, meta_extra_pool);
         if (list_idx) {
             negative_candidate_queue->erase(forget_timestamp);
             negative_candidate_queue->insert({current_seq % memory_window, req.id});
             assert(negative_candidate_queue->find(current_seq % memory_window) !=
                    negative_candidate_queue->end());
         } else {
-            auto *p = dynamic_cast<InCacheMeta *>(&meta);
+            auto *p = static_cast<InCacheMeta *>(&meta);
             p->p_last_request = in_cache_lru_queue.re_request(p->p_last_request);
         }
         //update negative_candidate_queue
@@ -215,7 +246,6 @@ void LRBCache::forget() {
             //batch_size ~>= batch_size
             if (training_data->labels.size() >= batch_size) {
                 train();
-                training_data->clear();
             }
             meta._sample_times.clear();
             meta._sample_times.shrink_to_fit();
@@ -264,6 +294,7 @@ void LRBCache::admit(const SimpleRequest &req) {
 
 
 pair<uint64_t, uint32_t> LRBCache::rank() {
+    update_model(false);
 
     {
         //if not trained yet, or in_cache_lru past memory window, use LRU
@@ -281,19 +312,13 @@ pair<uint64_t, uint32_t> LRBCache::rank() {
         }
     }
 
-    int32_t indptr[sample_rate + 1];
-    indptr[0] = 0;
-    int32_t indices[sample_rate * n_feature];
-    double data[sample_rate * n_feature];
     int32_t past_timestamps[sample_rate];
     uint64_t sizes[sample_rate];
 
     unordered_set<uint64_t> key_set;
     uint64_t keys[sample_rate];
     uint32_t poses[sample_rate];
-    //next_past_timestamp, next_size = next_indptr - 1
 
-    unsigned int idx_feature = 0;
     unsigned int idx_row = 0;
 
     auto n_new_sample = sample_rate - idx_row;
@@ -310,50 +335,12 @@ pair<uint64_t, uint32_t> LRBCache::rank() {
 
         keys[idx_row] = meta._key;
         poses[idx_row] = pos;
-        //fill in past_interval
-        indices[idx_feature] = 0;
-        data[idx_feature++] = current_seq - meta._past_timestamp;
         past_timestamps[idx_row] = meta._past_timestamp;
-
-        uint8_t j = 0;
-        uint32_t this_past_distance = 0;
-        uint8_t n_within = 0;
-        if (meta._extra) {
-            for (j = 0; j < meta._extra->_past_distance_idx && j < max_n_past_distances; ++j) {
-                uint8_t past_distance_idx = (meta._extra->_past_distance_idx - 1 - j) % max_n_past_distances;
-                uint32_t &past_distance = meta._extra->_past_distances[past_distance_idx];
-                this_past_distance += past_distance;
-                indices[idx_feature] = j + 1;
-                data[idx_feature++] = past_distance;
-                if (this_past_distance < memory_window) {
-                    ++n_within;
-                }
-            }
-        }
-
-        indices[idx_feature] = max_n_past_timestamps;
-        data[idx_feature++] = meta._size;
         sizes[idx_row] = meta._size;
-
-        for (uint k = 0; k < n_extra_fields; ++k) {
-            indices[idx_feature] = max_n_past_timestamps + k + 1;
-            data[idx_feature++] = meta._extra_features[k];
-        }
-
-        indices[idx_feature] = max_n_past_timestamps + n_extra_fields + 1;
-        data[idx_feature++] = n_within;
-
-        for (uint8_t k = 0; k < n_edc_feature; ++k) {
-            indices[idx_feature] = max_n_past_timestamps + n_extra_fields + 2 + k;
-            uint32_t _distance_idx = min(uint32_t(current_seq - meta._past_timestamp) / edc_windows[k],
-                                         max_hash_edc_idx);
-            if (meta._extra)
-                data[idx_feature++] = meta._extra->_edc[k] * hash_edc[_distance_idx];
-            else
-                data[idx_feature++] = hash_edc[_distance_idx];
-        }
-        //remove future t
-        indptr[++idx_row] = idx_feature;
+        //the same dense features as the training batches, a missing past distance is 0 as it is in sparse input
+        fill_features(meta, current_seq, &inference_data[(size_t) idx_row * n_feature], 1, memory_window,
+                      max_hash_edc_idx, edc_windows, hash_edc);
+        ++idx_row;
     }
 
     int64_t len;
@@ -362,19 +349,16 @@ pair<uint64_t, uint32_t> LRBCache::rank() {
     //sample to measure inference time
     if (!(current_seq % 10000))
         timeBegin = chrono::system_clock::now();
-    LGBM_BoosterPredictForCSR(booster,
-                              static_cast<void *>(indptr),
-                              C_API_DTYPE_INT32,
-                              indices,
-                              static_cast<void *>(data),
+    LGBM_BoosterPredictForMat(booster,
+                              static_cast<void *>(inference_data.data()),
                               C_API_DTYPE_FLOAT64,
-                              idx_row + 1,
-                              idx_feature,
+                              idx_row,
                               n_feature,  //remove future t
+                              1,  //row major
                               C_API_PREDICT_NORMAL,
                               0,
-                              atoi(training_params["num_iterations"].c_str()),
-                              map_to_string(inference_params).c_str(),
+                              n_iterations,
+                              inference_params_str.c_str(),
                               &len,
                               scores);
     if (!(current_seq % 10000))
@@ -434,7 +418,6 @@ void LRBCache::evict_with_candidate(pair<uint64_t, uint32_t> &epair) {
             //batch_size ~>= batch_size
             if (training_data->labels.size() >= batch_size) {
                 train();
-                training_data->clear();
             }
             meta._sample_times.clear();
             meta._sample_times.shrink_to_fit();
@@ -443,7 +426,7 @@ void LRBCache::evict_with_candidate(pair<uint64_t, uint32_t> &epair) {
         in_cache_lru_queue.dq.erase(meta.p_last_request);
         meta.p_last_request = in_cache_lru_queue.dq.end();
         //above is suppose to be below, but to make sure the action is correct
-        meta.free();
+        meta.free(meta_extra_pool);
         _currentSize -= meta._size;
         key_map.erase(key);
 
@@ -477,7 +460,7 @@ void LRBCache::evict_with_candidate(pair<uint64_t, uint32_t> &epair) {
 
 void LRBCache::remove_from_outcache_metas(Meta &meta, unsigned int &pos, const uint64_t &key) {
     //free the actual content
-    meta.free();
+    meta.free(meta_extra_pool);
     //TODO: can add a function to delete from a queue with (key, pos)
     //evict
     uint32_t tail_pos = out_cache_metas.size() - 1;
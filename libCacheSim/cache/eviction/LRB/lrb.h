@@ -17,6 +17,11 @@
 #include <sstream>
 #include <fstream>
 #include <list>
+#include <thread>
+#include <atomic>
+#include <new>
+#include <cstddef>
+#include <cstring>
 
 using namespace webcachesim;
 using namespace std;
@@ -33,40 +38,54 @@ namespace lrb {
     static const uint32_t batch_size = 131072;
 
 
+//the number of past distances a MetaExtra of each size class has room for,
+//most objects have few past distances, so a MetaExtra starts small and moves to the next class when it is full
+static const uint8_t n_meta_extra_class = 5;
+static const uint8_t meta_extra_capacity[n_meta_extra_class] = {1, 3, 7, 15, max_n_past_distances};
+
 struct MetaExtra {
-    //vector overhead = 24 (8 pointer, 8 size, 8 allocation)
-    //40 + 24 + 4*x + 1
-    //65 byte at least
-    //189 byte at most
+    //40 + 4 + 4 * capacity = 48 to 168 byte, allocated from MetaExtraPool
     //not 1 hit wonder
     float _edc[10];
-    vector<uint32_t> _past_distances;
     //the next index to put the distance
     uint8_t _past_distance_idx = 1;
+    uint8_t _n_past_distances = 1;
+    uint8_t _size_class = 0;
+    //ring buffer of the past distances, only the first meta_extra_capacity[_size_class] are allocated,
+    //the distances are in order until the buffer has max_n_past_distances
+    uint32_t _past_distances[max_n_past_distances];
+
+    static size_t size(uint8_t size_class) {
+        return offsetof(MetaExtra, _past_distances) + sizeof(uint32_t) * meta_extra_capacity[size_class];
+    }
+
+    bool full() const {
+        return _n_past_distances == meta_extra_capacity[_size_class];
+    }
 
     MetaExtra(const uint32_t &distance,
     uint32_t max_hash_edc_idx,
     vector<uint32_t> &edc_windows,
     const vector<double> &hash_edc
     ) {
-        _past_distances = vector<uint32_t>(1, distance);
+        _past_distances[0] = distance;
         for (uint8_t i = 0; i < n_edc_feature; ++i) {
             uint32_t _distance_idx = min(uint32_t(distance / edc_windows[i]), max_hash_edc_idx);
             _edc[i] = hash_edc[_distance_idx] + 1;
         }
     }
 
+    //the caller moves a full MetaExtra to a larger size class first (see MetaExtraPool::grow)
     void update(const uint32_t &distance,
         uint32_t max_hash_edc_idx,
         vector<uint32_t> &edc_windows,
         const vector<double> &hash_edc
     ) {
         uint8_t distance_idx = _past_distance_idx % max_n_past_distances;
-        if (_past_distances.size() < max_n_past_distances)
-            _past_distances.emplace_back(distance);
-        else
-            _past_distances[distance_idx] = distance;
-        assert(_past_distances.size() <= max_n_past_distances);
+        assert(distance_idx < meta_extra_capacity[_size_class]);
+        _past_distances[distance_idx] = distance;
+        if (_n_past_distances < max_n_past_distances)
+            ++_n_past_distances;
         _past_distance_idx = _past_distance_idx + (uint8_t) 1;
         if (_past_distance_idx >= max_n_past_distances * 2)
             _past_distance_idx -= max_n_past_distances;
@@ -77,6 +96,54 @@ struct MetaExtra {
     }
 };
 
+//MetaExtra of each size class is allocated from slabs and reused through a free list,
+//so updating an object does not call malloc and there is no per-object allocator overhead
+class MetaExtraPool {
+public:
+    static const uint32_t slab_size = 65536;
+
+    MetaExtraPool() = default;
+    MetaExtraPool(const MetaExtraPool &) = delete;
+    MetaExtraPool &operator=(const MetaExtraPool &) = delete;
+
+    ~MetaExtraPool() {
+        for (auto slab: slabs)
+            ::operator delete(slab);
+    }
+
+    MetaExtra *alloc(uint8_t size_class) {
+        auto &free_list = free_lists[size_class];
+        if (free_list.empty()) {
+            size_t extra_size = MetaExtra::size(size_class);
+            auto *slab = static_cast<char *>(::operator new(extra_size * slab_size));
+            slabs.push_back(slab);
+            free_list.reserve(free_list.size() + slab_size);
+            for (uint32_t i = slab_size; i > 0; --i)
+                free_list.push_back(reinterpret_cast<MetaExtra *>(slab + extra_size * (i - 1)));
+        }
+        auto *extra = free_list.back();
+        free_list.pop_back();
+        return extra;
+    }
+
+    void release(MetaExtra *extra) {
+        free_lists[extra->_size_class].push_back(extra);
+    }
+
+    //move a full MetaExtra to the next size class
+    MetaExtra *grow(MetaExtra *extra) {
+        auto *larger = alloc(extra->_size_class + 1);
+        memcpy(static_cast<void *>(larger), extra, MetaExtra::size(extra->_size_class));
+        larger->_size_class = extra->_size_class + 1;
+        release(extra);
+        return larger;
+    }
+
+private:
+    vector<char *> slabs;
+    vector<MetaExtra *> free_lists[n_meta_extra_class];
+};
+
 class Meta {
 public:
     //25 byte
@@ -96,28 +163,32 @@ public:
             _extra_features[i] = extra_features[i];
     }
 
-    virtual ~Meta() = default;
-
     void emplace_sample(uint32_t &sample_t) {
         _sample_times.emplace_back(sample_t);
     }
 
-    void free() {
-        delete _extra;
+    void free(MetaExtraPool &pool) {
+        if (_extra)
+            pool.release(_extra);
+        _extra = nullptr;
     }
 
     void update(const uint32_t &past_timestamp, uint32_t n_extra_fields,
                 uint32_t max_hash_edc_idx,
                 vector<uint32_t> &edc_windows,
-                const vector<double> &hash_edc
+                const vector<double> &hash_edc,
+                MetaExtraPool &pool
     ) {
         //distance
         uint32_t _distance = past_timestamp - _past_timestamp;
         assert(_distance);
         if (!_extra) {
-            _extra = new MetaExtra(_distance, max_hash_edc_idx, edc_windows, hash_edc);
-        } else
+            _extra = new (pool.alloc(0)) MetaExtra(_distance, max_hash_edc_idx, edc_windows, hash_edc);
+        } else {
+            if (_extra->full() && _extra->_size_class + 1 < n_meta_extra_class)
+                _extra = pool.grow(_extra);
             _extra->update(_distance, max_hash_edc_idx, edc_windows, hash_edc);
+        }
         //timestamp
         _past_timestamp = past_timestamp;
     }
@@ -125,7 +196,7 @@ public:
     int feature_overhead() {
         int ret = sizeof(Meta);
         if (_extra)
-            ret += sizeof(MetaExtra) - sizeof(_sample_times) + _extra->_past_distances.capacity() * sizeof(uint32_t);
+            ret += MetaExtra::size(_extra->_size_class);
         return ret;
     }
 
@@ -174,92 +245,100 @@ public:
     }
 };
 
+//write the features of meta at timestamp to out[0], out[stride], ..., the past distances the object does not have are 0,
+//used for both the training batches and the eviction candidates so that the model sees the same inputs
+inline void fill_features(const Meta &meta, uint32_t timestamp, double *out, size_t stride, uint32_t memory_window,
+                          uint32_t max_hash_edc_idx, const vector<uint32_t> &edc_windows,
+                          const vector<double> &hash_edc) {
+    auto col = [&](uint32_t k) -> double & { return out[(size_t) k * stride]; };
+
+    col(0) = timestamp - meta._past_timestamp;
+
+    uint32_t this_past_distance = 0;
+    int j = 0;
+    uint8_t n_within = 0;
+    if (meta._extra) {
+        for (; j < meta._extra->_past_distance_idx && j < max_n_past_distances; ++j) {
+            uint8_t past_distance_idx = (meta._extra->_past_distance_idx - 1 - j) % max_n_past_distances;
+            const uint32_t &past_distance = meta._extra->_past_distances[past_distance_idx];
+            this_past_distance += past_distance;
+            col(j + 1) = past_distance;
+            if (this_past_distance < memory_window) {
+                ++n_within;
+            }
+        }
+    }
+    for (; j < max_n_past_distances; ++j)
+        col(j + 1) = 0;
+
+    col(max_n_past_timestamps) = meta._size;
+
+    for (int k = 0; k < n_extra_fields; ++k) {
+        col(max_n_past_timestamps + k + 1) = meta._extra_features[k];
+    }
+
+    col(max_n_past_timestamps + n_extra_fields + 1) = n_within;
+
+    for (int k = 0; k < n_edc_feature; ++k) {
+        uint32_t _distance_idx = std::min(uint32_t(timestamp - meta._past_timestamp) / edc_windows[k],
+                                          max_hash_edc_idx);
+        if (meta._extra)
+            col(max_n_past_timestamps + n_extra_fields + 2 + k) = meta._extra->_edc[k] * hash_edc[_distance_idx];
+        else
+            col(max_n_past_timestamps + n_extra_fields + 2 + k) = hash_edc[_distance_idx];
+    }
+}
+
+//a batch of training samples in a dense column-major matrix, the features that are not available are 0,
+//the matrix is allocated once and reused for every batch
 class TrainingData {
 public:
     vector<float> labels;
-    vector<int32_t> indptr;
-    vector<int32_t> indices;
+    //column k of the sample in row i is data[k * capacity + i]
     vector<double> data;
+    uint32_t n_feature;
+    uint32_t capacity;
+    uint32_t n_row = 0;
     uint32_t memory_window;
 
-    TrainingData(uint32_t n_feature, uint32_t memory_window_) {
+    TrainingData(uint32_t n_feature_, uint32_t memory_window_) {
+        n_feature = n_feature_;
+        capacity = batch_size;
         labels.reserve(batch_size);
-        indptr.reserve(batch_size + 1);
-        indptr.emplace_back(0);
-        indices.reserve(batch_size * n_feature);
-        data.reserve(batch_size * n_feature);
+        data.resize((size_t) capacity * n_feature);
         memory_window = memory_window_;
     }
 
+    //a batch can be larger than batch_size because all samples of an object are added at once
+    void grow() {
+        uint32_t new_capacity = capacity * 2;
+        vector<double> new_data((size_t) new_capacity * n_feature);
+        for (uint32_t k = 0; k < n_feature; ++k)
+            memcpy(&new_data[(size_t) k * new_capacity], &data[(size_t) k * capacity], sizeof(double) * n_row);
+        data.swap(new_data);
+        capacity = new_capacity;
+    }
+
     void emplace_back(Meta &meta, uint32_t &sample_timestamp, uint32_t &future_interval, const uint64_t &key,
         uint32_t max_hash_edc_idx, vector<uint32_t> &edc_windows, vector<double> &hash_edc) {
-        int32_t counter = indptr.back();
-
-        indices.emplace_back(0);
-        data.emplace_back(sample_timestamp - meta._past_timestamp);
-        ++counter;
-
-        uint32_t this_past_distance = 0;
-        int j = 0;
-        uint8_t n_within = 0;
-        if (meta._extra) {
-            for (; j < meta._extra->_past_distance_idx && j < max_n_past_distances; ++j) {
-                uint8_t past_distance_idx = (meta._extra->_past_distance_idx - 1 - j) % max_n_past_distances;
-                const uint32_t &past_distance = meta._extra->_past_distances[past_distance_idx];
-                this_past_distance += past_distance;
-                indices.emplace_back(j + 1);
-                data.emplace_back(past_distance);
-                if (this_past_distance < memory_window) {
-                    ++n_within;
-                }
-            }
-        }
-
-        counter += j;
-
-        indices.emplace_back(max_n_past_timestamps);
-        data.push_back(meta._size);
-        ++counter;
-
-        for (int k = 0; k < n_extra_fields; ++k) {
-            indices.push_back(max_n_past_timestamps + k + 1);
-            data.push_back(meta._extra_features[k]);
-        }
-        counter += n_extra_fields;
-
-        indices.push_back(max_n_past_timestamps + n_extra_fields + 1);
-        data.push_back(n_within);
-        ++counter;
-
-        if (meta._extra) {
-            for (int k = 0; k < n_edc_feature; ++k) {
-                indices.push_back(max_n_past_timestamps + n_extra_fields + 2 + k);
-                uint32_t _distance_idx = std::min(
-                        uint32_t(sample_timestamp - meta._past_timestamp) / edc_windows[k],
-                        max_hash_edc_idx);
-                data.push_back(meta._extra->_edc[k] * hash_edc[_distance_idx]);
-            }
-        } else {
-            for (int k = 0; k < n_edc_feature; ++k) {
-                indices.push_back(max_n_past_timestamps + n_extra_fields + 2 + k);
-                uint32_t _distance_idx = std::min(
-                        uint32_t(sample_timestamp - meta._past_timestamp) / edc_windows[k],
-                        max_hash_edc_idx);
-                data.push_back(hash_edc[_distance_idx]);
-            }
-        }
-
-        counter += n_edc_feature;
+        if (n_row == capacity)
+            grow();
+        fill_features(meta, sample_timestamp, &data[n_row], capacity, memory_window, max_hash_edc_idx, edc_windows,
+                      hash_edc);
 
         labels.push_back(log1p(future_interval));
-        indptr.push_back(counter);
+        ++n_row;
+    }
+
+    //LightGBM reads a column-major matrix with n_row rows, move the columns together
+    void pack() {
+        for (uint32_t k = 1; k < n_feature; ++k)
+            memmove(&data[(size_t) k * n_row], &data[(size_t) k * capacity], sizeof(double) * n_row);
     }
 
     void clear() {
         labels.clear();
-        indptr.resize(1);
-        indices.clear();
-        data.clear();
+        n_row = 0;
     }
 };
 
@@ -283,9 +362,13 @@ public:
     vector<InCacheMeta> in_cache_metas;
     vector<Meta> out_cache_metas;
 
+    MetaExtraPool meta_extra_pool;
+
     InCacheLRUQueue in_cache_lru_queue;
     shared_ptr<sparse_hash_map<uint64_t, uint64_t>> negative_candidate_queue;
-    TrainingData *training_data;
+    //the batch being filled, and the batch the trainer thread is using
+    TrainingData *training_data = nullptr;
+    TrainingData *training_data_in_training = nullptr;
 
     // sample_size: use n_memorize keys + random choose (sample_rate - n_memorize) keys
     uint sample_rate = 64;
@@ -297,6 +380,17 @@ public:
     double inference_time = 0;
 
     BoosterHandle booster = nullptr;
+    //the features of the eviction candidates, a dense row-major matrix of sample_rate rows
+    vector<double> inference_data;
+
+    //train in a background thread, the model in use is replaced when the new one is ready,
+    //off by default because the miss ratio then depends on the thread timing
+    bool async_training = false;
+    thread trainer;
+    atomic<bool> model_ready{false};
+    BoosterHandle next_booster = nullptr;
+    double next_training_loss = 0;
+    double next_training_time = 0;
 
     unordered_map<string, string> training_params = {
             //don't use alias here. C api may not recognize
@@ -314,6 +408,10 @@ public:
     };
 
     unordered_map<string, string> inference_params;
+    //the parameters as strings, so that they are not built for every prediction
+    string training_params_str;
+    string inference_params_str;
+    int n_iterations;
 
     enum ObjectiveT : uint8_t {
         byte_miss_ratio = 0, object_miss_ratio = 1
@@ -350,6 +448,8 @@ public:
                 training_params["num_threads"] = it.second;
             } else if (it.first == "num_leaves") {
                 training_params["num_leaves"] = it.second;
+            } else if (it.first == "async_training") {
+                async_training = stoi(it.second) != 0;
             } else if (it.first == "byte_million_req") {
                 byte_million_req = stoull(it.second);
             } else if (it.first == "n_edc_feature") {
@@ -397,7 +497,21 @@ public:
             training_params["categorical_feature"] = categorical_feature;
         }
         inference_params = training_params;
+        training_params_str = map_to_string(training_params);
+        inference_params_str = map_to_string(inference_params);
+        n_iterations = stoi(training_params["num_iterations"]);
         training_data = new TrainingData(n_feature, memory_window);
+        training_data_in_training = new TrainingData(n_feature, memory_window);
+        inference_data.resize((size_t) sample_rate * n_feature);
+    }
+
+    ~LRBCache() override {
+        if (trainer.joinable())
+            trainer.join();
+        if (next_booster) LGBM_BoosterFree(next_booster);
+        if (booster) LGBM_BoosterFree(booster);
+        delete training_data;
+        delete training_data_in_training;
     }
 
     string map_to_string(unordered_map<string, string> &map) {
@@ -422,8 +536,16 @@ public:
     //sample, rank the 1st and return
     pair<uint64_t, uint32_t> rank();
 
+    //start training on the current batch, in the background if async_training
     void train();
 
+    //train a model on data, it does not change the cache so it can run in the trainer thread
+    BoosterHandle fit(TrainingData *data, double &loss, double &time_ms);
+
+    //replace the model in use with the model trained in the background if it is ready,
+    //if block, wait for the trainer
+    void update_model(bool block);
+
     void sample();
 
     void update_stat_periodic() override;
@@ -450,14 +572,14 @@ public:
             if (nullptr == meta._extra) {
                 ++distribution[0];
             } else {
-                ++distribution[meta._extra->_past_distances.size()];
+                ++distribution[meta._extra->_n_past_distances];
             }
         }
         for (auto &meta: out_cache_metas) {
             if (nullptr == meta._extra) {
                 ++distribution[0];
             } else {
-                ++distribution[meta._extra->_past_distances.size()];
+                ++distribution[meta._extra->_n_past_distances];
             }
         }
         return distribution;
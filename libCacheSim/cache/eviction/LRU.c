@@ -11,6 +11,7 @@
 
 #include "../../dataStructure/hashtable/hashtable.h"
 #include "../../include/libCacheSim/evictionAlgo.h"
+#include "../getSpecialized.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -33,6 +34,10 @@ static cache_obj_t *LRU_to_evict(cache_t *cache, const request_t *req);
 static void LRU_evict(cache_t *cache, const request_t *req);
 static bool LRU_remove(cache_t *cache, const obj_id_t obj_id);
 static void LRU_print_cache(const cache_t *cache);
+static void LRU_copy_state(cache_t *cache, const cache_t *src_cache);
+
+DEFINE_CACHE_GET_SPECIALIZED(LRU, cache_can_insert_no_admissioner,
+                             cache_get_occupied_byte_default)
 
 // ***********************************************************************
 // ****                                                               ****
@@ -53,6 +58,7 @@ cache_t *LRU_init(const common_cache_params_t ccache_params,
   cache->cache_init = LRU_init;
   cache->cache_free = LRU_free;
   cache->get = LRU_get;
+  cache->get_specialized = LRU_get_specialized;
   cache->find = LRU_find;
   cache->insert = LRU_insert;
   cache->evict = LRU_evict;
@@ -62,6 +68,7 @@ cache_t *LRU_init(const common_cache_params_t ccache_params,
   cache->can_insert = cache_can_insert_default;
   cache->get_n_obj = cache_get_n_obj_default;
   cache->print_cache = LRU_print_cache;
+  cache->copy_state = LRU_copy_state;
 
   if (ccache_params.consider_obj_metadata) {
     cache->obj_md_size = 8 * 2;
@@ -265,6 +272,20 @@ static bool LRU_remove(cache_t *cache, const obj_id_t obj_id) {
   return true;
 }
 
+/**
+ * @brief copy the objects and the LRU queue from src_cache to an empty cache
+ *
+ * @param cache
+ * @param src_cache
+ */
+static void LRU_copy_state(cache_t *cache, const cache_t *src_cache) {
+  LRU_params_t *params = (LRU_params_t *)cache->eviction_params;
+  const LRU_params_t *src_params = (const LRU_params_t *)src_cache->eviction_params;
+
+  cache_copy_queue_base(cache, src_params->q_tail, &params->q_head,
+                        &params->q_tail);
+}
+
 static void LRU_print_cache(const cache_t *cache) {
   LRU_params_t *params = (LRU_params_t *)cache->eviction_params;
   cache_obj_t *cur = params->q_head;
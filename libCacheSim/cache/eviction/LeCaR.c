@@ -4,15 +4,19 @@
  * performance, but it is harder to follow. LeCaR0 is a simpler implementation,
  * it has a lower throughput.
  *
+ * with ghost-fp-rate > 0, the eviction histories store fingerprints and the
+ * eviction time (see fingerprintGhost.h) instead of the evicted objects
+ *
  * */
 
 #include <assert.h>
-#include <glib.h>
 #include <math.h>
 
+#include "../../dataStructure/fingerprintGhost.h"
 #include "../../dataStructure/hashtable/hashtable.h"
 #include "../../include/libCacheSim/evictionAlgo.h"
 #include "../../include/libCacheSim/logging.h"
+#include "../freqBucket.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -22,15 +26,20 @@ extern "C" {
 
 static const char *DEFAULT_PARAMS = "update-weight=1,lru-weight=0.5";
 
+/* the regret discount of a history hit t requests after the eviction is
+ * cached for t below this */
+#define REGRET_DISCOUNT_TABLE_SIZE (1 << 16)
+/* for larger t, dr^t is dr^(hi * REGRET_DISCOUNT_TABLE_SIZE) * dr^lo, the two
+ * powers are cached, so a hit computes one exp and no pow for t below
+ * REGRET_DISCOUNT_TABLE_SIZE * REGRET_POW_HI_TABLE_SIZE (2^30) */
+#define REGRET_POW_HI_TABLE_SIZE (1 << 14)
+
 typedef struct LeCaR_params {
   cache_obj_t *q_head;
   cache_obj_t *q_tail;
 
-  // used for LFU
-  freq_node_t *freq_one_node;
-  GHashTable *freq_map;
-  uint64_t min_freq;
-  uint64_t max_freq;
+  // used for LFU, objects in a freq bucket are linked by LeCaR.lfu_prev/next
+  freq_bucket_list_t freq_buckets;
 
   // eviction history
   cache_obj_t *ghost_lru_head;
@@ -41,20 +50,26 @@ typedef struct LeCaR_params {
   cache_obj_t *ghost_lfu_tail;
   int64_t lfu_g_occupied_byte;
 
+  /* used instead of the ghost lists if ghost_fp_rate > 0, the value of an
+   * entry is the eviction time */
+  fp_ghost_t *ghost_lru_fp;
+  fp_ghost_t *ghost_lfu_fp;
+  double ghost_fp_rate;
+
   // LeCaR
   double w_lru;
   double w_lfu;
   double lr;  // learning rate
   double dr;  // discount rate
+  // exp(-lr * dr^t) indexed by t, 0 if it has not been computed
+  double *regret_discount;
+  double *dr_pow_lo;
+  double *dr_pow_hi;
   int64_t n_hit_lru_history;
   int64_t n_hit_lfu_history;
   bool update_weight;
 } LeCaR_params_t;
 
-static void free_freq_node(void *list_node) {
-  my_free(sizeof(freq_node_t), list_node);
-}
-
 // ***********************************************************************
 // ****                                                               ****
 // ****                   function declarations                       ****
@@ -74,11 +89,10 @@ static bool LeCaR_remove(cache_t *cache, const obj_id_t obj_id);
 
 /* internal */
 static void verify_ghost_lru_integrity(cache_t *cache, LeCaR_params_t *params);
-static inline void update_LFU_min_freq(LeCaR_params_t *params);
 static inline freq_node_t *get_min_freq_node(LeCaR_params_t *params);
 static inline void remove_obj_from_freq_node(LeCaR_params_t *params,
                                              cache_obj_t *cache_obj);
-static inline void insert_obj_info_freq_node(LeCaR_params_t *params,
+static inline void insert_obj_info_freq_node(freq_node_t *freq_node,
                                              cache_obj_t *cache_obj);
 
 static void update_weight(cache_t *cache, int64_t t, double *w_update,
@@ -146,15 +160,24 @@ cache_t *LeCaR_init(const common_cache_params_t ccache_params,
   }
 
   // LFU parameters
-  params->min_freq = 1;
-  params->max_freq = 1;
-  freq_node_t *freq_node = my_malloc_n(freq_node_t, 1);
-  params->freq_one_node = freq_node;
-  memset(freq_node, 0, sizeof(freq_node_t));
-  freq_node->freq = 1;
-  params->freq_map = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
-                                           (GDestroyNotify)free_freq_node);
-  g_hash_table_insert(params->freq_map, GSIZE_TO_POINTER(1), freq_node);
+  freq_bucket_list_init(&params->freq_buckets);
+
+  if (params->ghost_fp_rate > 0) {
+    params->ghost_lru_fp =
+        fp_ghost_new(cache->cache_size / 2, params->ghost_fp_rate);
+    params->ghost_lfu_fp =
+        fp_ghost_new(cache->cache_size / 2, params->ghost_fp_rate);
+  }
+
+  /* lr and dr do not change, the discounts are computed on first use,
+   * 0 means not computed yet */
+  params->regret_discount = my_malloc_n(double, REGRET_DISCOUNT_TABLE_SIZE);
+  memset(params->regret_discount, 0,
+         sizeof(double) * REGRET_DISCOUNT_TABLE_SIZE);
+  params->dr_pow_lo = my_malloc_n(double, REGRET_DISCOUNT_TABLE_SIZE);
+  memset(params->dr_pow_lo, 0, sizeof(double) * REGRET_DISCOUNT_TABLE_SIZE);
+  params->dr_pow_hi = my_malloc_n(double, REGRET_POW_HI_TABLE_SIZE);
+  memset(params->dr_pow_hi, 0, sizeof(double) * REGRET_POW_HI_TABLE_SIZE);
 
   if (!params->update_weight) {
     snprintf(cache->cache_name, CACHE_NAME_ARRAY_LEN, "LeCaR-%.4lflru",
@@ -171,7 +194,15 @@ cache_t *LeCaR_init(const common_cache_params_t ccache_params,
  */
 static void LeCaR_free(cache_t *cache) {
   LeCaR_params_t *params = (LeCaR_params_t *)(cache->eviction_params);
-  g_hash_table_destroy(params->freq_map);
+  freq_bucket_list_free(&params->freq_buckets);
+  my_free(sizeof(double) * REGRET_DISCOUNT_TABLE_SIZE,
+          params->regret_discount);
+  my_free(sizeof(double) * REGRET_DISCOUNT_TABLE_SIZE, params->dr_pow_lo);
+  my_free(sizeof(double) * REGRET_POW_HI_TABLE_SIZE, params->dr_pow_hi);
+  if (params->ghost_lru_fp != NULL) {
+    fp_ghost_free(params->ghost_lru_fp);
+    fp_ghost_free(params->ghost_lfu_fp);
+  }
   my_free(sizeof(LeCaR_params_t), params);
   cache_struct_free(cache);
 }
@@ -224,6 +255,20 @@ static cache_obj_t *LeCaR_find(cache_t *cache, const request_t *req,
   cache_obj_t *cache_obj = cache_find_base(cache, req, update_cache);
 
   if (cache_obj == NULL) {
+    int64_t eviction_vtime;
+    if (!update_cache || params->ghost_lru_fp == NULL) {
+      return NULL;
+    } else if (fp_ghost_remove_value(params->ghost_lru_fp, req->obj_id,
+                                     &eviction_vtime)) {
+      params->n_hit_lru_history++;
+      update_weight(cache, cache->n_req - eviction_vtime, &params->w_lru,
+                    &params->w_lfu);
+    } else if (fp_ghost_remove_value(params->ghost_lfu_fp, req->obj_id,
+                                     &eviction_vtime)) {
+      params->n_hit_lfu_history++;
+      update_weight(cache, cache->n_req - eviction_vtime, &params->w_lfu,
+                    &params->w_lru);
+    }
     return NULL;
   }
 
@@ -269,27 +314,13 @@ static cache_obj_t *LeCaR_find(cache_t *cache, const request_t *req,
     // update LRU chain
     move_obj_to_head(&params->q_head, &params->q_tail, cache_obj);
 
-    // update LFU state
-    // it is possible that this is the only object in the cache
+    // update LFU state, freq incr and move to the next freq node,
+    // which is either the neighbor or a new node after it
+    freq_node_t *old_node = cache_obj->LeCaR.freq_node;
+    freq_node_t *new_node = freq_bucket_find_or_create(
+        &params->freq_buckets, old_node, old_node->freq + 1);
     remove_obj_from_freq_node(params, cache_obj);
-
-    /* freq incr and move to next freq node */
-    cache_obj->LeCaR.freq += 1;
-    if (params->max_freq < cache_obj->LeCaR.freq) {
-      params->max_freq = cache_obj->LeCaR.freq;
-    }
-
-    insert_obj_info_freq_node(params, cache_obj);
-    if (cache->n_obj == 1) {
-      update_LFU_min_freq(params);
-    }
-
-    /* it is possible that we update freq to a higher freq
-     * when remove_obj_from_freq_node */
-    if (cache_obj->LeCaR.freq < params->min_freq) {
-      params->min_freq = cache_obj->LeCaR.freq;
-      VVERBOSE("update min freq to %d\n", (int)params->min_freq);
-    }
+    insert_obj_info_freq_node(new_node, cache_obj);
   }
 
   if (cache_obj == NULL || cache_obj->LeCaR.is_ghost) {
@@ -318,25 +349,13 @@ cache_obj_t *LeCaR_insert(cache_t *cache, const request_t *req) {
   cache_obj_t *cache_obj = cache_insert_base(cache, req);
 
   prepend_obj_to_head(&params->q_head, &params->q_tail, cache_obj);
-  cache_obj->LeCaR.freq = 1;
   cache_obj->LeCaR.is_ghost = false;
   cache_obj->LeCaR.evict_expert = 0;
-  cache_obj->LeCaR.eviction_vtime = 0;
 
   // LFU insert
-  params->min_freq = 1;
-  freq_node_t *freq_one_node = params->freq_one_node;
-  freq_one_node->n_obj += 1;
-  cache_obj->LeCaR.lfu_prev = freq_one_node->last_obj;
-
-  if (freq_one_node->last_obj != NULL) {
-    DEBUG_ASSERT(freq_one_node->first_obj != NULL);
-    freq_one_node->last_obj->LeCaR.lfu_next = cache_obj;
-  } else {
-    DEBUG_ASSERT(freq_one_node->first_obj == NULL);
-    freq_one_node->first_obj = cache_obj;
-  }
-  freq_one_node->last_obj = cache_obj;
+  freq_node_t *freq_one_node =
+      freq_bucket_find_or_create(&params->freq_buckets, NULL, 1);
+  insert_obj_info_freq_node(freq_one_node, cache_obj);
 
   return cache_obj;
 }
@@ -405,16 +424,16 @@ static void LeCaR_evict(cache_t *cache, const request_t *req) {
     cache_obj = lfu_choice;
   }
 
-  cache_obj->LeCaR.is_ghost = true;
-  cache_obj->LeCaR.evict_expert = -1;
-  cache_obj->LeCaR.eviction_vtime = cache->n_req;
-
   // update LRU chain state
   remove_obj_from_list(&params->q_head, &params->q_tail, cache_obj);
 
   // update LFU chain state
   remove_obj_from_freq_node(params, cache_obj);
 
+  cache_obj->LeCaR.is_ghost = true;
+  cache_obj->LeCaR.evict_expert = -1;
+  cache_obj->LeCaR.eviction_vtime = cache->n_req;
+
   // update cache state
   DEBUG_ASSERT(cache->occupied_byte >= cache_obj->obj_size);
   cache->occupied_byte -= (cache_obj->obj_size + cache->obj_md_size);
@@ -497,15 +516,32 @@ void LeCaR_evict(cache_t *cache, const request_t *req) {
     }
   }
 
-  obj_to_evict->LeCaR.is_ghost = true;
-  obj_to_evict->LeCaR.eviction_vtime = cache->n_req;
-
   // update LRU chain state
   remove_obj_from_list(&params->q_head, &params->q_tail, obj_to_evict);
 
   // update LFU chain state
   remove_obj_from_freq_node(params, obj_to_evict);
 
+  if (params->ghost_lru_fp != NULL) {
+    fp_ghost_t *ghost = NULL;
+    if (obj_to_evict->LeCaR.evict_expert == 1) {
+      ghost = params->ghost_lru_fp;
+    } else if (obj_to_evict->LeCaR.evict_expert == 2) {
+      ghost = params->ghost_lfu_fp;
+    }
+    if (ghost != NULL) {
+      fp_ghost_insert_value(ghost, obj_to_evict->obj_id,
+                            obj_to_evict->obj_size + cache->obj_md_size,
+                            cache->n_req);
+    }
+    cache_evict_base(cache, obj_to_evict, true);
+    return;
+  }
+
+  // eviction_vtime shares the space of freq_node
+  obj_to_evict->LeCaR.is_ghost = true;
+  obj_to_evict->LeCaR.eviction_vtime = cache->n_req;
+
   // update cache state
   cache_evict_base(cache, obj_to_evict, false);
 
@@ -561,7 +597,7 @@ void LeCaR_evict(cache_t *cache, const request_t *req) {
 bool LeCaR_remove(cache_t *cache, obj_id_t obj_id) {
   LeCaR_params_t *params = (LeCaR_params_t *)(cache->eviction_params);
   cache_obj_t *obj = hashtable_find_obj_id(cache->hashtable, obj_id);
-  if (obj == NULL) {
+  if (obj == NULL || obj->LeCaR.is_ghost) {
     return false;
   }
 
@@ -585,8 +621,9 @@ bool LeCaR_remove(cache_t *cache, obj_id_t obj_id) {
 static const char *LeCaR_current_params(cache_t *cache,
                                         LeCaR_params_t *params) {
   static __thread char params_str[128];
-  snprintf(params_str, 128, "update-weight=%d,lru-weight=%.lf",
-           params->update_weight, params->w_lru);
+  snprintf(params_str, 128,
+           "update-weight=%d,lru-weight=%.lf,ghost-fp-rate=%.4lf",
+           params->update_weight, params->w_lru, params->ghost_fp_rate);
 
   return params_str;
 }
@@ -619,6 +656,8 @@ static void LeCaR_parse_params(cache_t *cache,
       }
     } else if (strcasecmp(key, "lru-weight") == 0) {
       params->w_lru = (double)strtod(value, &end);
+    } else if (strcasecmp(key, "ghost-fp-rate") == 0) {
+      params->ghost_fp_rate = strtod(value, NULL);
     } else if (strcasecmp(key, "print") == 0) {
       printf("current parameters: %s\n", LeCaR_current_params(cache, params));
       exit(0);
@@ -637,36 +676,12 @@ static void LeCaR_parse_params(cache_t *cache,
 // ***********************************************************************
 
 /* LFU related function, LFU uses a chain of freq node sorted by freq in
- * ascending order, each node stores a list of objects with the same
- * frequency in FIFO order, when evicting, we find the min freq node and
- * evict the first object of the min freq, this is only called when current
- * min_freq is empty
+ * ascending order (see freqBucket.h), each node stores a list of objects with
+ * the same frequency in FIFO order, when evicting, we evict the first object
+ * of the min freq node, which is the head of the chain
  */
-static inline void update_LFU_min_freq(LeCaR_params_t *params) {
-  unsigned old_min_freq = params->min_freq;
-  for (uint64_t freq = params->min_freq + 1; freq <= params->max_freq; freq++) {
-    freq_node_t *node =
-        g_hash_table_lookup(params->freq_map, GSIZE_TO_POINTER(freq));
-    if (node != NULL && node->n_obj > 0) {
-      params->min_freq = freq;
-      break;
-    }
-  }
-  VVERBOSE("update LFU min freq from %u to %u\n", (unsigned)old_min_freq,
-           (unsigned)params->min_freq);
-  // if the object is the only object in the cache, we may have min_freq == 1
-  DEBUG_ASSERT(params->min_freq > old_min_freq ||
-               params->q_head == params->q_tail);
-}
-
 static inline freq_node_t *get_min_freq_node(LeCaR_params_t *params) {
-  freq_node_t *min_freq_node = NULL;
-  if (params->min_freq == 1) {
-    min_freq_node = params->freq_one_node;
-  } else {
-    min_freq_node = g_hash_table_lookup(params->freq_map,
-                                        GSIZE_TO_POINTER(params->min_freq));
-  }
+  freq_node_t *min_freq_node = params->freq_buckets.head;
 
   DEBUG_ASSERT(min_freq_node != NULL);
   DEBUG_ASSERT(min_freq_node->first_obj != NULL);
@@ -677,10 +692,8 @@ static inline freq_node_t *get_min_freq_node(LeCaR_params_t *params) {
 
 static inline void remove_obj_from_freq_node(LeCaR_params_t *params,
                                              cache_obj_t *cache_obj) {
-  freq_node_t *freq_node = g_hash_table_lookup(
-      params->freq_map, GSIZE_TO_POINTER(cache_obj->LeCaR.freq));
+  freq_node_t *freq_node = cache_obj->LeCaR.freq_node;
   DEBUG_ASSERT(freq_node != NULL);
-  DEBUG_ASSERT(freq_node->freq == cache_obj->LeCaR.freq);
   DEBUG_ASSERT(freq_node->n_obj > 0);
   VVERBOSE("remove object from freq node %p (freq %ld, %u obj)\n", freq_node,
            freq_node->freq, freq_node->n_obj);
@@ -710,41 +723,63 @@ static inline void remove_obj_from_freq_node(LeCaR_params_t *params,
 
   cache_obj->LeCaR.lfu_prev = NULL;
   cache_obj->LeCaR.lfu_next = NULL;
+  cache_obj->LeCaR.freq_node = NULL;
 
-  if (freq_node->freq == params->min_freq && freq_node->n_obj == 0) {
-    update_LFU_min_freq(params);
+  if (freq_node->n_obj == 0) {
+    freq_bucket_release(&params->freq_buckets, freq_node);
   }
 }
 
-static inline void insert_obj_info_freq_node(LeCaR_params_t *params,
+static inline void insert_obj_info_freq_node(freq_node_t *freq_node,
                                              cache_obj_t *cache_obj) {
-  // find the new freq_node this object should move to
-  freq_node_t *new_node = g_hash_table_lookup(
-      params->freq_map, GSIZE_TO_POINTER(cache_obj->LeCaR.freq));
-  if (new_node == NULL) {
-    new_node = my_malloc_n(freq_node_t, 1);
-    memset(new_node, 0, sizeof(freq_node_t));
-    new_node->freq = cache_obj->LeCaR.freq;
-    g_hash_table_insert(params->freq_map,
-                        GSIZE_TO_POINTER(cache_obj->LeCaR.freq), new_node);
-  } else {
-    DEBUG_ASSERT(new_node->freq == cache_obj->LeCaR.freq);
-  }
-
   /* add to tail of the list */
-  if (new_node->last_obj != NULL) {
-    new_node->last_obj->LeCaR.lfu_next = cache_obj;
-    cache_obj->LeCaR.lfu_prev = new_node->last_obj;
+  if (freq_node->last_obj != NULL) {
+    freq_node->last_obj->LeCaR.lfu_next = cache_obj;
+    cache_obj->LeCaR.lfu_prev = freq_node->last_obj;
   } else {
-    DEBUG_ASSERT(new_node->first_obj == NULL);
-    DEBUG_ASSERT(new_node->n_obj == 0);
-    new_node->first_obj = cache_obj;
+    DEBUG_ASSERT(freq_node->first_obj == NULL);
+    DEBUG_ASSERT(freq_node->n_obj == 0);
+    freq_node->first_obj = cache_obj;
     cache_obj->LeCaR.lfu_prev = NULL;
   }
 
   cache_obj->LeCaR.lfu_next = NULL;
-  new_node->last_obj = cache_obj;
-  new_node->n_obj += 1;
+  cache_obj->LeCaR.freq_node = freq_node;
+  freq_node->last_obj = cache_obj;
+  freq_node->n_obj += 1;
+}
+
+/* the factor exp(-lr * dr^t) that the weight of the expert that made a
+ * wrong eviction t requests ago is multiplied by */
+/* dr^(idx * step) cached in table, 0 means not computed yet */
+static inline double get_dr_pow(double *table, int64_t idx, int64_t step,
+                                double dr) {
+  if (table[idx] == 0) {
+    table[idx] = pow(dr, (double)(idx * step));
+  }
+  return table[idx];
+}
+
+static inline double get_regret_discount(LeCaR_params_t *params, int64_t t) {
+  if (t >= REGRET_DISCOUNT_TABLE_SIZE) {
+    int64_t hi = t / REGRET_DISCOUNT_TABLE_SIZE;
+    if (hi >= REGRET_POW_HI_TABLE_SIZE) {
+      return exp(-params->lr * pow(params->dr, (double)t));
+    }
+    double dr_pow =
+        get_dr_pow(params->dr_pow_hi, hi, REGRET_DISCOUNT_TABLE_SIZE,
+                   params->dr) *
+        get_dr_pow(params->dr_pow_lo, t % REGRET_DISCOUNT_TABLE_SIZE, 1,
+                   params->dr);
+    return exp(-params->lr * dr_pow);
+  }
+
+  double discount = params->regret_discount[t];
+  if (discount == 0) {
+    discount = exp(-params->lr * pow(params->dr, (double)t));
+    params->regret_discount[t] = discount;
+  }
+  return discount;
 }
 
 static void update_weight(cache_t *cache, int64_t t, double *w_update,
@@ -752,8 +787,8 @@ static void update_weight(cache_t *cache, int64_t t, double *w_update,
   LeCaR_params_t *params = (LeCaR_params_t *)(cache->eviction_params);
   if (!params->update_weight) return;
 
-  double r = pow(params->dr, (double)t);
-  *w_update = *w_update * exp(-params->lr * r) + 1e-10; /* to avoid w was 0 */
+  *w_update = *w_update * get_regret_discount(params, t) +
+              1e-10; /* to avoid w was 0 */
   double s = *w_update + *w_no_update + +2e-10;
   *w_update = *w_update / s;
   *w_no_update = (*w_no_update + 1e-10) / s;
@@ -4,6 +4,8 @@
 //  20% FIFO + ARC
 //  insert to ARC when evicting from FIFO
 //
+//  with ghost-fp-rate > 0, the ghost stores fingerprints (see
+//  fingerprintGhost.h) instead of a FIFO cache of the evicted objects
 //
 //  QDLP.c
 //  libCacheSim
@@ -12,6 +14,7 @@
 //  Copyright © 2018 Juncheng. All rights reserved.
 //
 
+#include "../../dataStructure/fingerprintGhost.h"
 #include "../../dataStructure/hashtable/hashtable.h"
 #include "../../include/libCacheSim/evictionAlgo.h"
 
@@ -22,6 +25,8 @@ extern "C" {
 typedef struct {
   cache_t *fifo;
   cache_t *fifo_ghost;
+  /* used instead of fifo_ghost if ghost_fp_rate > 0 */
+  fp_ghost_t *fp_ghost;
   cache_t *main_cache;
   bool hit_on_ghost;
 
@@ -35,6 +40,7 @@ typedef struct {
   int move_to_main_threshold;
   double fifo_size_ratio;
   double ghost_size_ratio;
+  double ghost_fp_rate;
   char main_cache_type[32];
 
   request_t *req_local;
@@ -42,7 +48,7 @@ typedef struct {
 
 static const char *DEFAULT_CACHE_PARAMS =
     "fifo-size-ratio=0.10,ghost-size-ratio=0.9,main-cache=Clock2,move-to-main-"
-    "threshold=1";
+    "threshold=1,ghost-fp-rate=0";
 
 // ***********************************************************************
 // ****                                                               ****
@@ -111,7 +117,10 @@ cache_t *QDLP_init(const common_cache_params_t ccache_params,
   ccache_params_local.cache_size = fifo_cache_size;
   params->fifo = FIFO_init(ccache_params_local, NULL);
 
-  if (fifo_ghost_cache_size > 0) {
+  if (fifo_ghost_cache_size > 0 && params->ghost_fp_rate > 0) {
+    params->fp_ghost = fp_ghost_new(fifo_ghost_cache_size, params->ghost_fp_rate);
+    params->fifo_ghost = NULL;
+  } else if (fifo_ghost_cache_size > 0) {
     ccache_params_local.cache_size = fifo_ghost_cache_size;
     params->fifo_ghost = FIFO_init(ccache_params_local, NULL);
     snprintf(params->fifo_ghost->cache_name, CACHE_NAME_ARRAY_LEN,
@@ -180,6 +189,9 @@ static void QDLP_free(cache_t *cache) {
   if (params->fifo_ghost != NULL) {
     params->fifo_ghost->cache_free(params->fifo_ghost);
   }
+  if (params->fp_ghost != NULL) {
+    fp_ghost_free(params->fp_ghost);
+  }
   params->main_cache->cache_free(params->main_cache);
   free(cache->eviction_params);
   cache_struct_free(cache);
@@ -258,6 +270,9 @@ static cache_obj_t *QDLP_find(cache_t *cache, const request_t *req,
       params->fifo_ghost->remove(params->fifo_ghost, req->obj_id)) {
     // if object in fifo_ghost, remove will return true
     params->hit_on_ghost = true;
+  } else if (params->fp_ghost != NULL &&
+             fp_ghost_remove(params->fp_ghost, req->obj_id)) {
+    params->hit_on_ghost = true;
   }
 
   obj = params->main_cache->find(params->main_cache, req, true);
@@ -372,6 +387,9 @@ static void QDLP_evict(cache_t *cache, const request_t *req) {
     // insert to ghost
     if (ghost != NULL) {
       ghost->get(ghost, params->req_local);
+    } else if (params->fp_ghost != NULL) {
+      fp_ghost_insert(params->fp_ghost, params->req_local->obj_id,
+                      params->req_local->obj_size);
     }
   }
 
@@ -399,6 +417,8 @@ static bool QDLP_remove(cache_t *cache, const obj_id_t obj_id) {
   removed = removed || params->fifo->remove(params->fifo, obj_id);
   removed = removed || (params->fifo_ghost &&
                         params->fifo_ghost->remove(params->fifo_ghost, obj_id));
+  removed = removed ||
+            (params->fp_ghost && fp_ghost_remove(params->fp_ghost, obj_id));
   removed = removed || params->main_cache->remove(params->main_cache, obj_id);
 
   return removed;
@@ -456,6 +476,8 @@ static void QDLP_parse_params(cache_t *cache,
       params->fifo_size_ratio = strtod(value, NULL);
     } else if (strcasecmp(key, "ghost-size-ratio") == 0) {
       params->ghost_size_ratio = strtod(value, NULL);
+    } else if (strcasecmp(key, "ghost-fp-rate") == 0) {
+      params->ghost_fp_rate = strtod(value, NULL);
     } else if (strcasecmp(key, "move-to-main-threshold") == 0) {
       params->move_to_main_threshold = atoi(value);
     } else if (strcasecmp(key, "main-cache") == 0) {
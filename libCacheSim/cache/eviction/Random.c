@@ -11,11 +11,16 @@
 #include "../../dataStructure/hashtable/hashtable.h"
 #include "../../include/libCacheSim/evictionAlgo.h"
 #include "../../include/libCacheSim/macro.h"
+#include "../candidateArray.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+typedef struct Random_params {
+  candidate_array_t candidates;
+} Random_params_t;
+
 // ***********************************************************************
 // ****                                                               ****
 // ****                   function declarations                       ****
@@ -45,11 +50,8 @@ static bool Random_remove(cache_t *cache, const obj_id_t obj_id);
  */
 cache_t *Random_init(const common_cache_params_t ccache_params,
                      const char *cache_specific_params) {
-  common_cache_params_t ccache_params_copy = ccache_params;
-  ccache_params_copy.hashpower = MAX(12, ccache_params_copy.hashpower - 8);
-
   cache_t *cache =
-      cache_struct_init("Random", ccache_params_copy, cache_specific_params);
+      cache_struct_init("Random", ccache_params, cache_specific_params);
   cache->cache_init = Random_init;
   cache->cache_free = Random_free;
   cache->get = Random_get;
@@ -59,6 +61,11 @@ cache_t *Random_init(const common_cache_params_t ccache_params,
   cache->evict = Random_evict;
   cache->remove = Random_remove;
 
+  Random_params_t *params = my_malloc(Random_params_t);
+  candidate_array_init(&params->candidates,
+                       offsetof(cache_obj_t, Random.sample_idx));
+  cache->eviction_params = params;
+
   return cache;
 }
 
@@ -67,7 +74,12 @@ cache_t *Random_init(const common_cache_params_t ccache_params,
  *
  * @param cache
  */
-static void Random_free(cache_t *cache) { cache_struct_free(cache); }
+static void Random_free(cache_t *cache) {
+  Random_params_t *params = (Random_params_t *)cache->eviction_params;
+  candidate_array_free(&params->candidates);
+  my_free(sizeof(Random_params_t), params);
+  cache_struct_free(cache);
+}
 
 /**
  * @brief this function is the user facing API
@@ -124,7 +136,11 @@ static cache_obj_t *Random_find(cache_t *cache, const request_t *req,
  * @return the inserted object
  */
 static cache_obj_t *Random_insert(cache_t *cache, const request_t *req) {
-  return cache_insert_base(cache, req);
+  Random_params_t *params = (Random_params_t *)cache->eviction_params;
+  cache_obj_t *obj = cache_insert_base(cache, req);
+  candidate_array_add(&params->candidates, obj);
+
+  return obj;
 }
 
 /**
@@ -138,7 +154,8 @@ static cache_obj_t *Random_insert(cache_t *cache, const request_t *req) {
  * @return the object to be evicted
  */
 static cache_obj_t *Random_to_evict(cache_t *cache, const request_t *req) {
-  return hashtable_rand_obj(cache->hashtable);
+  Random_params_t *params = (Random_params_t *)cache->eviction_params;
+  return candidate_array_rand_obj(&params->candidates);
 }
 
 /**
@@ -150,8 +167,10 @@ static cache_obj_t *Random_to_evict(cache_t *cache, const request_t *req) {
  * @param req not used
  */
 static void Random_evict(cache_t *cache, const request_t *req) {
+  Random_params_t *params = (Random_params_t *)cache->eviction_params;
   cache_obj_t *obj_to_evict = Random_to_evict(cache, req);
   DEBUG_ASSERT(obj_to_evict->obj_size != 0);
+  candidate_array_remove(&params->candidates, obj_to_evict);
   cache_evict_base(cache, obj_to_evict, true);
 }
 
@@ -173,6 +192,8 @@ static bool Random_remove(cache_t *cache, const obj_id_t obj_id) {
   if (obj == NULL) {
     return false;
   }
+  Random_params_t *params = (Random_params_t *)cache->eviction_params;
+  candidate_array_remove(&params->candidates, obj);
   cache_remove_obj_base(cache, obj, true);
 
   return true;
@@ -14,6 +14,7 @@
 #include "../../dataStructure/hashtable/hashtable.h"
 #include "../../include/libCacheSim/evictionAlgo.h"
 #include "../../include/libCacheSim/macro.h"
+#include "../candidateArray.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -21,6 +22,7 @@ extern "C" {
 
 typedef struct RandomLRU_params {
   int32_t n_samples;
+  candidate_array_t candidates;
 } RandomLRU_params_t;
 
 static const char *DEFAULT_CACHE_PARAMS = "n-samples=16";
@@ -53,10 +55,7 @@ static void RandomLRU_parse_params(cache_t *cache, const char *cache_specific_pa
  * @param cache_specific_params RandomLRU specific parameters, should be NULL
  */
 cache_t *RandomLRU_init(const common_cache_params_t ccache_params, const char *cache_specific_params) {
-  common_cache_params_t ccache_params_copy = ccache_params;
-  ccache_params_copy.hashpower = MAX(12, ccache_params_copy.hashpower - 8);
-
-  cache_t *cache = cache_struct_init("RandomLRU", ccache_params_copy, cache_specific_params);
+  cache_t *cache = cache_struct_init("RandomLRU", ccache_params, cache_specific_params);
   cache->cache_init = RandomLRU_init;
   cache->cache_free = RandomLRU_free;
   cache->get = RandomLRU_get;
@@ -74,6 +73,7 @@ cache_t *RandomLRU_init(const common_cache_params_t ccache_params, const char *c
   if (cache_specific_params != NULL) {
     RandomLRU_parse_params(cache, cache_specific_params);
   }
+  candidate_array_init(&params->candidates, offsetof(cache_obj_t, Random.sample_idx));
 
   snprintf(cache->cache_name, CACHE_NAME_ARRAY_LEN, "RandomLRU-%d", params->n_samples);
 
@@ -85,7 +85,12 @@ cache_t *RandomLRU_init(const common_cache_params_t ccache_params, const char *c
  *
  * @param cache
  */
-static void RandomLRU_free(cache_t *cache) { cache_struct_free(cache); }
+static void RandomLRU_free(cache_t *cache) {
+  RandomLRU_params_t *params = (RandomLRU_params_t *)cache->eviction_params;
+  candidate_array_free(&params->candidates);
+  free(params);
+  cache_struct_free(cache);
+}
 
 /**
  * @brief this function is the user facing API
@@ -144,8 +149,10 @@ static cache_obj_t *RandomLRU_find(cache_t *cache, const request_t *req, const b
  * @return the inserted object
  */
 static cache_obj_t *RandomLRU_insert(cache_t *cache, const request_t *req) {
+  RandomLRU_params_t *params = (RandomLRU_params_t *)cache->eviction_params;
   cache_obj_t *obj = cache_insert_base(cache, req);
   obj->Random.last_access_vtime = cache->n_req;
+  candidate_array_add(&params->candidates, obj);
 
   return obj;
 }
@@ -199,13 +206,19 @@ static int compare_access_time(const void *p1, const void *p2) {
  * @param req not used
  */
 static void RandomLRU_evict(cache_t *cache, const request_t *req) {
+  RandomLRU_params_t *params = (RandomLRU_params_t *)cache->eviction_params;
   const int N = 64;
-  cache_obj_t *obj_to_evict[N];
-  for (int i = 0; i < N; i++) {
-    obj_to_evict[i] = hashtable_rand_obj(cache->hashtable);
+  cache_obj_t *sampled_objs[N];
+  candidate_array_sample(&params->candidates, N, sampled_objs);
+
+  cache_obj_t *obj_to_evict = sampled_objs[0];
+  for (int i = 1; i < N; i++) {
+    if (compare_access_time(&sampled_objs[i], &obj_to_evict) < 0) {
+      obj_to_evict = sampled_objs[i];
+    }
   }
-  qsort(obj_to_evict, N, sizeof(cache_obj_t *), compare_access_time);
-  cache_evict_base(cache, obj_to_evict[0], true);
+  candidate_array_remove(&params->candidates, obj_to_evict);
+  cache_evict_base(cache, obj_to_evict, true);
 }
 
 /**
@@ -226,6 +239,8 @@ static bool RandomLRU_remove(cache_t *cache, const obj_id_t obj_id) {
   if (obj == NULL) {
     return false;
   }
+  RandomLRU_params_t *params = (RandomLRU_params_t *)cache->eviction_params;
+  candidate_array_remove(&params->candidates, obj);
   cache_remove_obj_base(cache, obj, true);
 
   return true;
@@ -12,11 +12,16 @@
 #include "../../dataStructure/hashtable/hashtable.h"
 #include "../../include/libCacheSim/evictionAlgo.h"
 #include "../../include/libCacheSim/macro.h"
+#include "../candidateArray.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+typedef struct RandomTwo_params {
+  candidate_array_t candidates;
+} RandomTwo_params_t;
+
 // ***********************************************************************
 // ****                                                               ****
 // ****                   function declarations                       ****
@@ -46,11 +51,8 @@ static bool RandomTwo_remove(cache_t *cache, const obj_id_t obj_id);
  */
 cache_t *RandomTwo_init(const common_cache_params_t ccache_params,
                         const char *cache_specific_params) {
-  common_cache_params_t ccache_params_copy = ccache_params;
-  ccache_params_copy.hashpower = MAX(12, ccache_params_copy.hashpower - 8);
-
   cache_t *cache =
-      cache_struct_init("RandomTwo", ccache_params_copy, cache_specific_params);
+      cache_struct_init("RandomTwo", ccache_params, cache_specific_params);
   cache->cache_init = RandomTwo_init;
   cache->cache_free = RandomTwo_free;
   cache->get = RandomTwo_get;
@@ -60,6 +62,11 @@ cache_t *RandomTwo_init(const common_cache_params_t ccache_params,
   cache->evict = RandomTwo_evict;
   cache->remove = RandomTwo_remove;
 
+  RandomTwo_params_t *params = my_malloc(RandomTwo_params_t);
+  candidate_array_init(&params->candidates,
+                       offsetof(cache_obj_t, Random.sample_idx));
+  cache->eviction_params = params;
+
   return cache;
 }
 
@@ -68,7 +75,12 @@ cache_t *RandomTwo_init(const common_cache_params_t ccache_params,
  *
  * @param cache
  */
-static void RandomTwo_free(cache_t *cache) { cache_struct_free(cache); }
+static void RandomTwo_free(cache_t *cache) {
+  RandomTwo_params_t *params = (RandomTwo_params_t *)cache->eviction_params;
+  candidate_array_free(&params->candidates);
+  my_free(sizeof(RandomTwo_params_t), params);
+  cache_struct_free(cache);
+}
 
 /**
  * @brief this function is the user facing API
@@ -130,8 +142,10 @@ static cache_obj_t *RandomTwo_find(cache_t *cache, const request_t *req,
  * @return the inserted object
  */
 static cache_obj_t *RandomTwo_insert(cache_t *cache, const request_t *req) {
+  RandomTwo_params_t *params = (RandomTwo_params_t *)cache->eviction_params;
   cache_obj_t *obj = cache_insert_base(cache, req);
   obj->Random.last_access_vtime = cache->n_req;
+  candidate_array_add(&params->candidates, obj);
 
   return obj;
 }
@@ -147,13 +161,14 @@ static cache_obj_t *RandomTwo_insert(cache_t *cache, const request_t *req) {
  * @return the object to be evicted
  */
 static cache_obj_t *RandomTwo_to_evict(cache_t *cache, const request_t *req) {
-  cache_obj_t *obj_to_evict1 = hashtable_rand_obj(cache->hashtable);
-  cache_obj_t *obj_to_evict2 = hashtable_rand_obj(cache->hashtable);
-  if (obj_to_evict1->Random.last_access_vtime <
-      obj_to_evict2->Random.last_access_vtime)
-    return obj_to_evict1;
+  RandomTwo_params_t *params = (RandomTwo_params_t *)cache->eviction_params;
+  cache_obj_t *sampled_objs[2];
+  candidate_array_sample(&params->candidates, 2, sampled_objs);
+  if (sampled_objs[0]->Random.last_access_vtime <
+      sampled_objs[1]->Random.last_access_vtime)
+    return sampled_objs[0];
   else
-    return obj_to_evict2;
+    return sampled_objs[1];
 }
 
 /**
@@ -165,13 +180,10 @@ static cache_obj_t *RandomTwo_to_evict(cache_t *cache, const request_t *req) {
  * @param req not used
  */
 static void RandomTwo_evict(cache_t *cache, const request_t *req) {
-  cache_obj_t *obj_to_evict1 = hashtable_rand_obj(cache->hashtable);
-  cache_obj_t *obj_to_evict2 = hashtable_rand_obj(cache->hashtable);
-  if (obj_to_evict1->Random.last_access_vtime <
-      obj_to_evict2->Random.last_access_vtime)
-    cache_evict_base(cache, obj_to_evict1, true);
-  else
-    cache_evict_base(cache, obj_to_evict2, true);
+  RandomTwo_params_t *params = (RandomTwo_params_t *)cache->eviction_params;
+  cache_obj_t *obj_to_evict = RandomTwo_to_evict(cache, req);
+  candidate_array_remove(&params->candidates, obj_to_evict);
+  cache_evict_base(cache, obj_to_evict, true);
 }
 
 /**
@@ -192,6 +204,8 @@ static bool RandomTwo_remove(cache_t *cache, const obj_id_t obj_id) {
   if (obj == NULL) {
     return false;
   }
+  RandomTwo_params_t *params = (RandomTwo_params_t *)cache->eviction_params;
+  candidate_array_remove(&params->candidates, obj);
   cache_remove_obj_base(cache, obj, true);
 
   return true;
@@ -19,6 +19,13 @@
 //          evict
 //
 //
+//  the small, main and ghost FIFO share the hashtable of the cache (see
+//  compositeQueue.h), so moving an object between the queues is relinking
+//
+//  with ghost-fp-rate > 0, the ghost stores fingerprints (see
+//  fingerprintGhost.h) instead of the evicted objects, which bounds the
+//  ghost memory at the cost of a small false positive rate
+//
 //  S3FIFO.c
 //  libCacheSim
 //
@@ -26,28 +33,42 @@
 //  Copyright © 2018 Juncheng. All rights reserved.
 //
 
+#include "../../dataStructure/fingerprintGhost.h"
 #include "../../dataStructure/hashtable/hashtable.h"
 #include "../../include/libCacheSim/evictionAlgo.h"
+#include "../compositeQueue.h"
+#include "../getSpecialized.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+typedef enum {
+  S3FIFO_SMALL_QUEUE = 0,
+  S3FIFO_MAIN_QUEUE = 1,
+  S3FIFO_GHOST_QUEUE = 2,
+} S3FIFO_queue_e;
+
 typedef struct {
-  cache_t *small_fifo;
-  cache_t *ghost_fifo;
-  cache_t *main_fifo;
+  sub_queue_t small_fifo;
+  sub_queue_t main_fifo;
+  /* ghost entries only keep the object id and size,
+   * ghost_fifo.cache_size is 0 if there is no ghost */
+  sub_queue_t ghost_fifo;
+  /* used instead of ghost_fifo if ghost_fp_rate > 0 */
+  fp_ghost_t *fp_ghost;
   bool hit_on_ghost;
 
   int move_to_main_threshold;
   double small_size_ratio;
   double ghost_size_ratio;
+  double ghost_fp_rate;
 
   bool has_evicted;
   request_t *req_local;
 } S3FIFO_params_t;
 
-static const char *DEFAULT_CACHE_PARAMS = "small-size-ratio=0.10,ghost-size-ratio=0.90,move-to-main-threshold=2";
+static const char *DEFAULT_CACHE_PARAMS = "small-size-ratio=0.10,ghost-size-ratio=0.90,move-to-main-threshold=2,ghost-fp-rate=0";
 
 // ***********************************************************************
 // ****                                                               ****
@@ -63,6 +84,7 @@ static cache_obj_t *S3FIFO_insert(cache_t *cache, const request_t *req);
 static cache_obj_t *S3FIFO_to_evict(cache_t *cache, const request_t *req);
 static void S3FIFO_evict(cache_t *cache, const request_t *req);
 static bool S3FIFO_remove(cache_t *cache, const obj_id_t obj_id);
+static void S3FIFO_copy_state(cache_t *cache, const cache_t *src_cache);
 static inline int64_t S3FIFO_get_occupied_byte(const cache_t *cache);
 static inline int64_t S3FIFO_get_n_obj(const cache_t *cache);
 static inline bool S3FIFO_can_insert(cache_t *cache, const request_t *req);
@@ -71,6 +93,8 @@ static void S3FIFO_parse_params(cache_t *cache, const char *cache_specific_param
 static void S3FIFO_evict_small(cache_t *cache, const request_t *req);
 static void S3FIFO_evict_main(cache_t *cache, const request_t *req);
 
+DEFINE_CACHE_GET_SPECIALIZED(S3FIFO, S3FIFO_can_insert, S3FIFO_get_occupied_byte)
+
 // ***********************************************************************
 // ****                                                               ****
 // ****                   end user facing functions                   ****
@@ -82,6 +106,7 @@ cache_t *S3FIFO_init(const common_cache_params_t ccache_params, const char *cach
   cache->cache_init = S3FIFO_init;
   cache->cache_free = S3FIFO_free;
   cache->get = S3FIFO_get;
+  cache->get_specialized = S3FIFO_get_specialized;
   cache->find = S3FIFO_find;
   cache->insert = S3FIFO_insert;
   cache->evict = S3FIFO_evict;
@@ -90,6 +115,7 @@ cache_t *S3FIFO_init(const common_cache_params_t ccache_params, const char *cach
   cache->get_n_obj = S3FIFO_get_n_obj;
   cache->get_occupied_byte = S3FIFO_get_occupied_byte;
   cache->can_insert = S3FIFO_can_insert;
+  cache->copy_state = S3FIFO_copy_state;
 
   cache->obj_md_size = 0;
 
@@ -108,21 +134,14 @@ cache_t *S3FIFO_init(const common_cache_params_t ccache_params, const char *cach
   int64_t main_fifo_size = ccache_params.cache_size - small_fifo_size;
   int64_t ghost_fifo_size = (int64_t)(ccache_params.cache_size * params->ghost_size_ratio);
 
-  common_cache_params_t ccache_params_local = ccache_params;
-  ccache_params_local.cache_size = small_fifo_size;
-  params->small_fifo = FIFO_init(ccache_params_local, NULL);
-  params->has_evicted = false;
-
-  if (ghost_fifo_size > 0) {
-    ccache_params_local.cache_size = ghost_fifo_size;
-    params->ghost_fifo = FIFO_init(ccache_params_local, NULL);
-    snprintf(params->ghost_fifo->cache_name, CACHE_NAME_ARRAY_LEN, "FIFO-ghost");
-  } else {
-    params->ghost_fifo = NULL;
+  sub_queue_init(&params->small_fifo, small_fifo_size);
+  sub_queue_init(&params->main_fifo, main_fifo_size);
+  if (params->ghost_fp_rate > 0 && ghost_fifo_size > 0) {
+    params->fp_ghost = fp_ghost_new(ghost_fifo_size, params->ghost_fp_rate);
+    ghost_fifo_size = 0;
   }
-
-  ccache_params_local.cache_size = main_fifo_size;
-  params->main_fifo = FIFO_init(ccache_params_local, NULL);
+  sub_queue_init(&params->ghost_fifo, MAX(ghost_fifo_size, 0));
+  params->has_evicted = false;
 
   snprintf(cache->cache_name, CACHE_NAME_ARRAY_LEN, "S3FIFO-%.4lf-%d", params->small_size_ratio,
            params->move_to_main_threshold);
@@ -138,11 +157,9 @@ cache_t *S3FIFO_init(const common_cache_params_t ccache_params, const char *cach
 static void S3FIFO_free(cache_t *cache) {
   S3FIFO_params_t *params = (S3FIFO_params_t *)cache->eviction_params;
   free_request(params->req_local);
-  params->small_fifo->cache_free(params->small_fifo);
-  if (params->ghost_fifo != NULL) {
-    params->ghost_fifo->cache_free(params->ghost_fifo);
+  if (params->fp_ghost != NULL) {
+    fp_ghost_free(params->fp_ghost);
   }
-  params->main_fifo->cache_free(params->main_fifo);
   free(cache->eviction_params);
   cache_struct_free(cache);
 }
@@ -168,9 +185,7 @@ static void S3FIFO_free(cache_t *cache) {
  */
 static bool S3FIFO_get(cache_t *cache, const request_t *req) {
   S3FIFO_params_t *params = (S3FIFO_params_t *)cache->eviction_params;
-  DEBUG_ASSERT(params->small_fifo->get_occupied_byte(params->small_fifo) +
-                   params->main_fifo->get_occupied_byte(params->main_fifo) <=
-               cache->cache_size);
+  DEBUG_ASSERT(params->small_fifo.occupied_byte + params->main_fifo.occupied_byte <= cache->cache_size);
 
   bool cache_hit = cache_get_base(cache, req);
 
@@ -182,6 +197,31 @@ static bool S3FIFO_get(cache_t *cache, const request_t *req) {
 // ****       developer facing APIs (used by cache developer)         ****
 // ****                                                               ****
 // ***********************************************************************
+static inline sub_queue_t *S3FIFO_queue_of(S3FIFO_params_t *params, const cache_obj_t *obj) {
+  switch (obj->S3FIFO.queue_id) {
+    case S3FIFO_SMALL_QUEUE:
+      return &params->small_fifo;
+    case S3FIFO_MAIN_QUEUE:
+      return &params->main_fifo;
+    default:
+      return &params->ghost_fifo;
+  }
+}
+
+/**
+ * @brief remove an object (cached or ghost) from its queue and the hashtable
+ */
+static void S3FIFO_remove_obj(cache_t *cache, cache_obj_t *obj) {
+  S3FIFO_params_t *params = (S3FIFO_params_t *)cache->eviction_params;
+  sub_queue_unlink(S3FIFO_queue_of(params, obj), obj, cache->obj_md_size);
+  if (obj->S3FIFO.queue_id == S3FIFO_GHOST_QUEUE) {
+    /* ghost entries are not counted in the cache */
+    hashtable_delete(cache->hashtable, obj);
+  } else {
+    cache_remove_obj_base(cache, obj, true);
+  }
+}
+
 /**
  * @brief find an object in the cache
  *
@@ -195,36 +235,31 @@ static bool S3FIFO_get(cache_t *cache, const request_t *req) {
 static cache_obj_t *S3FIFO_find(cache_t *cache, const request_t *req, const bool update_cache) {
   S3FIFO_params_t *params = (S3FIFO_params_t *)cache->eviction_params;
 
+  cache_obj_t *obj = hashtable_find(cache->hashtable, req);
+
   // if update cache is false, we only check the fifo and main caches
   if (!update_cache) {
-    cache_obj_t *obj = params->small_fifo->find(params->small_fifo, req, false);
-    if (obj != NULL) {
-      return obj;
-    }
-    obj = params->main_fifo->find(params->main_fifo, req, false);
-    if (obj != NULL) {
-      return obj;
+    if (obj != NULL && obj->S3FIFO.queue_id == S3FIFO_GHOST_QUEUE) {
+      return NULL;
     }
-    return NULL;
+    return obj;
   }
 
   /* update cache is true from now */
   params->hit_on_ghost = false;
-  cache_obj_t *obj = params->small_fifo->find(params->small_fifo, req, true);
-  if (obj != NULL) {
-    obj->S3FIFO.freq += 1;
-    return obj;
-  }
-
-  if (params->ghost_fifo != NULL && params->ghost_fifo->remove(params->ghost_fifo, req->obj_id)) {
-    // if object in ghost_fifo, remove will return true
+  if (obj != NULL && obj->S3FIFO.queue_id == S3FIFO_GHOST_QUEUE) {
+    S3FIFO_remove_obj(cache, obj);
     params->hit_on_ghost = true;
+    obj = NULL;
+  } else if (obj == NULL && params->fp_ghost != NULL) {
+    params->hit_on_ghost = fp_ghost_remove(params->fp_ghost, req->obj_id);
   }
 
-  obj = params->main_fifo->find(params->main_fifo, req, true);
-  if (obj != NULL) {
-    obj->S3FIFO.freq += 1;
+  obj = cache_find_obj_base(cache, req, obj, true);
+  if (obj == NULL) {
+    return NULL;
   }
+  obj->S3FIFO.freq += 1;
 
   return obj;
 }
@@ -242,28 +277,30 @@ static cache_obj_t *S3FIFO_find(cache_t *cache, const request_t *req, const bool
  */
 static cache_obj_t *S3FIFO_insert(cache_t *cache, const request_t *req) {
   S3FIFO_params_t *params = (S3FIFO_params_t *)cache->eviction_params;
-  cache_obj_t *obj = NULL;
+  sub_queue_t *queue = NULL;
 
-  cache_t *small = params->small_fifo;
-  cache_t *main = params->main_fifo;
+  sub_queue_t *small = &params->small_fifo;
 
   if (params->hit_on_ghost) {
     /* insert into main FIFO */
     params->hit_on_ghost = false;
-    obj = main->insert(main, req);
+    queue = &params->main_fifo;
   } else {
     /* insert into small fifo */
     if (req->obj_size >= small->cache_size) {
       return NULL;
     }
 
-    if (!params->has_evicted && small->get_occupied_byte(small) >= small->cache_size) {
-      obj = main->insert(main, req);
+    if (!params->has_evicted && small->occupied_byte >= small->cache_size) {
+      queue = &params->main_fifo;
     } else {
-      obj = small->insert(small, req);
+      queue = small;
     }
   }
 
+  cache_obj_t *obj = cache_insert_base(cache, req);
+  sub_queue_prepend(queue, obj, cache->obj_md_size);
+  obj->S3FIFO.queue_id = queue == small ? S3FIFO_SMALL_QUEUE : S3FIFO_MAIN_QUEUE;
   obj->S3FIFO.freq = 0;
 
   return obj;
@@ -284,58 +321,73 @@ static cache_obj_t *S3FIFO_to_evict(cache_t *cache, const request_t *req) {
   return NULL;
 }
 
+/**
+ * @brief turn an object evicted from the small FIFO into a ghost entry,
+ * the object is reused as the ghost entry, so no allocation is needed
+ */
+static void S3FIFO_move_to_ghost(cache_t *cache, cache_obj_t *obj) {
+  S3FIFO_params_t *params = (S3FIFO_params_t *)cache->eviction_params;
+  sub_queue_t *ghost = &params->ghost_fifo;
+  int64_t obj_byte = (int64_t)obj->obj_size + cache->obj_md_size;
+
+  if (params->fp_ghost != NULL) {
+    fp_ghost_insert(params->fp_ghost, obj->obj_id, obj_byte);
+    S3FIFO_remove_obj(cache, obj);
+    return;
+  }
+
+  if (obj_byte > ghost->cache_size) {
+    /* no ghost or the object cannot fit in the ghost */
+    S3FIFO_remove_obj(cache, obj);
+    return;
+  }
+
+  while (ghost->occupied_byte + obj_byte > ghost->cache_size) {
+    S3FIFO_remove_obj(cache, ghost->q_tail);
+  }
+
+  sub_queue_move_to_head(&params->small_fifo, ghost, obj, cache->obj_md_size);
+  obj->S3FIFO.queue_id = S3FIFO_GHOST_QUEUE;
+  cache->occupied_byte -= obj_byte;
+  cache->n_obj -= 1;
+}
+
 static void S3FIFO_evict_small(cache_t *cache, const request_t *req) {
   S3FIFO_params_t *params = (S3FIFO_params_t *)cache->eviction_params;
-  cache_t *small = params->small_fifo;
-  cache_t *ghost = params->ghost_fifo;
-  cache_t *main = params->main_fifo;
+  sub_queue_t *small = &params->small_fifo;
+  sub_queue_t *main = &params->main_fifo;
 
   bool has_evicted = false;
-  while (!has_evicted && small->get_occupied_byte(small) > 0) {
-    cache_obj_t *obj_to_evict = small->to_evict(small, req);
+  while (!has_evicted && small->occupied_byte > 0) {
+    cache_obj_t *obj_to_evict = small->q_tail;
     DEBUG_ASSERT(obj_to_evict != NULL);
-    // need to copy the object before it is evicted
-    copy_cache_obj_to_request(params->req_local, obj_to_evict);
 
     if (obj_to_evict->S3FIFO.freq >= params->move_to_main_threshold) {
-      cache_obj_t *new_obj = main->insert(main, params->req_local);
+      sub_queue_move_to_head(small, main, obj_to_evict, cache->obj_md_size);
+      obj_to_evict->S3FIFO.queue_id = S3FIFO_MAIN_QUEUE;
+      obj_to_evict->S3FIFO.freq = 0;
     } else {
-      // insert to ghost
-      if (ghost != NULL) {
-        ghost->get(ghost, params->req_local);
-      }
+      S3FIFO_move_to_ghost(cache, obj_to_evict);
       has_evicted = true;
     }
-
-    // remove from small fifo, but do not update stat
-    bool removed = small->remove(small, params->req_local->obj_id);
-    DEBUG_ASSERT(removed);
   }
 }
 
 static void S3FIFO_evict_main(cache_t *cache, const request_t *req) {
   S3FIFO_params_t *params = (S3FIFO_params_t *)cache->eviction_params;
-  cache_t *main = params->main_fifo;
+  sub_queue_t *main = &params->main_fifo;
 
   bool has_evicted = false;
-  while (!has_evicted && main->get_occupied_byte(main) > 0) {
-    cache_obj_t *obj_to_evict = main->to_evict(main, req);
+  while (!has_evicted && main->occupied_byte > 0) {
+    cache_obj_t *obj_to_evict = main->q_tail;
     DEBUG_ASSERT(obj_to_evict != NULL);
     int freq = obj_to_evict->S3FIFO.freq;
-    copy_cache_obj_to_request(params->req_local, obj_to_evict);
     if (freq >= 1) {
-      // we need to evict first because the object to insert has the same obj_id
-      main->remove(main, obj_to_evict->obj_id);
-      obj_to_evict = NULL;
-
-      cache_obj_t *new_obj = main->insert(main, params->req_local);
+      sub_queue_move_to_head(main, main, obj_to_evict, cache->obj_md_size);
       // clock with 2-bit counter
-      new_obj->S3FIFO.freq = MIN(freq, 3) - 1;
-
+      obj_to_evict->S3FIFO.freq = MIN(freq, 3) - 1;
     } else {
-      bool removed = main->remove(main, obj_to_evict->obj_id);
-      DEBUG_ASSERT(removed);
-
+      S3FIFO_remove_obj(cache, obj_to_evict);
       has_evicted = true;
     }
   }
@@ -354,10 +406,10 @@ static void S3FIFO_evict(cache_t *cache, const request_t *req) {
   S3FIFO_params_t *params = (S3FIFO_params_t *)cache->eviction_params;
   params->has_evicted = true;
 
-  cache_t *small = params->small_fifo;
-  cache_t *main = params->main_fifo;
+  sub_queue_t *small = &params->small_fifo;
+  sub_queue_t *main = &params->main_fifo;
 
-  if (main->get_occupied_byte(main) > main->cache_size || small->get_occupied_byte(small) == 0) {
+  if (main->occupied_byte > main->cache_size || small->occupied_byte == 0) {
     return S3FIFO_evict_main(cache, req);
   }
   return S3FIFO_evict_small(cache, req);
@@ -377,30 +429,63 @@ static void S3FIFO_evict(cache_t *cache, const request_t *req) {
  * cache
  */
 static bool S3FIFO_remove(cache_t *cache, const obj_id_t obj_id) {
-  S3FIFO_params_t *params = (S3FIFO_params_t *)cache->eviction_params;
-  bool removed = false;
-  removed = removed || params->small_fifo->remove(params->small_fifo, obj_id);
-  removed = removed || (params->ghost_fifo && params->ghost_fifo->remove(params->ghost_fifo, obj_id));
-  removed = removed || params->main_fifo->remove(params->main_fifo, obj_id);
+  cache_obj_t *obj = hashtable_find_obj_id(cache->hashtable, obj_id);
+  if (obj == NULL) {
+    return false;
+  }
+
+  S3FIFO_remove_obj(cache, obj);
+
+  return true;
+}
 
-  return removed;
+/**
+ * @brief copy the small, main and ghost FIFOs from src_cache to an empty
+ * cache, the two caches should have the same small_size_ratio and
+ * ghost_size_ratio, other parameters such as move_to_main_threshold can differ
+ *
+ * @param cache
+ * @param src_cache
+ */
+static void S3FIFO_copy_state(cache_t *cache, const cache_t *src_cache) {
+  S3FIFO_params_t *params = (S3FIFO_params_t *)cache->eviction_params;
+  const S3FIFO_params_t *src_params = (const S3FIFO_params_t *)src_cache->eviction_params;
+  DEBUG_ASSERT(params->small_fifo.cache_size == src_params->small_fifo.cache_size);
+  DEBUG_ASSERT(params->ghost_fifo.cache_size == src_params->ghost_fifo.cache_size);
+
+  sub_queue_t *queues[3] = {&params->small_fifo, &params->main_fifo, &params->ghost_fifo};
+  const sub_queue_t *src_queues[3] = {&src_params->small_fifo, &src_params->main_fifo, &src_params->ghost_fifo};
+  for (int i = 0; i < 3; i++) {
+    cache_copy_queue_base(cache, src_queues[i]->q_tail, &queues[i]->q_head, &queues[i]->q_tail);
+    queues[i]->n_obj = src_queues[i]->n_obj;
+    queues[i]->occupied_byte = src_queues[i]->occupied_byte;
+  }
+  /* ghost entries are not counted in the cache */
+  cache->n_obj = src_cache->n_obj;
+  cache->occupied_byte = src_cache->occupied_byte;
+  params->has_evicted = src_params->has_evicted;
+
+  if (params->fp_ghost != NULL) {
+    DEBUG_ASSERT(src_params->fp_ghost != NULL);
+    fp_ghost_free(params->fp_ghost);
+    params->fp_ghost = fp_ghost_clone(src_params->fp_ghost);
+  }
 }
 
 static inline int64_t S3FIFO_get_occupied_byte(const cache_t *cache) {
   S3FIFO_params_t *params = (S3FIFO_params_t *)cache->eviction_params;
-  return params->small_fifo->get_occupied_byte(params->small_fifo) +
-         params->main_fifo->get_occupied_byte(params->main_fifo);
+  return params->small_fifo.occupied_byte + params->main_fifo.occupied_byte;
 }
 
 static inline int64_t S3FIFO_get_n_obj(const cache_t *cache) {
   S3FIFO_params_t *params = (S3FIFO_params_t *)cache->eviction_params;
-  return params->small_fifo->get_n_obj(params->small_fifo) + params->main_fifo->get_n_obj(params->main_fifo);
+  return params->small_fifo.n_obj + params->main_fifo.n_obj;
 }
 
 static inline bool S3FIFO_can_insert(cache_t *cache, const request_t *req) {
   S3FIFO_params_t *params = (S3FIFO_params_t *)cache->eviction_params;
 
-  return req->obj_size <= params->small_fifo->cache_size && cache_can_insert_default(cache, req);
+  return req->obj_size <= params->small_fifo.cache_size && cache_can_insert_default(cache, req);
 }
 
 // ***********************************************************************
@@ -409,9 +494,11 @@ static inline bool S3FIFO_can_insert(cache_t *cache, const request_t *req) {
 // ****                                                               ****
 // ***********************************************************************
 static const char *S3FIFO_current_params(S3FIFO_params_t *params) {
-  static __thread char params_str[128];
-  snprintf(params_str, 128, "small-size-ratio=%.4lf,ghost-size-ratio=%.4lf,move-to-main-threshold=%d\n",
-           params->small_size_ratio, params->ghost_size_ratio, params->move_to_main_threshold);
+  static __thread char params_str[160];
+  snprintf(params_str, 160,
+           "small-size-ratio=%.4lf,ghost-size-ratio=%.4lf,move-to-main-threshold=%d,ghost-fp-rate=%.4lf\n",
+           params->small_size_ratio, params->ghost_size_ratio, params->move_to_main_threshold,
+           params->ghost_fp_rate);
   return params_str;
 }
 
@@ -439,6 +526,8 @@ static void S3FIFO_parse_params(cache_t *cache, const char *cache_specific_param
       params->ghost_size_ratio = strtod(value, NULL);
     } else if (strcasecmp(key, "move-to-main-threshold") == 0) {
       params->move_to_main_threshold = atoi(value);
+    } else if (strcasecmp(key, "ghost-fp-rate") == 0) {
+      params->ghost_fp_rate = strtod(value, NULL);
     } else if (strcasecmp(key, "print") == 0) {
       printf("parameters: %s\n", S3FIFO_current_params(params));
       exit(0);
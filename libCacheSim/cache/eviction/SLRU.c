@@ -2,6 +2,9 @@
 //  segmented LRU implemented using multiple lists instead of multiple LRUs
 //  this has a better performance than SLRUv0, but it is very hard to implement
 //
+//  the segments share the hashtable of the cache (see compositeQueue.h),
+//  so promoting or cooling an object is relinking
+//
 //  SLRU.c
 //  libCacheSim
 //
@@ -9,6 +12,7 @@
 
 #include "../../dataStructure/hashtable/hashtable.h"
 #include "../../include/libCacheSim/evictionAlgo.h"
+#include "../compositeQueue.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -20,11 +24,9 @@ extern "C" {
 #undef DEBUG_MODE
 
 typedef struct SLRU_params {
-  cache_obj_t **lru_heads;
-  cache_obj_t **lru_tails;
-  int64_t *lru_n_bytes;
-  int64_t *lru_n_objs;
-  int64_t *lru_max_n_bytes;
+  /* segs[n_seg - 1] is the most recent segment,
+   * the cache_size of a segment is 0 until it is set */
+  sub_queue_t segs[SLRU_MAX_N_SEG];
   int n_seg;
 } SLRU_params_t;
 
@@ -61,8 +63,9 @@ static void SLRU_parse_params(cache_t *cache,
   do {                                                                         \
     printf("%ld %ld %s: ", cache->n_req, req->obj_id, __func__);               \
     for (int i = 0; i < params->n_seg; i++) {                                  \
-      printf("%ld/%ld/%p/%p, ", params->lru_n_objs[i], params->lru_n_bytes[i], \
-             params->lru_heads[i], params->lru_tails[i]);                      \
+      printf("%ld/%ld/%p/%p, ", params->segs[i].n_obj,                         \
+             params->segs[i].occupied_byte, params->segs[i].q_head,            \
+             params->segs[i].q_tail);                                          \
     }                                                                          \
     printf("\n");                                                              \
     _SLRU_verify_lru_size(cache);                                              \
@@ -71,7 +74,7 @@ static void SLRU_parse_params(cache_t *cache,
 #define DEBUG_PRINT_CACHE(cache, params)                 \
   do {                                                   \
     for (int i = params->n_seg - 1; i >= 0; i--) {       \
-      cache_obj_t *obj = params->lru_heads[i];           \
+      cache_obj_t *obj = params->segs[i].q_head;         \
       while (obj != NULL) {                              \
         printf("%lu(%u)->", obj->obj_id, obj->obj_size); \
         obj = obj->queue.next;                           \
@@ -129,33 +132,18 @@ cache_t *SLRU_init(const common_cache_params_t ccache_params,
     SLRU_parse_params(cache, cache_specific_params);
   }
 
-  if (params->lru_max_n_bytes == NULL) {
+  if (params->segs[0].cache_size == 0) {
     // if the user does not specify segment size
-    params->lru_max_n_bytes = calloc(params->n_seg, sizeof(int64_t));
     for (int i = 0; i < params->n_seg; i++) {
-      params->lru_max_n_bytes[i] =
-          (int64_t)ccache_params.cache_size / params->n_seg;
+      sub_queue_init(&params->segs[i],
+                     (int64_t)ccache_params.cache_size / params->n_seg);
     }
   }
 
-  params->lru_heads =
-      (cache_obj_t **)malloc(sizeof(cache_obj_t *) * params->n_seg);
-  params->lru_tails =
-      (cache_obj_t **)malloc(sizeof(cache_obj_t *) * params->n_seg);
-  params->lru_n_objs = (int64_t *)malloc(sizeof(int64_t) * params->n_seg);
-  params->lru_n_bytes = (int64_t *)malloc(sizeof(int64_t) * params->n_seg);
-
-  for (int i = 0; i < params->n_seg; i++) {
-    params->lru_heads[i] = NULL;
-    params->lru_tails[i] = NULL;
-    params->lru_n_objs[i] = 0;
-    params->lru_n_bytes[i] = 0;
-  }
-
   // update slru cache name
   bool same_size = true;
   for (int i = 1; i < params->n_seg; i++) {
-    if (params->lru_max_n_bytes[i] != params->lru_max_n_bytes[i - 1]) {
+    if (params->segs[i].cache_size != params->segs[i - 1].cache_size) {
       same_size = false;
       break;
     }
@@ -171,12 +159,12 @@ cache_t *SLRU_init(const common_cache_params_t ccache_params,
   } else {
     n = snprintf(cache->cache_name, CACHE_NAME_ARRAY_LEN, "S%dLRU(%d",
                  params->n_seg,
-                 (int)(params->lru_max_n_bytes[0] * 100 / cache->cache_size));
+                 (int)(params->segs[0].cache_size * 100 / cache->cache_size));
 
     for (int i = 1; i < params->n_seg; i++) {
       n +=
           snprintf(cache->cache_name + n, CACHE_NAME_ARRAY_LEN - n, ":%d",
-                   (int)(params->lru_max_n_bytes[i] * 100 / cache->cache_size));
+                   (int)(params->segs[i].cache_size * 100 / cache->cache_size));
     }
   }
   snprintf(cache->cache_name + n, CACHE_NAME_ARRAY_LEN - n, ")");
@@ -196,12 +184,7 @@ cache_t *SLRU_init(const common_cache_params_t ccache_params,
  * @param cache
  */
 static void SLRU_free(cache_t *cache) {
-  SLRU_params_t *params = (SLRU_params_t *)(cache->eviction_params);
-  free(params->lru_max_n_bytes);
-  free(params->lru_heads);
-  free(params->lru_tails);
-  free(params->lru_n_objs);
-  free(params->lru_n_bytes);
+  free(cache->eviction_params);
   cache_struct_free(cache);
 }
 
@@ -256,13 +239,13 @@ static cache_obj_t *SLRU_find(cache_t *cache, const request_t *req,
 #endif
 
   if (obj->SLRU.lru_id == params->n_seg - 1) {
-    move_obj_to_head(&params->lru_heads[params->n_seg - 1],
-                     &params->lru_tails[params->n_seg - 1], obj);
+    sub_queue_t *seg = &params->segs[params->n_seg - 1];
+    move_obj_to_head(&seg->q_head, &seg->q_tail, obj);
   } else {
     SLRU_promote_to_next_seg(cache, req, obj);
 
-    while (params->lru_n_bytes[obj->SLRU.lru_id] >
-           params->lru_max_n_bytes[obj->SLRU.lru_id]) {
+    sub_queue_t *seg = &params->segs[obj->SLRU.lru_id];
+    while (seg->occupied_byte > seg->cache_size) {
       // if the LRU is full
       SLRU_cool(cache, req, obj->SLRU.lru_id);
     }
@@ -290,8 +273,8 @@ static cache_obj_t *SLRU_insert(cache_t *cache, const request_t *req) {
   // Find the lowest LRU with space for insertion
   int nth_seg = -1;
   for (int i = 0; i < params->n_seg; i++) {
-    if (params->lru_n_bytes[i] + req->obj_size + cache->obj_md_size <=
-        params->lru_max_n_bytes[i]) {
+    if (params->segs[i].occupied_byte + req->obj_size + cache->obj_md_size <=
+        params->segs[i].cache_size) {
       nth_seg = i;
       break;
     }
@@ -312,11 +295,8 @@ static cache_obj_t *SLRU_insert(cache_t *cache, const request_t *req) {
   obj->next_access_vtime = req->next_access_vtime;
 #endif
 
-  prepend_obj_to_head(&params->lru_heads[nth_seg], &params->lru_tails[nth_seg],
-                      obj);
+  sub_queue_prepend(&params->segs[nth_seg], obj, cache->obj_md_size);
   obj->SLRU.lru_id = nth_seg;
-  params->lru_n_bytes[nth_seg] += req->obj_size + cache->obj_md_size;
-  params->lru_n_objs[nth_seg]++;
 
   return obj;
 }
@@ -335,8 +315,8 @@ static cache_obj_t *SLRU_to_evict(cache_t *cache, const request_t *req) {
   SLRU_params_t *params = (SLRU_params_t *)(cache->eviction_params);
   DEBUG_PRINT_CACHE_STATE(cache, params, req);
   for (int i = 0; i < params->n_seg; i++) {
-    if (params->lru_n_bytes[i] > 0) {
-      return params->lru_tails[i];
+    if (params->segs[i].occupied_byte > 0) {
+      return params->segs[i].q_tail;
     }
   }
 // No object to evict
@@ -360,11 +340,7 @@ static void SLRU_evict(cache_t *cache, const request_t *req) {
 
   cache_obj_t *obj = SLRU_to_evict(cache, req);
 
-  params->lru_n_bytes[obj->SLRU.lru_id] -= obj->obj_size + cache->obj_md_size;
-  params->lru_n_objs[obj->SLRU.lru_id]--;
-
-  remove_obj_from_list(&params->lru_heads[obj->SLRU.lru_id],
-                       &params->lru_tails[obj->SLRU.lru_id], obj);
+  sub_queue_unlink(&params->segs[obj->SLRU.lru_id], obj, cache->obj_md_size);
   cache_evict_base(cache, obj, true);
 }
 
@@ -389,8 +365,7 @@ static bool SLRU_remove(cache_t *cache, const obj_id_t obj_id) {
     return false;
   }
 
-  remove_obj_from_list(&(params->lru_heads[obj->SLRU.lru_id]),
-                       &(params->lru_tails[obj->SLRU.lru_id]), obj);
+  sub_queue_unlink(&params->segs[obj->SLRU.lru_id], obj, cache->obj_md_size);
   cache_remove_obj_base(cache, obj, true);
 
   return true;
@@ -404,11 +379,11 @@ static bool SLRU_remove(cache_t *cache, const obj_id_t obj_id) {
 static const char *SLRU_current_params(cache_t *cache, SLRU_params_t *params) {
   static __thread char params_str[128];
   int n = snprintf(params_str, 128, "n-seg=%d,seg-size=%d", params->n_seg,
-                   (int)(params->lru_max_n_bytes[0] * 100 / cache->cache_size));
+                   (int)(params->segs[0].cache_size * 100 / cache->cache_size));
 
   for (int i = 1; i < params->n_seg; i++) {
     n += snprintf(params_str + n, 128 - n, ":%d",
-                  (int)(params->lru_max_n_bytes[i] * 100 / cache->cache_size));
+                  (int)(params->segs[i].cache_size * 100 / cache->cache_size));
   }
 
   return params_str;
@@ -437,21 +412,27 @@ static void SLRU_parse_params(cache_t *cache,
       if (strlen(end) > 2) {
         ERROR("param parsing error, find string \"%s\" after number\n", end);
       }
+      if (params->n_seg < 1 || params->n_seg > SLRU_MAX_N_SEG) {
+        ERROR("n-seg should be in [1, %d]\n", SLRU_MAX_N_SEG);
+      }
     } else if (strcasecmp(key, "seg-size") == 0) {
       int n_seg = 0;
       int64_t seg_size_sum = 0;
       int64_t seg_size_array[SLRU_MAX_N_SEG];
       char *v = strsep((char **)&value, ":");
       while (v != NULL) {
+        if (n_seg == SLRU_MAX_N_SEG) {
+          ERROR("at most %d segments\n", SLRU_MAX_N_SEG);
+        }
         seg_size_array[n_seg++] = (int64_t)strtol(v, &end, 0);
         seg_size_sum += seg_size_array[n_seg - 1];
         v = strsep((char **)&value, ":");
       }
       params->n_seg = n_seg;
-      params->lru_max_n_bytes = calloc(params->n_seg, sizeof(int64_t));
       for (int i = 0; i < n_seg; i++) {
-        params->lru_max_n_bytes[i] = (int64_t)(
-            (double)seg_size_array[i] / seg_size_sum * cache->cache_size);
+        sub_queue_init(&params->segs[i],
+                       (int64_t)((double)seg_size_array[i] / seg_size_sum *
+                                 cache->cache_size));
       }
     } else if (strcasecmp(key, "print") == 0) {
       printf("current parameters: %s\n", SLRU_current_params(cache, params));
@@ -474,7 +455,7 @@ bool SLRU_can_insert(cache_t *cache, const request_t *req) {
   SLRU_params_t *params = (SLRU_params_t *)cache->eviction_params;
   bool can_insert = cache_can_insert_default(cache, req);
   return can_insert &&
-         (req->obj_size + cache->obj_md_size <= params->lru_max_n_bytes[0]);
+         (req->obj_size + cache->obj_md_size <= params->segs[0].cache_size);
 }
 
 /**
@@ -490,20 +471,16 @@ static void SLRU_cool(cache_t *cache, const request_t *req, const int id) {
 
   if (id == 0) return SLRU_evict(cache, req);
 
-  cache_obj_t *obj = params->lru_tails[id];
+  cache_obj_t *obj = params->segs[id].q_tail;
   DEBUG_ASSERT(obj != NULL);
   DEBUG_ASSERT(obj->SLRU.lru_id == id);
-  remove_obj_from_list(&params->lru_heads[id], &params->lru_tails[id], obj);
-  prepend_obj_to_head(&params->lru_heads[id - 1], &params->lru_tails[id - 1],
-                      obj);
+  sub_queue_move_to_head(&params->segs[id], &params->segs[id - 1], obj,
+                         cache->obj_md_size);
   obj->SLRU.lru_id = id - 1;
-  params->lru_n_bytes[id] -= obj->obj_size;
-  params->lru_n_bytes[id - 1] += obj->obj_size;
-  params->lru_n_objs[id]--;
-  params->lru_n_objs[id - 1]++;
 
   // If lower LRUs are full
-  while (params->lru_n_bytes[id - 1] > params->lru_max_n_bytes[id - 1]) {
+  while (params->segs[id - 1].occupied_byte >
+         params->segs[id - 1].cache_size) {
     SLRU_cool(cache, req, id - 1);
   }
 }
@@ -518,15 +495,9 @@ static void SLRU_promote_to_next_seg(cache_t *cache, const request_t *req,
   DEBUG_PRINT_CACHE_STATE(cache, params, req);
 
   int id = obj->SLRU.lru_id;
-  remove_obj_from_list(&params->lru_heads[id], &params->lru_tails[id], obj);
-  params->lru_n_bytes[id] -= obj->obj_size + cache->obj_md_size;
-  params->lru_n_objs[id]--;
-
+  sub_queue_move_to_head(&params->segs[id], &params->segs[id + 1], obj,
+                         cache->obj_md_size);
   obj->SLRU.lru_id += 1;
-  prepend_obj_to_head(&params->lru_heads[id + 1], &params->lru_tails[id + 1],
-                      obj);
-  params->lru_n_bytes[id + 1] += obj->obj_size + cache->obj_md_size;
-  params->lru_n_objs[id + 1]++;
 }
 
 // ############################## debug functions ##############################
@@ -535,14 +506,14 @@ static void _SLRU_verify_lru_size(cache_t *cache) {
   for (int i = 0; i < params->n_seg; i++) {
     int64_t n_objs = 0;
     int64_t n_bytes = 0;
-    cache_obj_t *obj = params->lru_heads[i];
+    cache_obj_t *obj = params->segs[i].q_head;
     while (obj != NULL) {
       n_objs += 1;
-      n_bytes += obj->obj_size;
+      n_bytes += obj->obj_size + cache->obj_md_size;
       obj = obj->queue.next;
     }
-    assert(n_objs == params->lru_n_objs[i]);
-    assert(n_bytes == params->lru_n_bytes[i]);
+    assert(n_objs == params->segs[i].n_obj);
+    assert(n_bytes == params->segs[i].occupied_byte);
   }
 }
 
@@ -248,19 +248,17 @@ static cache_obj_t *SR_LRU_insert(cache_t *cache, const request_t *req) {
 
       cache_obj_t *evicted_obj = R->to_evict(R, req);
       copy_cache_obj_to_request(params->req_local, evicted_obj);
-      SR->insert(SR, params->req_local);
+      cache_obj_t *obj_in_SR = SR->insert(SR, params->req_local);
 
       // Mark the obj as demoted
       if (!evicted_obj->SR_LRU.demoted) {
         params->C_demoted += 1;
-        // evicted_obj.SR_LRU.demoted = true;
-        SR->find(SR, params->req_local, false)->SR_LRU.demoted = true;
+        obj_in_SR->SR_LRU.demoted = true;
       }
       R->evict(R, req);
     }
 
-    R->insert(R, req);
-    obj = R->find(R, req, false);
+    obj = R->insert(R, req);
 
     // Dynamic size adjustment
     // If an obj is moved from H to R
@@ -283,8 +281,7 @@ static cache_obj_t *SR_LRU_insert(cache_t *cache, const request_t *req) {
     }
   } else {
     // cache miss, history miss
-    SR->insert(SR, req);
-    obj = SR->find(SR, req, false);
+    obj = SR->insert(SR, req);
 
     // label that obj as new obj;
     obj->SR_LRU.new_obj = true;
@@ -296,18 +293,18 @@ static cache_obj_t *SR_LRU_insert(cache_t *cache, const request_t *req) {
     // The LRU item of SR is evicted to H.
     cache_obj_t *obj_to_evict = SR->to_evict(SR, req);
     copy_cache_obj_to_request(params->req_local, obj_to_evict);
-    H->insert(H, params->req_local);
+    cache_obj_t *obj_in_H = H->insert(H, params->req_local);
 
     if (params->other_cache) {
       params->other_cache->remove(params->other_cache, obj_to_evict->obj_id);
     }
     if (obj_to_evict->SR_LRU.new_obj) {
       params->C_new += 1;  // increment the number of new objs in history
-      H->find(H, params->req_local, false)->SR_LRU.new_obj = true;
+      obj_in_H->SR_LRU.new_obj = true;
     }
     if (obj_to_evict->SR_LRU.demoted) {
       // obj_to_evict.SR_LRU.demoted = false;
-      H->find(H, params->req_local, false)->SR_LRU.demoted = false;
+      obj_in_H->SR_LRU.demoted = false;
       params->C_demoted -= 1;
     }
     SR->evict(SR, req);
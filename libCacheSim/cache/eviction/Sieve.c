@@ -2,6 +2,7 @@
 
 #include "../../dataStructure/hashtable/hashtable.h"
 #include "../../include/libCacheSim/cache.h"
+#include "../getSpecialized.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -28,6 +29,9 @@ static cache_obj_t *Sieve_to_evict(cache_t *cache, const request_t *req);
 static void Sieve_evict(cache_t *cache, const request_t *req);
 static bool Sieve_remove(cache_t *cache, const obj_id_t obj_id);
 
+DEFINE_CACHE_GET_SPECIALIZED(Sieve, cache_can_insert_no_admissioner,
+                             cache_get_occupied_byte_default)
+
 // ***********************************************************************
 // ****                                                               ****
 // ****                   end user facing functions                   ****
@@ -49,6 +53,7 @@ cache_t *Sieve_init(const common_cache_params_t ccache_params,
   cache->cache_init = Sieve_init;
   cache->cache_free = Sieve_free;
   cache->get = Sieve_get;
+  cache->get_specialized = Sieve_get_specialized;
   cache->find = Sieve_find;
   cache->insert = Sieve_insert;
   cache->evict = Sieve_evict;
@@ -0,0 +1,261 @@
+//
+//  SieveArray is Sieve with the objects in an array (see clockArray.h)
+//  instead of a linked list, the visited bits are a bitmap so the hand skips
+//  64 visited objects with a few bit operations and does not read the objects
+//  it passes, it evicts the same objects as Sieve
+//
+//
+//  SieveArray.c
+//  libCacheSim
+//
+
+#include "../../dataStructure/hashtable/hashtable.h"
+#include "../../include/libCacheSim/evictionAlgo.h"
+#include "../clockArray.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  clock_array_t arr;
+} SieveArray_params_t;
+
+// ***********************************************************************
+// ****                                                               ****
+// ****                   function declarations                       ****
+// ****                                                               ****
+// ***********************************************************************
+static void SieveArray_free(cache_t *cache);
+static bool SieveArray_get(cache_t *cache, const request_t *req);
+static cache_obj_t *SieveArray_find(cache_t *cache, const request_t *req,
+                                    const bool update_cache);
+static cache_obj_t *SieveArray_insert(cache_t *cache, const request_t *req);
+static cache_obj_t *SieveArray_to_evict(cache_t *cache, const request_t *req);
+static void SieveArray_evict(cache_t *cache, const request_t *req);
+static bool SieveArray_remove(cache_t *cache, const obj_id_t obj_id);
+static void SieveArray_copy_state(cache_t *cache, const cache_t *src_cache);
+
+// ***********************************************************************
+// ****                                                               ****
+// ****                   end user facing functions                   ****
+// ****                                                               ****
+// ****                       init, free, get                         ****
+// ***********************************************************************
+
+/**
+ * @brief initialize cache
+ *
+ * @param ccache_params some common cache parameters
+ * @param cache_specific_params cache specific parameters, not used
+ */
+cache_t *SieveArray_init(const common_cache_params_t ccache_params,
+                         const char *cache_specific_params) {
+  cache_t *cache =
+      cache_struct_init("SieveArray", ccache_params, cache_specific_params);
+  cache->cache_init = SieveArray_init;
+  cache->cache_free = SieveArray_free;
+  cache->get = SieveArray_get;
+  cache->find = SieveArray_find;
+  cache->insert = SieveArray_insert;
+  cache->evict = SieveArray_evict;
+  cache->remove = SieveArray_remove;
+  cache->to_evict = SieveArray_to_evict;
+  cache->copy_state = SieveArray_copy_state;
+
+  if (ccache_params.consider_obj_metadata) {
+    cache->obj_md_size = 1;
+  } else {
+    cache->obj_md_size = 0;
+  }
+
+  cache->eviction_params = my_malloc(SieveArray_params_t);
+  memset(cache->eviction_params, 0, sizeof(SieveArray_params_t));
+  SieveArray_params_t *params = (SieveArray_params_t *)cache->eviction_params;
+  clock_array_init(&params->arr, 1,
+                   offsetof(cache_obj_t, clock_array.slot_idx));
+
+  return cache;
+}
+
+/**
+ * free resources used by this cache
+ *
+ * @param cache
+ */
+static void SieveArray_free(cache_t *cache) {
+  SieveArray_params_t *params = (SieveArray_params_t *)cache->eviction_params;
+  clock_array_free(&params->arr);
+  free(cache->eviction_params);
+  cache_struct_free(cache);
+}
+
+/**
+ * @brief this function is the user facing API
+ * it performs the following logic
+ *
+ * ```
+ * if obj in cache:
+ *    update_metadata
+ *    return true
+ * else:
+ *    if cache does not have enough space:
+ *        evict until it has space to insert
+ *    insert the object
+ *    return false
+ * ```
+ *
+ * @param cache
+ * @param req
+ * @return true if cache hit, false if cache miss
+ */
+static bool SieveArray_get(cache_t *cache, const request_t *req) {
+  return cache_get_base(cache, req);
+}
+
+// ***********************************************************************
+// ****                                                               ****
+// ****       developer facing APIs (used by cache developer)         ****
+// ****                                                               ****
+// ***********************************************************************
+
+/**
+ * @brief find an object in the cache
+ *
+ * @param cache
+ * @param req
+ * @param update_cache whether to update the cache,
+ *  if true, the object is promoted
+ *  and if the object is expired, it is removed from the cache
+ * @return the object or NULL if not found
+ */
+static cache_obj_t *SieveArray_find(cache_t *cache, const request_t *req,
+                                    const bool update_cache) {
+  SieveArray_params_t *params = (SieveArray_params_t *)cache->eviction_params;
+  cache_obj_t *cache_obj = cache_find_base(cache, req, update_cache);
+  if (cache_obj != NULL && update_cache) {
+    clock_array_set_counter(&params->arr,
+                            clock_array_get_idx(&params->arr, cache_obj), 1);
+  }
+
+  return cache_obj;
+}
+
+/**
+ * @brief insert an object into the cache,
+ * update the hash table and cache metadata
+ * this function assumes the cache has enough space
+ * eviction should be
+ * performed before calling this function
+ *
+ * @param cache
+ * @param req
+ * @return the inserted object
+ */
+static cache_obj_t *SieveArray_insert(cache_t *cache, const request_t *req) {
+  SieveArray_params_t *params = (SieveArray_params_t *)cache->eviction_params;
+  cache_obj_t *obj = cache_insert_base(cache, req);
+  clock_array_append(&params->arr, obj, 0);
+
+  return obj;
+}
+
+/**
+ * @brief find the object to be evicted
+ * this function does not actually evict the object or update metadata
+ *
+ * @param cache the cache
+ * @return the object to be evicted
+ */
+static cache_obj_t *SieveArray_to_evict(cache_t *cache, const request_t *req) {
+  SieveArray_params_t *params = (SieveArray_params_t *)cache->eviction_params;
+  clock_array_t *arr = &params->arr;
+
+  int64_t start = arr->hand == CLOCK_ARRAY_INVALID_IDX ? arr->head : arr->hand;
+  int64_t idx = clock_array_next_unvisited(arr, start, false);
+  if (idx == arr->tail) {
+    idx = clock_array_next_unvisited(arr, arr->head, false);
+  }
+  if (idx == arr->tail) {
+    /* all objects are visited, the hand clears the bits and comes back */
+    idx = start;
+  }
+
+  return clock_array_get(arr, idx);
+}
+
+/**
+ * @brief evict an object from the cache
+ * it needs to call cache_evict_base before returning
+ * which updates some metadata such as n_obj, occupied size, and hash table
+ *
+ * @param cache
+ * @param req not used
+ */
+static void SieveArray_evict(cache_t *cache, const request_t *req) {
+  SieveArray_params_t *params = (SieveArray_params_t *)cache->eviction_params;
+  clock_array_t *arr = &params->arr;
+
+  /* if we have run one full around or first eviction */
+  int64_t start = arr->hand == CLOCK_ARRAY_INVALID_IDX ? arr->head : arr->hand;
+  int64_t idx = clock_array_next_unvisited(arr, start, true);
+  if (idx == arr->tail) {
+    idx = clock_array_next_unvisited(arr, arr->head, true);
+  }
+
+  cache_obj_t *obj = clock_array_get(arr, idx);
+  /* removing the object moves the hand to the next object */
+  arr->hand = idx;
+  clock_array_remove(arr, obj);
+  cache_evict_base(cache, obj, true);
+}
+
+static void SieveArray_remove_obj(cache_t *cache, cache_obj_t *obj_to_remove) {
+  DEBUG_ASSERT(obj_to_remove != NULL);
+  SieveArray_params_t *params = (SieveArray_params_t *)cache->eviction_params;
+  clock_array_remove(&params->arr, obj_to_remove);
+  cache_remove_obj_base(cache, obj_to_remove, true);
+}
+
+/**
+ * @brief remove an object from the cache
+ * this is different from cache_evict because it is used to for user trigger
+ * remove, and eviction is used by the cache to make space for new objects
+ *
+ * it needs to call cache_remove_obj_base before returning
+ * which updates some metadata such as n_obj, occupied size, and hash table
+ *
+ * @param cache
+ * @param obj_id
+ * @return true if the object is removed, false if the object is not in the
+ * cache
+ */
+static bool SieveArray_remove(cache_t *cache, const obj_id_t obj_id) {
+  cache_obj_t *obj = hashtable_find_obj_id(cache->hashtable, obj_id);
+  if (obj == NULL) {
+    return false;
+  }
+
+  SieveArray_remove_obj(cache, obj);
+
+  return true;
+}
+
+/**
+ * @brief copy the objects, the visited bits and the hand from src_cache to
+ * an empty cache
+ *
+ * @param cache
+ * @param src_cache
+ */
+static void SieveArray_copy_state(cache_t *cache, const cache_t *src_cache) {
+  SieveArray_params_t *params = (SieveArray_params_t *)cache->eviction_params;
+  const SieveArray_params_t *src_params =
+      (const SieveArray_params_t *)src_cache->eviction_params;
+
+  clock_array_copy(cache, &params->arr, &src_params->arr);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -10,7 +10,7 @@
 //
 
 #include "../../dataStructure/hashtable/hashtable.h"
-#include "../../dataStructure/pqueue.h"
+#include "../../dataStructure/dheap.h"
 #include "../../include/libCacheSim/evictionAlgo.h"
 
 #ifdef __cplusplus
@@ -19,7 +19,7 @@ extern "C" {
 
 typedef struct Size_params {
   /* a priority queue ordering the object size */
-  pqueue_t *pq;
+  dheap_t *heap;
 } Size_params_t;
 
 // ***********************************************************************
@@ -67,7 +67,7 @@ cache_t *Size_init(const common_cache_params_t ccache_params,
   Size_params_t *params = my_malloc(Size_params_t);
   cache->eviction_params = params;
 
-  params->pq = pqueue_init((unsigned long)8e6);
+  params->heap = dheap_init(1024, offsetof(cache_obj_t, Size.heap_pos));
   return cache;
 }
 
@@ -78,12 +78,7 @@ cache_t *Size_init(const common_cache_params_t ccache_params,
  */
 static void Size_free(cache_t *cache) {
   Size_params_t *params = cache->eviction_params;
-  pq_node_t *node = pqueue_pop(params->pq);
-  while (node) {
-    my_free(sizeof(pq_node_t), node);
-    node = pqueue_pop(params->pq);
-  }
-  pqueue_free(params->pq);
+  dheap_free(params->heap);
 
   cache_struct_free(cache);
 }
@@ -109,7 +104,7 @@ static void Size_free(cache_t *cache) {
  */
 static bool Size_get(cache_t *cache, const request_t *req) {
   Size_params_t *params = cache->eviction_params;
-  DEBUG_ASSERT(cache->n_obj == params->pq->size - 1);
+  DEBUG_ASSERT(cache->n_obj == dheap_size(params->heap));
   bool ret = cache_get_base(cache, req);
 
   return ret;
@@ -142,9 +137,7 @@ static cache_obj_t *Size_find(cache_t *cache, const request_t *req,
     return NULL;
   }
 
-  pqueue_pri_t pri = {.pri = req->obj_size};
-  pqueue_change_priority(params->pq, pri,
-                         (pq_node_t *)(cached_obj->Size.pq_node));
+  dheap_update(params->heap, cached_obj, (double)req->obj_size);
   return cached_obj;
 }
 
@@ -163,11 +156,7 @@ static cache_obj_t *Size_insert(cache_t *cache, const request_t *req) {
 
   cache_obj_t *cached_obj = cache_insert_base(cache, req);
 
-  pq_node_t *node = my_malloc(pq_node_t);
-  node->obj_id = req->obj_id;
-  node->pri.pri = req->obj_size;
-  pqueue_insert(params->pq, (void *)node);
-  cached_obj->Size.pq_node = node;
+  dheap_insert(params->heap, cached_obj, (double)req->obj_size);
 
   return cached_obj;
 }
@@ -185,8 +174,7 @@ static cache_obj_t *Size_insert(cache_t *cache, const request_t *req) {
 static cache_obj_t *Size_to_evict(cache_t *cache, __attribute__((unused))
                                                     const request_t *req) {
   Size_params_t *params = cache->eviction_params;
-  pq_node_t *node = (pq_node_t *)pqueue_peek(params->pq);
-  return hashtable_find_obj_id(cache->hashtable, node->obj_id);
+  return (cache_obj_t *)dheap_peek(params->heap);
 }
 
 /**
@@ -200,14 +188,8 @@ static cache_obj_t *Size_to_evict(cache_t *cache, __attribute__((unused))
 static void Size_evict(cache_t *cache,
                          __attribute__((unused)) const request_t *req) {
   Size_params_t *params = cache->eviction_params;
-  pq_node_t *node = (pq_node_t *)pqueue_pop(params->pq);
-
-  cache_obj_t *obj_to_evict =
-      hashtable_find_obj_id(cache->hashtable, node->obj_id);
-  DEBUG_ASSERT(node == obj_to_evict->Size.pq_node);
-
-  obj_to_evict->Size.pq_node = NULL;
-  my_free(sizeof(pq_node_t), node);
+  cache_obj_t *obj_to_evict = (cache_obj_t *)dheap_pop(params->heap);
+  DEBUG_ASSERT(obj_to_evict->Size.heap_pos == DHEAP_INVALID_POS);
 
   cache_evict_base(cache, obj_to_evict, true);
 }
@@ -216,11 +198,9 @@ static void Size_remove_obj(cache_t *cache, cache_obj_t *obj) {
   Size_params_t *params = cache->eviction_params;
   DEBUG_ASSERT(obj != NULL);
 
-  if (obj->Size.pq_node != NULL) {
-    /* if it is NULL, it means we have deleted the entry in pq before this */
-    pqueue_remove(params->pq, obj->Size.pq_node);
-    my_free(sizeof(pq_node_t), obj->Size.pq_node);
-    obj->Size.pq_node = NULL;
+  if (obj->Size.heap_pos != DHEAP_INVALID_POS) {
+    /* if it is invalid, it means we have deleted the entry in heap before this */
+    dheap_remove(params->heap, obj);
   }
 
   cache_remove_obj_base(cache, obj, true);
@@ -1,8 +1,13 @@
 //
 //  Quick demotion + lazy promotion v1
 //
-//  20% Ain + ARC
-//  insert to ARC when evicting from Ain
+//  25% Ain (FIFO) + 75% Am (LRU) + Aout (ghost FIFO, 50% of the cache)
+//  insert to Ain if not in Aout, else insert to Am
+//  evict from Ain: move to Aout
+//  evict from Am: evict
+//
+//  Ain, Am and Aout share the hashtable of the cache (see compositeQueue.h),
+//  so moving an object from Ain to Aout only relinks the object
 //
 //
 //  TwoQ.c
@@ -14,25 +19,27 @@
 
 #include "../../dataStructure/hashtable/hashtable.h"
 #include "../../include/libCacheSim/evictionAlgo.h"
+#include "../compositeQueue.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+typedef enum {
+  TwoQ_AIN_QUEUE = 0,
+  TwoQ_AM_QUEUE = 1,
+  TwoQ_AOUT_QUEUE = 2,
+} TwoQ_queue_e;
+
 typedef struct {
-  cache_t *Ain;
-  cache_t *Aout;
-  cache_t *Am;
+  sub_queue_t Ain;
+  sub_queue_t Am;
+  /* ghost entries only keep the object id and size */
+  sub_queue_t Aout;
   bool hit_on_ghost;
 
-  int64_t Ain_cache_size;
-  int64_t Aout_cache_size;
-  int64_t Am_cache_size;
   double Ain_size_ratio;
   double Aout_size_ratio;
-  char Am_type[32];
-
-  request_t *req_local;
 } TwoQ_params_t;
 
 static const char *DEFAULT_CACHE_PARAMS =
@@ -57,6 +64,7 @@ static bool TwoQ_remove(cache_t *cache, const obj_id_t obj_id);
 static inline int64_t TwoQ_get_occupied_byte(const cache_t *cache);
 static inline int64_t TwoQ_get_n_obj(const cache_t *cache);
 static inline bool TwoQ_can_insert(cache_t *cache, const request_t *req);
+static void TwoQ_evict_Am(cache_t *cache);
 static void TwoQ_parse_params(cache_t *cache,
                               const char *cache_specific_params);
 
@@ -82,12 +90,15 @@ cache_t *TwoQ_init(const common_cache_params_t ccache_params,
   cache->get_occupied_byte = TwoQ_get_occupied_byte;
   cache->can_insert = TwoQ_can_insert;
 
-  cache->obj_md_size = 0;
+  if (ccache_params.consider_obj_metadata) {
+    cache->obj_md_size = 8 * 2;
+  } else {
+    cache->obj_md_size = 0;
+  }
 
   cache->eviction_params = malloc(sizeof(TwoQ_params_t));
   memset(cache->eviction_params, 0, sizeof(TwoQ_params_t));
   TwoQ_params_t *params = (TwoQ_params_t *)cache->eviction_params;
-  params->req_local = new_request();
   params->hit_on_ghost = false;
 
   TwoQ_parse_params(cache, DEFAULT_CACHE_PARAMS);
@@ -95,19 +106,11 @@ cache_t *TwoQ_init(const common_cache_params_t ccache_params,
     TwoQ_parse_params(cache, cache_specific_params);
   }
 
-  params->Ain_cache_size = ccache_params.cache_size * params->Ain_size_ratio;
-  params->Aout_cache_size = ccache_params.cache_size * params->Aout_size_ratio;
-  params->Am_cache_size = ccache_params.cache_size - params->Ain_cache_size;
-
-  common_cache_params_t ccache_params_local = ccache_params;
-  ccache_params_local.cache_size = params->Ain_cache_size;
-  params->Ain = FIFO_init(ccache_params_local, NULL);
-
-  ccache_params_local.cache_size = params->Aout_cache_size;
-  params->Aout = FIFO_init(ccache_params_local, NULL);
-
-  ccache_params_local.cache_size = params->Am_cache_size;
-  params->Am = LRU_init(ccache_params_local, NULL);
+  int64_t Ain_cache_size = ccache_params.cache_size * params->Ain_size_ratio;
+  int64_t Aout_cache_size = ccache_params.cache_size * params->Aout_size_ratio;
+  sub_queue_init(&params->Ain, Ain_cache_size);
+  sub_queue_init(&params->Am, ccache_params.cache_size - Ain_cache_size);
+  sub_queue_init(&params->Aout, Aout_cache_size);
 
   return cache;
 }
@@ -118,11 +121,6 @@ cache_t *TwoQ_init(const common_cache_params_t ccache_params,
  * @param cache
  */
 static void TwoQ_free(cache_t *cache) {
-  TwoQ_params_t *params = (TwoQ_params_t *)cache->eviction_params;
-  free_request(params->req_local);
-  params->Ain->cache_free(params->Ain);
-  params->Aout->cache_free(params->Aout);
-  params->Am->cache_free(params->Am);
   free(cache->eviction_params);
   cache_struct_free(cache);
 }
@@ -148,8 +146,7 @@ static void TwoQ_free(cache_t *cache) {
  */
 static bool TwoQ_get(cache_t *cache, const request_t *req) {
   TwoQ_params_t *params = (TwoQ_params_t *)cache->eviction_params;
-  DEBUG_ASSERT(params->Ain->get_occupied_byte(params->Ain) +
-                   params->Am->get_occupied_byte(params->Am) <=
+  DEBUG_ASSERT(params->Ain.occupied_byte + params->Am.occupied_byte <=
                cache->cache_size);
   bool cache_hit = cache_get_base(cache, req);
   return cache_hit;
@@ -160,6 +157,32 @@ static bool TwoQ_get(cache_t *cache, const request_t *req) {
 // ****       developer facing APIs (used by cache developer)         ****
 // ****                                                               ****
 // ***********************************************************************
+static inline sub_queue_t *TwoQ_queue_of(TwoQ_params_t *params,
+                                         const cache_obj_t *obj) {
+  switch (obj->TwoQ.queue_id) {
+    case TwoQ_AIN_QUEUE:
+      return &params->Ain;
+    case TwoQ_AM_QUEUE:
+      return &params->Am;
+    default:
+      return &params->Aout;
+  }
+}
+
+/**
+ * @brief remove an object (cached or ghost) from its queue and the hashtable
+ */
+static void TwoQ_remove_obj(cache_t *cache, cache_obj_t *obj) {
+  TwoQ_params_t *params = (TwoQ_params_t *)cache->eviction_params;
+  sub_queue_unlink(TwoQ_queue_of(params, obj), obj, cache->obj_md_size);
+  if (obj->TwoQ.queue_id == TwoQ_AOUT_QUEUE) {
+    /* ghost entries are not counted in the cache */
+    hashtable_delete(cache->hashtable, obj);
+  } else {
+    cache_remove_obj_base(cache, obj, true);
+  }
+}
+
 /**
  * @brief find an object in the cache
  *
@@ -174,32 +197,29 @@ static cache_obj_t *TwoQ_find(cache_t *cache, const request_t *req,
                               const bool update_cache) {
   TwoQ_params_t *params = (TwoQ_params_t *)cache->eviction_params;
 
-  cache_obj_t *obj = params->Ain->find(params->Ain, req, false);
+  cache_obj_t *obj = hashtable_find(cache->hashtable, req);
 
   // if update cache is false, we only check the Ain and Am
   if (!update_cache) {
-    if (obj != NULL) {
-      return obj;
+    if (obj != NULL && obj->TwoQ.queue_id == TwoQ_AOUT_QUEUE) {
+      return NULL;
     }
-    obj = params->Am->find(params->Am, req, false);
-    if (obj != NULL) {
-      return obj;
-    }
-    return NULL;
+    return obj;
   }
 
   /* update cache is true from now */
   params->hit_on_ghost = false;
-  if (obj != NULL) {
-    return obj;
-  }
-
-  if (params->Aout->remove(params->Aout, req->obj_id)) {
-    // if object in Aout, remove will return true
+  if (obj != NULL && obj->TwoQ.queue_id == TwoQ_AOUT_QUEUE) {
+    TwoQ_remove_obj(cache, obj);
     params->hit_on_ghost = true;
+    obj = NULL;
   }
 
-  obj = params->Am->find(params->Am, req, update_cache);
+  obj = cache_find_obj_base(cache, req, obj, true);
+  if (obj != NULL && obj->TwoQ.queue_id == TwoQ_AM_QUEUE) {
+    /* a hit in Ain does not promote the object */
+    move_obj_to_head(&params->Am.q_head, &params->Am.q_tail, obj);
+  }
 
   return obj;
 }
@@ -217,16 +237,26 @@ static cache_obj_t *TwoQ_find(cache_t *cache, const request_t *req,
  */
 static cache_obj_t *TwoQ_insert(cache_t *cache, const request_t *req) {
   TwoQ_params_t *params = (TwoQ_params_t *)cache->eviction_params;
-  cache_obj_t *obj = NULL;
+  sub_queue_t *queue = &params->Ain;
 
   if (params->hit_on_ghost) {
-    /* insert into the ARC */
+    /* insert into Am, which is full when the cache is full */
     params->hit_on_ghost = false;
-    params->Am->get(params->Am, req);
-  } else {
-    /* insert into the Ain */
-    obj = params->Ain->insert(params->Ain, req);
+    queue = &params->Am;
+    if (req->obj_size + cache->obj_md_size > queue->cache_size) {
+      return NULL;
+    }
+    while (queue->occupied_byte + req->obj_size + cache->obj_md_size >
+           queue->cache_size) {
+      TwoQ_evict_Am(cache);
+    }
   }
+
+  cache_obj_t *obj = cache_insert_base(cache, req);
+  sub_queue_prepend(queue, obj, cache->obj_md_size);
+  obj->TwoQ.queue_id =
+      queue == &params->Ain ? TwoQ_AIN_QUEUE : TwoQ_AM_QUEUE;
+
   return obj;
 }
 
@@ -241,8 +271,44 @@ static cache_obj_t *TwoQ_insert(cache_t *cache, const request_t *req) {
  * @return the object to be evicted
  */
 static cache_obj_t *TwoQ_to_evict(cache_t *cache, const request_t *req) {
-  assert(false);
-  return NULL;
+  TwoQ_params_t *params = (TwoQ_params_t *)cache->eviction_params;
+  if (params->Ain.occupied_byte > params->Ain.cache_size) {
+    return params->Ain.q_tail;
+  }
+  return params->Am.q_tail;
+}
+
+/**
+ * @brief turn an object evicted from Ain into a ghost entry,
+ * the object is reused as the ghost entry, so no allocation is needed
+ */
+static void TwoQ_move_to_ghost(cache_t *cache, cache_obj_t *obj) {
+  TwoQ_params_t *params = (TwoQ_params_t *)cache->eviction_params;
+  sub_queue_t *Aout = &params->Aout;
+  int64_t obj_byte = (int64_t)obj->obj_size + cache->obj_md_size;
+
+  if (obj_byte > Aout->cache_size) {
+    /* the object cannot fit in the ghost */
+    TwoQ_remove_obj(cache, obj);
+    return;
+  }
+
+  while (Aout->occupied_byte + obj_byte > Aout->cache_size) {
+    TwoQ_remove_obj(cache, Aout->q_tail);
+  }
+
+  sub_queue_move_to_head(&params->Ain, Aout, obj, cache->obj_md_size);
+  obj->TwoQ.queue_id = TwoQ_AOUT_QUEUE;
+  cache->occupied_byte -= obj_byte;
+  cache->n_obj -= 1;
+}
+
+static void TwoQ_evict_Am(cache_t *cache) {
+  TwoQ_params_t *params = (TwoQ_params_t *)cache->eviction_params;
+  cache_obj_t *obj = params->Am.q_tail;
+  DEBUG_ASSERT(obj != NULL);
+  sub_queue_unlink(&params->Am, obj, cache->obj_md_size);
+  cache_evict_base(cache, obj, true);
 }
 
 /**
@@ -252,28 +318,16 @@ static cache_obj_t *TwoQ_to_evict(cache_t *cache, const request_t *req) {
  *
  * @param cache
  * @param req not used
- * @param evicted_obj if not NULL, return the evicted object to caller
  */
 static void TwoQ_evict(cache_t *cache, const request_t *req) {
   TwoQ_params_t *params = (TwoQ_params_t *)cache->eviction_params;
 
-  cache_t *Ain = params->Ain;
-  cache_t *Aout = params->Aout;
-  cache_t *Am = params->Am;
-
-  if (Ain->get_occupied_byte(Ain) > params->Ain_cache_size) {
-    // evict from Ain cache
-    cache_obj_t *obj = Ain->to_evict(Ain, req);
-    assert(obj != NULL);
-    // need to copy the object before it is evicted
-    copy_cache_obj_to_request(params->req_local, obj);
-    Aout->get(Aout, params->req_local);
-    Ain->evict(Ain, req);
+  if (params->Ain.occupied_byte > params->Ain.cache_size) {
+    TwoQ_move_to_ghost(cache, params->Ain.q_tail);
     return;
   }
 
-  // evict from Am
-  Am->evict(Am, req);
+  TwoQ_evict_Am(cache);
 }
 
 /**
@@ -290,31 +344,31 @@ static void TwoQ_evict(cache_t *cache, const request_t *req) {
  * cache
  */
 static bool TwoQ_remove(cache_t *cache, const obj_id_t obj_id) {
-  TwoQ_params_t *params = (TwoQ_params_t *)cache->eviction_params;
-  bool removed = false;
-  removed = removed || params->Ain->remove(params->Ain, obj_id);
-  removed = removed || params->Aout->remove(params->Aout, obj_id);
-  removed = removed || params->Am->remove(params->Am, obj_id);
+  cache_obj_t *obj = hashtable_find_obj_id(cache->hashtable, obj_id);
+  if (obj == NULL) {
+    return false;
+  }
+
+  TwoQ_remove_obj(cache, obj);
 
-  return removed;
+  return true;
 }
 
 static inline int64_t TwoQ_get_occupied_byte(const cache_t *cache) {
   TwoQ_params_t *params = (TwoQ_params_t *)cache->eviction_params;
-  return params->Ain->get_occupied_byte(params->Ain) +
-         params->Am->get_occupied_byte(params->Am);
+  return params->Ain.occupied_byte + params->Am.occupied_byte;
 }
 
 static inline int64_t TwoQ_get_n_obj(const cache_t *cache) {
   TwoQ_params_t *params = (TwoQ_params_t *)cache->eviction_params;
-  return params->Ain->get_n_obj(params->Ain) +
-         params->Am->get_n_obj(params->Am);
+  return params->Ain.n_obj + params->Am.n_obj;
 }
 
 static inline bool TwoQ_can_insert(cache_t *cache, const request_t *req) {
   TwoQ_params_t *params = (TwoQ_params_t *)cache->eviction_params;
 
-  return req->obj_size <= params->Ain->cache_size && cache_can_insert_default(cache, req);
+  return req->obj_size <= params->Ain.cache_size &&
+         cache_can_insert_default(cache, req);
 }
 
 // ***********************************************************************
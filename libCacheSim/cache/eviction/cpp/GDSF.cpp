@@ -112,8 +112,7 @@ static bool GDSF_get(cache_t *cache, const request_t *req) {
     }
   }
 
-  DEBUG_ASSERT(gdsf->pq.size() == cache->n_obj);
-  DEBUG_ASSERT(gdsf->pq_map.size() == cache->n_obj);
+  DEBUG_ASSERT(gdsf->size() == cache->n_obj);
 
   return hit;
 }
@@ -144,63 +143,13 @@ static cache_obj_t *GDSF_find(cache_t *cache, const request_t *req, const bool u
     /* misc frequency is updated in cache_find_base */
     // obj->misc.freq += 1;
 
-    auto node = gdsf->pq_map[obj];
-    gdsf->pq.erase(node);
-
     double pri = gdsf->pri_last_evict + (double)(obj->misc.freq) * 1.0e6 / obj->obj_size;
-    eviction::pq_node_type new_node = {obj, pri, cache->n_req};
-    gdsf->pq.insert(new_node);
-    gdsf->pq_map[obj] = new_node;
+    gdsf->update(obj, pri, cache->n_req);
   }
 
   return obj;
 }
 
-static bool GDSF_can_insert(cache_t *cache, const request_t *req) {
-  static __thread int64_t n_insert = 0, n_cannot_insert = 0;
-  auto *gdsf = reinterpret_cast<eviction::GDSF *>(cache->eviction_params);
-  if (cache->get_occupied_byte(cache) + req->obj_size <= cache->cache_size) {
-    return true;
-  }
-  if (req->obj_size > cache->cache_size) {
-    return false;
-  }
-
-  int64_t to_evict_size = req->obj_size - (cache->cache_size - cache->get_occupied_byte(cache));
-  double pri = gdsf->pri_last_evict + 1.0e6 / req->obj_size;
-  bool can_insert = true;
-  auto iter = gdsf->pq.begin();
-
-  int n_evict = 0;
-  while (to_evict_size > 0) {
-    assert(iter != gdsf->pq.end());
-    assert(iter->obj->obj_id != req->obj_id);
-    n_evict += 1;
-
-    if (iter->priority > pri) {
-      // the incoming object will be evicted so not insert it
-      can_insert = false;
-      break;
-    }
-    to_evict_size -= iter->obj->obj_size;
-    iter++;
-  }
-
-  if (can_insert) {
-    n_insert += 1;
-  } else {
-    n_cannot_insert += 1;
-  }
-
-  if ((n_insert + n_cannot_insert) % 100000 == 0) {
-    if ((double)n_cannot_insert / (n_insert + n_cannot_insert) > 0.01)
-      DEBUG("size %ld n_insert %ld, n_cannot_insert %ld, ratio %.2f\n", cache->cache_size, n_insert, n_cannot_insert,
-            (double)n_cannot_insert / (n_insert + n_cannot_insert));
-  }
-
-  return can_insert;
-}
-
 /**
  * @brief insert an object into the cache,
  * update the hash table and cache metadata
@@ -215,21 +164,18 @@ static bool GDSF_can_insert(cache_t *cache, const request_t *req) {
 static cache_obj_t *GDSF_insert(cache_t *cache, const request_t *req) {
   auto *gdsf = reinterpret_cast<eviction::GDSF *>(cache->eviction_params);
 
-  // this does not affect insertion for most workloads unless object size is too large
+  // GDSF does not check whether the new object would be evicted first,
+  // the check does not affect insertion for most workloads unless object size is too large
   // however, when it have effect, it often increases miss ratio because a list of small objects (with relatively large
   // priority) will stop the insertion of a large object, however, the newly requested large object is likely to be more
   // useful than the small objects
-  // if (!GDSF_can_insert(cache, req)) return nullptr;
 
   cache_obj_t *obj = cache_insert_base(cache, req);
   DEBUG_ASSERT(obj != nullptr);
   obj->misc.freq = 1;
 
   double pri = gdsf->pri_last_evict + 1.0e6 / obj->obj_size;
-  eviction::pq_node_type new_node = {obj, pri, cache->n_req};
-  auto r = gdsf->pq.insert(new_node);
-  DEBUG_ASSERT(r.second);
-  gdsf->pq_map[obj] = new_node;
+  gdsf->insert(obj, pri, cache->n_req);
 
   return obj;
 }
@@ -125,12 +125,8 @@ static cache_obj_t *LFUCpp_find(cache_t *cache, const request_t *req, const bool
   auto *lfu = static_cast<eviction::LFUCpp *>(cache->eviction_params);
   cache_obj_t *obj = cache_find_base(cache, req, update_cache);
   if (obj != nullptr && update_cache) {
-    obj->lfu.freq++;
-    auto itr = lfu->pq_map[obj];
-    lfu->pq.erase(itr);
-    eviction::pq_node_type new_node = {obj, (double)obj->lfu.freq, cache->n_req};
-    lfu->pq.insert(new_node);
-    lfu->pq_map[obj] = new_node;
+    obj->rank.freq++;
+    lfu->update(obj, (double)obj->rank.freq, cache->n_req);
   }
 
   return obj;
@@ -151,12 +147,10 @@ static cache_obj_t *LFUCpp_insert(cache_t *cache, const request_t *req) {
   auto *lfu = static_cast<eviction::LFUCpp *>(cache->eviction_params);
 
   cache_obj_t *obj = cache_insert_base(cache, req);
-  obj->lfu.freq = 1;
+  obj->rank.freq = 1;
 
-  eviction::pq_node_type new_node = {obj, 1.0, cache->n_req};
-  lfu->pq.insert(new_node);
-  lfu->pq_map[obj] = new_node;
-  DEBUG_ASSERT(lfu->pq_map.size() == cache->n_obj);
+  lfu->insert(obj, 1.0, cache->n_req);
+  DEBUG_ASSERT(lfu->size() == cache->n_obj);
 
   return obj;
 }
@@ -195,21 +189,9 @@ static void LFUCpp_evict(cache_t *cache, const request_t *req) {
   cache_remove_obj_base(cache, obj, true);
 }
 
-static void LFUCpp_remove_obj(cache_t *cache, cache_obj_t *obj) {
-  auto *lfu = static_cast<eviction::LFUCpp *>(cache->eviction_params);
-  lfu->remove_obj(cache, obj);
-  cache_remove_obj_base(cache, obj, true);
-}
-
 static bool LFUCpp_remove(cache_t *cache, const obj_id_t obj_id) {
   auto *lfu = static_cast<eviction::LFUCpp *>(cache->eviction_params);
-  cache_obj_t *obj = hashtable_find_obj_id(cache->hashtable, obj_id);
-  if (obj == nullptr) {
-    return false;
-  }
-  bool ret = lfu->remove(cache, obj_id);
-  cache_remove_obj_base(cache, obj, true);
-  return true;
+  return lfu->remove(cache, obj_id);
 }
 
 #ifdef __cplusplus
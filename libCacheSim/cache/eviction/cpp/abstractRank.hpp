@@ -2,16 +2,17 @@
 
 #include <math.h>
 
+#include <cstddef>
 #include <fstream>
 #include <iostream>
 #include <map>
 #include <queue>
-#include <set>
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "../../../dataStructure/dheap.h"
 #include "../../../dataStructure/hashtable/hashtable.h"
 #include "../../../include/libCacheSim/cache.h"
 #include "../../../include/libCacheSim/cacheObj.h"
@@ -40,44 +41,48 @@ struct pq_node_type {
     printf("obj %lu, priority %f, last_request_vtime %ld\n", (unsigned long)obj->obj_id, priority,
            (long)last_request_vtime);
   }
-
-  bool operator<(const pq_node_type &rhs) const {
-    DEBUG_ASSERT(this->last_request_vtime != rhs.last_request_vtime || this->obj->obj_id == rhs.obj->obj_id);
-    if (this->priority == rhs.priority) {
-      /* use FIFO when objects have the same priority */
-      return this->last_request_vtime < rhs.last_request_vtime;
-    }
-
-    return this->priority < rhs.priority;
-  }
 };
 
 class abstractRank {
-  /* ranking based eviction algorithm */
+  /* ranking based eviction algorithm, the object with the lowest
+   * (priority, last_request_vtime) is evicted first,
+   * the objects are in a dheap keyed by the negated pair, and each object
+   * keeps its heap position in obj->rank.heap_pos */
 
  public:
-  abstractRank() = default;
+  abstractRank() { pq = dheap_init(1024, offsetof(cache_obj_t, rank.heap_pos)); }
+
+  ~abstractRank() { dheap_free(pq); }
+
+  abstractRank(const abstractRank &) = delete;
+  abstractRank &operator=(const abstractRank &) = delete;
+
+  inline void insert(cache_obj_t *obj, double priority, int64_t last_request_vtime) {
+    dheap_insert_seq(pq, obj, -priority, -last_request_vtime);
+  }
+
+  inline void update(cache_obj_t *obj, double priority, int64_t last_request_vtime) {
+    dheap_update_seq(pq, obj, -priority, -last_request_vtime);
+  }
+
+  inline int64_t size() const { return dheap_size(pq); }
 
   inline pq_node_type peek_lowest_score() {
-    auto p = pq.begin();
-    pq_node_type p_copy(*p);
+    DEBUG_ASSERT(pq->size > 0);
+    const dheap_node_t *p = &pq->nodes[0];
 
-    return std::move(p_copy);
+    return pq_node_type(static_cast<cache_obj_t *>(p->item), -p->pri, -p->seq);
   }
 
   inline pq_node_type pop_lowest_score() {
-    auto p = pq.begin();
-    pq_node_type p_copy(*p);
-    pq_map.erase(p->obj);
-    pq.erase(p);
+    pq_node_type p = peek_lowest_score();
+    dheap_remove(pq, p.obj);
 
-    return std::move(p_copy);
+    return p;
   }
 
   inline void remove_obj(cache_t *cache, cache_obj_t *obj) {
-    auto pq_node = pq_map[obj];
-    pq.erase(pq_node);
-    pq_map.erase(obj);
+    dheap_remove(pq, obj);
     cache_remove_obj_base(cache, obj, true);
   }
 
@@ -92,20 +97,15 @@ class abstractRank {
   }
 
   void print_keys() {
-    printf("pq size %ld, pq_map size %ld\n", pq.size(), pq_map.size());
+    printf("pq size %ld\n", (long)dheap_size(pq));
     printf("============= pq =============\n");
-    for (auto &p : pq) {
-      p.print();
-    }
-    printf("============= pq_map =============\n");
-    for (auto &p : pq_map) {
-      printf("key %lu, ", (unsigned long)p.first->obj_id);
-      p.second.print();
+    for (int64_t i = 0; i < dheap_size(pq); i++) {
+      const dheap_node_t *p = &pq->nodes[i];
+      pq_node_type(static_cast<cache_obj_t *>(p->item), -p->pri, -p->seq).print();
     }
   }
 
-  std::set<pq_node_type> pq{};
-  std::unordered_map<cache_obj_t *, pq_node_type> pq_map;
+  dheap_t *pq;
 
  private:
 };
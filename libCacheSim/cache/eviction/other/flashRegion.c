@@ -0,0 +1,458 @@
+//
+//  a log-structured flash cache that writes and evicts whole regions,
+//  similar to the block cache in CacheLib and the log in Kangaroo
+//
+//  objects are appended to the active region (buffered in DRAM), a full
+//  region is written to the device as a whole, and when there is no free
+//  region, the oldest region is evicted, its objects are dropped or
+//  (with region-evict=rrip) reinserted into the active region
+//
+//  the DRAM index is the hash table, each object keeps only the write
+//  sequence number of its region and an RRPV (flashRegion_obj_metadata_t),
+//  each region keeps the ids of the objects written to it, an id is stale
+//  if the object is removed or rewritten to another region
+//
+//  the admission policy (cache->admissioner) decides which misses are
+//  written to flash, the write counters in flashRegion_params_t give the
+//  device-level write amplification
+//
+//  parameters:
+//    region-size: the size of a region in bytes,
+//      default min(16 MiB, cache size / 64)
+//    region-evict: fifo (drop all objects) or rrip (reinsert objects whose
+//      RRPV is smaller than the max), default fifo
+//    rrip-bits: the number of bits of RRPV, default 2
+//
+//  flashRegion.c
+//  libCacheSim
+//
+
+#include "../../../dataStructure/hashtable/hashtable.h"
+#include "../../../include/libCacheSim/evictionAlgo.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct flash_region {
+  obj_id_t *obj_ids;  // the ids of the objects written to the region
+  int32_t n_obj;
+  int32_t n_obj_allocated;
+  int32_t seq;  // the write sequence number, changes when the region is reused
+  int64_t write_offset;
+} flash_region_t;
+
+static const char *DEFAULT_CACHE_PARAMS = "region-evict=fifo,rrip-bits=2";
+
+#define DEFAULT_REGION_SIZE (16 * MiB)
+
+// ***********************************************************************
+// ****                                                               ****
+// ****                   function declarations                       ****
+// ****                                                               ****
+// ***********************************************************************
+cache_t *flashRegion_init(const common_cache_params_t ccache_params,
+                          const char *cache_specific_params);
+static void flashRegion_free(cache_t *cache);
+static bool flashRegion_get(cache_t *cache, const request_t *req);
+
+static cache_obj_t *flashRegion_find(cache_t *cache, const request_t *req,
+                                     const bool update_cache);
+static bool flashRegion_can_insert(cache_t *cache, const request_t *req);
+static cache_obj_t *flashRegion_insert(cache_t *cache, const request_t *req);
+static cache_obj_t *flashRegion_to_evict(cache_t *cache, const request_t *req);
+static void flashRegion_evict(cache_t *cache, const request_t *req);
+static bool flashRegion_remove(cache_t *cache, const obj_id_t obj_id);
+static void flashRegion_parse_params(cache_t *cache,
+                                     const char *cache_specific_params);
+
+static void _flashRegion_write_obj(cache_t *cache, cache_obj_t *obj);
+
+// ***********************************************************************
+// ****                                                               ****
+// ****                   end user facing functions                   ****
+// ****                                                               ****
+// ***********************************************************************
+
+cache_t *flashRegion_init(const common_cache_params_t ccache_params,
+                          const char *cache_specific_params) {
+  cache_t *cache =
+      cache_struct_init("flashRegion", ccache_params, cache_specific_params);
+  cache->cache_init = flashRegion_init;
+  cache->cache_free = flashRegion_free;
+  cache->get = flashRegion_get;
+  cache->find = flashRegion_find;
+  cache->can_insert = flashRegion_can_insert;
+  cache->insert = flashRegion_insert;
+  cache->evict = flashRegion_evict;
+  cache->remove = flashRegion_remove;
+  cache->to_evict = flashRegion_to_evict;
+
+  if (ccache_params.consider_obj_metadata) {
+    // region sequence number and rrpv
+    cache->obj_md_size = 5;
+  } else {
+    cache->obj_md_size = 0;
+  }
+
+  cache->eviction_params = malloc(sizeof(flashRegion_params_t));
+  memset(cache->eviction_params, 0, sizeof(flashRegion_params_t));
+  flashRegion_params_t *params =
+      (flashRegion_params_t *)cache->eviction_params;
+  params->region_size = MIN(DEFAULT_REGION_SIZE, cache->cache_size / 64);
+  if (params->region_size < 1) params->region_size = 1;
+
+  flashRegion_parse_params(cache, DEFAULT_CACHE_PARAMS);
+  if (cache_specific_params != NULL) {
+    flashRegion_parse_params(cache, cache_specific_params);
+  }
+
+  params->n_region = (int32_t)(cache->cache_size / params->region_size);
+  if (params->n_region < 1) {
+    ERROR("cache size %ld is smaller than region size %ld\n",
+          (long)cache->cache_size, (long)params->region_size);
+  }
+
+  params->regions = calloc(params->n_region, sizeof(flash_region_t));
+  params->free_regions = malloc(sizeof(int32_t) * params->n_region);
+  params->sealed_regions = malloc(sizeof(int32_t) * params->n_region);
+  for (int32_t i = 0; i < params->n_region; i++) {
+    /* pop from the end, so region 0 is used first */
+    params->free_regions[i] = params->n_region - 1 - i;
+    /* an object removed and rewritten to another region must not match
+     * the ids left in its old region */
+    params->regions[i].seq = ++params->next_region_seq;
+  }
+  params->n_free_region = params->n_region;
+  params->active_region = -1;
+
+  snprintf(cache->cache_name, CACHE_NAME_ARRAY_LEN, "flashRegion-%ld-%s",
+           (long)params->region_size,
+           params->region_evict == FLASH_REGION_EVICT_FIFO ? "fifo" : "rrip");
+
+  return cache;
+}
+
+/**
+ * free resources used by this cache
+ *
+ * @param cache
+ */
+static void flashRegion_free(cache_t *cache) {
+  flashRegion_params_t *params =
+      (flashRegion_params_t *)cache->eviction_params;
+  for (int32_t i = 0; i < params->n_region; i++) {
+    free(params->regions[i].obj_ids);
+  }
+  free(params->regions);
+  free(params->free_regions);
+  free(params->sealed_regions);
+  free(cache->eviction_params);
+  cache_struct_free(cache);
+}
+
+/**
+ * @brief this function is the user facing API
+ * it performs the following logic
+ *
+ * ```
+ * if obj in cache:
+ *    update_metadata
+ *    return true
+ * else:
+ *    if the admission policy admits the object:
+ *        append it to the active region, evicting regions if needed
+ *    return false
+ * ```
+ *
+ * the live bytes never exceed the cache size, so the eviction loop in
+ * cache_get_base only runs when most of the flash holds live objects
+ *
+ * @param cache
+ * @param req
+ * @return true if cache hit, false if cache miss
+ */
+static bool flashRegion_get(cache_t *cache, const request_t *req) {
+  return cache_get_base(cache, req);
+}
+
+// ***********************************************************************
+// ****                                                               ****
+// ****       developer facing APIs (used by cache developer)         ****
+// ****                                                               ****
+// ***********************************************************************
+/**
+ * @brief find an object in the cache
+ *
+ * @param cache
+ * @param req
+ * @param update_cache whether to update the cache,
+ *  if true, the RRPV of the object is reset
+ *  and if the object is expired, it is removed from the cache
+ * @return the object or NULL if not found
+ */
+static cache_obj_t *flashRegion_find(cache_t *cache, const request_t *req,
+                                     const bool update_cache) {
+  cache_obj_t *obj = cache_find_base(cache, req, update_cache);
+  if (obj != NULL && update_cache) {
+    obj->flashRegion.rrpv = 0;
+  }
+
+  return obj;
+}
+
+/**
+ * @brief an object larger than a region cannot be written
+ */
+static bool flashRegion_can_insert(cache_t *cache, const request_t *req) {
+  flashRegion_params_t *params =
+      (flashRegion_params_t *)cache->eviction_params;
+  if (req->obj_size + cache->obj_md_size > params->region_size) {
+    return false;
+  }
+
+  return cache_can_insert_default(cache, req);
+}
+
+/**
+ * @brief insert an object into the cache,
+ * the object is appended to the active region, if the active region is full,
+ * it is written to the device and a new region is opened, which may evict the
+ * oldest region
+ *
+ * @param cache
+ * @param req
+ * @return the inserted object
+ */
+static cache_obj_t *flashRegion_insert(cache_t *cache, const request_t *req) {
+  flashRegion_params_t *params =
+      (flashRegion_params_t *)cache->eviction_params;
+
+  cache_obj_t *obj = cache_insert_base(cache, req);
+  obj->flashRegion.rrpv = params->max_rrpv;
+  params->n_obj_admitted += 1;
+  params->n_byte_admitted += obj->obj_size + cache->obj_md_size;
+  _flashRegion_write_obj(cache, obj);
+
+  return obj;
+}
+
+/**
+ * @brief the eviction unit is a region, not an object
+ */
+static cache_obj_t *flashRegion_to_evict(cache_t *cache, const request_t *req) {
+  assert(false);
+  return NULL;
+}
+
+/**
+ * @brief seal the active region and write it to the device
+ */
+static void _flashRegion_seal_active(flashRegion_params_t *params) {
+  DEBUG_ASSERT(params->active_region >= 0);
+  int32_t pos = (params->sealed_head + params->n_sealed_region) %
+                params->n_region;
+  params->sealed_regions[pos] = params->active_region;
+  params->n_sealed_region += 1;
+  params->active_region = -1;
+
+  params->n_region_written += 1;
+  params->n_byte_device_write += params->region_size;
+}
+
+/**
+ * @brief evict the oldest region, its objects are removed or reinserted
+ * into the active region
+ *
+ * the region is put to the free list before reinsertion, the reinserted
+ * objects come from this region so they fit into it
+ */
+static void _flashRegion_evict_region(cache_t *cache) {
+  flashRegion_params_t *params =
+      (flashRegion_params_t *)cache->eviction_params;
+
+  if (params->n_sealed_region == 0) {
+    if (params->active_region < 0 ||
+        params->regions[params->active_region].n_obj == 0) {
+      return;
+    }
+    _flashRegion_seal_active(params);
+  }
+
+  int32_t region_id = params->sealed_regions[params->sealed_head];
+  params->sealed_head = (params->sealed_head + 1) % params->n_region;
+  params->n_sealed_region -= 1;
+  params->n_region_evicted += 1;
+
+  flash_region_t *region = &params->regions[region_id];
+  obj_id_t *obj_ids = region->obj_ids;
+  int32_t n_obj = region->n_obj;
+  int32_t old_seq = region->seq;
+  region->obj_ids = NULL;
+  region->n_obj = 0;
+  region->n_obj_allocated = 0;
+  region->seq = ++params->next_region_seq;
+  region->write_offset = 0;
+  params->free_regions[params->n_free_region++] = region_id;
+
+  for (int32_t i = 0; i < n_obj; i++) {
+    cache_obj_t *obj = hashtable_find_obj_id(cache->hashtable, obj_ids[i]);
+    if (obj == NULL || obj->flashRegion.region_seq != old_seq) {
+      // removed or rewritten to another region
+      continue;
+    }
+
+    if (obj->flashRegion.rrpv < params->max_rrpv) {
+      obj->flashRegion.rrpv += 1;
+      params->n_obj_reinserted += 1;
+      params->n_byte_reinserted += obj->obj_size + cache->obj_md_size;
+      _flashRegion_write_obj(cache, obj);
+    } else {
+      cache_evict_base(cache, obj, true);
+    }
+  }
+
+  free(obj_ids);
+}
+
+/**
+ * @brief append an object to the active region
+ */
+static void _flashRegion_write_obj(cache_t *cache, cache_obj_t *obj) {
+  flashRegion_params_t *params =
+      (flashRegion_params_t *)cache->eviction_params;
+  int64_t obj_size = obj->obj_size + cache->obj_md_size;
+  DEBUG_ASSERT(obj_size <= params->region_size);
+
+  while (params->active_region < 0 ||
+         params->regions[params->active_region].write_offset + obj_size >
+             params->region_size) {
+    if (params->active_region >= 0) {
+      _flashRegion_seal_active(params);
+    }
+    if (params->n_free_region == 0) {
+      // may reinsert objects and open a region
+      _flashRegion_evict_region(cache);
+    }
+    if (params->active_region < 0) {
+      params->active_region = params->free_regions[--params->n_free_region];
+    }
+  }
+
+  flash_region_t *region = &params->regions[params->active_region];
+  if (region->n_obj == region->n_obj_allocated) {
+    region->n_obj_allocated =
+        region->n_obj_allocated == 0 ? 64 : region->n_obj_allocated * 2;
+    region->obj_ids =
+        realloc(region->obj_ids, sizeof(obj_id_t) * region->n_obj_allocated);
+  }
+  region->obj_ids[region->n_obj++] = obj->obj_id;
+  region->write_offset += obj_size;
+  obj->flashRegion.region_seq = region->seq;
+}
+
+/**
+ * @brief evict the oldest region
+ *
+ * @param cache
+ * @param req not used
+ */
+static void flashRegion_evict(cache_t *cache, const request_t *req) {
+  _flashRegion_evict_region(cache);
+}
+
+/**
+ * @brief remove an object from the cache, its space in the region is not
+ * reused until the region is evicted
+ *
+ * @param cache
+ * @param obj_id
+ * @return true if the object is removed, false if the object is not in the
+ * cache
+ */
+static bool flashRegion_remove(cache_t *cache, const obj_id_t obj_id) {
+  cache_obj_t *obj = hashtable_find_obj_id(cache->hashtable, obj_id);
+  if (obj == NULL) {
+    return false;
+  }
+
+  cache_remove_obj_base(cache, obj, true);
+
+  return true;
+}
+
+// ***********************************************************************
+// ****                                                               ****
+// ****                parameter set up functions                     ****
+// ****                                                               ****
+// ***********************************************************************
+static const char *flashRegion_current_params(flashRegion_params_t *params) {
+  static __thread char params_str[128];
+  snprintf(params_str, 128, "region-size=%ld,region-evict=%s,rrip-bits=%d\n",
+           (long)params->region_size,
+           params->region_evict == FLASH_REGION_EVICT_FIFO ? "fifo" : "rrip",
+           params->max_rrpv == 0 ? 0 : 32 - __builtin_clz(params->max_rrpv));
+  return params_str;
+}
+
+static void flashRegion_parse_params(cache_t *cache,
+                                     const char *cache_specific_params) {
+  flashRegion_params_t *params =
+      (flashRegion_params_t *)(cache->eviction_params);
+
+  char *params_str = strdup(cache_specific_params);
+  char *old_params_str = params_str;
+  int rrip_bits = params->max_rrpv == 0 ? 2 : 32 - __builtin_clz(params->max_rrpv);
+
+  while (params_str != NULL && params_str[0] != '\0') {
+    /* different parameters are separated by comma,
+     * key and value are separated by = */
+    char *key = strsep((char **)&params_str, "=");
+    char *value = strsep((char **)&params_str, ",");
+
+    // skip the white space
+    while (params_str != NULL && *params_str == ' ') {
+      params_str++;
+    }
+
+    if (strcasecmp(key, "region-size") == 0) {
+      params->region_size = strtoll(value, NULL, 10);
+      if (params->region_size <= 0) {
+        ERROR("region size must be positive, got %s\n", value);
+      }
+    } else if (strcasecmp(key, "region-evict") == 0) {
+      if (strcasecmp(value, "fifo") == 0) {
+        params->region_evict = FLASH_REGION_EVICT_FIFO;
+      } else if (strcasecmp(value, "rrip") == 0) {
+        params->region_evict = FLASH_REGION_EVICT_RRIP;
+      } else {
+        ERROR("flashRegion does not support region-evict=%s\n", value);
+      }
+    } else if (strcasecmp(key, "rrip-bits") == 0) {
+      rrip_bits = (int)strtol(value, NULL, 10);
+      if (rrip_bits < 1 || rrip_bits > 6) {
+        ERROR("rrip-bits must be in [1, 6], got %s\n", value);
+      }
+    } else if (strcasecmp(key, "print") == 0) {
+      printf("parameters: %s\n", flashRegion_current_params(params));
+      exit(0);
+    } else {
+      ERROR("%s does not have parameter %s\n", cache->cache_name, key);
+      exit(1);
+    }
+  }
+
+  /* with fifo, all objects are inserted with the max RRPV (0),
+   * so no object is reinserted */
+  if (params->region_evict == FLASH_REGION_EVICT_RRIP) {
+    params->max_rrpv = (int8_t)((1 << rrip_bits) - 1);
+  } else {
+    params->max_rrpv = 0;
+  }
+
+  free(old_params_str);
+}
+
+#ifdef __cplusplus
+}
+#endif
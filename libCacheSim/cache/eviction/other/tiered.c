@@ -0,0 +1,615 @@
+//
+//  a cache hierarchy of two or more tiers, e.g., DRAM and flash,
+//  a request looks up the tiers from the first to the last, and the misses
+//  and evictions of one tier stream into the next tier in the same pass
+//
+//  parameters:
+//    tiers: the eviction algorithm of each tier, e.g., tiers=LRU:flashRegion
+//    tier-size-ratio: the fraction of the cache size of each tier,
+//      default 0.1 for the first tier and the rest split evenly
+//    inclusion: non-inclusive (default), inclusive or exclusive,
+//      see tiered_inclusion_e
+//    promote: whether a hit in a lower tier writes the object to the first
+//      tier, default true
+//    latency: the lookup latency of each tier and the backend,
+//      e.g., latency=1:100:10000, the unit is chosen by the user,
+//      a hit in a tier costs the latency of the tiers up to it,
+//      and a miss costs the latency of all tiers and the backend
+//
+//  the admissioner of this cache decides which objects are written to the
+//  tiers after the first one (e.g., flash admission)
+//
+//  each tier reports the objects it evicts through an eviction hook (see
+//  cache_evict_base), including the objects evicted inside insert, e.g., the
+//  regions of flashRegion, the evicted objects are demoted to the next tier
+//  or removed from the upper tiers after the tier returns;
+//  twoQ, LIRS and S3FIFO do not evict through cache_evict_base, so they can
+//  only be the last tier (the first tier if inclusive)
+//
+//  tiered.c
+//  libCacheSim
+//
+
+#include "../../../dataStructure/hashtable/hashtable.h"
+#include "../../../include/libCacheSim/evictionAlgo.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static const char *DEFAULT_CACHE_PARAMS =
+    "tiers=LRU:FIFO,inclusion=non-inclusive,promote=true";
+
+// ***********************************************************************
+// ****                                                               ****
+// ****                   function declarations                       ****
+// ****                                                               ****
+// ***********************************************************************
+cache_t *tiered_init(const common_cache_params_t ccache_params,
+                     const char *cache_specific_params);
+static void tiered_free(cache_t *cache);
+static bool tiered_get(cache_t *cache, const request_t *req);
+
+static cache_obj_t *tiered_find(cache_t *cache, const request_t *req,
+                                const bool update_cache);
+static cache_obj_t *tiered_insert(cache_t *cache, const request_t *req);
+static cache_obj_t *tiered_to_evict(cache_t *cache, const request_t *req);
+static void tiered_evict(cache_t *cache, const request_t *req);
+static bool tiered_remove(cache_t *cache, const obj_id_t obj_id);
+static inline int64_t tiered_get_occupied_byte(const cache_t *cache);
+static inline int64_t tiered_get_n_obj(const cache_t *cache);
+static void tiered_parse_params(cache_t *cache,
+                                const char *cache_specific_params);
+
+static cache_obj_t *_tiered_write(cache_t *cache, int tier_idx,
+                                  const request_t *req);
+static void _tiered_record_eviction(cache_t *tier, const cache_obj_t *obj,
+                                    void *data);
+
+// ***********************************************************************
+// ****                                                               ****
+// ****                   end user facing functions                   ****
+// ****                                                               ****
+// ***********************************************************************
+
+static cache_t *_tiered_create_tier(const char *name,
+                                    const common_cache_params_t ccache_params) {
+  cache_t *tier = NULL;
+  if (strcasecmp(name, "LRU") == 0) {
+    tier = LRU_init(ccache_params, NULL);
+  } else if (strcasecmp(name, "FIFO") == 0) {
+    tier = FIFO_init(ccache_params, NULL);
+  } else if (strcasecmp(name, "Clock") == 0) {
+    tier = Clock_init(ccache_params, NULL);
+  } else if (strcasecmp(name, "clock-2") == 0) {
+    tier = Clock_init(ccache_params, "n-bit-counter=2");
+  } else if (strcasecmp(name, "ARC") == 0) {
+    tier = ARC_init(ccache_params, NULL);
+  } else if (strcasecmp(name, "twoQ") == 0) {
+    tier = TwoQ_init(ccache_params, NULL);
+  } else if (strcasecmp(name, "LIRS") == 0) {
+    tier = LIRS_init(ccache_params, NULL);
+  } else if (strcasecmp(name, "S3FIFO") == 0) {
+    tier = S3FIFO_init(ccache_params, NULL);
+  } else if (strcasecmp(name, "Sieve") == 0) {
+    tier = Sieve_init(ccache_params, NULL);
+  } else if (strcasecmp(name, "LHD") == 0) {
+    tier = LHD_init(ccache_params, NULL);
+  } else if (strcasecmp(name, "flashRegion") == 0) {
+    tier = flashRegion_init(ccache_params, NULL);
+  } else if (strcasecmp(name, "flashRegion-rrip") == 0) {
+    tier = flashRegion_init(ccache_params, "region-evict=rrip");
+  } else {
+    ERROR("tiered does not support tier %s\n", name);
+  }
+
+  return tier;
+}
+
+/* whether the evictions of the tier are demoted or back invalidated */
+static inline bool _tiered_need_eviction_hook(const tiered_params_t *params,
+                                              int tier_idx) {
+  if (params->inclusion == TIERED_INCLUSIVE) {
+    return tier_idx > 0;
+  }
+  return tier_idx < params->n_tier - 1;
+}
+
+/* these algorithms remove the evicted objects without cache_evict_base */
+static inline bool _tiered_report_eviction(const char *name) {
+  return strcasecmp(name, "twoQ") != 0 && strcasecmp(name, "LIRS") != 0 &&
+         strcasecmp(name, "S3FIFO") != 0;
+}
+
+cache_t *tiered_init(const common_cache_params_t ccache_params,
+                     const char *cache_specific_params) {
+  cache_t *cache =
+      cache_struct_init("tiered", ccache_params, cache_specific_params);
+  cache->cache_init = tiered_init;
+  cache->cache_free = tiered_free;
+  cache->get = tiered_get;
+  cache->find = tiered_find;
+  cache->insert = tiered_insert;
+  cache->evict = tiered_evict;
+  cache->remove = tiered_remove;
+  cache->to_evict = tiered_to_evict;
+  cache->get_n_obj = tiered_get_n_obj;
+  cache->get_occupied_byte = tiered_get_occupied_byte;
+
+  cache->obj_md_size = 0;
+
+  cache->eviction_params = malloc(sizeof(tiered_params_t));
+  memset(cache->eviction_params, 0, sizeof(tiered_params_t));
+  tiered_params_t *params = (tiered_params_t *)cache->eviction_params;
+
+  tiered_parse_params(cache, DEFAULT_CACHE_PARAMS);
+  if (cache_specific_params != NULL) {
+    tiered_parse_params(cache, cache_specific_params);
+  }
+
+  if (params->tier_size_ratio[0] == 0) {
+    params->tier_size_ratio[0] = 0.1;
+    for (int i = 1; i < params->n_tier; i++) {
+      params->tier_size_ratio[i] = 0.9 / (params->n_tier - 1);
+    }
+  }
+
+  int n = snprintf(cache->cache_name, CACHE_NAME_ARRAY_LEN, "tiered");
+  common_cache_params_t ccache_params_local = ccache_params;
+  for (int i = 0; i < params->n_tier; i++) {
+    ccache_params_local.cache_size =
+        (int64_t)(ccache_params.cache_size * params->tier_size_ratio[i]);
+    params->tiers[i] =
+        _tiered_create_tier(params->tier_names[i], ccache_params_local);
+    params->req_local[i] = new_request();
+    if (_tiered_need_eviction_hook(params, i)) {
+      if (!_tiered_report_eviction(params->tier_names[i])) {
+        ERROR("tiered: %s does not report its evictions, it can only be the "
+              "%s tier\n",
+              params->tier_names[i],
+              params->inclusion == TIERED_INCLUSIVE ? "first" : "last");
+      }
+      params->tiers[i]->evict_hook = _tiered_record_eviction;
+      params->tiers[i]->evict_hook_data = &params->evicted[i];
+    }
+    if (n < CACHE_NAME_ARRAY_LEN) {
+      n += snprintf(cache->cache_name + n, CACHE_NAME_ARRAY_LEN - n, "-%s",
+                    params->tier_names[i]);
+    }
+  }
+
+  return cache;
+}
+
+/**
+ * free resources used by this cache
+ *
+ * @param cache
+ */
+static void tiered_free(cache_t *cache) {
+  tiered_params_t *params = (tiered_params_t *)cache->eviction_params;
+  for (int i = 0; i < params->n_tier; i++) {
+    params->tiers[i]->cache_free(params->tiers[i]);
+    free_request(params->req_local[i]);
+    free(params->evicted[i].obj_id);
+    free(params->evicted[i].obj_size);
+  }
+  free(cache->eviction_params);
+  cache_struct_free(cache);
+}
+
+/**
+ * @brief this function is the user facing API
+ * it performs the following logic
+ *
+ * ```
+ * for each tier:
+ *    if obj in tier:
+ *        promote the object if it is not in the first tier
+ *        return true
+ * write the object to the first tier (or all tiers if inclusive),
+ * objects evicted from a tier are demoted to the next tier
+ * return false
+ * ```
+ *
+ * @param cache
+ * @param req
+ * @return true if cache hit, false if cache miss
+ */
+static bool tiered_get(cache_t *cache, const request_t *req) {
+  tiered_params_t *params = (tiered_params_t *)cache->eviction_params;
+  cache->n_req += 1;
+
+  int hit_tier = -1;
+  for (int i = 0; i < params->n_tier; i++) {
+    params->tiers[i]->n_req += 1;
+    params->total_latency += params->latency[i];
+    if (params->tiers[i]->find(params->tiers[i], req, true) != NULL) {
+      hit_tier = i;
+      break;
+    }
+  }
+
+  params->last_served_tier = hit_tier >= 0 ? hit_tier : params->n_tier;
+  if (hit_tier == 0) {
+    params->n_hit[0] += 1;
+    return true;
+  }
+
+  if (hit_tier > 0) {
+    params->n_hit[hit_tier] += 1;
+    if (!params->promote) {
+      return true;
+    }
+
+    params->n_promote[hit_tier] += 1;
+    if (params->inclusion == TIERED_EXCLUSIVE) {
+      cache_t *tier = params->tiers[hit_tier];
+      tier->remove(tier, req->obj_id);
+    }
+    if (params->inclusion == TIERED_INCLUSIVE) {
+      for (int i = hit_tier - 1; i >= 0; i--) {
+        _tiered_write(cache, i, req);
+      }
+    } else {
+      _tiered_write(cache, 0, req);
+    }
+
+    return true;
+  }
+
+  params->n_miss += 1;
+  params->total_latency += params->latency[params->n_tier];
+  tiered_insert(cache, req);
+
+  return false;
+}
+
+/**
+ * @brief the tier that served the last request, n_tier if it was a miss,
+ * used as the served_tier of a timing model (see timingModel.h)
+ */
+int tiered_served_tier(const cache_t *cache, const request_t *req, bool hit) {
+  const tiered_params_t *params =
+      (const tiered_params_t *)cache->eviction_params;
+  return params->last_served_tier;
+}
+
+// ***********************************************************************
+// ****                                                               ****
+// ****       developer facing APIs (used by cache developer)         ****
+// ****                                                               ****
+// ***********************************************************************
+/**
+ * @brief find an object in the tiers, objects found in a lower tier
+ * are not promoted
+ *
+ * @param cache
+ * @param req
+ * @param update_cache whether to update the metadata of the tier that has
+ * the object
+ * @return the object or NULL if not found
+ */
+static cache_obj_t *tiered_find(cache_t *cache, const request_t *req,
+                                const bool update_cache) {
+  tiered_params_t *params = (tiered_params_t *)cache->eviction_params;
+
+  for (int i = 0; i < params->n_tier; i++) {
+    cache_obj_t *obj = params->tiers[i]->find(params->tiers[i], req,
+                                              update_cache);
+    if (obj != NULL) {
+      return obj;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief the eviction hook of a tier, it records the evicted object,
+ * which is freed after the hook returns
+ */
+static void _tiered_record_eviction(cache_t *tier, const cache_obj_t *obj,
+                                    void *data) {
+  tiered_evicted_t *evicted = (tiered_evicted_t *)data;
+  if (evicted->n_obj == evicted->capacity) {
+    evicted->capacity = evicted->capacity == 0 ? 64 : evicted->capacity * 2;
+    evicted->obj_id =
+        realloc(evicted->obj_id, sizeof(obj_id_t) * evicted->capacity);
+    evicted->obj_size =
+        realloc(evicted->obj_size, sizeof(int64_t) * evicted->capacity);
+  }
+  evicted->obj_id[evicted->n_obj] = obj->obj_id;
+  evicted->obj_size[evicted->n_obj] = obj->obj_size;
+  evicted->n_obj += 1;
+}
+
+/**
+ * @brief demote the objects the tier has evicted to the next tier, or
+ * remove them from the upper tiers if the cache is inclusive,
+ * it is called after each evict and insert of the tier
+ */
+static void _tiered_handle_evicted(cache_t *cache, int tier_idx,
+                                   const request_t *req) {
+  tiered_params_t *params = (tiered_params_t *)cache->eviction_params;
+  tiered_evicted_t *evicted = &params->evicted[tier_idx];
+  request_t *req_local = params->req_local[tier_idx];
+
+  // demotion and back invalidation do not change this tier
+  for (int64_t j = 0; j < evicted->n_obj; j++) {
+    req_local->obj_id = evicted->obj_id[j];
+    req_local->obj_size = evicted->obj_size[j];
+    req_local->clock_time = req->clock_time;
+    req_local->hv = 0;  // the hashtable caches the hash of the last object
+    if (params->inclusion == TIERED_INCLUSIVE) {
+      for (int i = 0; i < tier_idx; i++) {
+        params->tiers[i]->remove(params->tiers[i], req_local->obj_id);
+      }
+    } else {
+      params->n_demote[tier_idx] += 1;
+      _tiered_write(cache, tier_idx + 1, req_local);
+    }
+  }
+  evicted->n_obj = 0;
+}
+
+/**
+ * @brief evict from a tier, the evicted objects are demoted to the next
+ * tier, or removed from the upper tiers if the cache is inclusive
+ */
+static void _tiered_evict_from_tier(cache_t *cache, int tier_idx,
+                                    const request_t *req) {
+  tiered_params_t *params = (tiered_params_t *)cache->eviction_params;
+  cache_t *tier = params->tiers[tier_idx];
+
+  tier->evict(tier, req);
+  _tiered_handle_evicted(cache, tier_idx, req);
+}
+
+/**
+ * @brief write an object to a tier, evicting from the tier if needed
+ */
+static cache_obj_t *_tiered_write(cache_t *cache, int tier_idx,
+                                  const request_t *req) {
+  tiered_params_t *params = (tiered_params_t *)cache->eviction_params;
+  cache_t *tier = params->tiers[tier_idx];
+
+  // a lower tier may still have the object
+  if (tier->find(tier, req, false) != NULL) {
+    return NULL;
+  }
+
+  if (tier_idx > 0 && cache->admissioner != NULL) {
+    admissioner_t *admissioner = cache->admissioner;
+    if (!admissioner->admit(admissioner, req)) {
+      return NULL;
+    }
+  }
+
+  if (!tier->can_insert(tier, req)) {
+    return NULL;
+  }
+
+  while (tier->get_occupied_byte(tier) + req->obj_size + tier->obj_md_size >
+         tier->cache_size) {
+    _tiered_evict_from_tier(cache, tier_idx, req);
+  }
+
+  params->n_write[tier_idx] += 1;
+  params->n_byte_write[tier_idx] += req->obj_size;
+
+  // some tiers evict inside insert, e.g., flashRegion evicts a region
+  cache_obj_t *obj = tier->insert(tier, req);
+  _tiered_handle_evicted(cache, tier_idx, req);
+
+  return obj;
+}
+
+/**
+ * @brief insert an object into the cache,
+ * it is written to the first tier, or all tiers if the cache is inclusive,
+ * eviction is part of this function
+ *
+ * @param cache
+ * @param req
+ * @return the inserted object
+ */
+static cache_obj_t *tiered_insert(cache_t *cache, const request_t *req) {
+  tiered_params_t *params = (tiered_params_t *)cache->eviction_params;
+
+  if (params->inclusion != TIERED_INCLUSIVE) {
+    return _tiered_write(cache, 0, req);
+  }
+
+  // from the last tier so that back invalidation does not remove it
+  cache_obj_t *obj = NULL;
+  for (int i = params->n_tier - 1; i >= 0; i--) {
+    obj = _tiered_write(cache, i, req);
+  }
+
+  return obj;
+}
+
+/**
+ * @brief find the object to be evicted
+ * this function does not actually evict the object or update metadata
+ * not all eviction algorithms support this function
+ * because the eviction logic cannot be decoupled from finding eviction
+ * candidate, so use assert(false) if you cannot support this function
+ *
+ * @param cache the cache
+ * @return the object to be evicted
+ */
+static cache_obj_t *tiered_to_evict(cache_t *cache, const request_t *req) {
+  assert(false);
+  return NULL;
+}
+
+/**
+ * @brief evict an object from the first non-empty tier, it may be demoted to
+ * the next tier
+ *
+ * @param cache
+ * @param req not used
+ */
+static void tiered_evict(cache_t *cache, const request_t *req) {
+  tiered_params_t *params = (tiered_params_t *)cache->eviction_params;
+
+  for (int i = 0; i < params->n_tier; i++) {
+    cache_t *tier = params->tiers[i];
+    if (tier->get_n_obj(tier) > 0) {
+      _tiered_evict_from_tier(cache, i, req);
+      return;
+    }
+  }
+}
+
+/**
+ * @brief remove an object from all tiers
+ *
+ * @param cache
+ * @param obj_id
+ * @return true if the object is removed, false if the object is not in the
+ * cache
+ */
+static bool tiered_remove(cache_t *cache, const obj_id_t obj_id) {
+  tiered_params_t *params = (tiered_params_t *)cache->eviction_params;
+  bool removed = false;
+  for (int i = 0; i < params->n_tier; i++) {
+    removed = params->tiers[i]->remove(params->tiers[i], obj_id) || removed;
+  }
+
+  return removed;
+}
+
+/* an object in several tiers is counted in each of them */
+static inline int64_t tiered_get_occupied_byte(const cache_t *cache) {
+  tiered_params_t *params = (tiered_params_t *)cache->eviction_params;
+  int64_t occupied_byte = 0;
+  for (int i = 0; i < params->n_tier; i++) {
+    occupied_byte += params->tiers[i]->get_occupied_byte(params->tiers[i]);
+  }
+  return occupied_byte;
+}
+
+static inline int64_t tiered_get_n_obj(const cache_t *cache) {
+  tiered_params_t *params = (tiered_params_t *)cache->eviction_params;
+  int64_t n_obj = 0;
+  for (int i = 0; i < params->n_tier; i++) {
+    n_obj += params->tiers[i]->get_n_obj(params->tiers[i]);
+  }
+  return n_obj;
+}
+
+// ***********************************************************************
+// ****                                                               ****
+// ****                parameter set up functions                     ****
+// ****                                                               ****
+// ***********************************************************************
+static const char *INCLUSION_NAMES[] = {"non-inclusive", "inclusive",
+                                        "exclusive"};
+
+static const char *tiered_current_params(tiered_params_t *params) {
+  static __thread char params_str[256];
+  int n = snprintf(params_str, 256, "tiers=");
+  for (int i = 0; i < params->n_tier; i++) {
+    n += snprintf(params_str + n, 256 - n, "%s%s", i == 0 ? "" : ":",
+                  params->tier_names[i]);
+  }
+  snprintf(params_str + n, 256 - n, ",inclusion=%s,promote=%s\n",
+           INCLUSION_NAMES[params->inclusion],
+           params->promote ? "true" : "false");
+  return params_str;
+}
+
+/**
+ * @brief split a colon-separated value
+ * @return the number of fields
+ */
+static int _tiered_split(char *value, char **fields) {
+  int n_field = 0;
+  char *field;
+  while ((field = strsep(&value, ":")) != NULL) {
+    if (n_field == TIERED_MAX_TIER + 1) {
+      ERROR("tiered supports at most %d tiers\n", TIERED_MAX_TIER);
+    }
+    fields[n_field++] = field;
+  }
+  return n_field;
+}
+
+static void tiered_parse_params(cache_t *cache,
+                                const char *cache_specific_params) {
+  tiered_params_t *params = (tiered_params_t *)(cache->eviction_params);
+
+  char *params_str = strdup(cache_specific_params);
+  char *old_params_str = params_str;
+  char *fields[TIERED_MAX_TIER + 1];
+
+  while (params_str != NULL && params_str[0] != '\0') {
+    /* different parameters are separated by comma,
+     * key and value are separated by = */
+    char *key = strsep((char **)&params_str, "=");
+    char *value = strsep((char **)&params_str, ",");
+
+    // skip the white space
+    while (params_str != NULL && *params_str == ' ') {
+      params_str++;
+    }
+
+    if (strcasecmp(key, "tiers") == 0) {
+      int n_field = _tiered_split(value, fields);
+      if (n_field < 2 || n_field > TIERED_MAX_TIER) {
+        ERROR("tiered needs 2 to %d tiers, got %d\n", TIERED_MAX_TIER,
+              n_field);
+      }
+      params->n_tier = n_field;
+      for (int i = 0; i < n_field; i++) {
+        strncpy(params->tier_names[i], fields[i], 15);
+      }
+    } else if (strcasecmp(key, "tier-size-ratio") == 0) {
+      int n_field = _tiered_split(value, fields);
+      if (n_field != params->n_tier) {
+        ERROR("tier-size-ratio has %d values, but there are %d tiers\n",
+              n_field, params->n_tier);
+      }
+      for (int i = 0; i < n_field; i++) {
+        params->tier_size_ratio[i] = strtod(fields[i], NULL);
+      }
+    } else if (strcasecmp(key, "inclusion") == 0) {
+      if (strcasecmp(value, "non-inclusive") == 0) {
+        params->inclusion = TIERED_NON_INCLUSIVE;
+      } else if (strcasecmp(value, "inclusive") == 0) {
+        params->inclusion = TIERED_INCLUSIVE;
+      } else if (strcasecmp(value, "exclusive") == 0) {
+        params->inclusion = TIERED_EXCLUSIVE;
+      } else {
+        ERROR("tiered does not support inclusion=%s\n", value);
+      }
+    } else if (strcasecmp(key, "promote") == 0) {
+      params->promote =
+          strcasecmp(value, "true") == 0 || strcmp(value, "1") == 0;
+    } else if (strcasecmp(key, "latency") == 0) {
+      int n_field = _tiered_split(value, fields);
+      if (n_field != params->n_tier + 1) {
+        ERROR("latency needs %d values (tiers and backend), got %d\n",
+              params->n_tier + 1, n_field);
+      }
+      for (int i = 0; i < n_field; i++) {
+        params->latency[i] = strtoll(fields[i], NULL, 10);
+      }
+    } else if (strcasecmp(key, "print") == 0) {
+      printf("parameters: %s\n", tiered_current_params(params));
+      exit(0);
+    } else {
+      ERROR("%s does not have parameter %s\n", cache->cache_name, key);
+      exit(1);
+    }
+  }
+
+  free(old_params_str);
+}
+
+#ifdef __cplusplus
+}
+#endif
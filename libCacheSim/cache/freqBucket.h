@@ -0,0 +1,166 @@
+//
+//  freqBucket.h
+//  frequency buckets used by LFU related algorithms,
+//  see "An O(1) algorithm for implementing the LFU cache eviction scheme"
+//
+//  the non-empty buckets form a doubly linked list sorted by freq, so the
+//  bucket with the smallest freq is the head of the list and the next freq
+//  bucket is one pointer away, each object points to its bucket
+//  (obj->lfu.freq_node), so no lookup by freq is needed
+//
+//  bucket nodes are allocated from slabs and recycled through a free list,
+//  so that nodes are close in memory and a hit does not call malloc
+//
+//  libCacheSim
+//
+
+#ifndef libCacheSim_FREQBUCKET_H
+#define libCacheSim_FREQBUCKET_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../include/libCacheSim/evictionAlgo.h"
+#include "../include/libCacheSim/macro.h"
+
+#define FREQ_NODE_SLAB_SIZE 1024
+
+typedef struct freq_node_slab {
+  struct freq_node_slab *next;
+  freq_node_t nodes[FREQ_NODE_SLAB_SIZE];
+} freq_node_slab_t;
+
+typedef struct freq_bucket_list {
+  /* the non-empty bucket with the smallest freq */
+  freq_node_t *head;
+  /* recycled nodes, linked by next */
+  freq_node_t *free_nodes;
+  freq_node_slab_t *slabs;
+} freq_bucket_list_t;
+
+static inline void freq_bucket_list_init(freq_bucket_list_t *list) {
+  list->head = NULL;
+  list->free_nodes = NULL;
+  list->slabs = NULL;
+}
+
+static inline void freq_bucket_list_free(freq_bucket_list_t *list) {
+  freq_node_slab_t *slab = list->slabs;
+  while (slab != NULL) {
+    freq_node_slab_t *next = slab->next;
+    my_free(sizeof(freq_node_slab_t), slab);
+    slab = next;
+  }
+  freq_bucket_list_init(list);
+}
+
+static inline freq_node_t *_freq_bucket_alloc_node(freq_bucket_list_t *list) {
+  if (list->free_nodes == NULL) {
+    freq_node_slab_t *slab = my_malloc(freq_node_slab_t);
+    slab->next = list->slabs;
+    list->slabs = slab;
+    /* push in reverse order so that nodes are handed out in address order */
+    for (int i = FREQ_NODE_SLAB_SIZE - 1; i >= 0; i--) {
+      slab->nodes[i].next = list->free_nodes;
+      list->free_nodes = &slab->nodes[i];
+    }
+  }
+
+  freq_node_t *node = list->free_nodes;
+  list->free_nodes = node->next;
+  return node;
+}
+
+/**
+ * @brief find the bucket of freq, the bucket is created if it does not exist
+ *
+ * @param list
+ * @param start the search starts from this bucket, it must have a freq no
+ *  larger than freq, NULL means the head of the list
+ * @param freq
+ * @return the bucket of freq
+ */
+static inline freq_node_t *freq_bucket_find_or_create(freq_bucket_list_t *list,
+                                                      freq_node_t *start,
+                                                      const int64_t freq) {
+  freq_node_t *prev = NULL;
+  freq_node_t *curr = start == NULL ? list->head : start;
+  while (curr != NULL && curr->freq < freq) {
+    prev = curr;
+    curr = curr->next;
+  }
+  if (curr != NULL && curr->freq == freq) {
+    return curr;
+  }
+
+  /* insert the new bucket between prev and curr */
+  freq_node_t *node = _freq_bucket_alloc_node(list);
+  node->freq = freq;
+  node->n_obj = 0;
+  node->first_obj = NULL;
+  node->last_obj = NULL;
+  node->prev = prev;
+  node->next = curr;
+  if (curr != NULL) {
+    curr->prev = node;
+  }
+  if (prev != NULL) {
+    prev->next = node;
+  } else {
+    list->head = node;
+  }
+
+  return node;
+}
+
+/**
+ * @brief unlink an empty bucket from the list and recycle it,
+ * used by the algorithms that link objects in a bucket by their own fields
+ */
+static inline void freq_bucket_release(freq_bucket_list_t *list,
+                                       freq_node_t *node) {
+  DEBUG_ASSERT(node->n_obj == 0);
+  if (node->prev != NULL) {
+    node->prev->next = node->next;
+  } else {
+    list->head = node->next;
+  }
+  if (node->next != NULL) {
+    node->next->prev = node->prev;
+  }
+  node->next = list->free_nodes;
+  list->free_nodes = node;
+}
+
+/**
+ * @brief append the object to the bucket,
+ * objects in the same bucket are evicted in FIFO order
+ */
+static inline void freq_bucket_add_obj(freq_node_t *node, cache_obj_t *obj) {
+  append_obj_to_tail(&node->first_obj, &node->last_obj, obj);
+  node->n_obj += 1;
+  obj->lfu.freq_node = node;
+}
+
+/**
+ * @brief remove the object from its bucket,
+ * the bucket is recycled if it becomes empty
+ */
+static inline void freq_bucket_remove_obj(freq_bucket_list_t *list,
+                                          cache_obj_t *obj) {
+  freq_node_t *node = obj->lfu.freq_node;
+  DEBUG_ASSERT(node != NULL && node->n_obj > 0);
+  remove_obj_from_list(&node->first_obj, &node->last_obj, obj);
+  node->n_obj -= 1;
+  obj->lfu.freq_node = NULL;
+  if (node->n_obj == 0) {
+    freq_bucket_release(list, node);
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // libCacheSim_FREQBUCKET_H
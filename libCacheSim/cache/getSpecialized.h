@@ -0,0 +1,70 @@
+#pragma once
+//
+//  a get function specialized for one eviction algorithm,
+//  it follows the same logic as cache_get_base, but calls the find, insert,
+//  evict functions of the algorithm directly instead of through the function
+//  pointers in cache_t, so the compiler can inline them into the request loop
+//
+//  it does not run the prefetcher, the simulator uses it (see cache_get_func)
+//  only when the cache has no admissioner and no prefetcher,
+//  TTL is handled in find as before
+//
+//  getSpecialized.h
+//  libCacheSim
+//
+
+#include "../include/libCacheSim/cache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief define a get function named <name>_get_specialized,
+ * the <name>_find, <name>_insert and <name>_evict functions must be declared
+ * before using this macro
+ *
+ * @param name the prefix of the eviction algorithm functions
+ * @param can_insert_func the can_insert function used by the algorithm
+ * @param get_occupied_byte_func the get_occupied_byte function used by the
+ * algorithm
+ */
+#define DEFINE_CACHE_GET_SPECIALIZED(name, can_insert_func,                  \
+                                     get_occupied_byte_func)                 \
+  static bool name##_get_specialized(cache_t *cache, const request_t *req) { \
+    DEBUG_ASSERT(cache->admissioner == NULL && cache->prefetcher == NULL);   \
+    cache->n_req += 1;                                                       \
+                                                                             \
+    if (name##_find(cache, req, true) != NULL) {                             \
+      return true;                                                           \
+    }                                                                        \
+                                                                             \
+    if (can_insert_func(cache, req)) {                                       \
+      while (get_occupied_byte_func(cache) + req->obj_size +                 \
+                 cache->obj_md_size >                                        \
+             cache->cache_size) {                                            \
+        name##_evict(cache, req);                                            \
+      }                                                                      \
+      name##_insert(cache, req);                                             \
+    }                                                                        \
+                                                                             \
+    return false;                                                            \
+  }
+
+/**
+ * @brief can_insert for algorithms that use cache_can_insert_default,
+ * there is no admissioner on the specialized path,
+ * so only objects larger than the cache go to cache_can_insert_default
+ */
+static inline bool cache_can_insert_no_admissioner(cache_t *cache,
+                                                   const request_t *req) {
+  if (likely(req->obj_size + cache->obj_md_size <= cache->cache_size)) {
+    return true;
+  }
+
+  return cache_can_insert_default(cache, req);
+}
+
+#ifdef __cplusplus
+}
+#endif
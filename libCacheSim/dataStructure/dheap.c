@@ -0,0 +1,151 @@
+//
+//  dheap.c
+//  an indexed 4-ary max heap, see dheap.h
+//
+//  libCacheSim
+//
+
+#include "dheap.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/libCacheSim/logging.h"
+#include "../include/libCacheSim/macro.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DHEAP_ARITY 4
+#define dheap_parent(i) (((i)-1) / DHEAP_ARITY)
+#define dheap_first_child(i) ((i)*DHEAP_ARITY + 1)
+
+/* whether node a should be above node b */
+static inline bool node_higher(const dheap_node_t *a, const dheap_node_t *b) {
+  return a->pri > b->pri || (a->pri == b->pri && a->seq > b->seq);
+}
+
+/* the item may be a packed struct, so the position is accessed with memcpy */
+static inline void set_pos(const dheap_t *heap, void *item, int64_t pos) {
+  memcpy((char *)item + heap->pos_offset, &pos, sizeof(int64_t));
+}
+
+int64_t dheap_get_pos(const dheap_t *heap, const void *item) {
+  int64_t pos;
+  memcpy(&pos, (const char *)item + heap->pos_offset, sizeof(int64_t));
+  return pos;
+}
+
+dheap_t *dheap_init(int64_t init_capacity, size_t pos_offset) {
+  dheap_t *heap = malloc(sizeof(dheap_t));
+  if (init_capacity < 16) init_capacity = 16;
+  heap->nodes = malloc(sizeof(dheap_node_t) * init_capacity);
+  if (heap->nodes == NULL) {
+    ERROR("fail to allocate heap of %ld nodes\n", (long)init_capacity);
+  }
+  heap->size = 0;
+  heap->capacity = init_capacity;
+  heap->pos_offset = pos_offset;
+  return heap;
+}
+
+void dheap_free(dheap_t *heap) {
+  free(heap->nodes);
+  free(heap);
+}
+
+static void sift_up(dheap_t *heap, int64_t i) {
+  dheap_node_t moving = heap->nodes[i];
+  while (i > 0) {
+    int64_t parent = dheap_parent(i);
+    if (!node_higher(&moving, &heap->nodes[parent])) break;
+    heap->nodes[i] = heap->nodes[parent];
+    set_pos(heap, heap->nodes[i].item, i);
+    i = parent;
+  }
+  heap->nodes[i] = moving;
+  set_pos(heap, moving.item, i);
+}
+
+static void sift_down(dheap_t *heap, int64_t i) {
+  dheap_node_t moving = heap->nodes[i];
+  while (true) {
+    int64_t first = dheap_first_child(i);
+    if (first >= heap->size) break;
+
+    int64_t last = first + DHEAP_ARITY;
+    if (last > heap->size) last = heap->size;
+    int64_t max_child = first;
+    for (int64_t c = first + 1; c < last; c++) {
+      if (node_higher(&heap->nodes[c], &heap->nodes[max_child])) max_child = c;
+    }
+    if (!node_higher(&heap->nodes[max_child], &moving)) break;
+
+    heap->nodes[i] = heap->nodes[max_child];
+    set_pos(heap, heap->nodes[i].item, i);
+    i = max_child;
+  }
+  heap->nodes[i] = moving;
+  set_pos(heap, moving.item, i);
+}
+
+void dheap_insert_seq(dheap_t *heap, void *item, double pri, int64_t seq) {
+  if (heap->size == heap->capacity) {
+    heap->capacity *= 2;
+    heap->nodes = realloc(heap->nodes, sizeof(dheap_node_t) * heap->capacity);
+    if (heap->nodes == NULL) {
+      ERROR("fail to grow heap to %ld nodes\n", (long)heap->capacity);
+    }
+  }
+
+  int64_t i = heap->size++;
+  heap->nodes[i].pri = pri;
+  heap->nodes[i].seq = seq;
+  heap->nodes[i].item = item;
+  sift_up(heap, i);
+}
+
+void dheap_update_seq(dheap_t *heap, void *item, double pri, int64_t seq) {
+  int64_t i = dheap_get_pos(heap, item);
+  DEBUG_ASSERT(i >= 0 && i < heap->size && heap->nodes[i].item == item);
+
+  dheap_node_t old_node = heap->nodes[i];
+  heap->nodes[i].pri = pri;
+  heap->nodes[i].seq = seq;
+  if (node_higher(&heap->nodes[i], &old_node)) {
+    sift_up(heap, i);
+  } else {
+    sift_down(heap, i);
+  }
+}
+
+void dheap_remove(dheap_t *heap, void *item) {
+  int64_t i = dheap_get_pos(heap, item);
+  DEBUG_ASSERT(i >= 0 && i < heap->size && heap->nodes[i].item == item);
+
+  set_pos(heap, item, DHEAP_INVALID_POS);
+  heap->size -= 1;
+  if (i == heap->size) return;
+
+  dheap_node_t removed_node = heap->nodes[i];
+  heap->nodes[i] = heap->nodes[heap->size];
+  if (node_higher(&heap->nodes[i], &removed_node)) {
+    sift_up(heap, i);
+  } else {
+    sift_down(heap, i);
+  }
+}
+
+void *dheap_pop(dheap_t *heap) {
+  if (heap->size == 0) return NULL;
+
+  void *item = heap->nodes[0].item;
+  dheap_remove(heap, item);
+  return item;
+}
+
+#ifdef __cplusplus
+}
+#endif
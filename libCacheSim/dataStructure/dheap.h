@@ -0,0 +1,110 @@
+//
+//  dheap.h
+//  an indexed 4-ary max heap, the item with the highest priority is on top,
+//  items with the same priority are ordered by an optional sequence number
+//  (the highest on top), e.g., the negated insertion time gives FIFO order
+//
+//  compared to pqueue, heap nodes are stored inline in one growing array,
+//  and each item (e.g., a cache_obj_t) stores its position in the heap at
+//  pos_offset, so update and remove do not need a lookup,
+//  a 4-ary heap is shallower than a binary heap and the children of a node
+//  are adjacent in memory
+//
+//  libCacheSim
+//
+
+#ifndef libCacheSim_DHEAP_H
+#define libCacheSim_DHEAP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* the position stored in an item that is not in the heap */
+#define DHEAP_INVALID_POS (-1)
+
+typedef struct {
+  double pri;
+  int64_t seq;  // breaks ties between the same pri
+  void *item;
+} dheap_node_t;
+
+typedef struct dheap {
+  dheap_node_t *nodes;
+  int64_t size;
+  int64_t capacity;
+  /* the byte offset of the int64_t position field in the item */
+  size_t pos_offset;
+} dheap_t;
+
+/**
+ * create a heap
+ *
+ * @param init_capacity the initial capacity, the heap grows when it is full
+ * @param pos_offset the byte offset of the int64_t field in the item that
+ *      stores the position of the item in the heap,
+ *      e.g., offsetof(cache_obj_t, Size.heap_pos)
+ */
+dheap_t *dheap_init(int64_t init_capacity, size_t pos_offset);
+
+void dheap_free(dheap_t *heap);
+
+static inline int64_t dheap_size(const dheap_t *heap) { return heap->size; }
+
+/**
+ * insert an item with (pri, seq), the item must not be in the heap
+ */
+void dheap_insert_seq(dheap_t *heap, void *item, double pri, int64_t seq);
+
+/**
+ * change the (pri, seq) of an item in the heap
+ */
+void dheap_update_seq(dheap_t *heap, void *item, double pri, int64_t seq);
+
+/**
+ * insert an item, the item must not be in the heap,
+ * the order of items with the same priority is unspecified
+ */
+static inline void dheap_insert(dheap_t *heap, void *item, double pri) {
+  dheap_insert_seq(heap, item, pri, 0);
+}
+
+/**
+ * change the priority of an item in the heap
+ */
+static inline void dheap_update(dheap_t *heap, void *item, double pri) {
+  dheap_update_seq(heap, item, pri, 0);
+}
+
+/**
+ * remove an item from the heap, the position of the item is set to
+ * DHEAP_INVALID_POS
+ */
+void dheap_remove(dheap_t *heap, void *item);
+
+/**
+ * @return the item with the highest priority, NULL if the heap is empty
+ */
+static inline void *dheap_peek(const dheap_t *heap) {
+  return heap->size == 0 ? NULL : heap->nodes[0].item;
+}
+
+/**
+ * remove and return the item with the highest priority,
+ * NULL if the heap is empty
+ */
+void *dheap_pop(dheap_t *heap);
+
+/**
+ * @return the position of the item, DHEAP_INVALID_POS if not in the heap
+ */
+int64_t dheap_get_pos(const dheap_t *heap, const void *item);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // libCacheSim_DHEAP_H
@@ -0,0 +1,290 @@
+//
+//  fingerprintGhost.c
+//  a compact ghost that stores fingerprints, see fingerprintGhost.h
+//
+//  libCacheSim
+//
+
+#include "fingerprintGhost.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/libCacheSim/logging.h"
+#include "../include/libCacheSim/macro.h"
+#include "hash/hash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FP_GHOST_SLOTS_PER_BUCKET 4
+#define FP_GHOST_INIT_RING_CAP 1024
+#define FP_GHOST_MAX_KICKS 256
+
+static inline uint64_t _alt_bucket(const fp_ghost_t *ghost, uint64_t bucket,
+                                   uint32_t fp) {
+  return (bucket ^ ((uint64_t)fp * 0x5bd1e995ULL)) & (ghost->n_bucket - 1);
+}
+
+static inline void _hash_obj(const fp_ghost_t *ghost, obj_id_t obj_id,
+                             uint32_t *fp, uint64_t *bucket) {
+  uint64_t hv = get_hash_value_int_64(&obj_id);
+  *fp = (uint32_t)(hv >> 32) & ghost->fp_mask;
+  if (*fp == 0) *fp = 1;
+  *bucket = hv & (ghost->n_bucket - 1);
+}
+
+static inline fp_ghost_slot_t *_bucket(const fp_ghost_t *ghost,
+                                       uint64_t bucket) {
+  return &ghost->table[bucket * FP_GHOST_SLOTS_PER_BUCKET];
+}
+
+/* the entry at ring_pos is not in the table, remove it from the ring */
+static void _drop_entry(fp_ghost_t *ghost, uint32_t ring_pos) {
+  fp_ghost_entry_t *entry = &ghost->ring[ring_pos];
+  ghost->occupied_byte -= entry->size;
+  ghost->n_entry -= 1;
+  ghost->n_dropped += 1;
+  entry->fp = 0;
+  WARN_ONCE("fingerprint ghost table is too full, entries are dropped\n");
+}
+
+/* insert a slot into the table, return false if the table is too full and
+ * a slot (not necessarily the new one) has been dropped */
+static bool _table_insert(fp_ghost_t *ghost, fp_ghost_slot_t slot,
+                          uint64_t bucket) {
+  for (int n_kick = 0; n_kick < FP_GHOST_MAX_KICKS; n_kick++) {
+    uint64_t alt = _alt_bucket(ghost, bucket, slot.fp);
+    uint64_t candidates[2] = {bucket, alt};
+    for (int b = 0; b < 2; b++) {
+      fp_ghost_slot_t *slots = _bucket(ghost, candidates[b]);
+      for (int i = 0; i < FP_GHOST_SLOTS_PER_BUCKET; i++) {
+        if (slots[i].fp == 0) {
+          slots[i] = slot;
+          return true;
+        }
+      }
+    }
+
+    /* both buckets are full, kick out a slot to its alternative bucket */
+    fp_ghost_slot_t *slots = _bucket(ghost, alt);
+    int victim = n_kick % FP_GHOST_SLOTS_PER_BUCKET;
+    fp_ghost_slot_t tmp = slots[victim];
+    slots[victim] = slot;
+    slot = tmp;
+    bucket = alt;
+  }
+
+  /* the entry of the last kicked out slot becomes a false negative */
+  _drop_entry(ghost, slot.ring_pos);
+  return false;
+}
+
+static fp_ghost_slot_t *_table_find(const fp_ghost_t *ghost, uint32_t fp,
+                                    uint64_t bucket) {
+  uint64_t candidates[2] = {bucket, _alt_bucket(ghost, bucket, fp)};
+  for (int b = 0; b < 2; b++) {
+    fp_ghost_slot_t *slots = _bucket(ghost, candidates[b]);
+    for (int i = 0; i < FP_GHOST_SLOTS_PER_BUCKET; i++) {
+      if (slots[i].fp == fp) return &slots[i];
+    }
+  }
+  return NULL;
+}
+
+/* remove the slot that points to the ring entry at ring_pos */
+static void _table_remove_entry(fp_ghost_t *ghost,
+                                const fp_ghost_entry_t *entry,
+                                uint32_t ring_pos) {
+  uint64_t bucket = entry->hash_lo & (ghost->n_bucket - 1);
+  uint64_t candidates[2] = {bucket, _alt_bucket(ghost, bucket, entry->fp)};
+  for (int b = 0; b < 2; b++) {
+    fp_ghost_slot_t *slots = _bucket(ghost, candidates[b]);
+    for (int i = 0; i < FP_GHOST_SLOTS_PER_BUCKET; i++) {
+      if (slots[i].fp == entry->fp && slots[i].ring_pos == ring_pos) {
+        slots[i].fp = 0;
+        return;
+      }
+    }
+  }
+}
+
+/* the table has two slots per ring entry so that the load is at most 50% */
+static void _rebuild_table(fp_ghost_t *ghost) {
+  free(ghost->table);
+  ghost->n_bucket = ghost->ring_cap * 2 / FP_GHOST_SLOTS_PER_BUCKET;
+  ghost->table = calloc(ghost->n_bucket * FP_GHOST_SLOTS_PER_BUCKET,
+                        sizeof(fp_ghost_slot_t));
+  if (ghost->table == NULL) {
+    ERROR("fail to allocate fingerprint ghost table\n");
+  }
+
+  int64_t mask = ghost->ring_cap - 1;
+  for (int64_t seq = ghost->head; seq < ghost->tail; seq++) {
+    const fp_ghost_entry_t *entry = &ghost->ring[seq & mask];
+    if (entry->fp == 0) continue;
+    fp_ghost_slot_t slot = {.fp = entry->fp, .ring_pos = (uint32_t)(seq & mask)};
+    _table_insert(ghost, slot, entry->hash_lo & (ghost->n_bucket - 1));
+  }
+}
+
+/* move the live entries to a ring of new_cap entries, the removed entries
+ * are reclaimed */
+static void _resize(fp_ghost_t *ghost, int64_t new_cap) {
+  int64_t old_mask = ghost->ring_cap - 1;
+  fp_ghost_entry_t *new_ring = malloc(sizeof(fp_ghost_entry_t) * new_cap);
+  if (new_ring == NULL) {
+    ERROR("fail to resize fingerprint ghost to %ld entries\n", (long)new_cap);
+  }
+  int64_t n_live = 0;
+  for (int64_t seq = ghost->head; seq < ghost->tail; seq++) {
+    const fp_ghost_entry_t *entry = &ghost->ring[seq & old_mask];
+    if (entry->fp == 0) continue;
+    new_ring[n_live++] = *entry;
+  }
+  DEBUG_ASSERT(n_live == ghost->n_entry);
+  free(ghost->ring);
+  ghost->ring = new_ring;
+  ghost->ring_cap = new_cap;
+  ghost->head = 0;
+  ghost->tail = n_live;
+  _rebuild_table(ghost);
+}
+
+fp_ghost_t *fp_ghost_new(int64_t size_limit, double false_positive_rate) {
+  fp_ghost_t *ghost = malloc(sizeof(fp_ghost_t));
+  memset(ghost, 0, sizeof(fp_ghost_t));
+
+  /* the false positive rate of a cuckoo filter with two buckets of b slots
+   * and f-bit fingerprints is about 2b / 2^f */
+  ASSERT_TRUE(false_positive_rate > 0 && false_positive_rate < 1,
+              "false positive rate must be in (0, 1)\n");
+  int n_bit = (int)ceil(log2(2.0 * FP_GHOST_SLOTS_PER_BUCKET / false_positive_rate));
+  n_bit = MAX(4, MIN(32, n_bit));
+  ghost->fp_mask = n_bit == 32 ? UINT32_MAX : ((1U << n_bit) - 1);
+
+  ghost->size_limit = size_limit;
+  ghost->ring_cap = FP_GHOST_INIT_RING_CAP;
+  ghost->ring = malloc(sizeof(fp_ghost_entry_t) * ghost->ring_cap);
+  ghost->head = ghost->tail = 0;
+  _rebuild_table(ghost);
+
+  return ghost;
+}
+
+void fp_ghost_free(fp_ghost_t *ghost) {
+  free(ghost->ring);
+  free(ghost->table);
+  free(ghost);
+}
+
+fp_ghost_t *fp_ghost_clone(const fp_ghost_t *ghost) {
+  fp_ghost_t *new_ghost = malloc(sizeof(fp_ghost_t));
+  memcpy(new_ghost, ghost, sizeof(fp_ghost_t));
+  new_ghost->ring = malloc(sizeof(fp_ghost_entry_t) * ghost->ring_cap);
+  memcpy(new_ghost->ring, ghost->ring,
+         sizeof(fp_ghost_entry_t) * ghost->ring_cap);
+  size_t table_size =
+      sizeof(fp_ghost_slot_t) * ghost->n_bucket * FP_GHOST_SLOTS_PER_BUCKET;
+  new_ghost->table = malloc(table_size);
+  memcpy(new_ghost->table, ghost->table, table_size);
+  return new_ghost;
+}
+
+static void _skip_removed(fp_ghost_t *ghost) {
+  while (ghost->head < ghost->tail &&
+         ghost->ring[ghost->head & (ghost->ring_cap - 1)].fp == 0) {
+    ghost->head += 1;
+  }
+}
+
+static void _remove_oldest(fp_ghost_t *ghost) {
+  DEBUG_ASSERT(ghost->head < ghost->tail);
+  uint32_t ring_pos = (uint32_t)(ghost->head & (ghost->ring_cap - 1));
+  fp_ghost_entry_t *entry = &ghost->ring[ring_pos];
+  if (entry->fp != 0) {
+    _table_remove_entry(ghost, entry, ring_pos);
+    ghost->occupied_byte -= entry->size;
+    ghost->n_entry -= 1;
+  }
+  ghost->head += 1;
+}
+
+void fp_ghost_insert(fp_ghost_t *ghost, obj_id_t obj_id, int64_t obj_size) {
+  fp_ghost_insert_value(ghost, obj_id, obj_size, 0);
+}
+
+void fp_ghost_insert_value(fp_ghost_t *ghost, obj_id_t obj_id,
+                           int64_t obj_size, int64_t value) {
+  if (obj_size > ghost->size_limit || obj_size > UINT32_MAX) return;
+
+  while (ghost->occupied_byte + obj_size > ghost->size_limit) {
+    _remove_oldest(ghost);
+  }
+  /* removed entries stay in the ring until they become the oldest or the
+   * ring is full */
+  _skip_removed(ghost);
+  if (ghost->tail - ghost->head == ghost->ring_cap) {
+    if (ghost->n_entry * 2 <= ghost->ring_cap) {
+      _resize(ghost, ghost->ring_cap);
+    } else {
+      _resize(ghost, ghost->ring_cap * 2);
+    }
+  }
+
+  uint64_t hv = get_hash_value_int_64(&obj_id);
+  uint32_t ring_pos = (uint32_t)(ghost->tail & (ghost->ring_cap - 1));
+  fp_ghost_entry_t *entry = &ghost->ring[ring_pos];
+  entry->value = value;
+  entry->fp = (uint32_t)(hv >> 32) & ghost->fp_mask;
+  if (entry->fp == 0) entry->fp = 1;
+  entry->size = (uint32_t)obj_size;
+  entry->hash_lo = (uint32_t)hv;
+  ghost->tail += 1;
+  ghost->occupied_byte += obj_size;
+  ghost->n_entry += 1;
+
+  fp_ghost_slot_t slot = {.fp = entry->fp, .ring_pos = ring_pos};
+  _table_insert(ghost, slot, entry->hash_lo & (ghost->n_bucket - 1));
+}
+
+bool fp_ghost_contains(const fp_ghost_t *ghost, obj_id_t obj_id) {
+  uint32_t fp;
+  uint64_t bucket;
+  _hash_obj(ghost, obj_id, &fp, &bucket);
+  return _table_find(ghost, fp, bucket) != NULL;
+}
+
+bool fp_ghost_remove(fp_ghost_t *ghost, obj_id_t obj_id) {
+  return fp_ghost_remove_value(ghost, obj_id, NULL);
+}
+
+bool fp_ghost_remove_value(fp_ghost_t *ghost, obj_id_t obj_id,
+                           int64_t *value) {
+  uint32_t fp;
+  uint64_t bucket;
+  _hash_obj(ghost, obj_id, &fp, &bucket);
+  fp_ghost_slot_t *slot = _table_find(ghost, fp, bucket);
+  if (slot == NULL) return false;
+
+  fp_ghost_entry_t *entry = &ghost->ring[slot->ring_pos];
+  if (value != NULL) *value = entry->value;
+  ghost->occupied_byte -= entry->size;
+  ghost->n_entry -= 1;
+  entry->fp = 0;
+  slot->fp = 0;
+  return true;
+}
+
+bool fp_ghost_remove_oldest(fp_ghost_t *ghost) {
+  _skip_removed(ghost);
+  if (ghost->head == ghost->tail) return false;
+  _remove_oldest(ghost);
+  return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,127 @@
+//
+//  fingerprintGhost.h
+//  a compact ghost (history of evicted objects) that stores fingerprints
+//  instead of cache objects
+//
+//  the ghost is a FIFO of (fingerprint, size, value) entries bounded by the
+//  total size, and a cuckoo-filter-style table (two candidate buckets of four
+//  slots) for membership, an entry uses 24 bytes in the FIFO ring and two
+//  8-byte slots in the table instead of a cache_obj_t in a hashtable and a
+//  queue, the value is an optional payload, e.g., the eviction time
+//
+//  removed entries leave holes in the ring, the ring is compacted instead of
+//  grown when at least half of it are holes, if the table is too full to
+//  place an entry, the entry is dropped (counted in n_dropped) and becomes a
+//  false negative
+//
+//  two objects with the same fingerprint are not distinguishable, so a lookup
+//  can return a false positive with a probability close to false_positive_rate
+//
+//  libCacheSim
+//
+
+#ifndef libCacheSim_FINGERPRINTGHOST_H
+#define libCacheSim_FINGERPRINTGHOST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../include/config.h"
+
+typedef struct fp_ghost_entry {
+  int64_t value;
+  /* 0 means the entry has been removed */
+  uint32_t fp;
+  uint32_t size;
+  /* the low bits of the hash, used to find the bucket of the entry */
+  uint32_t hash_lo;
+} fp_ghost_entry_t;
+
+typedef struct fp_ghost_slot {
+  /* 0 means the slot is empty */
+  uint32_t fp;
+  /* the position of the entry in the FIFO ring */
+  uint32_t ring_pos;
+} fp_ghost_slot_t;
+
+typedef struct fp_ghost {
+  fp_ghost_entry_t *ring;
+  int64_t ring_cap;
+  /* sequence number of the oldest entry and the next entry */
+  int64_t head;
+  int64_t tail;
+
+  fp_ghost_slot_t *table;
+  int64_t n_bucket;
+  uint32_t fp_mask;
+
+  int64_t size_limit;
+  int64_t occupied_byte;
+  int64_t n_entry;
+  /* the number of entries dropped because the table is too full */
+  int64_t n_dropped;
+} fp_ghost_t;
+
+/**
+ * create a fingerprint ghost
+ *
+ * @param size_limit the max total size of the objects in the ghost
+ * @param false_positive_rate the target false positive rate of lookups,
+ *      it decides the number of fingerprint bits (at most 32)
+ */
+fp_ghost_t *fp_ghost_new(int64_t size_limit, double false_positive_rate);
+
+void fp_ghost_free(fp_ghost_t *ghost);
+
+fp_ghost_t *fp_ghost_clone(const fp_ghost_t *ghost);
+
+/**
+ * add an evicted object to the ghost, the oldest entries are removed
+ * until the object fits, objects larger than the ghost are not added
+ */
+void fp_ghost_insert(fp_ghost_t *ghost, obj_id_t obj_id, int64_t obj_size);
+
+/**
+ * same as fp_ghost_insert, and the value is returned when the object is
+ * removed using fp_ghost_remove_value
+ */
+void fp_ghost_insert_value(fp_ghost_t *ghost, obj_id_t obj_id,
+                           int64_t obj_size, int64_t value);
+
+/**
+ * check whether the object is (probably) in the ghost
+ */
+bool fp_ghost_contains(const fp_ghost_t *ghost, obj_id_t obj_id);
+
+/**
+ * remove the object from the ghost
+ *
+ * @return true if the object was (probably) in the ghost
+ */
+bool fp_ghost_remove(fp_ghost_t *ghost, obj_id_t obj_id);
+
+/**
+ * remove the object from the ghost and get the value it was inserted with
+ *
+ * @param value not changed if the object is not in the ghost, can be NULL
+ * @return true if the object was (probably) in the ghost
+ */
+bool fp_ghost_remove_value(fp_ghost_t *ghost, obj_id_t obj_id,
+                           int64_t *value);
+
+/**
+ * remove the oldest entry, e.g., when the ghost is bounded by the caller
+ *
+ * @return false if the ghost is empty
+ */
+bool fp_ghost_remove_oldest(fp_ghost_t *ghost);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // libCacheSim_FINGERPRINTGHOST_H
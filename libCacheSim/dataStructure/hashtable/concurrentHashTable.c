@@ -0,0 +1,496 @@
+//
+// a lock-free hash table that can be shared by multiple threads,
+// each bucket is a lock-free linked list sorted by object id
+// (Michael, High Performance Dynamic Lock-Free Hash Tables and List-Based
+// Sets, SPAA 2002), the objects are linked by hash_next as in
+// chainedHashTableV2, and the lowest bit of hash_next marks an object that
+// has been deleted but may not have been unlinked yet
+//
+// deleted objects are freed with epoch-based reclamation, each thread using
+// the hash table takes a slot and announces the global epoch when it starts
+// an operation, an object unlinked in global epoch e is freed after the
+// global epoch reaches e + 2, which needs every thread using the hash table
+// to start another operation, so an object returned by the hash table stays
+// valid until the same thread calls the hash table again or calls
+// concurrent_hashtable_quiesce, a thread that holds a slot without calling
+// the hash table delays freeing the deleted objects
+//
+// the number of buckets is fixed when the hash table is created,
+// the hash table does not expand or shrink,
+// objects inserted with insert_obj must be 8-byte aligned
+//
+// concurrentHashTable.c
+// libCacheSim
+//
+
+#include "concurrentHashTable.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../include/libCacheSim/logging.h"
+#include "../../include/libCacheSim/macro.h"
+#include "../../utils/include/mymath.h"
+#include "../hash/hash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define N_RETIRE_LIST 3
+/* try to advance the global epoch after a thread retires this many objects */
+#define N_RETIRE_PER_ADVANCE 64
+#define N_TLS_SLOT_CACHE 4
+
+#define IS_MARKED(p) (((uintptr_t)(p)) & 1)
+#define MARK(p) ((cache_obj_t *)(((uintptr_t)(p)) | 1))
+#define UNMARK(p) ((cache_obj_t *)(((uintptr_t)(p)) & ~(uintptr_t)1))
+
+_Static_assert(offsetof(cache_obj_t, hash_next) == 0,
+               "hash_next must be the first field of cache_obj_t");
+
+typedef struct {
+  cache_obj_t **objs;
+  int64_t n_obj;
+  int64_t n_allocated;
+  uint64_t epoch; /* the global epoch when the objects were unlinked */
+} retire_list_t;
+
+typedef struct {
+  uint64_t owner; /* the thread using the slot, 0 if the slot is free */
+  uint64_t epoch; /* the epoch announced by the thread, 0 if quiescent */
+  retire_list_t retired[N_RETIRE_LIST];
+  int64_t n_retired_since_advance;
+} __attribute__((aligned(64))) thread_slot_t;
+
+typedef struct {
+  uint64_t global_epoch;
+  uint64_t id; /* used to find the slot of a thread in tls_slot_cache */
+  thread_slot_t slots[CONCURRENT_HASHTABLE_MAX_THREADS];
+} epoch_state_t;
+
+static uint64_t n_thread_token = 0;
+static uint64_t n_hashtable_id = 0;
+static __thread uint64_t tls_thread_token = 0;
+static __thread struct {
+  uint64_t hashtable_id;
+  thread_slot_t *slot;
+} tls_slot_cache[N_TLS_SLOT_CACHE];
+static __thread int tls_slot_cache_pos = 0;
+
+/************************ helper func ************************/
+/* hash_next is the first field of cache_obj_t (see the static assert) and
+ * the objects are allocated by malloc, so it is aligned for atomic operations
+ * although cache_obj_t is packed */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Waddress-of-packed-member"
+static inline cache_obj_t **_next_ptr(cache_obj_t *obj) {
+  return &obj->hash_next;
+}
+#pragma GCC diagnostic pop
+
+static inline cache_obj_t **_bucket(const hashtable_t *hashtable,
+                                    const obj_id_t obj_id) {
+  uint64_t hv = get_hash_value_int_64(&obj_id) & hashmask(hashtable->hashpower);
+  return &hashtable->ptr_table[hv];
+}
+
+static void _free_retire_list(const hashtable_t *hashtable,
+                              retire_list_t *list) {
+  if (!hashtable->external_obj) {
+    for (int64_t i = 0; i < list->n_obj; i++) {
+      free_cache_obj(list->objs[i]);
+    }
+  }
+  list->n_obj = 0;
+}
+
+/**
+ * @brief find the slot of the calling thread, take a free slot if the
+ * thread does not have one
+ */
+static thread_slot_t *_get_slot(epoch_state_t *state) {
+  for (int i = 0; i < N_TLS_SLOT_CACHE; i++) {
+    if (tls_slot_cache[i].hashtable_id == state->id) {
+      return tls_slot_cache[i].slot;
+    }
+  }
+
+  if (tls_thread_token == 0) {
+    tls_thread_token = __atomic_add_fetch(&n_thread_token, 1, __ATOMIC_RELAXED);
+  }
+
+  thread_slot_t *slot = NULL;
+  for (int i = 0; i < CONCURRENT_HASHTABLE_MAX_THREADS; i++) {
+    if (__atomic_load_n(&state->slots[i].owner, __ATOMIC_ACQUIRE) ==
+        tls_thread_token) {
+      slot = &state->slots[i];
+      break;
+    }
+  }
+  for (int i = 0; slot == NULL && i < CONCURRENT_HASHTABLE_MAX_THREADS; i++) {
+    uint64_t expected = 0;
+    if (__atomic_compare_exchange_n(&state->slots[i].owner, &expected,
+                                    tls_thread_token, false, __ATOMIC_ACQ_REL,
+                                    __ATOMIC_RELAXED)) {
+      slot = &state->slots[i];
+    }
+  }
+  if (slot == NULL) {
+    ERROR("more than %d threads use the concurrent hash table\n",
+          CONCURRENT_HASHTABLE_MAX_THREADS);
+  }
+
+  tls_slot_cache[tls_slot_cache_pos].hashtable_id = state->id;
+  tls_slot_cache[tls_slot_cache_pos].slot = slot;
+  tls_slot_cache_pos = (tls_slot_cache_pos + 1) % N_TLS_SLOT_CACHE;
+
+  return slot;
+}
+
+/**
+ * @brief start an operation, announce the global epoch, and free the objects
+ * that no thread can reference
+ */
+static inline thread_slot_t *_enter(const hashtable_t *hashtable) {
+  epoch_state_t *state = (epoch_state_t *)hashtable->extra_data;
+  thread_slot_t *slot = _get_slot(state);
+
+  uint64_t epoch = __atomic_load_n(&state->global_epoch, __ATOMIC_SEQ_CST);
+  if (slot->epoch != epoch) {
+    __atomic_store_n(&slot->epoch, epoch, __ATOMIC_SEQ_CST);
+    for (int i = 0; i < N_RETIRE_LIST; i++) {
+      if (slot->retired[i].n_obj > 0 && slot->retired[i].epoch + 2 <= epoch) {
+        _free_retire_list(hashtable, &slot->retired[i]);
+      }
+    }
+  }
+
+  return slot;
+}
+
+/**
+ * @brief advance the global epoch if all threads in an operation have
+ * announced the current epoch
+ */
+static void _try_advance(epoch_state_t *state) {
+  uint64_t epoch = __atomic_load_n(&state->global_epoch, __ATOMIC_SEQ_CST);
+  for (int i = 0; i < CONCURRENT_HASHTABLE_MAX_THREADS; i++) {
+    if (__atomic_load_n(&state->slots[i].owner, __ATOMIC_ACQUIRE) == 0) {
+      continue;
+    }
+    uint64_t slot_epoch =
+        __atomic_load_n(&state->slots[i].epoch, __ATOMIC_SEQ_CST);
+    if (slot_epoch != 0 && slot_epoch != epoch) return;
+  }
+
+  __atomic_compare_exchange_n(&state->global_epoch, &epoch, epoch + 1, false,
+                              __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief free an unlinked object once no thread can reference it
+ */
+static void _retire(const hashtable_t *hashtable, thread_slot_t *slot,
+                    cache_obj_t *cache_obj) {
+  if (hashtable->external_obj) return;
+
+  epoch_state_t *state = (epoch_state_t *)hashtable->extra_data;
+  uint64_t epoch = __atomic_load_n(&state->global_epoch, __ATOMIC_SEQ_CST);
+  retire_list_t *list = &slot->retired[epoch % N_RETIRE_LIST];
+  if (list->epoch != epoch) {
+    /* the objects were retired at least N_RETIRE_LIST epochs ago */
+    _free_retire_list(hashtable, list);
+    list->epoch = epoch;
+  }
+  if (list->n_obj == list->n_allocated) {
+    list->n_allocated = list->n_allocated == 0 ? 64 : list->n_allocated * 2;
+    list->objs =
+        realloc(list->objs, sizeof(cache_obj_t *) * list->n_allocated);
+  }
+  list->objs[list->n_obj++] = cache_obj;
+
+  if (++slot->n_retired_since_advance >= N_RETIRE_PER_ADVANCE) {
+    slot->n_retired_since_advance = 0;
+    _try_advance(state);
+  }
+}
+
+/**
+ * @brief find the first object in the bucket whose id is not smaller than
+ * obj_id, the deleted objects on the way are unlinked
+ *
+ * @param prev_p the pointer that points to the object
+ * @param cur_p the object, NULL if all objects have smaller ids
+ * @param next_p the object after it
+ * @return whether the object has obj_id
+ */
+static bool _search(const hashtable_t *hashtable, thread_slot_t *slot,
+                    cache_obj_t **head, const obj_id_t obj_id,
+                    cache_obj_t ***prev_p, cache_obj_t **cur_p,
+                    cache_obj_t **next_p) {
+try_again:;
+  cache_obj_t **prev = head;
+  cache_obj_t *cur = __atomic_load_n(prev, __ATOMIC_ACQUIRE);
+  while (true) {
+    if (cur == NULL) {
+      *prev_p = prev;
+      *cur_p = NULL;
+      *next_p = NULL;
+      return false;
+    }
+
+    cache_obj_t *next = __atomic_load_n(_next_ptr(cur), __ATOMIC_ACQUIRE);
+    if (IS_MARKED(next)) {
+      cache_obj_t *expected = cur;
+      if (!__atomic_compare_exchange_n(prev, &expected, UNMARK(next), false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        goto try_again;
+      }
+      _retire(hashtable, slot, cur);
+      cur = UNMARK(next);
+    } else {
+      obj_id_t cur_obj_id = cur->obj_id;
+      /* prev is changed or marked */
+      if (__atomic_load_n(prev, __ATOMIC_ACQUIRE) != cur) goto try_again;
+
+      if (cur_obj_id >= obj_id) {
+        *prev_p = prev;
+        *cur_p = cur;
+        *next_p = next;
+        return cur_obj_id == obj_id;
+      }
+      prev = _next_ptr(cur);
+      cur = next;
+    }
+  }
+}
+
+static cache_obj_t *_insert(hashtable_t *hashtable, cache_obj_t *cache_obj) {
+  thread_slot_t *slot = _enter(hashtable);
+  cache_obj_t **head = _bucket(hashtable, cache_obj->obj_id);
+  cache_obj_t **prev, *cur, *next;
+
+  while (true) {
+    if (_search(hashtable, slot, head, cache_obj->obj_id, &prev, &cur, &next)) {
+      return cur;
+    }
+
+    __atomic_store_n(_next_ptr(cache_obj), cur, __ATOMIC_RELAXED);
+    cache_obj_t *expected = cur;
+    if (__atomic_compare_exchange_n(prev, &expected, cache_obj, false,
+                                    __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+      __atomic_add_fetch(&hashtable->n_obj, 1, __ATOMIC_RELAXED);
+      return cache_obj;
+    }
+  }
+}
+
+/**
+ * @brief delete the object with obj_id, if cache_obj is not NULL,
+ * delete only if the object in the hash table is cache_obj
+ */
+static bool _delete(hashtable_t *hashtable, const obj_id_t obj_id,
+                    const cache_obj_t *cache_obj) {
+  thread_slot_t *slot = _enter(hashtable);
+  cache_obj_t **head = _bucket(hashtable, obj_id);
+  cache_obj_t **prev, *cur, *next;
+
+  while (true) {
+    if (!_search(hashtable, slot, head, obj_id, &prev, &cur, &next)) {
+      return false;
+    }
+    if (cache_obj != NULL && cur != cache_obj) return false;
+
+    /* mark the object as deleted, after this, no object is inserted after it
+     * and it cannot be deleted by other threads */
+    cache_obj_t *expected = next;
+    if (!__atomic_compare_exchange_n(_next_ptr(cur), &expected, MARK(next),
+                                     false, __ATOMIC_ACQ_REL,
+                                     __ATOMIC_RELAXED)) {
+      continue;
+    }
+    __atomic_sub_fetch(&hashtable->n_obj, 1, __ATOMIC_RELAXED);
+
+    expected = cur;
+    if (__atomic_compare_exchange_n(prev, &expected, next, false,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+      _retire(hashtable, slot, cur);
+    } else {
+      /* another thread changed prev, search unlinks the object */
+      _search(hashtable, slot, head, obj_id, &prev, &cur, &next);
+    }
+    return true;
+  }
+}
+
+/************************ hashtable func ************************/
+hashtable_t *create_concurrent_hashtable(const uint16_t hashpower) {
+  hashtable_t *hashtable = my_malloc(hashtable_t);
+  memset(hashtable, 0, sizeof(hashtable_t));
+
+  hashtable->ptr_table = my_malloc_n(cache_obj_t *, hashsize(hashpower));
+  if (hashtable->ptr_table == NULL) {
+    ERROR("allocate hash table %zu entry * %lu B = %ld MiB failed\n",
+          sizeof(cache_obj_t *), (unsigned long)(hashsize(hashpower)),
+          (long)(sizeof(cache_obj_t *) * hashsize(hashpower) / 1024 / 1024));
+  }
+  memset(hashtable->ptr_table, 0, sizeof(cache_obj_t *) * hashsize(hashpower));
+  hashtable->external_obj = false;
+  hashtable->hashpower = hashpower;
+  hashtable->n_obj = 0;
+
+  epoch_state_t *state = aligned_alloc(64, sizeof(epoch_state_t));
+  memset(state, 0, sizeof(epoch_state_t));
+  state->global_epoch = 1;
+  state->id = __atomic_add_fetch(&n_hashtable_id, 1, __ATOMIC_RELAXED);
+  hashtable->extra_data = state;
+
+  return hashtable;
+}
+
+cache_obj_t *concurrent_hashtable_find_obj_id(const hashtable_t *hashtable,
+                                              const obj_id_t obj_id) {
+  thread_slot_t *slot = _enter(hashtable);
+  cache_obj_t **prev, *cur, *next;
+  if (_search(hashtable, slot, _bucket(hashtable, obj_id), obj_id, &prev, &cur,
+              &next)) {
+    return cur;
+  }
+  return NULL;
+}
+
+cache_obj_t *concurrent_hashtable_find(const hashtable_t *hashtable,
+                                       const request_t *req) {
+  return concurrent_hashtable_find_obj_id(hashtable, req->obj_id);
+}
+
+cache_obj_t *concurrent_hashtable_find_obj(const hashtable_t *hashtable,
+                                           const cache_obj_t *cache_obj) {
+  return concurrent_hashtable_find_obj_id(hashtable, cache_obj->obj_id);
+}
+
+cache_obj_t *concurrent_hashtable_insert(hashtable_t *hashtable,
+                                         const request_t *req) {
+  cache_obj_t *new_cache_obj = create_cache_obj_from_request(req);
+  cache_obj_t *cache_obj = _insert(hashtable, new_cache_obj);
+  if (cache_obj != new_cache_obj) {
+    /* another thread has inserted the object */
+    free_cache_obj(new_cache_obj);
+  }
+  return cache_obj;
+}
+
+cache_obj_t *concurrent_hashtable_insert_obj(hashtable_t *hashtable,
+                                             cache_obj_t *cache_obj) {
+  DEBUG_ASSERT(hashtable->external_obj);
+  return _insert(hashtable, cache_obj);
+}
+
+bool concurrent_hashtable_try_delete(hashtable_t *hashtable,
+                                     cache_obj_t *cache_obj) {
+  return _delete(hashtable, cache_obj->obj_id, cache_obj);
+}
+
+void concurrent_hashtable_delete(hashtable_t *hashtable,
+                                 cache_obj_t *cache_obj) {
+  bool deleted = _delete(hashtable, cache_obj->obj_id, cache_obj);
+  // the object to remove is not in the hash table
+  DEBUG_ASSERT(deleted);
+  (void)deleted;
+}
+
+bool concurrent_hashtable_delete_obj_id(hashtable_t *hashtable,
+                                        const obj_id_t obj_id) {
+  return _delete(hashtable, obj_id, NULL);
+}
+
+/**
+ * @brief a random object, it starts from a random bucket and returns a random
+ * object in the first non-empty bucket, NULL if the hash table is empty
+ */
+cache_obj_t *concurrent_hashtable_rand_obj(hashtable_t *hashtable) {
+  _enter(hashtable);
+  uint64_t n_bucket = hashsize(hashtable->hashpower);
+  uint64_t pos = next_rand() & hashmask(hashtable->hashpower);
+
+  for (uint64_t i = 0; i < n_bucket; i++) {
+    cache_obj_t **head = &hashtable->ptr_table[(pos + i) & (n_bucket - 1)];
+    int n_obj_in_bucket = 0;
+    cache_obj_t *cur = __atomic_load_n(head, __ATOMIC_ACQUIRE);
+    while (cur != NULL) {
+      cache_obj_t *next = __atomic_load_n(_next_ptr(cur), __ATOMIC_ACQUIRE);
+      if (!IS_MARKED(next)) n_obj_in_bucket += 1;
+      cur = UNMARK(next);
+    }
+    if (n_obj_in_bucket == 0) continue;
+
+    int rand_pos = next_rand() % n_obj_in_bucket;
+    cur = __atomic_load_n(head, __ATOMIC_ACQUIRE);
+    while (cur != NULL) {
+      cache_obj_t *next = __atomic_load_n(_next_ptr(cur), __ATOMIC_ACQUIRE);
+      if (!IS_MARKED(next) && rand_pos-- == 0) return cur;
+      cur = UNMARK(next);
+    }
+  }
+
+  return NULL;
+}
+
+void concurrent_hashtable_foreach(hashtable_t *hashtable,
+                                  hashtable_iter iter_func, void *user_data) {
+  _enter(hashtable);
+  for (uint64_t i = 0; i < hashsize(hashtable->hashpower); i++) {
+    cache_obj_t *cur = __atomic_load_n(&hashtable->ptr_table[i],
+                                       __ATOMIC_ACQUIRE);
+    while (cur != NULL) {
+      cache_obj_t *next = __atomic_load_n(_next_ptr(cur), __ATOMIC_ACQUIRE);
+      if (!IS_MARKED(next)) iter_func(cur, user_data);
+      cur = UNMARK(next);
+    }
+  }
+}
+
+void concurrent_hashtable_quiesce(hashtable_t *hashtable) {
+  epoch_state_t *state = (epoch_state_t *)hashtable->extra_data;
+  for (int i = 0; i < N_TLS_SLOT_CACHE; i++) {
+    if (tls_slot_cache[i].hashtable_id == state->id) {
+      thread_slot_t *slot = tls_slot_cache[i].slot;
+      tls_slot_cache[i].hashtable_id = 0;
+      tls_slot_cache[i].slot = NULL;
+      /* the retired objects stay with the slot for the next thread */
+      __atomic_store_n(&slot->epoch, 0, __ATOMIC_SEQ_CST);
+      __atomic_store_n(&slot->owner, 0, __ATOMIC_RELEASE);
+    }
+  }
+}
+
+void free_concurrent_hashtable(hashtable_t *hashtable) {
+  epoch_state_t *state = (epoch_state_t *)hashtable->extra_data;
+  concurrent_hashtable_quiesce(hashtable);
+
+  for (uint64_t i = 0; i < hashsize(hashtable->hashpower); i++) {
+    cache_obj_t *cur = hashtable->ptr_table[i];
+    while (cur != NULL) {
+      cache_obj_t *next = UNMARK(*_next_ptr(cur));
+      if (!hashtable->external_obj) free_cache_obj(cur);
+      cur = next;
+    }
+  }
+
+  for (int i = 0; i < CONCURRENT_HASHTABLE_MAX_THREADS; i++) {
+    for (int j = 0; j < N_RETIRE_LIST; j++) {
+      _free_retire_list(hashtable, &state->slots[i].retired[j]);
+      free(state->slots[i].retired[j].objs);
+    }
+  }
+  free(state);
+  my_free(sizeof(cache_obj_t *) * hashsize(hashtable->hashpower),
+          hashtable->ptr_table);
+  my_free(sizeof(hashtable_t), hashtable);
+}
+
+#ifdef __cplusplus
+}
+#endif
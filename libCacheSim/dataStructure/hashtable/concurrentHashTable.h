@@ -0,0 +1,71 @@
+//
+// a lock-free hash table that can be shared by multiple threads,
+// see concurrentHashTable.c
+//
+// the eviction algorithms and concurrentCache do not use it (each stripe of
+// concurrentCache is a single-threaded cache behind a lock), it is used
+// directly by library users or through HASHTABLE_TYPE=CONCURRENT_HASHTABLE,
+// and it does not expand, so choose the hashpower for the largest cache
+//
+
+#ifndef libCacheSim_CONCURRENTHASHTABLE_H
+#define libCacheSim_CONCURRENTHASHTABLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <assert.h>
+#include <stdbool.h>
+
+#include "../../include/libCacheSim/cacheObj.h"
+#include "../../include/libCacheSim/request.h"
+#include "hashtableStruct.h"
+
+/* the max number of threads that use one hash table at the same time */
+#define CONCURRENT_HASHTABLE_MAX_THREADS 128
+
+hashtable_t *create_concurrent_hashtable(const uint16_t hashpower);
+
+cache_obj_t *concurrent_hashtable_find_obj_id(const hashtable_t *hashtable,
+                                              const obj_id_t obj_id);
+
+cache_obj_t *concurrent_hashtable_find(const hashtable_t *hashtable,
+                                       const request_t *req);
+
+cache_obj_t *concurrent_hashtable_find_obj(const hashtable_t *hashtable,
+                                           const cache_obj_t *cache_obj);
+
+/* return the new object, or the object already in the hash table if another
+ * thread inserted the same object id first */
+cache_obj_t *concurrent_hashtable_insert(hashtable_t *hashtable,
+                                         const request_t *req);
+
+cache_obj_t *concurrent_hashtable_insert_obj(hashtable_t *hashtable,
+                                             cache_obj_t *cache_obj);
+
+bool concurrent_hashtable_try_delete(hashtable_t *hashtable,
+                                     cache_obj_t *cache_obj);
+
+void concurrent_hashtable_delete(hashtable_t *hashtable,
+                                 cache_obj_t *cache_obj);
+
+bool concurrent_hashtable_delete_obj_id(hashtable_t *hashtable,
+                                        const obj_id_t obj_id);
+
+cache_obj_t *concurrent_hashtable_rand_obj(hashtable_t *hashtable);
+
+void concurrent_hashtable_foreach(hashtable_t *hashtable,
+                                  hashtable_iter iter_func, void *user_data);
+
+/* the calling thread stops using the hash table, objects it got from the
+ * hash table may be freed after this */
+void concurrent_hashtable_quiesce(hashtable_t *hashtable);
+
+void free_concurrent_hashtable(hashtable_t *hashtable);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // libCacheSim_CONCURRENTHASHTABLE_H
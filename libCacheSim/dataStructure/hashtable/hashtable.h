@@ -62,7 +62,33 @@ extern "C" {
 #define hashtable_add_ptr_to_monitoring(hashtable, ptr)
 #define HASHTABLE_VER 2
 
-#elif HASHTABLE_TYPE == CUCKCOO_HASHTABLE
+#elif HASHTABLE_TYPE == CONCURRENT_HASHTABLE
+#include "concurrentHashTable.h"
+#define create_hashtable(hashpower) create_concurrent_hashtable(hashpower)
+#define hashtable_find(hashtable, req) concurrent_hashtable_find(hashtable, req)
+#define hashtable_find_obj_id(hashtable, obj_id) \
+  concurrent_hashtable_find_obj_id(hashtable, obj_id)
+#define hashtable_find_obj(hashtable, cache_obj) \
+  concurrent_hashtable_find_obj(hashtable, cache_obj)
+#define hashtable_insert(hashtable, req) \
+  concurrent_hashtable_insert(hashtable, req)
+#define hashtable_insert_obj(hashtable, cache_obj) \
+  concurrent_hashtable_insert_obj(hashtable, cache_obj)
+#define hashtable_delete(hashtable, cache_obj) \
+  concurrent_hashtable_delete(hashtable, cache_obj)
+#define hashtable_try_delete(hashtable, cache_obj) \
+  concurrent_hashtable_try_delete(hashtable, cache_obj)
+#define hashtable_delete_obj_id(hashtable, obj_id) \
+  concurrent_hashtable_delete_obj_id(hashtable, obj_id)
+#define hashtable_rand_obj(hashtable) concurrent_hashtable_rand_obj(hashtable)
+#define hashtable_foreach(hashtable, iter_func, user_data) \
+  concurrent_hashtable_foreach(hashtable, iter_func, user_data)
+
+#define free_hashtable(hashtable) free_concurrent_hashtable(hashtable)
+#define hashtable_add_ptr_to_monitoring(hashtable, ptr)
+#define HASHTABLE_VER 3
+
+#elif HASHTABLE_TYPE == CUCKOO_HASHTABLE
 #include "cuckooHashTable.h"
 #error not implemented
 #else
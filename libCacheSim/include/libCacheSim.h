@@ -14,6 +14,7 @@
 #include "libCacheSim/macro.h"
 #include "libCacheSim/reader.h"
 #include "libCacheSim/request.h"
+#include "libCacheSim/requestSink.h"
 #include "libCacheSim/sampling.h"
 
 /* admission */
@@ -29,5 +30,6 @@
 #include "libCacheSim/plugin.h"
 #include "libCacheSim/profilerLRU.h"
 #include "libCacheSim/simulator.h"
+#include "libCacheSim/timingModel.h"
 
 #endif  // libCacheSim_H
@@ -66,6 +66,11 @@ typedef int64_t (*cache_get_n_obj_func_ptr)(const cache_t *);
 
 typedef void (*cache_print_cache_func_ptr)(const cache_t *);
 
+typedef void (*cache_copy_state_func_ptr)(cache_t *, const cache_t *);
+
+typedef void (*cache_evict_hook_func_ptr)(cache_t *, const cache_obj_t *obj,
+                                          void *data);
+
 // #define EVICTION_AGE_ARRAY_SZE 40
 #define EVICTION_AGE_ARRAY_SZE 320
 #define EVICTION_AGE_LOG_BASE 1.08
@@ -107,11 +112,23 @@ struct cache {
   cache_get_occupied_byte_func_ptr get_occupied_byte;
   cache_get_n_obj_func_ptr get_n_obj;
   cache_print_cache_func_ptr print_cache;
+  /* copy the objects and the eviction state from the second cache to the
+   * first (an empty cache), NULL if the algorithm does not support fork */
+  cache_copy_state_func_ptr copy_state;
+  /* get without function pointer dispatch inside, NULL if the algorithm does
+   * not have one, use cache_get_func to choose between get and this */
+  cache_get_func_ptr get_specialized;
 
   admissioner_t *admissioner;
 
   prefetcher_t *prefetcher;
 
+  /* called by cache_evict_base with each evicted object before it is freed,
+   * including the objects an algorithm evicts inside insert, used by a
+   * cache built from other caches (e.g., tiered), NULL by default */
+  cache_evict_hook_func_ptr evict_hook;
+  void *evict_hook_data;
+
   void *eviction_params;
 
   // other name: logical_time, virtual_time, reference_count
@@ -154,9 +171,12 @@ struct cache {
   bool track_demotion;
 #endif
 
-  /* not used by most algorithms */
-  int32_t *future_stack_dist;
-  int64_t future_stack_dist_array_size;
+  /* the number of requests till the next access of each request in the
+   * trace (-1 means no more access), it gives the Belady family the next
+   * access time on traces without it, shared by the clones and not owned
+   * by the cache, see load_next_access_dist, not used by most algorithms */
+  int32_t *next_access_dist;
+  int64_t next_access_dist_array_size;
 
   int64_t log_eviction_age_cnt[EVICTION_AGE_ARRAY_SZE];
 };
@@ -193,6 +213,36 @@ void cache_struct_free(cache_t *cache);
  */
 cache_t *clone_cache(const cache_t *old_cache);
 
+/**
+ * @brief fork a warm cache, the new cache has the same objects and eviction
+ * state as the old cache, so that a warmup can be shared by the caches that
+ * differ only in parameters, it returns NULL if the algorithm does not
+ * implement copy_state
+ *
+ * note that the new cache must have the same layout as the old cache, e.g.,
+ * the same queue sizes, the admissioner is cloned without its state
+ *
+ * @param old_cache
+ * @param cache_specific_params the parameters of the new cache,
+ *        NULL means the same parameters as the old cache
+ * @return cache_t*
+ */
+cache_t *fork_cache(const cache_t *old_cache,
+                    const char *cache_specific_params);
+
+/**
+ * @brief copy a queue of objects to an empty cache, the objects keep the
+ * order and the metadata, this is used by copy_state of queue-based
+ * algorithms
+ *
+ * @param cache the new cache
+ * @param src_q_tail the tail of the queue in the old cache
+ * @param q_head the head of the queue in the new cache
+ * @param q_tail the tail of the queue in the new cache
+ */
+void cache_copy_queue_base(cache_t *cache, const cache_obj_t *src_q_tail,
+                           cache_obj_t **q_head, cache_obj_t **q_tail);
+
 /**
  * create a cache with new size
  * @param old_cache
@@ -202,6 +252,21 @@ cache_t *clone_cache(const cache_t *old_cache);
 cache_t *create_cache_with_new_size(const cache_t *old_cache,
                                     const uint64_t new_size);
 
+/**
+ * @brief create a thread-safe cache for replaying a trace with multiple
+ * threads, the cache is split into n_stripe stripes by object id, each
+ * stripe is a cache of the algorithm of old_cache with its own hashtable
+ * and lock, it supports the algorithms that have a specialized get
+ * (FIFO, LRU, Clock, Sieve and S3FIFO), the returned cache cannot be cloned
+ * or forked, and its n_req is not updated
+ *
+ * @param old_cache
+ * @param n_stripe the number of stripes, rounded up to a power of 2,
+ *        it is halved until each stripe has at least one byte
+ * @return cache_t*
+ */
+cache_t *create_concurrent_cache(const cache_t *old_cache, int n_stripe);
+
 /**
  * a function that finds object from the cache, it is used by
  * all eviction algorithms that directly use the hashtable
@@ -214,6 +279,20 @@ cache_t *create_cache_with_new_size(const cache_t *old_cache,
 cache_obj_t *cache_find_base(cache_t *cache, const request_t *req,
                              const bool update_cache);
 
+/**
+ * the second half of cache_find_base, it is used by eviction algorithms
+ * that look up the hashtable themselves, e.g., to skip the ghost entries
+ *
+ * @param cache
+ * @param req
+ * @param cache_obj the object found in the hashtable or NULL
+ * @param update_cache
+ * @return cache_obj or NULL if it is NULL or expired
+ */
+cache_obj_t *cache_find_obj_base(cache_t *cache, const request_t *req,
+                                 cache_obj_t *cache_obj,
+                                 const bool update_cache);
+
 /**
  * a common cache get function
  * @param cache
@@ -275,6 +354,21 @@ static inline int64_t cache_get_occupied_byte_default(const cache_t *cache) {
   return cache->occupied_byte;
 }
 
+/**
+ * @brief choose the get function for a request loop, the specialized get
+ * skips the admissioner and the prefetcher, so it is only used when the
+ * cache has neither
+ *
+ * @param cache
+ */
+static inline cache_get_func_ptr cache_get_func(const cache_t *cache) {
+  if (cache->get_specialized != NULL && cache->admissioner == NULL &&
+      cache->prefetcher == NULL) {
+    return cache->get_specialized;
+  }
+  return cache->get;
+}
+
 /**
  * @brief get the number of objects in the cache, this is the default
  * for most algorithms, but some algorithms may have different implementation
@@ -298,6 +392,22 @@ static inline int64_t cache_get_virtual_time(const cache_t *cache) {
   return cache->n_req;
 }
 
+/**
+ * @brief set the next access time of the idx-th (starting from 0) request
+ * of the trace from next_access_dist, the time starts from 1 as in the
+ * oracleGeneral traces, do nothing if the cache does not have the array
+ */
+static inline void cache_set_next_access_vtime(const cache_t *cache,
+                                               request_t *req, int64_t idx) {
+  if (cache->next_access_dist == NULL ||
+      idx >= cache->next_access_dist_array_size) {
+    return;
+  }
+
+  int32_t dist = cache->next_access_dist[idx];
+  req->next_access_vtime = dist == -1 ? MAX_REUSE_DISTANCE : idx + dist + 1;
+}
+
 /**
  * @brief print cache stat
  *
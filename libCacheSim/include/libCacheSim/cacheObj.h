@@ -17,8 +17,10 @@ extern "C" {
 #endif
 
 // ############## per object metadata used in eviction algorithm cache obj
+struct freq_node;
 typedef struct {
   int64_t freq;
+  struct freq_node *freq_node;  // the freq node the object is in
 } LFU_obj_metadata_t;
 
 typedef struct {
@@ -26,9 +28,18 @@ typedef struct {
 } Clock_obj_metadata_t;
 
 typedef struct {
-  void *pq_node;
+  int64_t heap_pos;  // position in the dheap
 } Size_obj_metadata_t;
 
+typedef struct {
+  int64_t slot_idx;  // index in the clock array
+} ClockArray_obj_metadata_t;
+
+typedef struct {
+  int64_t heap_pos;  // position in the dheap
+  int64_t freq;
+} Rank_obj_metadata_t;
+
 typedef struct {
   int lru_id;
   bool ghost;
@@ -37,10 +48,13 @@ typedef struct {
 typedef struct {
   void *lfu_next;
   void *lfu_prev;
-  int64_t eviction_vtime:40;
-  int64_t freq:23;
-  int64_t is_ghost:1;
-  int8_t evict_expert; // 1: LRU, 2: LFU
+  union {
+    struct freq_node *freq_node;  // the freq node of a cached object
+    int64_t eviction_vtime;       // the eviction time of a ghost object
+  };
+  /* share the byte of evict_expert so the metadata does not grow */
+  int8_t evict_expert : 7; // 1: LRU, 2: LFU
+  bool is_ghost : 1;
 } __attribute__((packed)) LeCaR_obj_metadata_t;
 
 typedef struct {
@@ -60,17 +74,27 @@ typedef struct {
 typedef struct {
   int64_t vtime_enter_cache:40;
   int64_t freq:24;
-  void *pq_node;
+  int64_t sample_idx;  // index in the candidate array
 } Hyperbolic_obj_metadata_t;
 
 typedef struct Belady_obj_metadata {
-  void *pq_node;
+  int64_t heap_pos;  // position in the dheap
   int64_t next_access_vtime;
 } Belady_obj_metadata_t;
 
 typedef struct {
-  bool is_LIR;
-  bool in_cache;
+  /* the links in queue Q (resident HIR objects) or in the non-resident
+   * list, an object is never in both, stack S uses queue.prev/next */
+  void *q_prev;
+  void *q_next;
+  /* increases from the bottom to the top of stack S, it tells whether a
+   * non-resident object in the fingerprint ghost is still in S */
+  int64_t s_seq : 40;
+  bool is_LIR : 1;
+  bool in_cache : 1;
+  bool in_s : 1;
+  bool in_q : 1;
+  bool in_nh : 1;
 } LIRS_obj_metadata_t;
 
 typedef struct FIFOMerge_obj_metadata {
@@ -102,8 +126,13 @@ typedef struct {
   int64_t last_access_vtime;
   int64_t insertion_time;
   int32_t oracle_idx;
+  int64_t sample_idx;  // index in the candidate array
 } Random_obj_metadata_t;
 
+typedef struct {
+  int64_t tag_idx;  // index in the LHD tag arrays
+} LHD_obj_metadata_t;
+
 typedef struct {
   int64_t last_access_vtime;
   int32_t freq;
@@ -121,12 +150,22 @@ typedef struct {
   int64_t insertion_time;   // measured in number of objects inserted
   int64_t freq;
   int32_t main_insert_freq;
+  int8_t queue_id;  // which queue the object is in, see compositeQueue.h
 } S3FIFO_obj_metadata_t;
 
+typedef struct {
+  int8_t queue_id;  // Ain, Am or Aout, see compositeQueue.h
+} TwoQ_obj_metadata_t;
+
 typedef struct {
   int32_t freq;
 } __attribute__((packed)) Sieve_obj_params_t;
 
+typedef struct {
+  int32_t region_seq;  // the write sequence number of the region it is in
+  int8_t rrpv;         // re-reference prediction value
+} __attribute__((packed)) flashRegion_obj_metadata_t;
+
 typedef struct {
   int64_t next_access_vtime;
   int32_t freq;
@@ -156,14 +195,17 @@ typedef struct cache_obj {
   union {
     LFU_obj_metadata_t lfu;          // for LFU
     Clock_obj_metadata_t clock;      // for Clock
+    ClockArray_obj_metadata_t clock_array;  // for ClockArray and SieveArray
     Size_obj_metadata_t Size;        // for Size
     ARC_obj_metadata_t ARC;          // for ARC
+    Rank_obj_metadata_t rank;        // for LFUCpp and GDSF
     LeCaR_obj_metadata_t LeCaR;      // for LeCaR
     Cacheus_obj_metadata_t Cacheus;  // for Cacheus
     SR_LRU_obj_metadata_t SR_LRU;
     CR_LFU_obj_metadata_t CR_LFU;
     Hyperbolic_obj_metadata_t hyperbolic;
     Random_obj_metadata_t Random;
+    LHD_obj_metadata_t LHD;
     Belady_obj_metadata_t Belady;
     FIFO_Merge_obj_metadata_t FIFO_Merge;
     FIFO_Reinsertion_obj_metadata_t FIFO_Reinsertion;
@@ -172,7 +214,9 @@ typedef struct cache_obj {
     QDLP_obj_metadata_t QDLP;
     LIRS_obj_metadata_t LIRS;
     S3FIFO_obj_metadata_t S3FIFO;
+    TwoQ_obj_metadata_t TwoQ;
     Sieve_obj_params_t sieve;
+    flashRegion_obj_metadata_t flashRegion;
 
 #if defined(ENABLE_GLCACHE) && ENABLE_GLCACHE == 1
     GLCache_obj_metadata_t GLCache;
@@ -17,6 +17,7 @@ typedef enum {
   DIST_SINCE_FIRST_ACCESS,
   STACK_DIST,
   FUTURE_STACK_DIST,
+  DIST_TILL_NEXT_ACCESS,
 } dist_type_e;
 
 static char *g_dist_type_name[] = {
@@ -24,6 +25,7 @@ static char *g_dist_type_name[] = {
     "DIST_SINCE_FIRST_ACCESS",
     "STACK_DIST",
     "FUTURE_STACK_DIST",
+    "DIST_TILL_NEXT_ACCESS",
 };
 
 /***********************************************************
@@ -39,10 +41,12 @@ int32_t *get_stack_dist(reader_t *reader, const dist_type_e dist_type,
                         int64_t *array_size);
 
 /***********************************************************
- * get the distance (the num of requests) since last/first access
+ * get the distance (the num of requests) since last/first access or till
+ * next access, -1 means no such access
 
  * @param reader
- * @param dist_type DIST_SINCE_LAST_ACCESS or DIST_SINCE_FIRST_ACCESS
+ * @param dist_type DIST_SINCE_LAST_ACCESS, DIST_SINCE_FIRST_ACCESS or
+ *                  DIST_TILL_NEXT_ACCESS
  *
  * @return an array of int32_t with size of n_req
  */
@@ -80,6 +84,33 @@ void save_dist_txt(reader_t *const reader, const int32_t *dist_array,
 int32_t *load_dist(reader_t *const reader, const char *const ifilepath,
                    int64_t *array_size);
 
+/***********************************************************
+ * set the directory where get_dist_cached stores the distance arrays,
+ * NULL (the default) disables the cache files
+ *
+ * @param cache_dir             the directory, it must exist
+ */
+void set_dist_cache_dir(const char *const cache_dir);
+
+/***********************************************************
+ * get the distance array, if a cache directory is given (or set with
+ * set_dist_cache_dir), the array is cached in a memory-mapped file keyed by
+ * the trace identity, the reader parameters and the distance type, so that
+ * repeated runs on the same trace do not recompute it
+ *
+ * @param reader                the reader for data
+ * @param dist_type             type of distance
+ * @param array_size            the size of the returned array
+ * @param cache_dir             directory of the cache file, NULL to use the
+ *                              directory set by set_dist_cache_dir
+ * @return                      read-only distance array, release it with
+ *                              release_dist_cached
+ */
+int32_t *get_dist_cached(reader_t *const reader, const dist_type_e dist_type,
+                         int64_t *array_size, const char *const cache_dir);
+
+void release_dist_cached(int32_t *dist_array, const int64_t array_size);
+
 void save_dist_as_cnt_txt(reader_t *const reader, const int32_t *dist_array,
                       const int64_t array_size, const char *const ofilepath,
                       const dist_type_e dist_type);
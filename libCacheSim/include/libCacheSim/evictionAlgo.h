@@ -23,6 +23,9 @@ typedef struct freq_node {
   cache_obj_t *first_obj;
   cache_obj_t *last_obj;
   uint32_t n_obj;
+  /* neighbor freq nodes in freq order, used by freqBucket.h */
+  struct freq_node *prev;
+  struct freq_node *next;
 } freq_node_t;
 
 typedef struct {
@@ -38,6 +41,89 @@ typedef struct {
   int64_t n_byte_rewritten;
 } Clock_params_t;
 
+/* used by flashRegion */
+typedef enum {
+  FLASH_REGION_EVICT_FIFO,
+  FLASH_REGION_EVICT_RRIP,
+} flash_region_evict_e;
+
+struct flash_region;
+typedef struct {
+  int64_t region_size;
+  int32_t n_region;
+  flash_region_evict_e region_evict;
+  int8_t max_rrpv;
+
+  struct flash_region *regions;
+  int32_t active_region;  // -1 if no region is open for writes
+  int32_t *free_regions;
+  int32_t n_free_region;
+  /* sealed regions in the order they are written, a ring buffer */
+  int32_t *sealed_regions;
+  int32_t sealed_head;
+  int32_t n_sealed_region;
+  int32_t next_region_seq;
+
+  /* objects admitted by the admission policy (or all misses) */
+  int64_t n_obj_admitted;
+  int64_t n_byte_admitted;
+  /* live objects written again when their region is evicted */
+  int64_t n_obj_reinserted;
+  int64_t n_byte_reinserted;
+  int64_t n_region_evicted;
+  /* the device writes whole regions, including the unused tail of a region,
+   * n_byte_device_write = n_region_written * region_size */
+  int64_t n_region_written;
+  int64_t n_byte_device_write;
+} flashRegion_params_t;
+
+/* used by tiered */
+#define TIERED_MAX_TIER 8
+
+typedef enum {
+  /* an object is written to the first tier, evicted objects are demoted to
+   * the next tier, a lower tier may keep a copy after promotion */
+  TIERED_NON_INCLUSIVE,
+  /* an object is written to all tiers, an object evicted from a lower tier
+   * is removed from the upper tiers */
+  TIERED_INCLUSIVE,
+  /* an object is in at most one tier, promotion moves the object */
+  TIERED_EXCLUSIVE,
+} tiered_inclusion_e;
+
+/* the objects evicted from a tier, collected by the eviction hook of the
+ * tier and demoted or invalidated after the tier returns */
+typedef struct {
+  obj_id_t *obj_id;
+  int64_t *obj_size;
+  int64_t n_obj;
+  int64_t capacity;
+} tiered_evicted_t;
+
+typedef struct {
+  cache_t *tiers[TIERED_MAX_TIER];
+  int n_tier;
+  tiered_inclusion_e inclusion;
+  bool promote;  // whether a hit in a lower tier writes the object to tier 0
+  double tier_size_ratio[TIERED_MAX_TIER];
+  /* the latency of looking up each tier, the last one is the backend */
+  int64_t latency[TIERED_MAX_TIER + 1];
+  char tier_names[TIERED_MAX_TIER][16];
+  /* the objects evicted from each tier */
+  tiered_evicted_t evicted[TIERED_MAX_TIER];
+  request_t *req_local[TIERED_MAX_TIER];
+
+  int64_t n_hit[TIERED_MAX_TIER];
+  int64_t n_miss;
+  /* writes into each tier, including promotions and demotions */
+  int64_t n_write[TIERED_MAX_TIER];
+  int64_t n_byte_write[TIERED_MAX_TIER];
+  int64_t n_promote[TIERED_MAX_TIER];  // promoted from the tier
+  int64_t n_demote[TIERED_MAX_TIER];   // demoted from the tier to the next
+  int64_t total_latency;
+  int32_t last_served_tier;  // n_tier if the last request was a miss
+} tiered_params_t;
+
 cache_t *ARC_init(const common_cache_params_t ccache_params, const char *cache_specific_params);
 
 cache_t *ARCv0_init(const common_cache_params_t ccache_params, const char *cache_specific_params);
@@ -50,6 +136,8 @@ cache_t *Cacheus_init(const common_cache_params_t ccache_params, const char *cac
 
 cache_t *Clock_init(const common_cache_params_t ccache_params, const char *cache_specific_params);
 
+cache_t *ClockArray_init(const common_cache_params_t ccache_params, const char *cache_specific_params);
+
 cache_t *CR_LFU_init(const common_cache_params_t ccache_params, const char *cache_specific_params);
 
 cache_t *FIFO_init(const common_cache_params_t ccache_params, const char *cache_specific_params);
@@ -100,6 +188,12 @@ cache_t *FIFO_Reinsertion_init(const common_cache_params_t ccache_params, const
 
 cache_t *flashProb_init(const common_cache_params_t ccache_params, const char *cache_specific_params);
 
+cache_t *flashRegion_init(const common_cache_params_t ccache_params, const char *cache_specific_params);
+
+cache_t *tiered_init(const common_cache_params_t ccache_params, const char *cache_specific_params);
+
+int tiered_served_tier(const cache_t *cache, const request_t *req, bool hit);
+
 cache_t *LRU_Prob_init(const common_cache_params_t ccache_params, const char *cache_specific_params);
 
 cache_t *SFIFOv0_init(const common_cache_params_t ccache_params, const char *cache_specific_params);
@@ -126,6 +220,8 @@ cache_t *FIFO_Belady_init(const common_cache_params_t ccache_params, const char
 
 cache_t *Sieve_init(const common_cache_params_t ccache_params, const char *cache_specific_params);
 
+cache_t *SieveArray_init(const common_cache_params_t ccache_params, const char *cache_specific_params);
+
 cache_t *RandomLRU_init(const common_cache_params_t ccache_params, const char *cache_specific_params);
 
 cache_t *ThreeLCache_init(const common_cache_params_t ccache_params, const char *cache_specific_params);
@@ -25,6 +25,20 @@ extern "C" {
 double *get_lru_obj_miss_ratio(reader_t *reader, gint64 size);
 double *get_lru_obj_miss_ratio_curve(reader_t *reader, gint64 size);
 
+/* estimate the LRU miss ratio curve (size 0 ~ n_points objects) from
+ * a bucketed reuse time histogram using the Average Eviction Time model,
+ * it is much faster than the exact profiler on long traces */
+double *get_lru_mrc_aet(reader_t *reader, gint64 n_points);
+
+/* estimate one AET miss ratio curve per window_sec of trace time in one pass,
+ * returns a row-major n_windows * (n_points + 1) matrix */
+double *get_lru_mrc_aet_windowed(reader_t *reader, gint64 n_points,
+                                 int64_t window_sec, gint64 *n_windows);
+
+/* save the windowed miss ratio curves as a binary matrix */
+void save_windowed_mrc(const char *ofilepath, const double *mrc,
+                       gint64 n_windows, gint64 n_points, int64_t window_sec);
+
 /* not possible because it requires huge array for storing reuse_hit_cnt
  * it is possible to implement this in O(NlogN) however, we need to modify splay
  * tree
@@ -0,0 +1,89 @@
+//
+//  requestSink.h
+//  libCacheSim
+//
+//  a request sink writes a stream of requests (e.g., the misses or the
+//  evictions of a cache) to a trace file, the requests are written to a
+//  large buffer and the buffer is written (and compressed) when it is full,
+//  so writing one request is a memcpy or a few integer conversions
+//
+//  supported formats: ORACLE_GENERAL_TRACE, LCS_TRACE (lcs v2, keeps the
+//  operation and tenant) and CSV_TRACE (clock_time,obj_id,obj_size per line,
+//  no header), the output is compressed with zstd if the path ends with .zst,
+//  the reader detects the compression the same way
+//
+
+#ifndef REQUEST_SINK_H
+#define REQUEST_SINK_H
+
+#include <stdio.h>
+
+#include "enum.h"
+#include "request.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define REQUEST_SINK_BUF_SIZE (4 * 1024 * 1024)
+
+typedef struct request_sink {
+  char *ofilepath;
+  trace_type_e format;
+  FILE *ofile;
+
+  char *buf;
+  size_t buf_pos;
+
+  bool compress;
+  void *zstd_cctx;
+  char *zstd_buf;
+  size_t zstd_buf_size;
+
+  int64_t n_req;
+  int64_t n_req_byte;
+  int64_t n_read;
+  int64_t n_write;
+  int64_t n_delete;
+  int64_t start_timestamp;
+  int64_t end_timestamp;
+  int64_t smallest_obj_size;
+  int64_t largest_obj_size;
+} request_sink_t;
+
+/**
+ * open a request sink, the file is truncated
+ * @param ofilepath compressed with zstd if it ends with .zst
+ * @param format ORACLE_GENERAL_TRACE, LCS_TRACE or CSV_TRACE
+ * @return
+ */
+request_sink_t *open_request_sink(const char *ofilepath, trace_type_e format);
+
+/**
+ * write one request to the sink, the next_access_vtime in the binary formats
+ * is -2 (unknown) because the requests in the sink are a subset of the trace,
+ * traceConv can compute it
+ *
+ * @param sink
+ * @param req
+ */
+void request_sink_write(request_sink_t *sink, const request_t *req);
+
+/**
+ * write the buffered requests to the file
+ * @param sink
+ */
+void request_sink_flush(request_sink_t *sink);
+
+/**
+ * flush and close the sink, the lcs header is updated with the number of
+ * requests, bytes and the time range if the file is not compressed
+ * @param sink
+ */
+void close_request_sink(request_sink_t *sink);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REQUEST_SINK_H */
@@ -47,6 +47,73 @@ cache_stat_t *simulate_at_multi_sizes(reader_t *reader,
                                       int num_of_threads, 
                                       bool use_random_seed);
 
+/**
+ * this function simulates a stack policy (LRU and Belady) at the given
+ * cache sizes in a single pass over the trace, the result is the same as
+ * simulate_at_multi_sizes, but the cost does not grow with num_of_sizes,
+ * other policies fall back to simulate_at_multi_sizes
+ * Belady takes O(N * K) time, K is the number of objects in the largest
+ * cache, and is exact only if all objects have the same size
+ * the returned cache_stat_t should be freed by the user
+ *
+ * @param reader
+ * @param cache
+ * @param num_of_sizes
+ * @param cache_sizes
+ * @param warmup_reader
+ * @param warmup_frac
+ * @param warmup_sec
+ * @param num_of_threads only used when falling back
+ * @param use_random_seed only used when falling back
+ * @return an array of cache_stat_t, each corresponds to one cache size
+ */
+cache_stat_t *simulate_stack_policy_all_sizes(reader_t *reader,
+                                              const cache_t *cache,
+                                              int num_of_sizes,
+                                              const uint64_t *cache_sizes,
+                                              reader_t *warmup_reader,
+                                              double warmup_frac,
+                                              int warmup_sec,
+                                              int num_of_threads,
+                                              bool use_random_seed);
+
+/**
+ * this function simulates Belady (MIN) with each object taking one slot at
+ * all the cache sizes (in number of objects), the next access of each request
+ * is computed from the trace, so the trace does not need next access
+ * information, the result is the same as Belady on a trace read with
+ * ignore_obj_size, each cache size is simulated by one thread
+ * the returned cache_stat_t should be freed by the user
+ *
+ * @param reader
+ * @param num_of_sizes
+ * @param cache_sizes
+ * @param num_of_threads
+ * @return an array of cache_stat_t, each corresponds to one cache size
+ */
+cache_stat_t *simulate_offline_belady(reader_t *reader,
+                                      int num_of_sizes,
+                                      const uint64_t *cache_sizes,
+                                      int num_of_threads);
+
+/**
+ * this function computes the PFOO-L lower bound of the miss ratio of any
+ * policy with variable object sizes at all the cache sizes (in bytes),
+ * n_miss bounds the number of misses and n_miss_byte bounds the missed bytes
+ * the returned cache_stat_t should be freed by the user
+ *
+ * @param reader
+ * @param num_of_sizes
+ * @param cache_sizes
+ * @param num_of_threads the two orders of reuse intervals are sorted in
+ *        parallel if larger than 1
+ * @return an array of cache_stat_t, each corresponds to one cache size
+ */
+cache_stat_t *get_pfoo_lower_bound(reader_t *reader,
+                                   int num_of_sizes,
+                                   const uint64_t *cache_sizes,
+                                   int num_of_threads);
+
 /**
  * this function performs cache_size/step_size simulations to obtain miss ratio,
  * the size of simulations are step_size, step_size*2 ... step_size*n,
@@ -99,6 +166,68 @@ cache_stat_t *simulate_with_multi_caches(reader_t *reader,
                                          bool free_cache_when_finish, 
                                          bool use_random_seed);
 
+/**
+ * this function warms up the cache once, then forks the warm cache
+ * (see fork_cache) to num_of_variants caches, each uses the parameters in
+ * variant_params, and simulates the rest of the trace in parallel,
+ * this avoids replaying a long warmup for each variant of a parameter sweep
+ * the returned cache_stat_t should be freed by the user
+ *
+ * @param reader
+ * @param cache a new cache, it is warmed up and still owned by the caller
+ * @param num_of_variants
+ * @param variant_params NULL or an array of cache_specific_params
+ * @param warmup_reader
+ * @param warmup_frac
+ * @param warmup_sec
+ * @param num_of_threads
+ * @return
+ */
+cache_stat_t *simulate_with_shared_warmup(reader_t *reader,
+                                          cache_t *cache,
+                                          int num_of_variants,
+                                          const char *variant_params[],
+                                          reader_t *warmup_reader,
+                                          double warmup_frac,
+                                          int warmup_sec,
+                                          int num_of_threads,
+                                          bool use_random_seed);
+
+/**
+ * this function replays the trace with num_of_clients threads against one
+ * thread-safe cache that has the algorithm, size and parameters of cache
+ * and n_stripe stripes (see create_concurrent_cache), the interleaving of
+ * the clients is not deterministic, so the result may differ between runs
+ * the returned cache_stat_t should be freed by the user
+ *
+ * @param reader
+ * @param cache not used for the simulation, still owned by the caller
+ * @param n_stripe
+ * @param num_of_clients
+ * @return
+ */
+cache_stat_t *simulate_with_concurrent_clients(reader_t *reader,
+                                               const cache_t *cache,
+                                               int n_stripe,
+                                               int num_of_clients);
+
+/**
+ * this function loads the distances till the next access for the caches that
+ * use the next access time (Belady, BeladySize, FIFO_Belady, LRU_Belady and
+ * Sieve_Belady) when the trace does not have it, the array is read from the
+ * dist cache file if a cache directory is set (see set_dist_cache_dir)
+ * the simulate functions call it, the returned array is shared by the caches
+ * and should be released using release_dist_cached
+ *
+ * @param reader
+ * @param caches
+ * @param num_of_caches
+ * @param array_size
+ * @return NULL if no cache needs it or the trace has the next access time
+ */
+int32_t *load_next_access_dist(reader_t *reader, cache_t *caches[],
+                               int num_of_caches, int64_t *array_size);
+
 #ifdef __cplusplus
 }
 #endif
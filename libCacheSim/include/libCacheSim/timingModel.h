@@ -0,0 +1,159 @@
+//
+//  timingModel.h
+//  libCacheSim
+//
+//  a discrete-event timing model of the requests, each cache tier and the
+//  backend is a FCFS queue with n_channel servers and a service time model,
+//  requests arrive at the trace timestamps, and the simulator reports the
+//  latency percentiles and the backend bandwidth over time
+//
+
+#ifndef timingModel_h
+#define timingModel_h
+
+#include "cache.h"
+#include "reader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TIMING_MAX_TIER 8
+
+/* the latency histogram records values in ns with
+ * 2^LATENCY_HIST_SUB_BUCKET_BITS buckets per power of two,
+ * so the relative error of a percentile is below 1% */
+#define LATENCY_HIST_SUB_BUCKET_BITS 7
+#define LATENCY_HIST_N_BUCKET \
+  ((64 - LATENCY_HIST_SUB_BUCKET_BITS) << LATENCY_HIST_SUB_BUCKET_BITS)
+
+typedef struct {
+  int64_t n;
+  int64_t min_ns;
+  int64_t max_ns;
+  double sum_ns;
+  int64_t cnt[LATENCY_HIST_N_BUCKET];
+} latency_hist_t;
+
+struct service_model;
+/* the time (us) a server spends on the request, not including queueing */
+typedef double (*service_time_func_ptr)(const struct service_model *model,
+                                        const request_t *req);
+
+typedef struct service_model {
+  service_time_func_ptr service_time;
+  double latency_us;      // fixed time of each request
+  double bandwidth_MBps;  // transfer rate (byte per us), 0 means unlimited
+  /* the number of requests served in parallel, 0 means no queueing */
+  int n_channel;
+  void *model_data;  // used by a user-defined service_time
+} service_model_t;
+
+typedef struct timing_model {
+  int n_tier;
+  service_model_t tier[TIMING_MAX_TIER];
+  service_model_t backend;
+  /* which tier served the request, n_tier for the backend, NULL means
+   * a hit is served by tier 0, e.g., tiered_served_tier for tiered */
+  int (*served_tier)(const cache_t *cache, const request_t *req, bool hit);
+  /* us per unit of the trace timestamp, e.g., 1000000 for second */
+  double ts_unit_us;
+  /* spread the requests with the same timestamp evenly over the unit,
+   * otherwise they arrive at the same time */
+  bool spread_arrival;
+  /* the window of the backend bandwidth timeline */
+  int64_t bw_window_us;
+} timing_model_t;
+
+typedef struct {
+  int64_t n_req;
+  int64_t n_req_byte;
+  int64_t n_miss;
+  int64_t n_miss_byte;
+  int n_tier;
+
+  /* end-to-end latency of all requests */
+  latency_hist_t latency;
+  /* latency of the requests served by each tier, the last one is the
+   * backend */
+  latency_hist_t tier_latency[TIMING_MAX_TIER + 1];
+  int64_t n_served[TIMING_MAX_TIER + 1];
+  double queueing_us[TIMING_MAX_TIER + 1];  // total time spent waiting
+  /* the end of the last request, the start is time 0 */
+  double end_us;
+
+  /* the bytes fetched from the backend in each bw_window_us window */
+  int64_t bw_window_us;
+  int64_t n_bw_window;
+  int64_t *backend_byte;
+
+  int64_t cache_size;
+  char cache_name[CACHE_NAME_ARRAY_LEN];
+} timing_stat_t;
+
+/**
+ * the service time is latency_us + obj_size / bandwidth_MBps
+ */
+double linear_service_time(const service_model_t *model, const request_t *req);
+
+static inline service_model_t linear_service_model(double latency_us,
+                                                   double bandwidth_MBps,
+                                                   int n_channel) {
+  service_model_t model;
+  memset(&model, 0, sizeof(service_model_t));
+  model.service_time = linear_service_time;
+  model.latency_us = latency_us;
+  model.bandwidth_MBps = bandwidth_MBps;
+  model.n_channel = n_channel;
+  return model;
+}
+
+/**
+ * a DRAM cache in front of a disk-like backend with 1-second timestamps
+ */
+timing_model_t default_timing_model(void);
+
+/**
+ * set the timing model from a string, e.g.,
+ * "tier-latency=1:100,tier-bw=10000:2000,tier-channel=0:64,
+ *  backend-latency=5000,backend-bw=200,backend-channel=16,
+ *  ts-unit=1000000,spread-arrival=true,bw-window=1000000",
+ * the per-tier values are separated by ':' and set n_tier
+ *
+ * @param model
+ * @param params
+ */
+void parse_timing_model_params(timing_model_t *model, const char *params);
+
+void latency_hist_record(latency_hist_t *hist, int64_t latency_ns);
+
+/**
+ * @param hist
+ * @param percentile in [0, 100], e.g., 99.9
+ * @return the latency in us
+ */
+double latency_hist_percentile(const latency_hist_t *hist, double percentile);
+
+/**
+ * replay the trace on the cache and time each request, a request looks up
+ * the tiers before the one serving it (each costs its latency_us without
+ * queueing), then waits for and is served by the serving tier or the backend,
+ * writing the missed object to the cache is not on the request path,
+ * the cache is not freed
+ * the returned timing_stat_t should be freed using free_timing_stat
+ *
+ * @param reader
+ * @param cache
+ * @param model
+ * @return
+ */
+timing_stat_t *simulate_with_timing(reader_t *reader, cache_t *cache,
+                                    const timing_model_t *model);
+
+void free_timing_stat(timing_stat_t *stat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* timingModel_h */
@@ -8,8 +8,12 @@ extern "C" {
 
 #include <assert.h>
 #include <math.h>
+#include <fcntl.h>
 #include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include "../dataStructure/splay.h"
 #include "../include/libCacheSim/dist.h"
@@ -44,7 +48,8 @@ int64_t get_access_dist_add_req(const request_t *req, GHashTable *hash_table,
     ret = curr_ts - old_ts;
   }
 
-  if (dist_type == DIST_SINCE_LAST_ACCESS) {
+  if (dist_type == DIST_SINCE_LAST_ACCESS ||
+      dist_type == DIST_TILL_NEXT_ACCESS) {
     /* update last access time */
     g_hash_table_insert(hash_table, GSIZE_TO_POINTER(req->obj_id),
                         GSIZE_TO_POINTER((gsize)curr_ts));
@@ -166,6 +171,11 @@ int32_t *get_access_dist(reader_t *reader, const dist_type_e dist_type,
   request_t *req = new_request();
   *array_size = get_num_of_req(reader);
   int32_t *dist_array = malloc(sizeof(int32_t) * get_num_of_req(reader));
+  if (dist_type == DIST_TILL_NEXT_ACCESS) {
+    for (int64_t i = 0; i < get_num_of_req(reader); i++) {
+      dist_array[i] = -1;
+    }
+  }
 
   GHashTable *hash_table =
       g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, NULL);
@@ -179,7 +189,12 @@ int32_t *get_access_dist(reader_t *reader, const dist_type_e dist_type,
       abort();
     }
 
-    dist_array[curr_ts] = dist;
+    if (dist_type == DIST_TILL_NEXT_ACCESS) {
+      /* the distance till the next access of the last access */
+      if (dist != -1) dist_array[curr_ts - dist] = dist;
+    } else {
+      dist_array[curr_ts] = dist;
+    }
     read_one_req(reader, req);
     curr_ts++;
   }
@@ -241,6 +256,224 @@ int32_t *load_dist(reader_t *const reader, const char *const ifilepath,
   return dist_array;
 }
 
+/* the distance array in the cache file starts at a page boundary */
+#define DIST_CACHE_HEADER_SIZE 4096
+#define DIST_CACHE_MAGIC "LCSDIST"
+#define DIST_CACHE_VERSION 2
+
+typedef struct {
+  char magic[8];
+  int32_t version;
+  int32_t dist_type;
+  int64_t n_req;
+  /* the identity of the trace, the cache is invalid if the trace changes */
+  int64_t trace_file_size;
+  int64_t trace_mtime;
+  int32_t trace_type;
+  int32_t block_size;
+  /* the reader parameters that change the request stream */
+  int64_t cap_at_n_req;
+  int64_t trace_start_offset;
+  uint64_t binary_fmt_hash;
+  int32_t time_field;
+  int32_t obj_id_field;
+  int32_t obj_size_field;
+  int32_t op_field;
+  int32_t ttl_field;
+  int32_t cnt_field;
+  int32_t tenant_field;
+  int32_t next_access_vtime_field;
+  bool obj_id_is_num;
+  bool ignore_obj_size;
+  bool ignore_size_zero_req;
+  bool has_header;
+  char delimiter;
+} dist_cache_header_t;
+
+/* NULL means not caching the distance arrays in files */
+static char *dist_cache_dir = NULL;
+
+void set_dist_cache_dir(const char *const cache_dir) {
+  free(dist_cache_dir);
+  dist_cache_dir = cache_dir == NULL ? NULL : strdup(cache_dir);
+}
+
+static void _fill_dist_cache_header(reader_t *const reader,
+                                    const dist_type_e dist_type,
+                                    dist_cache_header_t *header) {
+  struct stat st;
+  memset(header, 0, sizeof(dist_cache_header_t));
+  memcpy(header->magic, DIST_CACHE_MAGIC, sizeof(DIST_CACHE_MAGIC));
+  header->version = DIST_CACHE_VERSION;
+  header->dist_type = dist_type;
+  header->n_req = get_num_of_req(reader);
+  if (stat(reader->trace_path, &st) == 0) {
+    header->trace_file_size = st.st_size;
+    header->trace_mtime = st.st_mtime;
+  }
+  header->trace_type = reader->trace_type;
+
+  const reader_init_param_t *params = &reader->init_params;
+  header->block_size = params->block_size;
+  header->cap_at_n_req = reader->cap_at_n_req;
+  header->trace_start_offset = params->trace_start_offset;
+  if (params->binary_fmt_str != NULL) {
+    header->binary_fmt_hash = g_str_hash(params->binary_fmt_str);
+  }
+  header->time_field = params->time_field;
+  header->obj_id_field = params->obj_id_field;
+  header->obj_size_field = params->obj_size_field;
+  header->op_field = params->op_field;
+  header->ttl_field = params->ttl_field;
+  header->cnt_field = params->cnt_field;
+  header->tenant_field = params->tenant_field;
+  header->next_access_vtime_field = params->next_access_vtime_field;
+  header->obj_id_is_num = params->obj_id_is_num;
+  header->ignore_obj_size = params->ignore_obj_size;
+  header->ignore_size_zero_req = params->ignore_size_zero_req;
+  header->has_header = params->has_header;
+  header->delimiter = params->delimiter;
+}
+
+static int32_t *_compute_dist(reader_t *const reader,
+                              const dist_type_e dist_type,
+                              int64_t *array_size) {
+  if (dist_type == STACK_DIST || dist_type == FUTURE_STACK_DIST) {
+    return get_stack_dist(reader, dist_type, array_size);
+  } else {
+    return get_access_dist(reader, dist_type, array_size);
+  }
+}
+
+/* map the cache file, return NULL if it does not exist or does not match */
+static int32_t *_map_dist_cache(const char *const cache_path,
+                                const dist_cache_header_t *header) {
+  int fd = open(cache_path, O_RDONLY);
+  if (fd < 0) return NULL;
+
+  struct stat st;
+  size_t map_size = DIST_CACHE_HEADER_SIZE + sizeof(int32_t) * header->n_req;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size != map_size) {
+    close(fd);
+    return NULL;
+  }
+
+  char *mapped = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) return NULL;
+
+  if (memcmp(mapped, header, sizeof(dist_cache_header_t)) != 0) {
+    munmap(mapped, map_size);
+    return NULL;
+  }
+
+  return (int32_t *)(mapped + DIST_CACHE_HEADER_SIZE);
+}
+
+static bool _write_dist_cache(const char *const cache_path,
+                              const dist_cache_header_t *header,
+                              const int32_t *dist_array) {
+  char *tmp_path = (char *)malloc(strlen(cache_path) + 32);
+  sprintf(tmp_path, "%s.%d.tmp", cache_path, (int)getpid());
+  FILE *file = fopen(tmp_path, "wb");
+  if (file == NULL) {
+    free(tmp_path);
+    return false;
+  }
+
+  char header_buf[DIST_CACHE_HEADER_SIZE];
+  memset(header_buf, 0, DIST_CACHE_HEADER_SIZE);
+  memcpy(header_buf, header, sizeof(dist_cache_header_t));
+  bool ok =
+      fwrite(header_buf, 1, DIST_CACHE_HEADER_SIZE, file) ==
+          DIST_CACHE_HEADER_SIZE &&
+      fwrite(dist_array, sizeof(int32_t), header->n_req, file) ==
+          (size_t)header->n_req;
+  ok = (fclose(file) == 0) && ok;
+
+  /* rename is atomic, so concurrent runs never see a partial file */
+  if (ok) ok = rename(tmp_path, cache_path) == 0;
+  if (!ok) unlink(tmp_path);
+  free(tmp_path);
+
+  return ok;
+}
+
+/***********************************************************
+ * get the distance array and cache it in a file in cache_dir (or the
+ * directory set by set_dist_cache_dir), the cache file is keyed by the trace
+ * identity (size and modification time), the reader parameters and the
+ * distance type, so repeated runs on the same trace map the file instead of
+ * recomputing, without a cache directory the array is computed every time
+ *
+ * @param reader
+ * @param dist_type
+ * @param array_size
+ * @param cache_dir the directory to store the cache file, NULL means
+ *                  the directory set by set_dist_cache_dir
+ * @return a read-only distance array, it should be released using
+ *         release_dist_cached
+ */
+int32_t *get_dist_cached(reader_t *const reader, const dist_type_e dist_type,
+                         int64_t *array_size, const char *const cache_dir) {
+  dist_cache_header_t header;
+  _fill_dist_cache_header(reader, dist_type, &header);
+  *array_size = header.n_req;
+
+  const char *dir = cache_dir != NULL ? cache_dir : dist_cache_dir;
+  const char *trace_name = reader->trace_path;
+  if (strrchr(trace_name, '/') != NULL) {
+    trace_name = strrchr(trace_name, '/') + 1;
+  }
+  char *cache_path = NULL;
+  if (dir != NULL) {
+    cache_path = (char *)malloc(strlen(dir) + strlen(trace_name) + 128);
+    sprintf(cache_path, "%s/%s.%s.cache", dir, trace_name,
+            g_dist_type_name[dist_type]);
+  }
+
+  /* a sampled reader does not have a stable identity */
+  bool use_cache = cache_path != NULL && reader->sampler == NULL;
+  int32_t *dist_array = NULL;
+  if (use_cache) {
+    dist_array = _map_dist_cache(cache_path, &header);
+    if (dist_array != NULL) {
+      DEBUG("load %s from %s\n", g_dist_type_name[dist_type], cache_path);
+      free(cache_path);
+      return dist_array;
+    }
+  }
+
+  int32_t *computed = _compute_dist(reader, dist_type, array_size);
+  DEBUG_ASSERT(*array_size == header.n_req);
+  if (use_cache && _write_dist_cache(cache_path, &header, computed)) {
+    dist_array = _map_dist_cache(cache_path, &header);
+  } else if (use_cache) {
+    WARN("cannot write distance cache %s\n", cache_path);
+  }
+
+  if (dist_array == NULL) {
+    /* fall back to an anonymous mapping so that the array can always be
+     * released in the same way */
+    size_t map_size = DIST_CACHE_HEADER_SIZE + sizeof(int32_t) * header.n_req;
+    char *mapped = mmap(NULL, map_size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT_TRUE(mapped != MAP_FAILED, "cannot mmap distance array\n");
+    memcpy(mapped + DIST_CACHE_HEADER_SIZE, computed,
+           sizeof(int32_t) * header.n_req);
+    dist_array = (int32_t *)(mapped + DIST_CACHE_HEADER_SIZE);
+  }
+
+  free(computed);
+  free(cache_path);
+  return dist_array;
+}
+
+void release_dist_cached(int32_t *dist_array, const int64_t array_size) {
+  char *mapped = (char *)dist_array - DIST_CACHE_HEADER_SIZE;
+  munmap(mapped, DIST_CACHE_HEADER_SIZE + sizeof(int32_t) * array_size);
+}
+
 void cnt_dist(const int32_t *dist_array, const int64_t array_size,
               GHashTable *hash_table) {
   for (uint64_t i = 0; i < array_size; i++) {
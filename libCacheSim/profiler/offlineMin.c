@@ -0,0 +1,394 @@
+//
+//  offlineMin.c
+//  the offline optimal (MIN) used as the reference line of miss ratio curves
+//
+//  the trace is loaded once and the next access of each request is computed
+//  in a reverse pass (as convert_to_lcs does), so the trace does not need to
+//  carry next_access_vtime
+//
+//  simulate_offline_belady: Belady with each object taking one slot of the
+//      cache, the cached objects are kept in a calendar of their next access
+//      times with one bucket per request, a request accesses one object, so
+//      no two cached objects share a bucket, the latest occupied bucket (the
+//      object to evict) is found with a hierarchy of bitmaps, each eviction
+//      is a few word operations instead of a heap pop, and each cache size
+//      is simulated by its own thread
+//
+//  get_pfoo_lower_bound: the PFOO-L lower bound of the miss ratio with
+//      variable object sizes, Berger et al. "Practical Bounds on Optimal
+//      Caching with Variable Object Sizes" (SIGMETRICS'18), keeping an object
+//      between two accesses costs object size * reuse time of space-time,
+//      a cache of C bytes has C * n_req of space-time, and the reuse
+//      intervals are taken greedily from the cheapest per hit (per byte hit
+//      for the byte miss ratio) until the space-time is used up
+//
+
+#include <string.h>
+
+#include "../include/libCacheSim/macro.h"
+#include "../include/libCacheSim/mem.h"
+#include "../include/libCacheSim/simulator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OFFLINE_MIN_NO_NEXT (-1)
+#define CALENDAR_MAX_LEVEL 8
+
+typedef struct {
+  int64_t n_req;
+  int64_t n_req_byte;
+  int64_t n_alloc;
+  int64_t *obj_size;
+  /* the index of the next request to the same object,
+   * OFFLINE_MIN_NO_NEXT if the object is not requested again */
+  int64_t *next_access;
+} offline_trace_t;
+
+/* one bucket per request, level 0 has one bit per bucket, a bit at level
+ * l + 1 is set if the word under it at level l is not zero, the top level is
+ * one word */
+typedef struct {
+  int n_level;
+  uint64_t *bits[CALENDAR_MAX_LEVEL];
+  int64_t n_word[CALENDAR_MAX_LEVEL];
+} calendar_t;
+
+typedef struct {
+  const offline_trace_t *trace;
+  int num_of_sizes;
+  const uint64_t *cache_sizes;
+  cache_stat_t *result;
+} offline_min_params_t;
+
+typedef struct {
+  int64_t length;
+  int64_t size;
+} reuse_interval_t;
+
+static void _load_trace(reader_t *reader, offline_trace_t *trace) {
+  int64_t n_req_total = get_num_of_req(reader);
+  obj_id_t *obj_ids = my_malloc_n(obj_id_t, n_req_total);
+  trace->obj_size = my_malloc_n(int64_t, n_req_total);
+  trace->next_access = my_malloc_n(int64_t, n_req_total);
+  trace->n_alloc = n_req_total;
+  trace->n_req = 0;
+  trace->n_req_byte = 0;
+
+  reader_t *cloned_reader = clone_reader(reader);
+  request_t *req = new_request();
+  read_one_req(cloned_reader, req);
+  while (req->valid && trace->n_req < n_req_total) {
+    obj_ids[trace->n_req] = req->obj_id;
+    trace->obj_size[trace->n_req] = req->obj_size;
+    trace->n_req_byte += req->obj_size;
+    trace->n_req += 1;
+    read_one_req(cloned_reader, req);
+  }
+  free_request(req);
+  close_reader(cloned_reader);
+
+  /* scanning backward, the last seen position of an object is the next
+   * access of the current request */
+  GHashTable *next_pos = g_hash_table_new(g_direct_hash, g_direct_equal);
+  for (int64_t i = trace->n_req - 1; i >= 0; i--) {
+    gpointer key = GSIZE_TO_POINTER(obj_ids[i]);
+    gpointer pos;
+    if (g_hash_table_lookup_extended(next_pos, key, NULL, &pos)) {
+      trace->next_access[i] = (int64_t)GPOINTER_TO_SIZE(pos);
+    } else {
+      trace->next_access[i] = OFFLINE_MIN_NO_NEXT;
+    }
+    g_hash_table_insert(next_pos, key, GSIZE_TO_POINTER((gsize)i));
+  }
+  g_hash_table_destroy(next_pos);
+  my_free(sizeof(obj_id_t) * n_req_total, obj_ids);
+}
+
+static void _free_trace(offline_trace_t *trace) {
+  my_free(sizeof(int64_t) * trace->n_alloc, trace->obj_size);
+  my_free(sizeof(int64_t) * trace->n_alloc, trace->next_access);
+}
+
+static void _calendar_init(calendar_t *cal, int64_t n_bucket) {
+  memset(cal, 0, sizeof(calendar_t));
+  int64_t n_bit = MAX(n_bucket, 1);
+  do {
+    DEBUG_ASSERT(cal->n_level < CALENDAR_MAX_LEVEL);
+    int64_t n_word = (n_bit + 63) / 64;
+    cal->bits[cal->n_level] = my_malloc_n(uint64_t, n_word);
+    memset(cal->bits[cal->n_level], 0, sizeof(uint64_t) * n_word);
+    cal->n_word[cal->n_level] = n_word;
+    cal->n_level += 1;
+    n_bit = n_word;
+  } while (n_bit > 1);
+}
+
+static void _calendar_free(calendar_t *cal) {
+  for (int l = 0; l < cal->n_level; l++) {
+    my_free(sizeof(uint64_t) * cal->n_word[l], cal->bits[l]);
+  }
+}
+
+static inline bool _calendar_is_set(const calendar_t *cal, int64_t pos) {
+  return (cal->bits[0][pos >> 6] >> (pos & 63)) & 1;
+}
+
+static inline void _calendar_set(calendar_t *cal, int64_t pos) {
+  for (int l = 0; l < cal->n_level; l++) {
+    uint64_t *word = &cal->bits[l][pos >> 6];
+    bool was_empty = *word == 0;
+    *word |= 1ULL << (pos & 63);
+    if (!was_empty) break;
+    pos >>= 6;
+  }
+}
+
+static inline void _calendar_clear(calendar_t *cal, int64_t pos) {
+  for (int l = 0; l < cal->n_level; l++) {
+    uint64_t *word = &cal->bits[l][pos >> 6];
+    *word &= ~(1ULL << (pos & 63));
+    if (*word != 0) break;
+    pos >>= 6;
+  }
+}
+
+/**
+ * @brief the latest occupied bucket, the calendar must not be empty
+ */
+static inline int64_t _calendar_last(const calendar_t *cal) {
+  int64_t pos = 0;
+  for (int l = cal->n_level - 1; l >= 0; l--) {
+    uint64_t word = cal->bits[l][pos];
+    DEBUG_ASSERT(word != 0);
+    pos = (pos << 6) + 63 - __builtin_clzll(word);
+  }
+  return pos;
+}
+
+/**
+ * @brief simulate Belady at one cache size (in number of objects)
+ */
+static void _offline_belady(const offline_trace_t *trace, int64_t cache_size, cache_stat_t *stat) {
+  calendar_t cal;
+  _calendar_init(&cal, trace->n_req);
+
+  int64_t n_obj = 0;
+  /* cached objects that are not requested again, they are evicted first */
+  int64_t n_obj_no_next = 0;
+  for (int64_t t = 0; t < trace->n_req; t++) {
+    int64_t next = trace->next_access[t];
+    if (_calendar_is_set(&cal, t)) {
+      _calendar_clear(&cal, t);
+    } else {
+      stat->n_miss += 1;
+      stat->n_miss_byte += trace->obj_size[t];
+      if (cache_size <= 0) continue;
+
+      if (n_obj == cache_size) {
+        if (n_obj_no_next > 0) {
+          n_obj_no_next -= 1;
+        } else {
+          _calendar_clear(&cal, _calendar_last(&cal));
+        }
+        n_obj -= 1;
+      }
+      n_obj += 1;
+    }
+
+    if (next == OFFLINE_MIN_NO_NEXT) {
+      n_obj_no_next += 1;
+    } else {
+      _calendar_set(&cal, next);
+    }
+  }
+
+  stat->n_obj = n_obj;
+  /* the cache size is in objects, so is the occupied size */
+  stat->occupied_byte = n_obj;
+  _calendar_free(&cal);
+}
+
+static void _offline_belady_thread(gpointer data, gpointer user_data) {
+  offline_min_params_t *params = (offline_min_params_t *)user_data;
+  int idx = (int)GPOINTER_TO_SIZE(data) - 1;
+  _offline_belady(params->trace, (int64_t)params->cache_sizes[idx], &params->result[idx]);
+}
+
+static cache_stat_t *_new_result(const offline_trace_t *trace, int num_of_sizes, const uint64_t *cache_sizes,
+                                 const char *name) {
+  cache_stat_t *result = my_malloc_n(cache_stat_t, num_of_sizes);
+  memset(result, 0, sizeof(cache_stat_t) * num_of_sizes);
+  for (int i = 0; i < num_of_sizes; i++) {
+    result[i].cache_size = (int64_t)cache_sizes[i];
+    result[i].n_req = trace->n_req;
+    result[i].n_req_byte = trace->n_req_byte;
+    strncpy(result[i].cache_name, name, CACHE_NAME_ARRAY_LEN);
+  }
+  return result;
+}
+
+/**
+ * @brief simulate Belady at all cache sizes, the cache size is the number of
+ * objects, the result is the same as Belady on a trace read with
+ * ignore_obj_size, and the trace does not need next access information
+ *
+ * @param reader
+ * @param num_of_sizes
+ * @param cache_sizes the number of objects each cache holds
+ * @param num_of_threads
+ * @return an array of cache_stat_t, each corresponds to one cache size
+ */
+cache_stat_t *simulate_offline_belady(reader_t *reader, int num_of_sizes, const uint64_t *cache_sizes,
+                                      int num_of_threads) {
+  offline_trace_t trace;
+  _load_trace(reader, &trace);
+
+  cache_stat_t *result = _new_result(&trace, num_of_sizes, cache_sizes, "Belady");
+  offline_min_params_t params = {
+      .trace = &trace,
+      .num_of_sizes = num_of_sizes,
+      .cache_sizes = cache_sizes,
+      .result = result,
+  };
+
+  GThreadPool *gthread_pool =
+      g_thread_pool_new((GFunc)_offline_belady_thread, (gpointer)&params, MAX(num_of_threads, 1), TRUE, NULL);
+  ASSERT_NOT_NULL(gthread_pool, "cannot create thread pool in offline Belady\n");
+  for (int i = 1; i < num_of_sizes + 1; i++) {
+    ASSERT_TRUE(g_thread_pool_push(gthread_pool, GSIZE_TO_POINTER(i), NULL),
+                "cannot push data into thread_pool in offline Belady\n");
+  }
+  g_thread_pool_free(gthread_pool, FALSE, TRUE);
+
+  INFO("offline Belady finishes %d cache sizes, %" PRId64 " requests\n", num_of_sizes, trace.n_req);
+
+  _free_trace(&trace);
+  return result;
+}
+
+static int _cmp_interval_space_time(const void *a, const void *b) {
+  const reuse_interval_t *ia = (const reuse_interval_t *)a;
+  const reuse_interval_t *ib = (const reuse_interval_t *)b;
+  double ca = (double)ia->size * (double)ia->length;
+  double cb = (double)ib->size * (double)ib->length;
+  return (ca > cb) - (ca < cb);
+}
+
+static int _cmp_interval_length(const void *a, const void *b) {
+  const reuse_interval_t *ia = (const reuse_interval_t *)a;
+  const reuse_interval_t *ib = (const reuse_interval_t *)b;
+  return (ia->length > ib->length) - (ia->length < ib->length);
+}
+
+typedef struct {
+  reuse_interval_t *intervals;
+  int64_t n_interval;
+  int (*cmp)(const void *, const void *);
+} interval_sort_params_t;
+
+static gpointer _sort_intervals(gpointer data) {
+  interval_sort_params_t *params = (interval_sort_params_t *)data;
+  qsort(params->intervals, params->n_interval, sizeof(reuse_interval_t), params->cmp);
+  return NULL;
+}
+
+/**
+ * @brief take the sorted intervals until the space-time of each cache size is
+ * used up, the interval that crosses the budget is counted as a hit, so that
+ * the number of hits is not smaller than the fractional optimum
+ */
+static void _pfoo_fill(const offline_trace_t *trace, const reuse_interval_t *intervals, int64_t n_interval,
+                       int num_of_sizes, const uint64_t *cache_sizes, cache_stat_t *result, bool byte_miss) {
+  /* visit the cache sizes from the smallest */
+  int *order = my_malloc_n(int, num_of_sizes);
+  for (int i = 0; i < num_of_sizes; i++) {
+    int j = i;
+    while (j > 0 && cache_sizes[order[j - 1]] > cache_sizes[i]) {
+      order[j] = order[j - 1];
+      j--;
+    }
+    order[j] = i;
+  }
+
+  int64_t j = 0, n_hit = 0, n_hit_byte = 0;
+  double space_time = 0;
+  for (int k = 0; k < num_of_sizes; k++) {
+    double budget = (double)cache_sizes[order[k]] * (double)trace->n_req;
+    while (j < n_interval && space_time < budget) {
+      space_time += (double)intervals[j].size * (double)intervals[j].length;
+      n_hit += 1;
+      n_hit_byte += intervals[j].size;
+      j++;
+    }
+    if (byte_miss) {
+      result[order[k]].n_miss_byte = trace->n_req_byte - n_hit_byte;
+    } else {
+      result[order[k]].n_miss = trace->n_req - n_hit;
+    }
+  }
+  my_free(sizeof(int) * num_of_sizes, order);
+}
+
+/**
+ * @brief compute the PFOO-L lower bound of the miss ratio of any policy at
+ * each cache size (in bytes), n_miss is the bound of the number of misses
+ * and n_miss_byte is the bound of the missed bytes, they come from two
+ * different greedy orders, which are sorted in parallel
+ *
+ * @param reader
+ * @param num_of_sizes
+ * @param cache_sizes
+ * @param num_of_threads
+ * @return an array of cache_stat_t, each corresponds to one cache size
+ */
+cache_stat_t *get_pfoo_lower_bound(reader_t *reader, int num_of_sizes, const uint64_t *cache_sizes,
+                                   int num_of_threads) {
+  offline_trace_t trace;
+  _load_trace(reader, &trace);
+
+  /* the reuse interval ends at the next access, which is a hit if the
+   * object stays in the cache, the object size is the size at the hit */
+  reuse_interval_t *by_space_time = my_malloc_n(reuse_interval_t, MAX(trace.n_req, 1));
+  int64_t n_interval = 0;
+  for (int64_t i = 0; i < trace.n_req; i++) {
+    int64_t next = trace.next_access[i];
+    if (next == OFFLINE_MIN_NO_NEXT) continue;
+    by_space_time[n_interval].length = next - i;
+    by_space_time[n_interval].size = trace.obj_size[next];
+    n_interval++;
+  }
+  reuse_interval_t *by_length = my_malloc_n(reuse_interval_t, MAX(n_interval, 1));
+  memcpy(by_length, by_space_time, sizeof(reuse_interval_t) * n_interval);
+
+  /* the cheapest per hit is the one with the least space-time, and the
+   * cheapest per byte hit is the one with the shortest reuse time */
+  interval_sort_params_t sort_params[2] = {
+      {.intervals = by_space_time, .n_interval = n_interval, .cmp = _cmp_interval_space_time},
+      {.intervals = by_length, .n_interval = n_interval, .cmp = _cmp_interval_length},
+  };
+  if (num_of_threads > 1) {
+    GThread *sorter = g_thread_new("pfoo_sort", _sort_intervals, &sort_params[1]);
+    _sort_intervals(&sort_params[0]);
+    g_thread_join(sorter);
+  } else {
+    _sort_intervals(&sort_params[0]);
+    _sort_intervals(&sort_params[1]);
+  }
+
+  cache_stat_t *result = _new_result(&trace, num_of_sizes, cache_sizes, "PFOO-L");
+  _pfoo_fill(&trace, by_space_time, n_interval, num_of_sizes, cache_sizes, result, false);
+  _pfoo_fill(&trace, by_length, n_interval, num_of_sizes, cache_sizes, result, true);
+
+  INFO("PFOO-L finishes %d cache sizes, %" PRId64 " requests\n", num_of_sizes, trace.n_req);
+
+  my_free(sizeof(reuse_interval_t) * MAX(trace.n_req, 1), by_space_time);
+  my_free(sizeof(reuse_interval_t) * MAX(n_interval, 1), by_length);
+  _free_trace(&trace);
+  return result;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,279 @@
+//
+//  profilerAET.c
+//  estimate the LRU miss ratio curve using the Average Eviction Time (AET)
+//  model, see "Kinetic Modeling of Data Eviction in Cache", ATC'16
+//
+//  the profiler makes one pass over the trace and builds a reuse time
+//  histogram, the histogram uses log-linear buckets (similar to HDR histogram)
+//  so it uses constant memory regardless of the trace length,
+//  the miss ratio curve is then derived analytically from the histogram
+//
+//  note that we still need to remember the last access time of each object,
+//  use a spatially sampled reader to bound the memory usage on huge traces
+//
+
+#include <errno.h>
+#include <string.h>
+
+#include "../include/libCacheSim/macro.h"
+#include "../include/libCacheSim/profilerLRU.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* each power of two range is split into 2^AET_SUB_BUCKET_BITS linear buckets,
+ * so the relative error of a bucketed reuse time is bounded by 1/256 */
+#define AET_SUB_BUCKET_BITS 8
+#define AET_N_SUB_BUCKET (1ULL << AET_SUB_BUCKET_BITS)
+#define AET_N_BUCKET ((64 - AET_SUB_BUCKET_BITS + 1) * AET_N_SUB_BUCKET)
+
+static inline uint64_t aet_bucket_idx(const uint64_t rt) {
+  if (rt < AET_N_SUB_BUCKET) return rt;
+
+  int msb = 63 - __builtin_clzll(rt);
+  int shift = msb - AET_SUB_BUCKET_BITS;
+  return ((uint64_t)(shift + 1) << AET_SUB_BUCKET_BITS) +
+         ((rt >> shift) - AET_N_SUB_BUCKET);
+}
+
+/* the smallest reuse time that falls into the bucket */
+static inline uint64_t aet_bucket_lower(const uint64_t idx) {
+  if (idx < AET_N_SUB_BUCKET) return idx;
+
+  int shift = (int)(idx >> AET_SUB_BUCKET_BITS) - 1;
+  return (AET_N_SUB_BUCKET + (idx & (AET_N_SUB_BUCKET - 1))) << shift;
+}
+
+static inline uint64_t aet_bucket_width(const uint64_t idx) {
+  if (idx < AET_N_SUB_BUCKET) return 1;
+
+  return 1ULL << ((idx >> AET_SUB_BUCKET_BITS) - 1);
+}
+
+/* called when a window of the reuse time histogram is closed */
+typedef void (*rt_hist_window_func_ptr)(const uint64_t *rt_hist,
+                                        uint64_t n_req, uint64_t n_cold_miss,
+                                        gint64 window, void *user_data);
+
+/**
+ * build the reuse time histogram in one pass, the reuse time is measured in
+ * requests, if window_sec > 0, the histogram is handed to on_window and
+ * cleared at the end of each window_sec of trace time (including the windows
+ * without requests), a request whose last access is in an earlier window is
+ * still a reuse, otherwise the whole trace is one window
+ *
+ * @param reader
+ * @param window_sec the length of a window in seconds, 0 means no window
+ * @param on_window called with the histogram (AET_N_BUCKET elements), the
+ *        number of requests and cold misses of each window
+ * @param user_data passed to on_window
+ * @return the number of windows
+ */
+static gint64 _build_reuse_time_hist(reader_t *reader, int64_t window_sec,
+                                     rt_hist_window_func_ptr on_window,
+                                     void *user_data) {
+  uint64_t *rt_hist = g_new0(uint64_t, AET_N_BUCKET);
+  uint64_t n_window_req = 0, n_window_cold_miss = 0;
+  gint64 curr_window = 0;
+  uint64_t ts = 0;
+  request_t *req = new_request();
+  GHashTable *hash_table =
+      g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, NULL);
+
+  read_one_req(reader, req);
+  int64_t start_time = req->clock_time;
+  while (req->valid) {
+    gint64 window =
+        window_sec > 0 ? (gint64)((req->clock_time - start_time) / window_sec)
+                       : 0;
+    /* close the current window and the empty windows in between */
+    while (curr_window < window) {
+      on_window(rt_hist, n_window_req, n_window_cold_miss, curr_window,
+                user_data);
+      memset(rt_hist, 0, sizeof(uint64_t) * AET_N_BUCKET);
+      n_window_req = 0;
+      n_window_cold_miss = 0;
+      curr_window += 1;
+    }
+
+    ts += 1;
+    n_window_req += 1;
+    gpointer gp =
+        g_hash_table_lookup(hash_table, GSIZE_TO_POINTER(req->obj_id));
+    if (gp == NULL) {
+      n_window_cold_miss += 1;
+    } else {
+      rt_hist[aet_bucket_idx(ts - (uint64_t)GPOINTER_TO_SIZE(gp))] += 1;
+    }
+    /* ts starts from 1 so that a stored timestamp is never NULL */
+    g_hash_table_insert(hash_table, GSIZE_TO_POINTER(req->obj_id),
+                        GSIZE_TO_POINTER((gsize)ts));
+    read_one_req(reader, req);
+  }
+  on_window(rt_hist, n_window_req, n_window_cold_miss, curr_window,
+            user_data);
+
+  free_request(req);
+  g_hash_table_destroy(hash_table);
+  g_free(rt_hist);
+  reset_reader(reader);
+
+  return curr_window + 1;
+}
+
+/**
+ * convert a reuse time histogram to the miss ratio curve,
+ * let P(t) be the probability that the reuse time of a request is larger
+ * than t, the average eviction time of a cache of size c is the T that
+ * satisfies sum_{t=0}^{T-1} P(t) = c, and the miss ratio is P(T)
+ *
+ * @param rt_hist the reuse time histogram, it has AET_N_BUCKET elements
+ * @param n_req the number of requests
+ * @param n_cold_miss the number of requests that do not have a reuse
+ * @param n_points the max cache size (number of objects) on the curve
+ * @param mrc the output array with n_points + 1 elements
+ */
+static void _aet_hist_to_mrc(const uint64_t *rt_hist, const uint64_t n_req,
+                             const uint64_t n_cold_miss, const gint64 n_points,
+                             double *mrc) {
+  for (gint64 i = 0; i < n_points + 1; i++) mrc[i] = 1.0;
+  if (n_req == 0) return;
+
+  /* n_larger is the number of requests with reuse time larger than
+   * the current t, it starts with all reuses plus the cold misses */
+  uint64_t n_larger = n_req;
+  /* sum of P(t) for t in [0, t_lo) */
+  double cum_p = 0;
+  gint64 cache_size = 1;
+
+  for (uint64_t idx = 0; idx < AET_N_BUCKET && cache_size <= n_points; idx++) {
+    uint64_t width = aet_bucket_width(idx);
+    /* P(t) at the start and the end of the bucket, we assume the reuse
+     * times in one bucket are uniformly distributed */
+    double p_lo = (double)n_larger / (double)n_req;
+    n_larger -= rt_hist[idx];
+    double p_hi = (double)n_larger / (double)n_req;
+    double cum_p_hi = cum_p + (p_lo + p_hi) / 2.0 * (double)width;
+
+    while (cache_size <= n_points && (double)cache_size <= cum_p_hi) {
+      double frac = (cum_p_hi - cum_p) > 0
+                        ? ((double)cache_size - cum_p) / (cum_p_hi - cum_p)
+                        : 0;
+      mrc[cache_size++] = p_lo + (p_hi - p_lo) * frac;
+    }
+    cum_p = cum_p_hi;
+
+    /* all reuses have been counted, the remaining misses are cold misses */
+    if (n_larger == n_cold_miss) break;
+  }
+
+  double cold_miss_ratio = (double)n_cold_miss / (double)n_req;
+  while (cache_size <= n_points) {
+    mrc[cache_size++] = cold_miss_ratio;
+  }
+}
+
+/* the miss ratio curves of the windows, one row per window */
+typedef struct {
+  double *mrc;
+  gint64 n_points;
+  gint64 n_rows_alloc;
+} aet_mrc_matrix_t;
+
+static void _aet_window_to_mrc(const uint64_t *rt_hist, uint64_t n_req,
+                               uint64_t n_cold_miss, gint64 window,
+                               void *user_data) {
+  aet_mrc_matrix_t *matrix = (aet_mrc_matrix_t *)user_data;
+  gint64 n_cols = matrix->n_points + 1;
+  if (window >= matrix->n_rows_alloc) {
+    while (window >= matrix->n_rows_alloc) matrix->n_rows_alloc *= 2;
+    matrix->mrc = g_renew(double, matrix->mrc, matrix->n_rows_alloc * n_cols);
+  }
+  _aet_hist_to_mrc(rt_hist, n_req, n_cold_miss, matrix->n_points,
+                   matrix->mrc + window * n_cols);
+}
+
+/**
+ * estimate the LRU miss ratio curve using the AET model
+ *
+ * the time and space complexity are O(N) and O(M + n_points),
+ * where N is the number of requests and M is the number of objects
+ *
+ * note that the profiler does not support variable object size
+ *
+ * @param reader
+ * @param n_points the max cache size (number of objects) on the curve
+ * @return an array of n_points + 1 miss ratios, the ith element is
+ *         the estimated miss ratio of an LRU cache that holds i objects,
+ *         the user is responsible for freeing the array with g_free
+ */
+double *get_lru_mrc_aet(reader_t *reader, gint64 n_points) {
+  aet_mrc_matrix_t matrix = {.mrc = g_new0(double, n_points + 1),
+                             .n_points = n_points,
+                             .n_rows_alloc = 1};
+  _build_reuse_time_hist(reader, 0, _aet_window_to_mrc, &matrix);
+
+  return matrix.mrc;
+}
+
+/**
+ * estimate the LRU miss ratio curve of each time window in one pass,
+ * each window has its own reuse time histogram, a request whose last access
+ * is in an earlier window is still a reuse (the reuse time is measured
+ * in requests across windows), so the curve of a window shows the cache
+ * demand of the requests in the window with a warm cache
+ *
+ * windows without requests have a miss ratio of 1
+ *
+ * @param reader
+ * @param n_points the max cache size (number of objects) on the curve
+ * @param window_sec the length of a window in seconds of trace time
+ * @param n_windows the number of windows (rows) in the returned matrix
+ * @return a row-major matrix of n_windows * (n_points + 1) miss ratios,
+ *         the user is responsible for freeing the matrix with g_free
+ */
+double *get_lru_mrc_aet_windowed(reader_t *reader, gint64 n_points,
+                                 int64_t window_sec, gint64 *n_windows) {
+  ASSERT_TRUE(window_sec > 0, "window_sec must be positive\n");
+
+  aet_mrc_matrix_t matrix = {.mrc = g_new0(double, 16 * (n_points + 1)),
+                             .n_points = n_points,
+                             .n_rows_alloc = 16};
+  *n_windows =
+      _build_reuse_time_hist(reader, window_sec, _aet_window_to_mrc, &matrix);
+
+  return matrix.mrc;
+}
+
+/**
+ * save the windowed miss ratio curves as a binary matrix,
+ * the file starts with three int64_t: n_windows, n_points + 1 and window_sec,
+ * followed by n_windows * (n_points + 1) doubles in row-major order
+ *
+ * @param ofilepath
+ * @param mrc the matrix returned by get_lru_mrc_aet_windowed
+ * @param n_windows
+ * @param n_points
+ * @param window_sec
+ */
+void save_windowed_mrc(const char *ofilepath, const double *mrc,
+                       gint64 n_windows, gint64 n_points, int64_t window_sec) {
+  FILE *file = fopen(ofilepath, "wb");
+  if (file == NULL) {
+    ERROR("cannot open %s %s\n", ofilepath, strerror(errno));
+  }
+
+  int64_t header[3] = {n_windows, n_points + 1, window_sec};
+  size_t n_elem = (size_t)(n_windows * (n_points + 1));
+  if (fwrite(header, sizeof(int64_t), 3, file) != 3 ||
+      fwrite(mrc, sizeof(double), n_elem, file) != n_elem ||
+      fclose(file) != 0) {
+    ERROR("cannot write windowed miss ratio curves to %s %s\n", ofilepath,
+          strerror(errno));
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -6,17 +6,15 @@
 //  Copyright © 2016 Juncheng. All rights reserved.
 //
 
-#include "../dataStructure/splay.h"
+#include <assert.h>
+
+#include "../include/libCacheSim/dist.h"
 #include "../include/libCacheSim/profilerLRU.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-int64_t get_stack_dist_add_req(const request_t *req, sTree **splay_tree,
-                               GHashTable *hash_table, const int64_t curr_ts,
-                               int64_t *last_access_ts);
-
 guint64 *_get_lru_hit_cnt(reader_t *reader, gint64 size);
 
 double *get_lru_obj_miss_ratio_curve(reader_t *reader, gint64 size) {
@@ -48,26 +46,21 @@ guint64 *_get_lru_miss_cnt(reader_t *reader, gint64 size) {
 
 /**
  * get hit count for size 0~size,
- * non-parallel version
+ * non-parallel version, the stack distances are cached in the directory set
+ * by set_dist_cache_dir if any (see get_dist_cached)
  *
  * @param reader: reader for reading data
  * @param size: the max cache size, if -1, then it uses the maximum size
  */
 
 guint64 *_get_lru_hit_cnt(reader_t *reader, gint64 size) {
-  guint64 ts = 0;
   gint64 stack_dist;
   guint64 *hit_count_array = g_new0(guint64, size + 1);
-  request_t *req = new_request();
-
-  // create hash table and splay tree
-  GHashTable *hash_table =
-      g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, NULL);
-  sTree *splay_tree = NULL;
 
-  read_one_req(reader, req);
-  while (req->valid) {
-    stack_dist = get_stack_dist_add_req(req, &splay_tree, hash_table, ts, NULL);
+  int64_t n_dist = 0;
+  int32_t *dist_array = get_dist_cached(reader, STACK_DIST, &n_dist, NULL);
+  for (int64_t ts = 0; ts < n_dist; ts++) {
+    stack_dist = dist_array[ts];
 
     if (stack_dist == -1)
       // cold miss
@@ -77,8 +70,6 @@ guint64 *_get_lru_hit_cnt(reader_t *reader, gint64 size) {
         /* + 1 here because reuse stack_dist is 0 for consecutive accesses */
         hit_count_array[stack_dist + 1] += 1;
     }
-    read_one_req(reader, req);
-    ts++;
   }
 
   // change to accumulative, so that hit_count_array[x] is the hit count for
@@ -87,11 +78,7 @@ guint64 *_get_lru_hit_cnt(reader_t *reader, gint64 size) {
     hit_count_array[i] = hit_count_array[i] + hit_count_array[i - 1];
   }
 
-  // clean up
-  free_request(req);
-  g_hash_table_destroy(hash_table);
-  free_sTree(splay_tree);
-  reset_reader(reader);
+  release_dist_cached(dist_array, n_dist);
   return hit_count_array;
 }
 
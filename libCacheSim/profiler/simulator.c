@@ -13,8 +13,10 @@ extern "C" {
 #include "../include/libCacheSim/simulator.h"
 
 #include <math.h>
+#include <strings.h>
 
 #include "../cache/cacheUtils.h"
+#include "../include/libCacheSim/dist.h"
 #include "../include/libCacheSim/evictionAlgo.h"
 #include "../include/libCacheSim/plugin.h"
 #include "../utils/include/myprint.h"
@@ -25,6 +27,9 @@ typedef struct simulator_multithreading_params {
   ssize_t n_caches;
   cache_t **caches;
   uint64_t n_warmup_req; /* num of requests used for warming up cache */
+  /* num of requests at the start of reader that have been used to warm up
+   * the (forked) caches before the simulation */
+  uint64_t n_skip_req;
   reader_t *warmup_reader;
   int warmup_sec; /* num of seconds of requests used for warming up cache */
   cache_stat_t *result;
@@ -35,6 +40,14 @@ typedef struct simulator_multithreading_params {
   bool use_random_seed;
 } sim_mt_params_t;
 
+/* read the idx-th request of the trace, the next access time is set if the
+ * cache uses the distances from load_next_access_dist */
+static inline void _read_trace_req(reader_t *reader, request_t *req, const cache_t *cache, int64_t *idx) {
+  read_one_req(reader, req);
+  cache_set_next_access_vtime(cache, req, *idx);
+  *idx += 1;
+}
+
 static void _simulate(gpointer data, gpointer user_data) {
   sim_mt_params_t *params = (sim_mt_params_t *)user_data;
   int idx = GPOINTER_TO_UINT(data) - 1;
@@ -48,6 +61,7 @@ static void _simulate(gpointer data, gpointer user_data) {
   reader_t *cloned_reader = clone_reader(params->reader);
   request_t *req = new_request();
   cache_t *local_cache = params->caches[idx];
+  cache_get_func_ptr get = cache_get_func(local_cache);
   strncpy(result[idx].cache_name, local_cache->cache_name, CACHE_NAME_ARRAY_LEN);
 
   /* warm up using warmup_reader */
@@ -55,7 +69,7 @@ static void _simulate(gpointer data, gpointer user_data) {
     reader_t *warmup_cloned_reader = clone_reader(params->warmup_reader);
     read_one_req(warmup_cloned_reader, req);
     while (req->valid) {
-      local_cache->get(local_cache, req);
+      get(local_cache, req);
       result[idx].n_warmup_req += 1;
       read_one_req(warmup_cloned_reader, req);
     }
@@ -66,17 +80,24 @@ static void _simulate(gpointer data, gpointer user_data) {
          local_cache->cache_name, local_cache->cache_size, result[idx].n_warmup_req);
   }
 
-  read_one_req(cloned_reader, req);
+  int64_t req_idx = 0;
+  _read_trace_req(cloned_reader, req, local_cache, &req_idx);
   int64_t start_ts = (int64_t)req->clock_time;
 
+  /* skip the requests that have been used to warm up the forked caches */
+  for (uint64_t i = 0; i < params->n_skip_req && req->valid; i++) {
+    _read_trace_req(cloned_reader, req, local_cache, &req_idx);
+  }
+  result[idx].n_warmup_req += params->n_skip_req;
+
   /* using warmup_frac or warmup_sec of requests from reader to warm up */
   if (params->n_warmup_req > 0 || params->warmup_sec > 0) {
     uint64_t n_warmup = 0;
     while (req->valid && (n_warmup < params->n_warmup_req || req->clock_time - start_ts < params->warmup_sec)) {
       req->clock_time -= start_ts;
-      local_cache->get(local_cache, req);
+      get(local_cache, req);
       n_warmup += 1;
-      read_one_req(cloned_reader, req);
+      _read_trace_req(cloned_reader, req, local_cache, &req_idx);
     }
     result[idx].n_warmup_req += n_warmup;
     INFO("cache %s (size %" PRIu64
@@ -90,11 +111,11 @@ static void _simulate(gpointer data, gpointer user_data) {
     result[idx].n_req_byte += req->obj_size;
 
     req->clock_time -= start_ts;
-    if (local_cache->get(local_cache, req) == false) {
+    if (get(local_cache, req) == false) {
       result[idx].n_miss++;
       result[idx].n_miss_byte += req->obj_size;
     }
-    read_one_req(cloned_reader, req);
+    _read_trace_req(cloned_reader, req, local_cache, &req_idx);
   }
 
 /* disabled due to ARC and LeCaR use ghost entries in the hash table */
@@ -136,6 +157,60 @@ static void _simulate(gpointer data, gpointer user_data) {
   close_reader(cloned_reader);
 }
 
+/* the algorithms that use the next access time of the requests */
+static bool _use_next_access(const cache_t *cache) {
+  static const char *algos[] = {"Belady", "BeladySize", "FIFO_Belady", "LRU_Belady", "Sieve_Belady"};
+  for (size_t i = 0; i < sizeof(algos) / sizeof(algos[0]); i++) {
+    size_t len = strlen(algos[i]);
+    /* the name may have the parameters or the variant after the algorithm */
+    char next = cache->cache_name[len];
+    if (strncasecmp(cache->cache_name, algos[i], len) == 0 && (next == '\0' || next == '-' || next == '_')) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief load the distances till the next access for the caches of the
+ * Belady family if the trace does not have the next access time,
+ * the array is mapped from the cache file if a dist cache directory is set
+ * (see set_dist_cache_dir), so repeated runs do not recompute it
+ *
+ * @param reader
+ * @param caches the caches that need the array share it
+ * @param num_of_caches
+ * @param array_size
+ * @return the array, it should be released using release_dist_cached after
+ *         the simulation, NULL if no cache needs it
+ */
+int32_t *load_next_access_dist(reader_t *reader, cache_t *caches[], int num_of_caches, int64_t *array_size) {
+  bool need = false;
+  for (int i = 0; i < num_of_caches; i++) {
+    need = need || _use_next_access(caches[i]);
+  }
+  if (!need) return NULL;
+
+  /* the oracle traces have the next access time */
+  reader_t *cloned_reader = clone_reader(reader);
+  request_t *req = new_request();
+  read_one_req(cloned_reader, req);
+  bool has_next_access = req->next_access_vtime != -2;
+  free_request(req);
+  close_reader(cloned_reader);
+  if (has_next_access) return NULL;
+
+  int32_t *dist = get_dist_cached(reader, DIST_TILL_NEXT_ACCESS, array_size, NULL);
+  for (int i = 0; i < num_of_caches; i++) {
+    if (_use_next_access(caches[i])) {
+      caches[i]->next_access_dist = dist;
+      caches[i]->next_access_dist_array_size = *array_size;
+    }
+  }
+
+  return dist;
+}
+
 cache_stat_t *simulate_at_multi_sizes_with_step_size(reader_t *const reader, const cache_t *cache, uint64_t step_size,
                                                      reader_t *warmup_reader, double warmup_frac, int warmup_sec,
                                                      int num_of_threads, bool use_random_seed) {
@@ -182,6 +257,7 @@ cache_stat_t *simulate_at_multi_sizes(reader_t *reader, const cache_t *cache, in
   params->warmup_sec = warmup_sec;
   params->n_caches = num_of_sizes;
   params->n_warmup_req = (uint64_t)((double)get_num_of_req(reader) * warmup_frac);
+  params->n_skip_req = 0;
   params->result = result;
   params->free_cache_when_finish = true;
   params->progress = &progress;
@@ -194,9 +270,13 @@ cache_stat_t *simulate_at_multi_sizes(reader_t *reader, const cache_t *cache, in
 
   // start computation
   params->caches = my_malloc_n(cache_t *, num_of_sizes);
+  for (int i = 0; i < num_of_sizes; i++) {
+    params->caches[i] = create_cache_with_new_size(cache, cache_sizes[i]);
+    result[i].cache_size = cache_sizes[i];
+  }
+  int64_t n_next_access_dist = 0;
+  int32_t *next_access_dist = load_next_access_dist(reader, params->caches, num_of_sizes, &n_next_access_dist);
   for (int i = 1; i < num_of_sizes + 1; i++) {
-    params->caches[i - 1] = create_cache_with_new_size(cache, cache_sizes[i - 1]);
-    result[i - 1].cache_size = cache_sizes[i - 1];
     ASSERT_TRUE(g_thread_pool_push(gthread_pool, GSIZE_TO_POINTER(i), NULL),
                 "cannot push data into thread_pool in get_miss_ratio\n");
   }
@@ -219,6 +299,7 @@ cache_stat_t *simulate_at_multi_sizes(reader_t *reader, const cache_t *cache, in
   // clean up
   g_thread_pool_free(gthread_pool, FALSE, TRUE);
   g_mutex_clear(&(params->mtx));
+  if (next_access_dist != NULL) release_dist_cached(next_access_dist, n_next_access_dist);
   my_free(sizeof(cache_t *) * num_of_sizes, params->caches);
   my_free(sizeof(sim_mt_params_t), params);
 
@@ -259,6 +340,7 @@ cache_stat_t *simulate_with_multi_caches(reader_t *reader, cache_t *caches[], in
   } else {
     params->n_warmup_req = 0;
   }
+  params->n_skip_req = 0;
   params->result = result;
   params->free_cache_when_finish = free_cache_when_finish;
   params->progress = &progress;
@@ -269,6 +351,8 @@ cache_stat_t *simulate_with_multi_caches(reader_t *reader, cache_t *caches[], in
   ASSERT_NOT_NULL(gthread_pool, "cannot create thread pool in simulator\n");
 
   // start computation
+  int64_t n_next_access_dist = 0;
+  int32_t *next_access_dist = load_next_access_dist(reader, caches, num_of_caches, &n_next_access_dist);
   for (i = 1; i < num_of_caches + 1; i++) {
     result[i - 1].cache_size = caches[i - 1]->cache_size;
 
@@ -294,12 +378,239 @@ cache_stat_t *simulate_with_multi_caches(reader_t *reader, cache_t *caches[], in
   // clean up
   g_thread_pool_free(gthread_pool, FALSE, TRUE);
   g_mutex_clear(&(params->mtx));
+  if (next_access_dist != NULL) {
+    release_dist_cached(next_access_dist, n_next_access_dist);
+    /* the caches still owned by the caller should not keep the array */
+    for (i = 0; i < num_of_caches && !free_cache_when_finish; i++) {
+      caches[i]->next_access_dist = NULL;
+      caches[i]->next_access_dist_array_size = 0;
+    }
+  }
   my_free(sizeof(sim_mt_params_t), params);
 
   // user is responsible for free-ing the result
   return result;
 }
 
+/**
+ * @brief warm up the cache once and fork it to the parameter variants,
+ * the variants then run the rest of the trace in parallel
+ *
+ * @param reader
+ * @param cache a new cache, it is warmed up and owned by the caller
+ * @param num_of_variants
+ * @param variant_params the cache_specific_params of each variant,
+ *        NULL means the same parameters as cache
+ * @param warmup_reader if not NULL, read from warmup_reader to warm up cache
+ * @param warmup_frac use warmup_frac of requests from reader to warm up cache
+ * @param warmup_sec uses warmup_sec seconds of requests to warm up cache
+ * @param num_of_threads
+ * @param use_random_seed
+ * @return cache_stat_t*
+ */
+cache_stat_t *simulate_with_shared_warmup(reader_t *reader, cache_t *cache, int num_of_variants,
+                                          const char *variant_params[], reader_t *warmup_reader, double warmup_frac,
+                                          int warmup_sec, int num_of_threads, bool use_random_seed) {
+  assert(num_of_variants > 0);
+  int progress = 0;
+  uint64_t n_warmup_req = 0, n_skip_req = 0;
+  request_t *req = new_request();
+  cache_get_func_ptr get = cache_get_func(cache);
+
+  if (use_random_seed) {
+    set_rand_seed(rand());
+  } else {
+    set_rand_seed(1);
+  }
+
+  /* the forked caches share the array with cache */
+  int64_t n_next_access_dist = 0;
+  int32_t *next_access_dist = load_next_access_dist(reader, &cache, 1, &n_next_access_dist);
+
+  /* warm up using warmup_reader */
+  if (warmup_reader) {
+    reader_t *warmup_cloned_reader = clone_reader(warmup_reader);
+    read_one_req(warmup_cloned_reader, req);
+    while (req->valid) {
+      get(cache, req);
+      n_warmup_req += 1;
+      read_one_req(warmup_cloned_reader, req);
+    }
+    close_reader(warmup_cloned_reader);
+  }
+
+  /* using warmup_frac or warmup_sec of requests from reader to warm up */
+  uint64_t n_warmup_frac_req = (uint64_t)((double)get_num_of_req(reader) * warmup_frac);
+  if (n_warmup_frac_req > 0 || warmup_sec > 0) {
+    reader_t *cloned_reader = clone_reader(reader);
+    int64_t req_idx = 0;
+    _read_trace_req(cloned_reader, req, cache, &req_idx);
+    int64_t start_ts = (int64_t)req->clock_time;
+    while (req->valid && (n_skip_req < n_warmup_frac_req || req->clock_time - start_ts < warmup_sec)) {
+      req->clock_time -= start_ts;
+      get(cache, req);
+      n_skip_req += 1;
+      _read_trace_req(cloned_reader, req, cache, &req_idx);
+    }
+    close_reader(cloned_reader);
+  }
+  free_request(req);
+  INFO("cache %s finishes shared warm up with %" PRIu64 " requests\n", cache->cache_name, n_warmup_req + n_skip_req);
+
+  cache_stat_t *result = my_malloc_n(cache_stat_t, num_of_variants);
+  memset(result, 0, sizeof(cache_stat_t) * num_of_variants);
+
+  sim_mt_params_t *params = my_malloc(sim_mt_params_t);
+  params->reader = reader;
+  params->warmup_reader = NULL;
+  params->warmup_sec = 0;
+  params->n_warmup_req = 0;
+  params->n_skip_req = n_skip_req;
+  params->n_caches = num_of_variants;
+  params->result = result;
+  params->free_cache_when_finish = true;
+  params->progress = &progress;
+  params->use_random_seed = use_random_seed;
+  g_mutex_init(&(params->mtx));
+
+  params->caches = my_malloc_n(cache_t *, num_of_variants);
+  for (int i = 0; i < num_of_variants; i++) {
+    params->caches[i] = fork_cache(cache, variant_params == NULL ? NULL : variant_params[i]);
+    if (params->caches[i] == NULL) {
+      ERROR("%s does not support fork, cannot share warmup\n", cache->cache_name);
+    }
+    result[i].cache_size = params->caches[i]->cache_size;
+    result[i].n_warmup_req = n_warmup_req;
+  }
+
+  GThreadPool *gthread_pool = g_thread_pool_new((GFunc)_simulate, (gpointer)params, num_of_threads, TRUE, NULL);
+  ASSERT_NOT_NULL(gthread_pool, "cannot create thread pool in simulator\n");
+  for (int i = 1; i < num_of_variants + 1; i++) {
+    ASSERT_TRUE(g_thread_pool_push(gthread_pool, GSIZE_TO_POINTER(i), NULL),
+                "cannot push data into thread_pool in get_miss_ratio\n");
+  }
+
+  INFO("%s starts computation %s, %d variants, %d threads, please wait\n", __func__, cache->cache_name,
+       num_of_variants, num_of_threads);
+
+  // wait for all simulations to finish
+  while (progress < (uint64_t)num_of_variants - 1) {
+    print_progress((double)progress / (double)(num_of_variants - 1) * 100);
+  }
+
+  // clean up
+  g_thread_pool_free(gthread_pool, FALSE, TRUE);
+  g_mutex_clear(&(params->mtx));
+  if (next_access_dist != NULL) {
+    release_dist_cached(next_access_dist, n_next_access_dist);
+    cache->next_access_dist = NULL;
+    cache->next_access_dist_array_size = 0;
+  }
+  my_free(sizeof(cache_t *) * num_of_variants, params->caches);
+  my_free(sizeof(sim_mt_params_t), params);
+
+  // user is responsible for free-ing the result
+  return result;
+}
+
+/* the number of requests a client takes from the reader each time */
+#define N_REQ_PER_CLIENT_BATCH 1024
+
+typedef struct {
+  reader_t *reader;
+  cache_t *cache;
+  cache_stat_t *result;
+  GMutex mtx; /* protects the reader and the result */
+} concurrent_sim_params_t;
+
+static gpointer _concurrent_client(gpointer data) {
+  concurrent_sim_params_t *params = (concurrent_sim_params_t *)data;
+  cache_t *cache = params->cache;
+  request_t *req = new_request();
+  request_t *reqs = my_malloc_n(request_t, N_REQ_PER_CLIENT_BATCH);
+  int64_t n_req = 0, n_req_byte = 0, n_miss = 0, n_miss_byte = 0;
+
+  while (true) {
+    int n = 0;
+    g_mutex_lock(&(params->mtx));
+    for (; n < N_REQ_PER_CLIENT_BATCH; n++) {
+      read_one_req(params->reader, req);
+      if (!req->valid) break;
+      copy_request(&reqs[n], req);
+    }
+    g_mutex_unlock(&(params->mtx));
+    if (n == 0) break;
+
+    for (int i = 0; i < n; i++) {
+      n_req += 1;
+      n_req_byte += reqs[i].obj_size;
+      if (cache->get(cache, &reqs[i]) == false) {
+        n_miss += 1;
+        n_miss_byte += reqs[i].obj_size;
+      }
+    }
+  }
+
+  g_mutex_lock(&(params->mtx));
+  params->result->n_req += n_req;
+  params->result->n_req_byte += n_req_byte;
+  params->result->n_miss += n_miss;
+  params->result->n_miss_byte += n_miss_byte;
+  g_mutex_unlock(&(params->mtx));
+
+  my_free(sizeof(request_t) * N_REQ_PER_CLIENT_BATCH, reqs);
+  free_request(req);
+  return NULL;
+}
+
+/**
+ * @brief replay the trace with num_of_clients threads against one
+ * thread-safe cache (see create_concurrent_cache), each client takes a batch
+ * of requests from the reader at a time, so the order of requests seen by
+ * the cache depends on the thread scheduling
+ *
+ * @param reader
+ * @param cache the cache to copy the algorithm, size and parameters from,
+ *        it is not used for the simulation
+ * @param n_stripe
+ * @param num_of_clients
+ * @return cache_stat_t*
+ */
+cache_stat_t *simulate_with_concurrent_clients(reader_t *reader, const cache_t *cache, int n_stripe,
+                                               int num_of_clients) {
+  cache_stat_t *result = my_malloc(cache_stat_t);
+  memset(result, 0, sizeof(cache_stat_t));
+
+  concurrent_sim_params_t params;
+  params.reader = clone_reader(reader);
+  params.cache = create_concurrent_cache(cache, n_stripe);
+  params.result = result;
+  g_mutex_init(&(params.mtx));
+
+  INFO("%s starts computation %s, %d clients, please wait\n", __func__, params.cache->cache_name, num_of_clients);
+
+  GThread **threads = my_malloc_n(GThread *, num_of_clients);
+  for (int i = 0; i < num_of_clients; i++) {
+    threads[i] = g_thread_new("client", _concurrent_client, &params);
+  }
+  for (int i = 0; i < num_of_clients; i++) {
+    g_thread_join(threads[i]);
+  }
+
+  result->cache_size = params.cache->cache_size;
+  result->n_obj = params.cache->get_n_obj(params.cache);
+  result->occupied_byte = params.cache->get_occupied_byte(params.cache);
+  strncpy(result->cache_name, params.cache->cache_name, CACHE_NAME_ARRAY_LEN);
+
+  my_free(sizeof(GThread *) * num_of_clients, threads);
+  g_mutex_clear(&(params.mtx));
+  params.cache->cache_free(params.cache);
+  close_reader(params.reader);
+
+  // user is responsible for free-ing the result
+  return result;
+}
+
 #ifdef __cplusplus
 }
 #endif
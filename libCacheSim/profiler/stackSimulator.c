@@ -0,0 +1,416 @@
+//
+//  stackSimulator.c
+//  simulate a stack policy at all cache sizes in one pass
+//
+//  a policy is a stack policy if the content of a smaller cache is always a
+//  subset of the content of a larger cache (the inclusion property), so each
+//  request has a stack distance d, and it is a hit in all caches with
+//  size >= d, Mattson et al. "Evaluation techniques for storage hierarchies"
+//
+//  LRU: the stack is ordered by the last access time, the byte stack distance
+//       is computed with a Fenwick tree indexed by the last access time,
+//       O(N log M) time regardless of the number of cache sizes, the access
+//       times are renumbered when the tree is full, so the tree is bounded by
+//       a multiple of M, the number of objects in the trace
+//  Belady: the stack is ordered by the next access time, each request carries
+//       the object with a later next access down the stack until it reaches
+//       the accessed object, the stack is truncated at the largest cache size,
+//       O(N * K) time where K is the number of objects in the largest cache,
+//       so the cost grows with the largest cache size (simulate_offline_belady
+//       is faster for large caches), and the result is exact only when all
+//       objects have the same size, because Belady with variable object size
+//       does not have the inclusion property
+//
+//  note that the in-cache LFU (LFU.c) forgets the frequency of evicted
+//  objects, so it does not have the inclusion property and is simulated
+//  using simulate_at_multi_sizes
+//
+
+#include "../include/libCacheSim/simulator.h"
+
+#include <string.h>
+
+#include "../include/libCacheSim/macro.h"
+#include "../include/libCacheSim/mem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STACK_DIST_INF INT64_MAX
+#define FENWICK_INIT_SIZE (1 << 16)
+/* the weight of an access time that is not the last access of an object */
+#define FENWICK_DEAD_WEIGHT (-1)
+
+typedef enum {
+  STACK_POLICY_UNSUPPORTED,
+  STACK_POLICY_LRU,
+  STACK_POLICY_BELADY,
+} stack_policy_e;
+
+typedef struct {
+  obj_id_t obj_id;
+  int64_t next_access_vtime;
+  int64_t weight;
+} belady_stack_entry_t;
+
+typedef struct {
+  stack_policy_e policy;
+  int64_t obj_md_size;
+  int64_t max_cache_size;
+
+  /* LRU: obj_id -> the last access time (starting from 1),
+   * the Fenwick tree stores the weight of each object at its last access,
+   * weight and obj_id are indexed by the access time */
+  GHashTable *last_access;
+  int64_t *fenwick;
+  int64_t *weight;
+  obj_id_t *obj_id;
+  int64_t n_fenwick;
+  int64_t curr_ts;
+
+  /* Belady: the top of the stack that fits in the largest cache */
+  belady_stack_entry_t *stack;
+  int64_t stack_len;
+  int64_t stack_cap;
+} stack_sim_t;
+
+static inline void _fenwick_add(stack_sim_t *sim, int64_t pos, int64_t delta) {
+  for (; pos <= sim->n_fenwick; pos += pos & (-pos)) sim->fenwick[pos] += delta;
+}
+
+static inline int64_t _fenwick_prefix_sum(const stack_sim_t *sim, int64_t pos) {
+  int64_t sum = 0;
+  for (; pos > 0; pos -= pos & (-pos)) sum += sim->fenwick[pos];
+  return sum;
+}
+
+static void _fenwick_alloc(stack_sim_t *sim, int64_t n) {
+  sim->n_fenwick = n;
+  sim->fenwick = my_malloc_n(int64_t, (n + 1));
+  sim->weight = my_malloc_n(int64_t, (n + 1));
+  sim->obj_id = my_malloc_n(obj_id_t, (n + 1));
+}
+
+static void _fenwick_free(stack_sim_t *sim) {
+  my_free(sizeof(int64_t) * (sim->n_fenwick + 1), sim->fenwick);
+  my_free(sizeof(int64_t) * (sim->n_fenwick + 1), sim->weight);
+  my_free(sizeof(obj_id_t) * (sim->n_fenwick + 1), sim->obj_id);
+}
+
+/**
+ * @brief renumber the last access times of the objects from 1 in the same
+ * order, the tree is grown if more than half of it would be in use
+ */
+static void _fenwick_compact(stack_sim_t *sim) {
+  int64_t *old_weight = sim->weight;
+  obj_id_t *old_obj_id = sim->obj_id;
+  int64_t old_n = sim->n_fenwick;
+  my_free(sizeof(int64_t) * (old_n + 1), sim->fenwick);
+
+  int64_t n_live = (int64_t)g_hash_table_size(sim->last_access);
+  int64_t new_n = old_n;
+  while (n_live * 2 > new_n) new_n *= 2;
+  _fenwick_alloc(sim, new_n);
+
+  int64_t ts = 0;
+  for (int64_t old_ts = 1; old_ts <= sim->curr_ts; old_ts++) {
+    if (old_weight[old_ts] == FENWICK_DEAD_WEIGHT) continue;
+    ts += 1;
+    sim->weight[ts] = old_weight[old_ts];
+    sim->obj_id[ts] = old_obj_id[old_ts];
+    g_hash_table_insert(sim->last_access, GSIZE_TO_POINTER(sim->obj_id[ts]), GSIZE_TO_POINTER((gsize)ts));
+  }
+  DEBUG_ASSERT(ts == n_live);
+  sim->curr_ts = ts;
+
+  /* build the tree in linear time, the nodes after ts cover the live
+   * objects too, so the sums are carried up to the end of the tree */
+  memset(sim->fenwick, 0, sizeof(int64_t) * (new_n + 1));
+  for (int64_t i = 1; i <= new_n; i++) {
+    if (i <= ts) sim->fenwick[i] += sim->weight[i];
+    int64_t parent = i + (i & (-i));
+    if (parent <= new_n) sim->fenwick[parent] += sim->fenwick[i];
+  }
+
+  my_free(sizeof(int64_t) * (old_n + 1), old_weight);
+  my_free(sizeof(obj_id_t) * (old_n + 1), old_obj_id);
+}
+
+/**
+ * @brief check whether the cache can be simulated with the stack algorithm
+ */
+static stack_policy_e _get_stack_policy(const cache_t *cache) {
+  if (cache->admissioner != NULL || cache->prefetcher != NULL) {
+    return STACK_POLICY_UNSUPPORTED;
+  }
+#ifdef SUPPORT_TTL
+  if (cache->default_ttl != 0) {
+    return STACK_POLICY_UNSUPPORTED;
+  }
+#endif
+
+  if (strcasecmp(cache->cache_name, "LRU") == 0) {
+    return STACK_POLICY_LRU;
+  } else if (strcasecmp(cache->cache_name, "Belady") == 0) {
+    return STACK_POLICY_BELADY;
+  }
+
+  return STACK_POLICY_UNSUPPORTED;
+}
+
+/**
+ * @brief access the object in the LRU stack
+ *
+ * @return the number of bytes from the top of the stack to the object
+ *        (inclusive), or STACK_DIST_INF if the object has not been seen
+ */
+static int64_t _lru_stack_access(stack_sim_t *sim, const request_t *req) {
+  int64_t dist = STACK_DIST_INF;
+  int64_t weight = (int64_t)req->obj_size + sim->obj_md_size;
+
+  if (sim->curr_ts == sim->n_fenwick) {
+    _fenwick_compact(sim);
+  }
+  sim->curr_ts += 1;
+  gpointer gp = g_hash_table_lookup(sim->last_access, GSIZE_TO_POINTER(req->obj_id));
+  if (gp != NULL) {
+    int64_t last_ts = (int64_t)GPOINTER_TO_SIZE(gp);
+    dist = _fenwick_prefix_sum(sim, sim->curr_ts - 1) - _fenwick_prefix_sum(sim, last_ts - 1);
+    /* the stack uses the latest object size */
+    _fenwick_add(sim, last_ts, -sim->weight[last_ts]);
+    sim->weight[last_ts] = FENWICK_DEAD_WEIGHT;
+  }
+
+  _fenwick_add(sim, sim->curr_ts, weight);
+  sim->weight[sim->curr_ts] = weight;
+  sim->obj_id[sim->curr_ts] = req->obj_id;
+  g_hash_table_insert(sim->last_access, GSIZE_TO_POINTER(req->obj_id), GSIZE_TO_POINTER((gsize)sim->curr_ts));
+
+  return dist;
+}
+
+/**
+ * @brief access the object in the Belady (MIN) stack, the object is moved to
+ * the top, and at each position the object with an earlier next access stays,
+ * while the other one is carried down
+ *
+ * @return the number of bytes from the top of the stack to the object
+ *        (inclusive), or STACK_DIST_INF if the object is not in the stack
+ */
+static int64_t _belady_stack_access(stack_sim_t *sim, const request_t *req) {
+  DEBUG_ASSERT(req->next_access_vtime != -2);
+  belady_stack_entry_t carry = {
+      .obj_id = req->obj_id,
+      .next_access_vtime = req->next_access_vtime == -1 ? INT64_MAX : req->next_access_vtime,
+      .weight = (int64_t)req->obj_size + sim->obj_md_size,
+  };
+
+  /* the number of bytes of the entries above the current position
+   * in the stack before this access */
+  int64_t old_cum = 0;
+  /* the number of bytes of the entries above the current position
+   * in the stack after this access */
+  int64_t new_cum = 0;
+  for (int64_t i = 0; i < sim->stack_len; i++) {
+    belady_stack_entry_t *entry = &sim->stack[i];
+    old_cum += entry->weight;
+    if (entry->obj_id == req->obj_id) {
+      /* the carried object takes the slot of the accessed object */
+      *entry = carry;
+      return old_cum;
+    }
+
+    if (i == 0 || entry->next_access_vtime > carry.next_access_vtime) {
+      belady_stack_entry_t tmp = *entry;
+      *entry = carry;
+      carry = tmp;
+    }
+
+    new_cum += entry->weight;
+    if (new_cum > sim->max_cache_size) {
+      /* the rest of the stack cannot fit in any of the caches */
+      sim->stack_len = i;
+      return STACK_DIST_INF;
+    }
+  }
+
+  if (new_cum + carry.weight <= sim->max_cache_size) {
+    if (sim->stack_len == sim->stack_cap) {
+      sim->stack_cap = sim->stack_cap * 2 + 1024;
+      sim->stack = realloc(sim->stack, sizeof(belady_stack_entry_t) * sim->stack_cap);
+      ASSERT_NOT_NULL(sim->stack, "cannot allocate memory for the Belady stack\n");
+    }
+    sim->stack[sim->stack_len++] = carry;
+  }
+
+  return STACK_DIST_INF;
+}
+
+static inline int64_t _stack_access(stack_sim_t *sim, const request_t *req) {
+  if (sim->policy == STACK_POLICY_LRU) {
+    return _lru_stack_access(sim, req);
+  } else {
+    return _belady_stack_access(sim, req);
+  }
+}
+
+/**
+ * @brief fill the number of objects and bytes in each cache at the end
+ */
+static void _fill_final_cache_state(const stack_sim_t *sim, cache_stat_t *result, int num_of_sizes) {
+  int64_t cum = 0;
+  if (sim->policy == STACK_POLICY_LRU) {
+    for (int64_t ts = sim->curr_ts; ts > 0 && cum <= sim->max_cache_size; ts--) {
+      int64_t weight = sim->weight[ts];
+      if (weight == FENWICK_DEAD_WEIGHT) continue;
+      cum += weight;
+      for (int i = 0; i < num_of_sizes; i++) {
+        if (cum <= (int64_t)result[i].cache_size) {
+          result[i].n_obj += 1;
+          result[i].occupied_byte += weight;
+        }
+      }
+    }
+  } else {
+    for (int64_t i = 0; i < sim->stack_len; i++) {
+      cum += sim->stack[i].weight;
+      for (int j = 0; j < num_of_sizes; j++) {
+        if (cum <= (int64_t)result[j].cache_size) {
+          result[j].n_obj += 1;
+          result[j].occupied_byte += sim->stack[i].weight;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief simulate a stack policy at the given cache sizes in a single pass,
+ * the result is the same as simulate_at_multi_sizes, but the trace is read
+ * only once and the cost does not grow with the number of cache sizes
+ *
+ * LRU and Belady are supported, other policies (and caches with admission,
+ * prefetching or TTL) fall back to simulate_at_multi_sizes, the cost of
+ * Belady grows with the number of objects in the largest cache, and it is
+ * exact only if all objects have the same size (see the top of this file)
+ *
+ * note that the inclusion property only holds when object size does not
+ * change, the result is exact when all objects have the same size, with
+ * variable object size, the stack uses the latest size of each object while
+ * LRU.c keeps the size at insertion, and an eviction may free more space than
+ * needed, so the miss ratio may differ slightly (<1% on the test traces)
+ *
+ * @param reader
+ * @param cache
+ * @param num_of_sizes
+ * @param cache_sizes
+ * @param warmup_reader if not NULL, read from warmup_reader to warm up cache
+ * @param warmup_frac use warmup_frac of requests from reader to warm up cache
+ * @param warmup_sec uses warmup_sec seconds of requests to warm up cache
+ * @param num_of_threads only used when falling back to simulate_at_multi_sizes
+ * @param use_random_seed only used when falling back to simulate_at_multi_sizes
+ * @return an array of cache_stat_t, each corresponds to one cache size
+ */
+cache_stat_t *simulate_stack_policy_all_sizes(reader_t *reader, const cache_t *cache, int num_of_sizes,
+                                              const uint64_t *cache_sizes, reader_t *warmup_reader,
+                                              double warmup_frac, int warmup_sec, int num_of_threads,
+                                              bool use_random_seed) {
+  stack_sim_t sim;
+  memset(&sim, 0, sizeof(stack_sim_t));
+  sim.policy = _get_stack_policy(cache);
+  if (sim.policy == STACK_POLICY_UNSUPPORTED) {
+    INFO("%s is not a stack policy, simulate at each size\n", cache->cache_name);
+    return simulate_at_multi_sizes(reader, cache, num_of_sizes, cache_sizes, warmup_reader, warmup_frac, warmup_sec,
+                                   num_of_threads, use_random_seed);
+  }
+
+  cache_stat_t *result = my_malloc_n(cache_stat_t, num_of_sizes);
+  memset(result, 0, sizeof(cache_stat_t) * num_of_sizes);
+  for (int i = 0; i < num_of_sizes; i++) {
+    result[i].cache_size = cache_sizes[i];
+    strncpy(result[i].cache_name, cache->cache_name, CACHE_NAME_ARRAY_LEN);
+    if ((int64_t)cache_sizes[i] > sim.max_cache_size) {
+      sim.max_cache_size = (int64_t)cache_sizes[i];
+    }
+  }
+
+  sim.obj_md_size = cache->obj_md_size;
+  if (sim.policy == STACK_POLICY_LRU) {
+    _fenwick_alloc(&sim, FENWICK_INIT_SIZE);
+    memset(sim.fenwick, 0, sizeof(int64_t) * (sim.n_fenwick + 1));
+    sim.last_access = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, NULL);
+  }
+
+  request_t *req = new_request();
+  uint64_t n_warmup_req = 0;
+
+  /* warm up using warmup_reader */
+  if (warmup_reader != NULL) {
+    reader_t *warmup_cloned_reader = clone_reader(warmup_reader);
+    read_one_req(warmup_cloned_reader, req);
+    while (req->valid) {
+      _stack_access(&sim, req);
+      n_warmup_req += 1;
+      read_one_req(warmup_cloned_reader, req);
+    }
+    close_reader(warmup_cloned_reader);
+  }
+
+  reader_t *cloned_reader = clone_reader(reader);
+  read_one_req(cloned_reader, req);
+  int64_t start_ts = (int64_t)req->clock_time;
+
+  /* using warmup_frac or warmup_sec of requests from reader to warm up */
+  uint64_t n_warmup_frac_req = (uint64_t)((double)get_num_of_req(reader) * warmup_frac);
+  if (n_warmup_frac_req > 0 || warmup_sec > 0) {
+    uint64_t n_warmup = 0;
+    while (req->valid && (n_warmup < n_warmup_frac_req || req->clock_time - start_ts < warmup_sec)) {
+      _stack_access(&sim, req);
+      n_warmup += 1;
+      read_one_req(cloned_reader, req);
+    }
+    n_warmup_req += n_warmup;
+  }
+
+  uint64_t n_req = 0, n_req_byte = 0;
+  while (req->valid) {
+    n_req += 1;
+    n_req_byte += req->obj_size;
+
+    int64_t dist = _stack_access(&sim, req);
+    for (int i = 0; i < num_of_sizes; i++) {
+      if (dist > (int64_t)cache_sizes[i]) {
+        result[i].n_miss += 1;
+        result[i].n_miss_byte += req->obj_size;
+      }
+    }
+    read_one_req(cloned_reader, req);
+  }
+
+  for (int i = 0; i < num_of_sizes; i++) {
+    result[i].n_warmup_req = n_warmup_req;
+    result[i].n_req = n_req;
+    result[i].n_req_byte = n_req_byte;
+    result[i].curr_rtime = req->clock_time - start_ts;
+  }
+  _fill_final_cache_state(&sim, result, num_of_sizes);
+
+  INFO("%s finishes simulating %d cache sizes in one pass, %" PRIu64 " requests\n", cache->cache_name, num_of_sizes,
+       n_req);
+
+  free_request(req);
+  close_reader(cloned_reader);
+  if (sim.policy == STACK_POLICY_LRU) {
+    _fenwick_free(&sim);
+    g_hash_table_destroy(sim.last_access);
+  } else {
+    free(sim.stack);
+  }
+
+  return result;
+}
+
+#ifdef __cplusplus
+}
+#endif
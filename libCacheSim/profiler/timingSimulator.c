@@ -0,0 +1,409 @@
+//
+//  timingSimulator.c
+//  libCacheSim
+//
+//  replay a trace and time each request using a timing model,
+//  see timingModel.h
+//
+//  because the requests arrive in the order of the trace and each server is
+//  FCFS, the start and the end of a request are known when it arrives, so
+//  no event queue is needed, each server only keeps when its channels
+//  become free in a min-heap
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../include/libCacheSim/timingModel.h"
+
+#include <math.h>
+
+#include "../utils/include/mymath.h"
+
+#define SUB_BUCKET_BITS LATENCY_HIST_SUB_BUCKET_BITS
+#define N_SUB_BUCKET (1LL << SUB_BUCKET_BITS)
+
+typedef struct {
+  const service_model_t *model;
+  int n_channel;
+  double *free_us;  // min-heap of the time each channel becomes free
+} server_t;
+
+typedef struct {
+  cache_t *cache;
+  cache_get_func_ptr get;
+  const timing_model_t *model;
+  timing_stat_t *stat;
+  server_t servers[TIMING_MAX_TIER + 1];
+  /* the time of looking up the tiers before tier i */
+  double lookup_us[TIMING_MAX_TIER + 1];
+  int64_t n_bw_window_allocated;
+} timing_sim_t;
+
+double linear_service_time(const service_model_t *model, const request_t *req) {
+  if (model->bandwidth_MBps <= 0) {
+    return model->latency_us;
+  }
+  return model->latency_us + (double)req->obj_size / model->bandwidth_MBps;
+}
+
+timing_model_t default_timing_model(void) {
+  timing_model_t model;
+  memset(&model, 0, sizeof(timing_model_t));
+  model.n_tier = 1;
+  model.tier[0] = linear_service_model(1, 10000, 0);
+  model.backend = linear_service_model(1000, 200, 16);
+  model.served_tier = NULL;
+  model.ts_unit_us = 1000000;
+  model.spread_arrival = true;
+  model.bw_window_us = 1000000;
+  return model;
+}
+
+static int _split_tier_values(char *value, char *fields[]) {
+  int n_field = 0;
+  while (value != NULL && n_field < TIMING_MAX_TIER) {
+    fields[n_field++] = strsep(&value, ":");
+  }
+  if (value != NULL) {
+    ERROR("timing model supports at most %d tiers\n", TIMING_MAX_TIER);
+  }
+  return n_field;
+}
+
+void parse_timing_model_params(timing_model_t *model, const char *params) {
+  char *params_str = strdup(params);
+  char *old_params_str = params_str;
+  char *fields[TIMING_MAX_TIER];
+  int n_tier_set = -1;
+
+  while (params_str != NULL && params_str[0] != '\0') {
+    /* different parameters are separated by comma,
+     * key and value are separated by = */
+    char *key = strsep((char **)&params_str, "=");
+    char *value = strsep((char **)&params_str, ",");
+
+    // skip the white space
+    while (params_str != NULL && *params_str == ' ') {
+      params_str++;
+    }
+
+    if (value == NULL) {
+      ERROR("timing model parameter %s has no value\n", key);
+    }
+
+    if (strncasecmp(key, "tier-", 5) == 0) {
+      int n_field = _split_tier_values(value, fields);
+      if (n_tier_set != -1 && n_tier_set != n_field) {
+        ERROR("%s has %d tiers, other tier parameters have %d\n", key,
+              n_field, n_tier_set);
+      }
+      for (int i = n_tier_set == -1 ? 0 : n_tier_set; i < n_field; i++) {
+        model->tier[i] = model->tier[0];
+      }
+      n_tier_set = n_field;
+      model->n_tier = n_field;
+      for (int i = 0; i < n_field; i++) {
+        if (strcasecmp(key, "tier-latency") == 0) {
+          model->tier[i].latency_us = strtod(fields[i], NULL);
+        } else if (strcasecmp(key, "tier-bw") == 0) {
+          model->tier[i].bandwidth_MBps = strtod(fields[i], NULL);
+        } else if (strcasecmp(key, "tier-channel") == 0) {
+          model->tier[i].n_channel = (int)strtol(fields[i], NULL, 0);
+        } else {
+          ERROR("timing model does not have parameter %s\n", key);
+        }
+      }
+    } else if (strcasecmp(key, "backend-latency") == 0) {
+      model->backend.latency_us = strtod(value, NULL);
+    } else if (strcasecmp(key, "backend-bw") == 0) {
+      model->backend.bandwidth_MBps = strtod(value, NULL);
+    } else if (strcasecmp(key, "backend-channel") == 0) {
+      model->backend.n_channel = (int)strtol(value, NULL, 0);
+    } else if (strcasecmp(key, "ts-unit") == 0) {
+      model->ts_unit_us = strtod(value, NULL);
+    } else if (strcasecmp(key, "spread-arrival") == 0) {
+      model->spread_arrival =
+          strcasecmp(value, "true") == 0 || strcmp(value, "1") == 0;
+    } else if (strcasecmp(key, "bw-window") == 0) {
+      model->bw_window_us = strtoll(value, NULL, 0);
+    } else {
+      ERROR("timing model does not have parameter %s\n", key);
+    }
+  }
+
+  if (model->bw_window_us <= 0) {
+    ERROR("bw-window must be positive\n");
+  }
+
+  free(old_params_str);
+}
+
+// ***********************************************************************
+// ****                                                               ****
+// ****                      latency histogram                        ****
+// ****                                                               ****
+// ***********************************************************************
+/* values below N_SUB_BUCKET have one bucket each, the values in
+ * [2^h, 2^(h+1)) share N_SUB_BUCKET buckets of width 2^(h-SUB_BUCKET_BITS) */
+static inline int64_t _latency_hist_idx(int64_t v) {
+  if (v < N_SUB_BUCKET) {
+    return v;
+  }
+  int shift = 63 - __builtin_clzll((unsigned long long)v) - SUB_BUCKET_BITS;
+  return ((int64_t)(shift + 1) << SUB_BUCKET_BITS) + (v >> shift) -
+         N_SUB_BUCKET;
+}
+
+/* the middle of the bucket */
+static inline int64_t _latency_hist_value(int64_t idx) {
+  if (idx < N_SUB_BUCKET) {
+    return idx;
+  }
+  int shift = (int)(idx >> SUB_BUCKET_BITS) - 1;
+  int64_t lower = ((idx & (N_SUB_BUCKET - 1)) + N_SUB_BUCKET) << shift;
+  return lower + ((1LL << shift) >> 1);
+}
+
+void latency_hist_record(latency_hist_t *hist, int64_t latency_ns) {
+  if (latency_ns < 0) {
+    latency_ns = 0;
+  }
+  if (hist->n == 0 || latency_ns < hist->min_ns) {
+    hist->min_ns = latency_ns;
+  }
+  if (latency_ns > hist->max_ns) {
+    hist->max_ns = latency_ns;
+  }
+  hist->n += 1;
+  hist->sum_ns += (double)latency_ns;
+  hist->cnt[_latency_hist_idx(latency_ns)] += 1;
+}
+
+double latency_hist_percentile(const latency_hist_t *hist, double percentile) {
+  if (hist->n == 0) {
+    return 0;
+  }
+
+  int64_t rank = (int64_t)ceil(percentile / 100.0 * (double)hist->n);
+  if (rank < 1) {
+    rank = 1;
+  }
+
+  int64_t n_seen = 0, value = hist->max_ns;
+  for (int64_t i = 0; i < LATENCY_HIST_N_BUCKET; i++) {
+    n_seen += hist->cnt[i];
+    if (n_seen >= rank) {
+      value = _latency_hist_value(i);
+      break;
+    }
+  }
+  value = MAX(value, hist->min_ns);
+  value = MIN(value, hist->max_ns);
+
+  return (double)value / 1000.0;
+}
+
+// ***********************************************************************
+// ****                                                               ****
+// ****                       timing simulation                       ****
+// ****                                                               ****
+// ***********************************************************************
+static void _server_init(server_t *server, const service_model_t *model) {
+  if (model->service_time == NULL) {
+    ERROR("the service model does not have a service_time function\n");
+  }
+  server->model = model;
+  server->n_channel = model->n_channel > 0 ? model->n_channel : 0;
+  server->free_us = NULL;
+  if (server->n_channel > 0) {
+    server->free_us = malloc(sizeof(double) * server->n_channel);
+    memset(server->free_us, 0, sizeof(double) * server->n_channel);
+  }
+}
+
+/**
+ * @brief serve the request on the channel that becomes free first
+ *
+ * @param server
+ * @param arrival_us
+ * @param req
+ * @param start_us when the service starts
+ * @return when the service ends
+ */
+static double _server_serve(server_t *server, double arrival_us,
+                            const request_t *req, double *start_us) {
+  double service_us = server->model->service_time(server->model, req);
+  if (server->n_channel == 0) {
+    *start_us = arrival_us;
+    return arrival_us + service_us;
+  }
+
+  double *heap = server->free_us;
+  *start_us = MAX(arrival_us, heap[0]);
+  double end_us = *start_us + service_us;
+
+  /* replace the root and sift down */
+  int pos = 0;
+  while (true) {
+    int child = pos * 2 + 1;
+    if (child >= server->n_channel) break;
+    if (child + 1 < server->n_channel && heap[child + 1] < heap[child]) {
+      child += 1;
+    }
+    if (heap[child] >= end_us) break;
+    heap[pos] = heap[child];
+    pos = child;
+  }
+  heap[pos] = end_us;
+
+  return end_us;
+}
+
+static void _record_backend_byte(timing_sim_t *sim, double start_us,
+                                 int64_t obj_size) {
+  timing_stat_t *stat = sim->stat;
+  int64_t window = (int64_t)(start_us / (double)stat->bw_window_us);
+  if (window >= sim->n_bw_window_allocated) {
+    int64_t n_allocated = MAX(sim->n_bw_window_allocated * 2, window + 1);
+    stat->backend_byte =
+        realloc(stat->backend_byte, sizeof(int64_t) * n_allocated);
+    memset(stat->backend_byte + sim->n_bw_window_allocated, 0,
+           sizeof(int64_t) * (n_allocated - sim->n_bw_window_allocated));
+    sim->n_bw_window_allocated = n_allocated;
+  }
+  stat->backend_byte[window] += obj_size;
+  stat->n_bw_window = MAX(stat->n_bw_window, window + 1);
+}
+
+static void _time_one_req(timing_sim_t *sim, const request_t *req,
+                          double arrival_us) {
+  const timing_model_t *model = sim->model;
+  timing_stat_t *stat = sim->stat;
+
+  bool hit = sim->get(sim->cache, req);
+  int tier = model->n_tier;
+  if (hit) {
+    tier = model->served_tier == NULL
+               ? 0
+               : model->served_tier(sim->cache, req, hit);
+    if (tier < 0 || tier >= model->n_tier) {
+      ERROR("a hit is served by tier %d, the timing model has %d tiers\n",
+            tier, model->n_tier);
+    }
+  }
+
+  double arrival_at_server_us = arrival_us + sim->lookup_us[tier];
+  double start_us;
+  double end_us =
+      _server_serve(&sim->servers[tier], arrival_at_server_us, req, &start_us);
+
+  int64_t latency_ns = llround((end_us - arrival_us) * 1000.0);
+  latency_hist_record(&stat->latency, latency_ns);
+  latency_hist_record(&stat->tier_latency[tier], latency_ns);
+  stat->n_served[tier] += 1;
+  stat->queueing_us[tier] += start_us - arrival_at_server_us;
+  stat->end_us = MAX(stat->end_us, end_us);
+
+  stat->n_req += 1;
+  stat->n_req_byte += req->obj_size;
+  if (!hit) {
+    stat->n_miss += 1;
+    stat->n_miss_byte += req->obj_size;
+    _record_backend_byte(sim, start_us, req->obj_size);
+  }
+}
+
+/* time the requests that have the same timestamp */
+static void _time_req_batch(timing_sim_t *sim, const request_t *reqs,
+                            int64_t n_req, double ts_us) {
+  double interval_us = 0;
+  if (sim->model->spread_arrival) {
+    interval_us = sim->model->ts_unit_us / (double)n_req;
+  }
+  for (int64_t i = 0; i < n_req; i++) {
+    _time_one_req(sim, &reqs[i], ts_us + interval_us * (double)i);
+  }
+}
+
+timing_stat_t *simulate_with_timing(reader_t *reader, cache_t *cache,
+                                    const timing_model_t *model) {
+  if (model->n_tier < 1 || model->n_tier > TIMING_MAX_TIER) {
+    ERROR("the timing model needs 1 to %d tiers, got %d\n", TIMING_MAX_TIER,
+          model->n_tier);
+  }
+  if (model->bw_window_us <= 0) {
+    ERROR("the timing model needs a positive bw_window_us\n");
+  }
+
+  timing_stat_t *stat = my_malloc(timing_stat_t);
+  memset(stat, 0, sizeof(timing_stat_t));
+  stat->n_tier = model->n_tier;
+  stat->bw_window_us = model->bw_window_us;
+  stat->cache_size = cache->cache_size;
+  strncpy(stat->cache_name, cache->cache_name, CACHE_NAME_ARRAY_LEN);
+
+  timing_sim_t sim;
+  memset(&sim, 0, sizeof(timing_sim_t));
+  sim.cache = cache;
+  sim.get = cache_get_func(cache);
+  sim.model = model;
+  sim.stat = stat;
+  for (int i = 0; i < model->n_tier; i++) {
+    _server_init(&sim.servers[i], &model->tier[i]);
+    sim.lookup_us[i + 1] = sim.lookup_us[i] + model->tier[i].latency_us;
+  }
+  _server_init(&sim.servers[model->n_tier], &model->backend);
+
+  INFO("%s starts computation %s, please wait\n", __func__, cache->cache_name);
+
+  /* the requests that have the same timestamp, they are buffered to know
+   * how many requests arrive in the time unit */
+  int64_t n_batch_allocated = 1024, n_batch = 0;
+  request_t *batch = malloc(sizeof(request_t) * n_batch_allocated);
+  int64_t start_ts = 0, batch_ts = 0;
+
+  reset_reader(reader);
+  request_t *req = new_request();
+  read_one_req(reader, req);
+  start_ts = req->clock_time;
+  batch_ts = start_ts;
+  while (req->valid) {
+    if (req->clock_time != batch_ts) {
+      _time_req_batch(&sim, batch, n_batch,
+                      (double)(batch_ts - start_ts) * model->ts_unit_us);
+      n_batch = 0;
+      batch_ts = req->clock_time;
+    }
+    if (n_batch == n_batch_allocated) {
+      n_batch_allocated *= 2;
+      batch = realloc(batch, sizeof(request_t) * n_batch_allocated);
+    }
+    batch[n_batch++] = *req;
+    read_one_req(reader, req);
+  }
+  if (n_batch > 0) {
+    _time_req_batch(&sim, batch, n_batch,
+                    (double)(batch_ts - start_ts) * model->ts_unit_us);
+  }
+  reset_reader(reader);
+
+  free(batch);
+  free_request(req);
+  for (int i = 0; i <= model->n_tier; i++) {
+    free(sim.servers[i].free_us);
+  }
+
+  // user is responsible for free-ing the result
+  return stat;
+}
+
+void free_timing_stat(timing_stat_t *stat) {
+  free(stat->backend_byte);
+  my_free(sizeof(timing_stat_t), stat);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,236 @@
+//
+//  requestSink.c
+//  libCacheSim
+//
+//  write a stream of requests to a trace file, see requestSink.h
+//
+
+#include "../include/libCacheSim/requestSink.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef SUPPORT_ZSTD_TRACE
+#include <zstd.h>
+#endif
+
+#include "../include/libCacheSim/logging.h"
+#include "customizedReader/lcs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SINK_ZSTD_LEVEL 3
+/* a CSV line has at most 3 64-bit integers and 3 delimiters */
+#define CSV_LINE_MAX_LEN 64
+
+static void _write_to_file(request_sink_t *sink, const void *data,
+                           size_t n_byte) {
+  if (fwrite(data, 1, n_byte, sink->ofile) != n_byte) {
+    ERROR("cannot write to %s %s\n", sink->ofilepath, strerror(errno));
+  }
+}
+
+#ifdef SUPPORT_ZSTD_TRACE
+static void _compress_and_write(request_sink_t *sink, const void *data,
+                                size_t n_byte, ZSTD_EndDirective mode) {
+  ZSTD_inBuffer input = {data, n_byte, 0};
+  bool finished = false;
+  while (!finished) {
+    ZSTD_outBuffer output = {sink->zstd_buf, sink->zstd_buf_size, 0};
+    size_t remaining = ZSTD_compressStream2((ZSTD_CCtx *)sink->zstd_cctx,
+                                            &output, &input, mode);
+    if (ZSTD_isError(remaining)) {
+      ERROR("zstd compression error %s\n", ZSTD_getErrorName(remaining));
+    }
+    _write_to_file(sink, sink->zstd_buf, output.pos);
+    /* continue: all input is consumed, end: the frame is complete */
+    finished = mode == ZSTD_e_end ? remaining == 0 : input.pos == input.size;
+  }
+}
+#endif
+
+void request_sink_flush(request_sink_t *sink) {
+  if (sink->buf_pos == 0) {
+    return;
+  }
+
+  if (sink->compress) {
+#ifdef SUPPORT_ZSTD_TRACE
+    _compress_and_write(sink, sink->buf, sink->buf_pos, ZSTD_e_continue);
+#endif
+  } else {
+    _write_to_file(sink, sink->buf, sink->buf_pos);
+  }
+  sink->buf_pos = 0;
+}
+
+static inline char *_ensure_space(request_sink_t *sink, size_t n_byte) {
+  if (sink->buf_pos + n_byte > REQUEST_SINK_BUF_SIZE) {
+    request_sink_flush(sink);
+  }
+  return sink->buf + sink->buf_pos;
+}
+
+/* snprintf is too slow to write one line per request */
+static inline int _write_uint64(char *dst, uint64_t u) {
+  char tmp[24];
+  int n = 0, len = 0;
+  do {
+    tmp[n++] = (char)('0' + u % 10);
+    u /= 10;
+  } while (u != 0);
+  while (n > 0) {
+    dst[len++] = tmp[--n];
+  }
+  return len;
+}
+
+static inline int _write_int64(char *dst, int64_t v) {
+  if (v < 0) {
+    dst[0] = '-';
+    return 1 + _write_uint64(dst + 1, -(uint64_t)v);
+  }
+  return _write_uint64(dst, (uint64_t)v);
+}
+
+static void _fill_lcs_header(const request_sink_t *sink,
+                             lcs_trace_header_t *header) {
+  memset(header, 0, sizeof(lcs_trace_header_t));
+  header->start_magic = LCS_TRACE_START_MAGIC;
+  header->end_magic = LCS_TRACE_END_MAGIC;
+  header->version = 2;
+
+  lcs_trace_stat_t *stat = &header->stat;
+  stat->version = CURR_STAT_VERSION;
+  stat->n_req = sink->n_req;
+  stat->n_req_byte = sink->n_req_byte;
+  stat->start_timestamp = sink->start_timestamp;
+  stat->end_timestamp = sink->end_timestamp;
+  stat->n_read = sink->n_read;
+  stat->n_write = sink->n_write;
+  stat->n_delete = sink->n_delete;
+  stat->smallest_obj_size = sink->smallest_obj_size;
+  stat->largest_obj_size = sink->largest_obj_size;
+}
+
+request_sink_t *open_request_sink(const char *ofilepath, trace_type_e format) {
+  if (format != ORACLE_GENERAL_TRACE && format != LCS_TRACE &&
+      format != CSV_TRACE) {
+    ERROR("request sink does not support trace type %s\n",
+          g_trace_type_name[format]);
+  }
+
+  request_sink_t *sink = malloc(sizeof(request_sink_t));
+  memset(sink, 0, sizeof(request_sink_t));
+  sink->ofilepath = strdup(ofilepath);
+  sink->format = format;
+  sink->ofile = fopen(ofilepath, "wb");
+  if (sink->ofile == NULL) {
+    ERROR("cannot open %s %s\n", ofilepath, strerror(errno));
+  }
+  sink->buf = malloc(REQUEST_SINK_BUF_SIZE);
+
+  size_t slen = strlen(ofilepath);
+  sink->compress = slen > 4 && strcmp(ofilepath + slen - 4, ".zst") == 0;
+  if (sink->compress) {
+#ifdef SUPPORT_ZSTD_TRACE
+    ZSTD_CCtx *cctx = ZSTD_createCCtx();
+    ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, SINK_ZSTD_LEVEL);
+    sink->zstd_cctx = cctx;
+    sink->zstd_buf_size = ZSTD_CStreamOutSize();
+    sink->zstd_buf = malloc(sink->zstd_buf_size);
+#else
+    ERROR("cannot write %s, libCacheSim is built without zstd\n", ofilepath);
+#endif
+  }
+
+  if (format == LCS_TRACE) {
+    /* the stat is updated when the sink is closed */
+    lcs_trace_header_t *header = (lcs_trace_header_t *)sink->buf;
+    _fill_lcs_header(sink, header);
+    sink->buf_pos = sizeof(lcs_trace_header_t);
+  }
+
+  return sink;
+}
+
+void request_sink_write(request_sink_t *sink, const request_t *req) {
+  if (sink->n_req == 0) {
+    sink->start_timestamp = req->clock_time;
+    sink->smallest_obj_size = req->obj_size;
+  }
+  sink->n_req += 1;
+  sink->n_req_byte += req->obj_size;
+  sink->end_timestamp = req->clock_time;
+  if (req->obj_size < sink->smallest_obj_size) {
+    sink->smallest_obj_size = req->obj_size;
+  }
+  if (req->obj_size > sink->largest_obj_size) {
+    sink->largest_obj_size = req->obj_size;
+  }
+  if (req->op == OP_GET || req->op == OP_GETS || req->op == OP_READ) {
+    sink->n_read += 1;
+  } else if (req->op == OP_DELETE) {
+    sink->n_delete += 1;
+  } else if (req->op != OP_NOP && req->op != OP_INVALID) {
+    sink->n_write += 1;
+  }
+
+  if (sink->format == ORACLE_GENERAL_TRACE) {
+    lcs_req_v1_t *rec =
+        (lcs_req_v1_t *)_ensure_space(sink, sizeof(lcs_req_v1_t));
+    rec->clock_time = (uint32_t)req->clock_time;
+    rec->obj_id = req->obj_id;
+    rec->obj_size = (uint32_t)req->obj_size;
+    rec->next_access_vtime = -2;
+    sink->buf_pos += sizeof(lcs_req_v1_t);
+  } else if (sink->format == LCS_TRACE) {
+    lcs_req_v2_t *rec =
+        (lcs_req_v2_t *)_ensure_space(sink, sizeof(lcs_req_v2_t));
+    rec->clock_time = (uint32_t)req->clock_time;
+    rec->obj_id = req->obj_id;
+    rec->obj_size = (uint32_t)req->obj_size;
+    rec->op = req->op;
+    rec->tenant = req->tenant_id;
+    rec->next_access_vtime = -2;
+    sink->buf_pos += sizeof(lcs_req_v2_t);
+  } else {
+    char *line = _ensure_space(sink, CSV_LINE_MAX_LEN);
+    int len = _write_int64(line, req->clock_time);
+    line[len++] = ',';
+    len += _write_uint64(line + len, req->obj_id);
+    line[len++] = ',';
+    len += _write_int64(line + len, req->obj_size);
+    line[len++] = '\n';
+    sink->buf_pos += len;
+  }
+}
+
+void close_request_sink(request_sink_t *sink) {
+  request_sink_flush(sink);
+
+  if (sink->compress) {
+#ifdef SUPPORT_ZSTD_TRACE
+    _compress_and_write(sink, NULL, 0, ZSTD_e_end);
+    ZSTD_freeCCtx((ZSTD_CCtx *)sink->zstd_cctx);
+    free(sink->zstd_buf);
+#endif
+  } else if (sink->format == LCS_TRACE) {
+    lcs_trace_header_t header;
+    _fill_lcs_header(sink, &header);
+    fseek(sink->ofile, 0, SEEK_SET);
+    _write_to_file(sink, &header, sizeof(lcs_trace_header_t));
+  }
+
+  fclose(sink->ofile);
+  free(sink->buf);
+  free(sink->ofilepath);
+  free(sink);
+}
+
+#ifdef __cplusplus
+}
+#endif
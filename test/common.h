@@ -80,6 +80,16 @@ static reader_t *setup_oracleGeneralBin_reader(void) {
   return reader_oracle;
 }
 
+static reader_t *setup_oracleGeneralBin_reader_with_ignored_obj_size(void) {
+  char data_path[1024];
+  reader_init_param_t *init_params = g_new0(reader_init_param_t, 1);
+  init_params->ignore_obj_size = true;
+  _detect_data_path(data_path, "cloudPhysicsIO.oracleGeneral.bin");
+  reader_t *reader_oracle = setup_reader(data_path, ORACLE_GENERAL_TRACE, init_params);
+  g_free(init_params);
+  return reader_oracle;
+}
+
 static reader_t *setup_GLCacheTestData_reader(void) {
   char *url =
       "https://ftp.pdl.cmu.edu/pub/datasets/twemcacheWorkload/"
@@ -204,6 +214,8 @@ static cache_t *create_test_cache(const char *alg_name, common_cache_params_t cc
     cache = FIFO_init(cc_params, NULL);
   } else if (strcasecmp(alg_name, "FIFO-Reinsertion") == 0 || strcasecmp(alg_name, "Clock") == 0) {
     cache = Clock_init(cc_params, NULL);
+  } else if (strcasecmp(alg_name, "ClockArray") == 0) {
+    cache = ClockArray_init(cc_params, NULL);
   } else if (strcasecmp(alg_name, "Belady") == 0) {
     cache = Belady_init(cc_params, NULL);
   } else if (strcasecmp(alg_name, "BeladySize") == 0) {
@@ -268,6 +280,8 @@ static cache_t *create_test_cache(const char *alg_name, common_cache_params_t cc
     cache = SR_LRU_init(cc_params, NULL);
   } else if (strcasecmp(alg_name, "CR_LFU") == 0) {
     cache = CR_LFU_init(cc_params, NULL);
+  } else if (strcasecmp(alg_name, "TwoQ") == 0) {
+    cache = TwoQ_init(cc_params, NULL);
   } else if (strcasecmp(alg_name, "SLRU") == 0) {
     cache = SLRU_init(cc_params, "n-seg=5");
   } else if (strcasecmp(alg_name, "LIRS") == 0) {
@@ -280,6 +294,14 @@ static cache_t *create_test_cache(const char *alg_name, common_cache_params_t cc
     cache = S3FIFO_init(cc_params, "move-to-main-threshold=2");
   } else if (strcasecmp(alg_name, "Sieve") == 0) {
     cache = Sieve_init(cc_params, NULL);
+  } else if (strcasecmp(alg_name, "SieveArray") == 0) {
+    cache = SieveArray_init(cc_params, NULL);
+  } else if (strcasecmp(alg_name, "tiered-LRU-flashRegion") == 0) {
+    cache = tiered_init(cc_params, "tiers=LRU:flashRegion,tier-size-ratio=0.2:0.8");
+  } else if (strcasecmp(alg_name, "flashRegion-FIFO") == 0) {
+    cache = flashRegion_init(cc_params, "region-size=16777216,region-evict=fifo");
+  } else if (strcasecmp(alg_name, "flashRegion-RRIP") == 0) {
+    cache = flashRegion_init(cc_params, "region-size=16777216,region-evict=rrip");
   } else if (strcasecmp(alg_name, "Mithril") == 0) {
     cache = LRU_init(cc_params, NULL);
     cache->prefetcher = create_prefetcher("Mithril", NULL, cc_params.cache_size);
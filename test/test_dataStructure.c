@@ -2,8 +2,12 @@
 // Created by Juncheng Yang on 11/24/24.
 //
 
+#include "../libCacheSim/dataStructure/dheap.h"
+#include "../libCacheSim/dataStructure/fingerprintGhost.h"
 #include "../libCacheSim/dataStructure/hashtable/chainedHashTableV2.h"
+#include "../libCacheSim/dataStructure/hashtable/concurrentHashTable.h"
 #include "../libCacheSim/dataStructure/hashtable/hashtable.h"
+#include "../libCacheSim/utils/include/mysys.h"
 #include "common.h"
 
 void test_chained_hashtable_v2(gconstpointer user_data) {
@@ -29,12 +33,311 @@ void test_chained_hashtable_v2(gconstpointer user_data) {
   // printf("random object %lu\n", obj->obj_id);
 }
 
+void test_concurrent_hashtable(gconstpointer user_data) {
+  hashtable_t *hashtable = create_concurrent_hashtable(4);
+  request_t *req = new_request();
+  for (int i = 0; i < 256; i++) {
+    req->obj_id = i;
+    req->obj_size = i + 1;
+    cache_obj_t *obj = concurrent_hashtable_insert(hashtable, req);
+    g_assert_cmpint(obj->obj_id, ==, i);
+  }
+  g_assert_cmpint(hashtable->n_obj, ==, 256);
+
+  /* inserting an existing object returns the object in the hash table */
+  req->obj_id = 8;
+  req->obj_size = 1000;
+  cache_obj_t *obj = concurrent_hashtable_insert(hashtable, req);
+  g_assert_cmpint(obj->obj_size, ==, 9);
+  g_assert_cmpint(hashtable->n_obj, ==, 256);
+
+  for (int i = 0; i < 256; i += 2) {
+    g_assert_true(concurrent_hashtable_delete_obj_id(hashtable, i));
+  }
+  g_assert_false(concurrent_hashtable_delete_obj_id(hashtable, 0));
+  g_assert_cmpint(hashtable->n_obj, ==, 128);
+
+  for (int i = 0; i < 256; i++) {
+    obj = concurrent_hashtable_find_obj_id(hashtable, i);
+    if (i % 2 == 0) {
+      g_assert_null(obj);
+    } else {
+      g_assert_nonnull(obj);
+      g_assert_cmpint(obj->obj_size, ==, i + 1);
+    }
+  }
+
+  obj = concurrent_hashtable_find_obj_id(hashtable, 255);
+  g_assert_true(concurrent_hashtable_try_delete(hashtable, obj));
+  g_assert_cmpint(hashtable->n_obj, ==, 127);
+
+  for (int i = 0; i < 100; i++) {
+    obj = concurrent_hashtable_rand_obj(hashtable);
+    g_assert_cmpint(obj->obj_id % 2, ==, 1);
+  }
+
+  free_request(req);
+  free_concurrent_hashtable(hashtable);
+}
+
+typedef struct {
+  hashtable_t *hashtable;
+  int64_t n_op;
+  int64_t n_key;
+  int thread_id;
+  /* the fraction of find, the rest is split between insert and delete */
+  double find_ratio;
+  int64_t n_error;
+} concurrent_hashtable_worker_t;
+
+static gpointer _concurrent_hashtable_worker(gpointer data) {
+  concurrent_hashtable_worker_t *worker = data;
+  hashtable_t *hashtable = worker->hashtable;
+  request_t *req = new_request();
+  uint64_t rand_state = worker->thread_id * 2654435761ULL + 1;
+  uint32_t find_threshold = (uint32_t)(worker->find_ratio * 1000);
+
+  for (int64_t i = 0; i < worker->n_op; i++) {
+    rand_state = rand_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    uint64_t r = rand_state >> 33;
+    obj_id_t obj_id = r % worker->n_key;
+    uint32_t op = (r >> 16) % 1000;
+
+    if (op < find_threshold) {
+      cache_obj_t *obj = concurrent_hashtable_find_obj_id(hashtable, obj_id);
+      /* the object size is set from the id, a freed object breaks this */
+      if (obj != NULL && (obj->obj_id != obj_id || obj->obj_size != obj_id + 1))
+        worker->n_error += 1;
+    } else if (op % 2 == 0) {
+      req->obj_id = obj_id;
+      req->obj_size = obj_id + 1;
+      cache_obj_t *obj = concurrent_hashtable_insert(hashtable, req);
+      if (obj->obj_id != obj_id) worker->n_error += 1;
+    } else {
+      concurrent_hashtable_delete_obj_id(hashtable, obj_id);
+    }
+  }
+
+  concurrent_hashtable_quiesce(hashtable);
+  free_request(req);
+  return NULL;
+}
+
+static void _count_obj(cache_obj_t *cache_obj, void *user_data) {
+  int64_t *counts = user_data;
+  counts[cache_obj->obj_id] += 1;
+}
+
+/**
+ * run n_thread workers on one hash table
+ * @return the elapsed time in seconds
+ */
+static double _run_concurrent_hashtable_workers(hashtable_t *hashtable,
+                                                int n_thread, int64_t n_op,
+                                                int64_t n_key,
+                                                double find_ratio,
+                                                int64_t *n_error) {
+  concurrent_hashtable_worker_t *workers =
+      g_new0(concurrent_hashtable_worker_t, n_thread);
+  GThread **threads = g_new0(GThread *, n_thread);
+
+  double start = gettime();
+  for (int i = 0; i < n_thread; i++) {
+    workers[i].hashtable = hashtable;
+    workers[i].n_op = n_op;
+    workers[i].n_key = n_key;
+    workers[i].thread_id = i;
+    workers[i].find_ratio = find_ratio;
+    threads[i] = g_thread_new("worker", _concurrent_hashtable_worker, &workers[i]);
+  }
+  *n_error = 0;
+  for (int i = 0; i < n_thread; i++) {
+    g_thread_join(threads[i]);
+    *n_error += workers[i].n_error;
+  }
+  double elapsed = gettime() - start;
+
+  g_free(threads);
+  g_free(workers);
+  return elapsed;
+}
+
+void test_concurrent_hashtable_stress(gconstpointer user_data) {
+  const int64_t n_key = 1024;
+  /* a small table so that the chains are long and threads collide */
+  hashtable_t *hashtable = create_concurrent_hashtable(6);
+
+  int64_t n_error;
+  _run_concurrent_hashtable_workers(hashtable, 8, 200000, n_key, 0.5, &n_error);
+  g_assert_cmpint(n_error, ==, 0);
+
+  /* every object is in the hash table once, and n_obj counts them */
+  int64_t *counts = g_new0(int64_t, n_key);
+  concurrent_hashtable_foreach(hashtable, _count_obj, counts);
+  int64_t n_obj = 0;
+  for (int64_t i = 0; i < n_key; i++) {
+    g_assert_cmpint(counts[i], <=, 1);
+    n_obj += counts[i];
+    g_assert_true((counts[i] == 1) ==
+                  (concurrent_hashtable_find_obj_id(hashtable, i) != NULL));
+  }
+  g_assert_cmpint(n_obj, ==, hashtable->n_obj);
+
+  g_free(counts);
+  free_concurrent_hashtable(hashtable);
+}
+
+/* the throughput with 1 to 64 threads, run with -m perf */
+void test_concurrent_hashtable_scaling(gconstpointer user_data) {
+  const int64_t n_key = 1000000;
+  const int64_t n_op = 2000000;
+
+  for (int n_thread = 1; n_thread <= 64; n_thread *= 2) {
+    hashtable_t *hashtable = create_concurrent_hashtable(20);
+    int64_t n_error;
+    /* insert and delete to fill part of the hash table */
+    _run_concurrent_hashtable_workers(hashtable, 1, n_key, n_key, 0, &n_error);
+    double elapsed = _run_concurrent_hashtable_workers(
+        hashtable, n_thread, n_op / n_thread, n_key, 0.9, &n_error);
+    g_assert_cmpint(n_error, ==, 0);
+    g_test_minimized_result(elapsed, "%d threads %.2lf MQPS", n_thread,
+                            (double)n_op / elapsed / 1e6);
+    free_concurrent_hashtable(hashtable);
+  }
+}
+
+void test_dheap(gconstpointer user_data) {
+  const int n = 1000;
+  cache_obj_t *objs = g_new0(cache_obj_t, n);
+  dheap_t *heap = dheap_init(1, offsetof(cache_obj_t, Size.heap_pos));
+
+  for (int i = 0; i < n; i++) {
+    objs[i].obj_id = i;
+    dheap_insert(heap, &objs[i], (double)((i * 7919) % n));
+  }
+  g_assert_cmpint(dheap_size(heap), ==, n);
+
+  /* move half of the objects to the end of the order */
+  for (int i = 0; i < n; i += 2) {
+    dheap_update(heap, &objs[i], (double)(-i - 1));
+  }
+  dheap_remove(heap, &objs[1]);
+  g_assert_cmpint(objs[1].Size.heap_pos, ==, DHEAP_INVALID_POS);
+
+  double last_pri = (double)n;
+  int64_t n_popped = 0;
+  cache_obj_t *obj;
+  while ((obj = dheap_pop(heap)) != NULL) {
+    double pri = obj->obj_id % 2 == 0 ? (double)(-(int64_t)obj->obj_id - 1)
+                                      : (double)((obj->obj_id * 7919) % n);
+    g_assert_cmpfloat(pri, <=, last_pri);
+    last_pri = pri;
+    n_popped += 1;
+  }
+  g_assert_cmpint(n_popped, ==, n - 1);
+
+  /* the same priority pops in FIFO order with the negated insertion seq */
+  for (int i = 0; i < n; i++) {
+    dheap_insert_seq(heap, &objs[i], (double)(i % 3), -(int64_t)((i * 7919) % n));
+  }
+  dheap_update_seq(heap, &objs[0], 0, -(int64_t)n);
+  int64_t last_seq = 0;
+  last_pri = 2;
+  while ((obj = dheap_pop(heap)) != NULL) {
+    double pri = (double)(obj->obj_id % 3);
+    int64_t seq = obj->obj_id == 0 ? n : (int64_t)((obj->obj_id * 7919) % n);
+    if (pri != last_pri) {
+      g_assert_cmpfloat(pri, <, last_pri);
+      last_pri = pri;
+      last_seq = 0;
+    }
+    g_assert_cmpint(seq, >, last_seq);
+    last_seq = seq;
+  }
+
+  dheap_free(heap);
+  g_free(objs);
+}
+
+void test_fp_ghost(gconstpointer user_data) {
+  /* room for 1000 objects of size 10 */
+  fp_ghost_t *ghost = fp_ghost_new(10000, 0.001);
+
+  for (obj_id_t id = 0; id < 5000; id++) {
+    fp_ghost_insert(ghost, id, 10);
+  }
+  g_assert_cmpint(ghost->n_entry, ==, 1000);
+  g_assert_cmpint(ghost->occupied_byte, ==, 10000);
+
+  /* the newest objects are in the ghost */
+  for (obj_id_t id = 4000; id < 5000; id++) {
+    g_assert_true(fp_ghost_contains(ghost, id));
+  }
+  /* the old objects are (mostly) not */
+  int n_false_positive = 0;
+  for (obj_id_t id = 0; id < 4000; id++) {
+    n_false_positive += fp_ghost_contains(ghost, id);
+  }
+  g_assert_cmpint(n_false_positive, <, 40);
+
+  g_assert_true(fp_ghost_remove(ghost, 4500));
+  g_assert_false(fp_ghost_contains(ghost, 4500));
+  g_assert_cmpint(ghost->n_entry, ==, 999);
+
+  fp_ghost_t *clone = fp_ghost_clone(ghost);
+  fp_ghost_insert(clone, 5000, 10);
+  g_assert_true(fp_ghost_contains(clone, 5000));
+  g_assert_true(fp_ghost_contains(clone, 4999));
+  fp_ghost_free(clone);
+
+  g_assert_true(fp_ghost_remove_oldest(ghost));
+  g_assert_false(fp_ghost_contains(ghost, 4000));
+  g_assert_cmpint(ghost->n_entry, ==, 998);
+  g_assert_cmpint(ghost->n_dropped, ==, 0);
+  fp_ghost_free(ghost);
+
+  /* removed entries are reclaimed instead of growing the ring */
+  ghost = fp_ghost_new(INT64_MAX, 1e-9);
+  for (obj_id_t id = 0; id < 100000; id++) {
+    fp_ghost_insert_value(ghost, id, 10, id * 2);
+    if (id % 10 != 0) {
+      int64_t value = -1;
+      g_assert_true(fp_ghost_remove_value(ghost, id, &value));
+      g_assert_cmpint(value, ==, id * 2);
+    }
+  }
+  g_assert_cmpint(ghost->n_entry, ==, 10000);
+  g_assert_cmpint(ghost->ring_cap, <=, 32768);
+  for (obj_id_t id = 0; id < 100000; id += 10) {
+    g_assert_true(fp_ghost_contains(ghost, id));
+  }
+  fp_ghost_free(ghost);
+
+  /* the same object inserted many times fills both of its buckets,
+   * the entries that cannot be placed are dropped and counted */
+  ghost = fp_ghost_new(10000, 0.001);
+  for (int i = 0; i < 20; i++) {
+    fp_ghost_insert(ghost, 42, 10);
+  }
+  g_assert_cmpint(ghost->n_dropped, ==, 12);
+  g_assert_cmpint(ghost->n_entry, ==, 8);
+  g_assert_cmpint(ghost->occupied_byte, ==, 80);
+  fp_ghost_free(ghost);
+}
+
 int main(int argc, char *argv[]) {
   g_test_init(&argc, &argv, NULL);
   reader_t *reader;
 
   reader = setup_plaintxt_reader_num();
   g_test_add_data_func("/libCacheSim/test_chained_hashtable_v2", NULL, test_chained_hashtable_v2);
+  g_test_add_data_func("/libCacheSim/test_concurrent_hashtable", NULL, test_concurrent_hashtable);
+  g_test_add_data_func("/libCacheSim/test_concurrent_hashtable_stress", NULL, test_concurrent_hashtable_stress);
+  if (g_test_perf()) {
+    g_test_add_data_func("/libCacheSim/test_concurrent_hashtable_scaling", NULL, test_concurrent_hashtable_scaling);
+  }
+  g_test_add_data_func("/libCacheSim/test_dheap", NULL, test_dheap);
+  g_test_add_data_func("/libCacheSim/test_fp_ghost", NULL, test_fp_ghost);
 
   return g_test_run();
 }
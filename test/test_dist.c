@@ -9,7 +9,6 @@ void test_distUtils_basic(gconstpointer user_data) {
   // int32_t last_dist_true[N_TEST] = {-1, -1, -1, 7, -1, 137};
   int32_t last_dist_true[N_TEST] = {-1, -1, -1, 8, -1, 138};
   int32_t frd_true[N_TEST] = {11, 37, 49, -1, 8, -1};
-  // int32_t next_dist_true[N_TEST] = {11, 59, 79, -1, 8, -1};
   int32_t next_dist_true[N_TEST] = {12, 60, 80, -1, 9, -1};
   int32_t* dist;
   int64_t array_size;
@@ -35,10 +34,11 @@ void test_distUtils_basic(gconstpointer user_data) {
     g_assert_cmpint(dist[i], ==, last_dist_true[j]);
   }
 
-  // dist = get_next_access_dist(reader);
-  // for (i = 6, j = 0; j < N_TEST; i++, j++) {
-  //   g_assert_cmpint(dist[i], ==, next_dist_true[j]);
-  // }
+  dist = get_access_dist(reader, DIST_TILL_NEXT_ACCESS, &array_size);
+  g_assert_cmpint(array_size, ==, get_num_of_req(reader));
+  for (i = 6, j = 0; j < N_TEST; i++, j++) {
+    g_assert_cmpint(dist[i], ==, next_dist_true[j]);
+  }
 }
 
 void test_distUtils_more1(gconstpointer user_data) {
@@ -59,6 +59,57 @@ void test_distUtils_more1(gconstpointer user_data) {
     g_assert_cmpint(rd[i], ==, rd_true[j]);
   }
   g_free(rd);
+  remove("rd.save.STACK_DIST");
+}
+
+void test_distUtils_cached(gconstpointer user_data) {
+  reader_t* reader = (reader_t*)user_data;
+  int64_t array_size = 0, cached_size = 0;
+  int32_t* frd = get_stack_dist(reader, FUTURE_STACK_DIST, &array_size);
+
+  unlink("./cloudPhysicsIO.vscsi.FUTURE_STACK_DIST.cache");
+  /* the first call computes and saves the array, the second call maps it */
+  for (int n = 0; n < 2; n++) {
+    int32_t* cached = get_dist_cached(reader, FUTURE_STACK_DIST, &cached_size, ".");
+    g_assert_cmpint(cached_size, ==, array_size);
+    g_assert_cmpint(access("./cloudPhysicsIO.vscsi.FUTURE_STACK_DIST.cache", F_OK), ==, 0);
+    for (long i = 0; i < array_size; i++) {
+      g_assert_cmpint(cached[i], ==, frd[i]);
+    }
+    release_dist_cached(cached, cached_size);
+  }
+  unlink("./cloudPhysicsIO.vscsi.FUTURE_STACK_DIST.cache");
+  free(frd);
+}
+
+void test_distUtils_cached_key(gconstpointer user_data) {
+  reader_t* reader = (reader_t*)user_data;
+  int64_t array_size = 0, cached_size = 0;
+
+  /* no cache file is written unless a cache directory is given */
+  int32_t* cached = get_dist_cached(reader, STACK_DIST, &cached_size, NULL);
+  g_assert_cmpint(access("./cloudPhysicsIO.csv.STACK_DIST.cache", F_OK), ==, -1);
+  release_dist_cached(cached, cached_size);
+
+  cached = get_dist_cached(reader, STACK_DIST, &cached_size, ".");
+  release_dist_cached(cached, cached_size);
+  g_assert_cmpint(access("./cloudPhysicsIO.csv.STACK_DIST.cache", F_OK), ==, 0);
+
+  /* the same trace read with a different obj_id field must not use the
+   * array cached for the first reader */
+  reader_init_param_t init_params = {.delimiter = ',', .time_field = 2, .obj_id_field = 4,
+                                     .obj_size_field = 4, .has_header = true, .obj_id_is_num = true};
+  reader_t* size_reader = setup_reader(reader->trace_path, CSV_TRACE, &init_params);
+  int32_t* rd = get_stack_dist(size_reader, STACK_DIST, &array_size);
+  cached = get_dist_cached(size_reader, STACK_DIST, &cached_size, ".");
+  g_assert_cmpint(cached_size, ==, array_size);
+  for (long i = 0; i < array_size; i++) {
+    g_assert_cmpint(cached[i], ==, rd[i]);
+  }
+  release_dist_cached(cached, cached_size);
+  close_reader(size_reader);
+  unlink("./cloudPhysicsIO.csv.STACK_DIST.cache");
+  free(rd);
 }
 
 int main(int argc, char* argv[]) {
@@ -89,5 +140,12 @@ int main(int argc, char* argv[]) {
   g_test_add_data_func("/libCacheSim/test_distUtils_basic_vscsi", reader, test_distUtils_basic);
   g_test_add_data_func_full("/libCacheSim/test_distUtils_more1_vscsi", reader, test_distUtils_more1, test_teardown);
 
+  reader = setup_vscsi_reader();
+  g_test_add_data_func_full("/libCacheSim/test_distUtils_cached_vscsi", reader, test_distUtils_cached, test_teardown);
+
+  reader = setup_csv_reader_obj_num();
+  g_test_add_data_func_full("/libCacheSim/test_distUtils_cached_key_csv", reader, test_distUtils_cached_key,
+                            test_teardown);
+
   return g_test_run();
 }
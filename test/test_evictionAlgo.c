@@ -2,6 +2,7 @@
 // Created by Juncheng Yang on 11/21/19.
 //
 
+#include "../libCacheSim/dataStructure/hashtable/hashtable.h"
 #include "../libCacheSim/utils/include/mymath.h"
 #include "common.h"
 
@@ -75,6 +76,59 @@ static void test_Clock(gconstpointer user_data) {
   my_free(sizeof(cache_stat_t), res);
 }
 
+static void test_ClockArray(gconstpointer user_data) {
+  /* new objects are inserted behind the hand, so it evicts the same objects
+   * as Clock */
+  uint64_t miss_cnt_true[] = {93313, 89775, 83411, 81328, 74815, 72283, 71927, 64456};
+  uint64_t miss_byte_true[] = {4213887488, 4064512000, 3762650624, 3644467200,
+                               3256760832, 3091688448, 3074241024, 2697378816};
+
+  reader_t *reader = (reader_t *)user_data;
+  common_cache_params_t cc_params = {.cache_size = CACHE_SIZE, .hashpower = 20, .default_ttl = DEFAULT_TTL};
+  cache_t *cache = create_test_cache("ClockArray", cc_params, reader, NULL);
+  g_assert_true(cache != NULL);
+  cache_stat_t *res = simulate_at_multi_sizes_with_step_size(reader, cache, STEP_SIZE, NULL, 0, 0, _n_cores(), false);
+
+  print_results(cache, res);
+  _verify_profiler_results(res, CACHE_SIZE / STEP_SIZE, g_req_cnt_true, miss_cnt_true, g_req_byte_true, miss_byte_true);
+  cache->cache_free(cache);
+  my_free(sizeof(cache_stat_t), res);
+
+  /* with packed counters, it evicts the same objects as Clock too */
+  uint64_t cache_size = 256 * MiB;
+  cache_t *caches[2] = {Clock_init(cc_params, "n-bit-counter=2,init-freq=1"),
+                        ClockArray_init(cc_params, "n-bit-counter=2,init-freq=1")};
+  res = simulate_at_multi_sizes(reader, caches[0], 1, &cache_size, NULL, 0, 0, 1, false);
+  cache_stat_t *res_array = simulate_at_multi_sizes(reader, caches[1], 1, &cache_size, NULL, 0, 0, 1, false);
+  g_assert_cmpuint(res_array[0].n_miss, ==, res[0].n_miss);
+  g_assert_cmpuint(res_array[0].n_miss_byte, ==, res[0].n_miss_byte);
+  caches[0]->cache_free(caches[0]);
+  caches[1]->cache_free(caches[1]);
+  my_free(sizeof(cache_stat_t), res);
+  my_free(sizeof(cache_stat_t), res_array);
+
+  /* the hand evicts the object to_evict returns, with packed counters too */
+  cc_params.cache_size = 64 * MiB;
+  cache = ClockArray_init(cc_params, "n-bit-counter=2,init-freq=1");
+  request_t *req = new_request();
+  reset_reader(reader);
+  while (read_one_req(reader, req) == 0) {
+    if (cache->find(cache, req, true) != NULL || !cache->can_insert(cache, req)) {
+      continue;
+    }
+    while (cache->get_occupied_byte(cache) + req->obj_size > cache->cache_size) {
+      request_t *victim = new_request();
+      copy_cache_obj_to_request(victim, cache->to_evict(cache, req));
+      cache->evict(cache, req);
+      g_assert_null(cache->find(cache, victim, false));
+      free_request(victim);
+    }
+    cache->insert(cache, req);
+  }
+  free_request(req);
+  cache->cache_free(cache);
+}
+
 static void test_FIFO(gconstpointer user_data) {
   uint64_t miss_cnt_true[] = {93403, 89386, 84387, 84025, 72498, 72228, 72182, 72140};
   uint64_t miss_byte_true[] = {4213112832, 4052646400, 3829170176, 3807412736,
@@ -135,9 +189,9 @@ static void test_BeladySize(gconstpointer user_data) {
 }
 
 static void test_Random(gconstpointer user_data) {
-  uint64_t miss_cnt_true[] = {92457, 88582, 84459, 80277, 76132, 72134, 68230, 64225};
-  uint64_t miss_byte_true[] = {4170166272, 3975292416, 3757524992, 3539850752,
-                               3321110016, 3113551360, 2917275648, 2725705216};
+  uint64_t miss_cnt_true[] = {92644, 88557, 84444, 80461, 76411, 72498, 68615, 64342};
+  uint64_t miss_byte_true[] = {4180113920, 3980830208, 3764096512, 3544998400,
+                               3333765632, 3124005888, 2928898048, 2724442624};
 
   reader_t *reader = (reader_t *)user_data;
   common_cache_params_t cc_params = {.cache_size = CACHE_SIZE, .hashpower = 12, .default_ttl = DEFAULT_TTL};
@@ -217,12 +271,33 @@ static void test_LHD(gconstpointer user_data) {
   _verify_profiler_results(res, CACHE_SIZE / STEP_SIZE, g_req_cnt_true, miss_cnt_true, g_req_byte_true, miss_byte_true);
   cache->cache_free(cache);
   my_free(sizeof(cache_stat_t), res);
+
+  /* the trace is shorter than a reconfiguration period (2^20 requests),
+   * replay it past the 6th reconfiguration, which changes the age coarsening
+   * and rescales the classes one per request in the next 256 requests */
+  cc_params.cache_size = 64 * MiB;
+  cache = create_test_cache("LHD", cc_params, reader, NULL);
+  set_rand_seed(1);
+  request_t *req = new_request();
+  uint64_t n_req = 0, n_miss = 0;
+  for (int i = 0; i < 60; i++) {
+    reset_reader(reader);
+    while (read_one_req(reader, req) == 0) {
+      n_req += 1;
+      n_miss += cache->get(cache, req) ? 0 : 1;
+      g_assert_cmpint(cache->get_occupied_byte(cache), <=, cache->cache_size);
+    }
+  }
+  g_assert_cmpuint(n_req, ==, 60 * g_req_cnt_true);
+  g_assert_cmpuint(n_miss, ==, 4794414);
+  free_request(req);
+  cache->cache_free(cache);
 }
 
 static void test_Hyperbolic(gconstpointer user_data) {
-  uint64_t miss_cnt_true[] = {92924, 89470, 83452, 81234, 74544, 71234, 69356, 65338};
-  uint64_t miss_byte_true[] = {4213586432, 4064826368, 3766646272, 3644941824,
-                               3245021184, 3035783168, 2939981312, 2754100224};
+  uint64_t miss_cnt_true[] = {92919, 89490, 83402, 81260, 74557, 71195, 69280, 65264};
+  uint64_t miss_byte_true[] = {4213233664, 4066689024, 3764336128, 3646453760,
+                               3246876672, 3033270784, 2936896512, 2749701632};
 
   reader_t *reader = (reader_t *)user_data;
   common_cache_params_t cc_params = {.cache_size = CACHE_SIZE, .hashpower = 18, .default_ttl = DEFAULT_TTL};
@@ -372,6 +447,23 @@ static void test_SLRU(gconstpointer user_data) {
   my_free(sizeof(cache_stat_t), res);
 }
 
+static void test_TwoQ(gconstpointer user_data) {
+  uint64_t miss_cnt_true[] = {91729, 83567, 82245, 77039, 72182, 72136, 72113, 72074};
+  uint64_t miss_byte_true[] = {4130814976, 3757302784, 3693497856, 3305772032,
+                               3080457216, 3079010304, 3078737920, 3077292544};
+
+  reader_t *reader = (reader_t *)user_data;
+  common_cache_params_t cc_params = {.cache_size = CACHE_SIZE, .hashpower = 20, .default_ttl = DEFAULT_TTL};
+  cache_t *cache = create_test_cache("TwoQ", cc_params, reader, NULL);
+  g_assert_true(cache != NULL);
+  cache_stat_t *res = simulate_at_multi_sizes_with_step_size(reader, cache, STEP_SIZE, NULL, 0, 0, _n_cores(), false);
+
+  print_results(cache, res);
+  _verify_profiler_results(res, CACHE_SIZE / STEP_SIZE, g_req_cnt_true, miss_cnt_true, g_req_byte_true, miss_byte_true);
+  cache->cache_free(cache);
+  my_free(sizeof(cache_stat_t), res);
+}
+
 static void test_QDLP_FIFO(gconstpointer user_data) {
   uint64_t miss_cnt_true[] = {88746, 80630, 76450, 71638, 67380, 65680, 66125, 64417};
   uint64_t miss_byte_true[] = {4008265728, 3625704960, 3330610176, 3099731456,
@@ -440,6 +532,210 @@ static void test_Sieve(gconstpointer user_data) {
   my_free(sizeof(cache_stat_t), res);
 }
 
+static void test_SieveArray(gconstpointer user_data) {
+  uint64_t miss_cnt_true[] = {91699, 86720, 78578, 76707, 69945, 66221, 64445, 64376};
+  uint64_t miss_byte_true[] = {4158632960, 3917211648, 3536227840, 3455379968,
+                               3035580416, 2801699328, 2699456000, 2696345600};
+
+  reader_t *reader = (reader_t *)user_data;
+  common_cache_params_t cc_params = {.cache_size = CACHE_SIZE, .hashpower = 20, .default_ttl = DEFAULT_TTL};
+  cache_t *cache = create_test_cache("SieveArray", cc_params, reader, NULL);
+  g_assert_true(cache != NULL);
+  cache_stat_t *res = simulate_at_multi_sizes_with_step_size(reader, cache, STEP_SIZE, NULL, 0, 0, _n_cores(), false);
+
+  print_results(cache, res);
+  _verify_profiler_results(res, CACHE_SIZE / STEP_SIZE, g_req_cnt_true, miss_cnt_true, g_req_byte_true, miss_byte_true);
+  cache->cache_free(cache);
+  my_free(sizeof(cache_stat_t), res);
+}
+
+static void test_flashRegion_FIFO(gconstpointer user_data) {
+  uint64_t miss_cnt_true[] = {93545, 89859, 84407, 84036, 72532, 72229, 72182, 72140};
+  uint64_t miss_byte_true[] = {4221304832, 4071924224, 3830411264, 3808178688,
+                               3095247872, 3079526400, 3079210496, 3077547520};
+
+  reader_t *reader = (reader_t *)user_data;
+  common_cache_params_t cc_params = {.cache_size = CACHE_SIZE, .hashpower = 20, .default_ttl = DEFAULT_TTL};
+  cache_t *cache = create_test_cache("flashRegion-FIFO", cc_params, reader, NULL);
+  g_assert_true(cache != NULL);
+  cache_stat_t *res = simulate_at_multi_sizes_with_step_size(reader, cache, STEP_SIZE, NULL, 0, 0, _n_cores(), false);
+
+  print_results(cache, res);
+  _verify_profiler_results(res, CACHE_SIZE / STEP_SIZE, g_req_cnt_true, miss_cnt_true, g_req_byte_true, miss_byte_true);
+  cache->cache_free(cache);
+  my_free(sizeof(cache_stat_t), res);
+}
+
+static void test_flashRegion_RRIP(gconstpointer user_data) {
+  uint64_t miss_cnt_true[] = {93297, 89556, 83412, 79596, 74270, 65563, 64489, 64377};
+  uint64_t miss_byte_true[] = {4222279168, 4050157568, 3748573184, 3538324992,
+                               3225369600, 2767468544, 2702193152, 2696349696};
+
+  reader_t *reader = (reader_t *)user_data;
+  common_cache_params_t cc_params = {.cache_size = CACHE_SIZE, .hashpower = 20, .default_ttl = DEFAULT_TTL};
+  cache_t *cache = create_test_cache("flashRegion-RRIP", cc_params, reader, NULL);
+  g_assert_true(cache != NULL);
+  cache_stat_t *res = simulate_at_multi_sizes_with_step_size(reader, cache, STEP_SIZE, NULL, 0, 0, _n_cores(), false);
+
+  print_results(cache, res);
+  _verify_profiler_results(res, CACHE_SIZE / STEP_SIZE, g_req_cnt_true, miss_cnt_true, g_req_byte_true, miss_byte_true);
+  cache->cache_free(cache);
+  my_free(sizeof(cache_stat_t), res);
+}
+
+static void _run_flashRegion(reader_t *reader, cache_t *cache) {
+  request_t *req = new_request();
+  reset_reader(reader);
+  while (read_one_req(reader, req) == 0) {
+    cache->get(cache, req);
+  }
+  free_request(req);
+}
+
+static void test_flashRegion_write_amp(gconstpointer user_data) {
+  reader_t *reader = (reader_t *)user_data;
+  common_cache_params_t cc_params = {.cache_size = 256 * MiB, .hashpower = 20, .default_ttl = DEFAULT_TTL};
+  const int64_t region_size = 16 * MiB;
+
+  cache_t *fifo = flashRegion_init(cc_params, "region-size=16777216,region-evict=fifo");
+  cache_t *rrip = flashRegion_init(cc_params, "region-size=16777216,region-evict=rrip");
+  cache_t *admit = flashRegion_init(cc_params, "region-size=16777216,region-evict=fifo");
+  admit->admissioner = create_admissioner("bloomfilter", NULL);
+  _run_flashRegion(reader, fifo);
+  _run_flashRegion(reader, rrip);
+  _run_flashRegion(reader, admit);
+
+  cache_t *caches[] = {fifo, rrip, admit};
+  for (int i = 0; i < 3; i++) {
+    flashRegion_params_t *params = (flashRegion_params_t *)caches[i]->eviction_params;
+    g_assert_cmpint(params->n_region, ==, 16);
+    g_assert_cmpint(params->n_byte_device_write, ==, params->n_region_written * region_size);
+    /* everything written except the active region is on the device,
+     * the device also writes the unused tail of each region */
+    int64_t n_byte_written = params->n_byte_admitted + params->n_byte_reinserted;
+    g_assert_cmpint(params->n_byte_device_write + region_size, >=, n_byte_written);
+    g_assert_cmpint(caches[i]->get_occupied_byte(caches[i]), <=, params->n_region * region_size);
+  }
+
+  flashRegion_params_t *fifo_params = (flashRegion_params_t *)fifo->eviction_params;
+  flashRegion_params_t *rrip_params = (flashRegion_params_t *)rrip->eviction_params;
+  flashRegion_params_t *admit_params = (flashRegion_params_t *)admit->eviction_params;
+  g_assert_cmpint(fifo_params->n_obj_reinserted, ==, 0);
+  g_assert_cmpint(rrip_params->n_obj_reinserted, >, 0);
+  /* the admission policy writes less to the device */
+  g_assert_cmpint(admit_params->n_byte_device_write, <, fifo_params->n_byte_device_write);
+
+  fifo->cache_free(fifo);
+  rrip->cache_free(rrip);
+  admit->cache_free(admit);
+}
+
+static void test_flashRegion_reinsert(gconstpointer user_data) {
+  /* two regions of two unit-size objects */
+  common_cache_params_t cc_params = {.cache_size = 4, .hashpower = 10, .default_ttl = DEFAULT_TTL};
+  cache_t *cache = flashRegion_init(cc_params, "region-size=2,region-evict=fifo");
+  request_t *req = new_request();
+  req->obj_size = 1;
+  obj_id_t ids[] = {1, 2, 1, 3, 4};
+  for (int i = 0; i < 5; i++) {
+    req->obj_id = ids[i];
+    if (i == 2) {
+      /* 1 is removed from the first region and rewritten to the second */
+      g_assert_true(cache->remove(cache, 1));
+    }
+    g_assert_false(cache->get(cache, req));
+  }
+
+  /* writing 4 evicts the first region, only 2 is still there */
+  flashRegion_params_t *params = (flashRegion_params_t *)cache->eviction_params;
+  g_assert_cmpint(params->n_region_evicted, ==, 1);
+  g_assert_cmpint(cache->get_n_obj(cache), ==, 3);
+  for (obj_id_t id = 1; id <= 4; id++) {
+    req->obj_id = id;
+    g_assert_true((cache->find(cache, req, false) != NULL) == (id != 2));
+  }
+
+  free_request(req);
+  cache->cache_free(cache);
+}
+
+static void test_tiered(gconstpointer user_data) {
+  uint64_t miss_cnt_true[] = {93475, 90140, 84665, 83405, 74515, 72230, 72145, 72105};
+  uint64_t miss_byte_true[] = {4219321344, 4079277056, 3823227392, 3768482816,
+                               3228857856, 3083307520, 3079174144, 3077409280};
+
+  reader_t *reader = (reader_t *)user_data;
+  common_cache_params_t cc_params = {.cache_size = CACHE_SIZE, .hashpower = 20, .default_ttl = DEFAULT_TTL};
+  cache_t *cache = create_test_cache("tiered-LRU-flashRegion", cc_params, reader, NULL);
+  g_assert_true(cache != NULL);
+  cache_stat_t *res = simulate_at_multi_sizes_with_step_size(reader, cache, STEP_SIZE, NULL, 0, 0, _n_cores(), false);
+
+  print_results(cache, res);
+  _verify_profiler_results(res, CACHE_SIZE / STEP_SIZE, g_req_cnt_true, miss_cnt_true, g_req_byte_true, miss_byte_true);
+  cache->cache_free(cache);
+  my_free(sizeof(cache_stat_t), res);
+}
+
+static void _check_in_tier(cache_obj_t *cache_obj, void *user_data) {
+  cache_t *tier = (cache_t *)user_data;
+  g_assert_nonnull(hashtable_find_obj_id(tier->hashtable, cache_obj->obj_id));
+}
+
+static void test_tiered_modes(gconstpointer user_data) {
+  reader_t *reader = (reader_t *)user_data;
+  common_cache_params_t cc_params = {.cache_size = 2000, .hashpower = 16, .default_ttl = DEFAULT_TTL};
+  cache_t *lru = LRU_init(cc_params, NULL);
+  cache_t *exclusive = tiered_init(cc_params, "tiers=LRU:LRU,tier-size-ratio=0.25:0.75,inclusion=exclusive");
+  cache_t *inclusive = tiered_init(cc_params, "tiers=LRU:LRU,tier-size-ratio=0.25:0.75,inclusion=inclusive");
+  cache_t *admit = tiered_init(cc_params, "tiers=LRU:FIFO,latency=1:100:10000");
+  cache_t *admit_bloom = tiered_init(cc_params, "tiers=LRU:FIFO,latency=1:100:10000");
+  admit_bloom->admissioner = create_admissioner("bloomfilter", NULL);
+  /* flashRegion evicts whole regions inside insert */
+  cache_t *inclusive_flash =
+      tiered_init(cc_params, "tiers=LRU:flashRegion,tier-size-ratio=0.25:0.75,inclusion=inclusive");
+  cache_t *caches[] = {lru, exclusive, inclusive, admit, admit_bloom, inclusive_flash};
+  int64_t n_hit[6] = {0};
+
+  /* unit size, an exclusive LRU hierarchy is the same as one LRU */
+  request_t *req = new_request();
+  int64_t n_req = 0;
+  reset_reader(reader);
+  while (read_one_req(reader, req) == 0) {
+    req->obj_size = 1;
+    n_req += 1;
+    for (int i = 0; i < 6; i++) {
+      n_hit[i] += caches[i]->get(caches[i], req);
+    }
+  }
+  free_request(req);
+
+  g_assert_cmpint(n_hit[1], ==, n_hit[0]);
+
+  /* every object in the first tier is in the second tier */
+  tiered_params_t *params = (tiered_params_t *)inclusive->eviction_params;
+  hashtable_foreach(params->tiers[0]->hashtable, _check_in_tier, params->tiers[1]);
+  params = (tiered_params_t *)inclusive_flash->eviction_params;
+  g_assert_cmpint(((flashRegion_params_t *)params->tiers[1]->eviction_params)->n_region_evicted, >, 0);
+  hashtable_foreach(params->tiers[0]->hashtable, _check_in_tier, params->tiers[1]);
+
+  /* the latency adds up the tiers looked up */
+  params = (tiered_params_t *)admit->eviction_params;
+  g_assert_cmpint(params->n_hit[0] + params->n_hit[1] + params->n_miss, ==, n_req);
+  g_assert_cmpint(params->n_hit[0] + params->n_hit[1], ==, n_hit[3]);
+  g_assert_cmpint(params->total_latency, ==, params->n_hit[0] * 1 + params->n_hit[1] * 101 + params->n_miss * 10101);
+  /* a promoted object keeps its copy in the second tier */
+  g_assert_cmpint(params->n_write[1], <=, params->n_demote[0]);
+  g_assert_cmpint(params->n_write[1], >, 0);
+
+  /* the admission policy filters the writes into the second tier */
+  tiered_params_t *bloom_params = (tiered_params_t *)admit_bloom->eviction_params;
+  g_assert_cmpint(bloom_params->n_write[1], <, params->n_write[1]);
+
+  for (int i = 0; i < 6; i++) {
+    caches[i]->cache_free(caches[i]);
+  }
+}
+
 static void test_WTinyLFU(gconstpointer user_data) {
   // TODO: to be implemented
 }
@@ -478,12 +774,14 @@ int main(int argc, char *argv[]) {
   reader = setup_oracleGeneralBin_reader();
 
   g_test_add_data_func("/libCacheSim/cacheAlgo_Sieve", reader, test_Sieve);
+  g_test_add_data_func("/libCacheSim/cacheAlgo_SieveArray", reader, test_SieveArray);
   g_test_add_data_func("/libCacheSim/cacheAlgo_S3FIFO", reader, test_S3FIFO);
   g_test_add_data_func("/libCacheSim/cacheAlgo_S3FIFOv0", reader, test_S3FIFOv0);
   g_test_add_data_func("/libCacheSim/cacheAlgo_QDLP_FIFO", reader, test_QDLP_FIFO);
 
   g_test_add_data_func("/libCacheSim/cacheAlgo_LRU", reader, test_LRU);
   g_test_add_data_func("/libCacheSim/cacheAlgo_SLRU", reader, test_SLRU);
+  g_test_add_data_func("/libCacheSim/cacheAlgo_TwoQ", reader, test_TwoQ);
   g_test_add_data_func("/libCacheSim/cacheAlgo_ARC", reader, test_ARC);
   g_test_add_data_func("/libCacheSim/cacheAlgo_LeCaR", reader, test_LeCaR);
   g_test_add_data_func("/libCacheSim/cacheAlgo_SR_LRU", reader, test_SR_LRU);
@@ -491,8 +789,15 @@ int main(int argc, char *argv[]) {
   g_test_add_data_func("/libCacheSim/cacheAlgo_Cacheus", reader, test_Cacheus);
   g_test_add_data_func("/libCacheSim/cacheAlgo_Hyperbolic", reader, test_Hyperbolic);
   g_test_add_data_func("/libCacheSim/cacheAlgo_LIRS", reader, test_LIRS);
+  g_test_add_data_func("/libCacheSim/cacheAlgo_flashRegion_FIFO", reader, test_flashRegion_FIFO);
+  g_test_add_data_func("/libCacheSim/cacheAlgo_flashRegion_RRIP", reader, test_flashRegion_RRIP);
+  g_test_add_data_func("/libCacheSim/cacheAlgo_flashRegion_write_amp", reader, test_flashRegion_write_amp);
+  g_test_add_data_func("/libCacheSim/cacheAlgo_flashRegion_reinsert", reader, test_flashRegion_reinsert);
+  g_test_add_data_func("/libCacheSim/cacheAlgo_tiered", reader, test_tiered);
+  g_test_add_data_func("/libCacheSim/cacheAlgo_tiered_modes", reader, test_tiered_modes);
 
   g_test_add_data_func("/libCacheSim/cacheAlgo_Clock", reader, test_Clock);
+  g_test_add_data_func("/libCacheSim/cacheAlgo_ClockArray", reader, test_ClockArray);
   g_test_add_data_func("/libCacheSim/cacheAlgo_FIFO", reader, test_FIFO);
   g_test_add_data_func("/libCacheSim/cacheAlgo_MRU", reader, test_MRU);
   g_test_add_data_func("/libCacheSim/cacheAlgo_Random", reader, test_Random);
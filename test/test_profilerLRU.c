@@ -28,6 +28,62 @@ void test_profilerLRU_basic(gconstpointer user_data) {
   g_free(mr);
 }
 
+void test_profilerLRU_aet(gconstpointer user_data) {
+  reader_t *reader = (reader_t *)user_data;
+  gint64 max_size = 20000;
+
+  double *mr_true = get_lru_obj_miss_ratio(reader, max_size);
+  double *mr_aet = get_lru_mrc_aet(reader, max_size);
+  g_assert_cmpfloat(mr_aet[0], ==, 1.0);
+  for (gint64 i = 1; i < max_size + 1; i++) {
+    g_assert_cmpfloat(mr_aet[i], <=, mr_aet[i - 1]);
+  }
+  /* AET is an approximation, the error is larger around the cliffs */
+  double err_sum = 0;
+  for (gint64 i = 1; i < max_size + 1; i++) {
+    err_sum += fabs(mr_aet[i] - mr_true[i]);
+  }
+  g_assert_cmpfloat(err_sum / max_size, <=, 0.015);
+  g_free(mr_true);
+  g_free(mr_aet);
+}
+
+void test_profilerLRU_aet_windowed(gconstpointer user_data) {
+  reader_t *reader = (reader_t *)user_data;
+  gint64 max_size = 2000, n_windows = 0;
+
+  /* one window that covers the whole trace is the same as get_lru_mrc_aet */
+  double *mr_aet = get_lru_mrc_aet(reader, max_size);
+  double *mr_win = get_lru_mrc_aet_windowed(reader, max_size, INT32_MAX, &n_windows);
+  g_assert_cmpint(n_windows, ==, 1);
+  for (gint64 i = 0; i < max_size + 1; i++) {
+    g_assert_cmpfloat(mr_win[i], ==, mr_aet[i]);
+  }
+  g_free(mr_win);
+  g_free(mr_aet);
+
+  mr_win = get_lru_mrc_aet_windowed(reader, max_size, 3600, &n_windows);
+  g_assert_cmpint(n_windows, >, 1);
+  for (gint64 w = 0; w < n_windows; w++) {
+    double *mrc = mr_win + w * (max_size + 1);
+    g_assert_cmpfloat(mrc[0], ==, 1.0);
+    for (gint64 i = 1; i < max_size + 1; i++) {
+      g_assert_cmpfloat(mrc[i], <=, mrc[i - 1]);
+    }
+  }
+
+  save_windowed_mrc("mrc_windowed.bin", mr_win, n_windows, max_size, 3600);
+  FILE *file = fopen("mrc_windowed.bin", "rb");
+  int64_t header[3];
+  g_assert_cmpint(fread(header, sizeof(int64_t), 3, file), ==, 3);
+  g_assert_cmpint(header[0], ==, n_windows);
+  g_assert_cmpint(header[1], ==, max_size + 1);
+  g_assert_cmpint(header[2], ==, 3600);
+  fclose(file);
+  remove("mrc_windowed.bin");
+  g_free(mr_win);
+}
+
 int main(int argc, char *argv[]) {
   g_test_init(&argc, &argv, NULL);
   reader_t *reader;
@@ -49,6 +105,8 @@ int main(int argc, char *argv[]) {
 
   reader = setup_vscsi_reader();
   g_test_add_data_func("/libCacheSim/test_profilerLRU_basic_vscsi", reader, test_profilerLRU_basic);
+  g_test_add_data_func("/libCacheSim/test_profilerLRU_aet_vscsi", reader, test_profilerLRU_aet);
+  g_test_add_data_func("/libCacheSim/test_profilerLRU_aet_windowed_vscsi", reader, test_profilerLRU_aet_windowed);
 
   return g_test_run();
 }
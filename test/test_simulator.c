@@ -200,6 +200,414 @@ static void test_simulator_with_ttl(gconstpointer user_data) {
   cache->cache_free(cache);
 }
 
+/**
+ * the single-pass stack simulation should give the same result as
+ * simulating each cache size separately
+ * @param user_data
+ */
+static void test_simulator_stack_lru(gconstpointer user_data) {
+  uint64_t cache_size = CACHE_SIZE / CACHE_SIZE_UNIT;
+  uint64_t step_size = STEP_SIZE / CACHE_SIZE_UNIT;
+
+  uint64_t req_cnt_true = 113872;
+  uint64_t miss_cnt_true[] = {99411, 96397, 95652, 95370, 95182, 94997, 94891, 94816};
+
+  reader_t *reader = (reader_t *)user_data;
+  common_cache_params_t cc_params = {.cache_size = cache_size, .default_ttl = 0};
+  cache_t *cache = LRU_init(cc_params, NULL);
+  g_assert_true(cache != NULL);
+
+  uint64_t cache_sizes[8];
+  for (uint64_t i = 0; i < 8; i++) {
+    cache_sizes[i] = step_size * (i + 1);
+  }
+  cache_stat_t *res = simulate_stack_policy_all_sizes(reader, cache, 8, cache_sizes, NULL, 0, 0, _n_cores(), false);
+
+  for (uint64_t i = 0; i < 8; i++) {
+    g_assert_cmpuint(res[i].cache_size, ==, step_size * (i + 1));
+    g_assert_cmpuint(res[i].n_req, ==, req_cnt_true);
+    g_assert_cmpuint(res[i].n_miss, ==, miss_cnt_true[i]);
+    g_assert_cmpuint(res[i].n_obj, ==, step_size * (i + 1));
+  }
+  g_free(res);
+
+  cache->cache_free(cache);
+}
+
+/**
+ * with variable object size, the inclusion property does not hold strictly,
+ * so the result should be close to simulating each size
+ * @param user_data
+ */
+static void test_simulator_stack_lru_size(gconstpointer user_data) {
+  uint64_t req_cnt_true = 113872, req_byte_true = 4205978112;
+  uint64_t miss_cnt_true[] = {93151, 87793, 83135, 81609, 72481, 72106, 71973, 71702};
+
+  reader_t *reader = (reader_t *)user_data;
+  common_cache_params_t cc_params = {.cache_size = CACHE_SIZE, .default_ttl = 0};
+  cache_t *cache = LRU_init(cc_params, NULL);
+  g_assert_true(cache != NULL);
+
+  uint64_t cache_sizes[8];
+  for (uint64_t i = 0; i < 8; i++) {
+    cache_sizes[i] = STEP_SIZE * (i + 1);
+  }
+  cache_stat_t *res = simulate_stack_policy_all_sizes(reader, cache, 8, cache_sizes, NULL, 0, 0, _n_cores(), false);
+
+  for (uint64_t i = 0; i < 8; i++) {
+    g_assert_cmpuint(res[i].n_req, ==, req_cnt_true);
+    g_assert_cmpuint(res[i].n_req_byte, ==, req_byte_true);
+    g_assert_cmpfloat(fabs((double)res[i].n_miss - (double)miss_cnt_true[i]) / (double)miss_cnt_true[i], <, 0.01);
+  }
+  g_free(res);
+
+  cache->cache_free(cache);
+}
+
+static void test_simulator_stack_belady(gconstpointer user_data) {
+  uint64_t cache_sizes[] = {100, 500, 1000, 2000, 4000};
+  int n_sizes = sizeof(cache_sizes) / sizeof(cache_sizes[0]);
+
+  reader_t *reader = (reader_t *)user_data;
+  common_cache_params_t cc_params = {.cache_size = 4000, .default_ttl = 0, .hashpower = 16};
+  cache_t *cache = Belady_init(cc_params, NULL);
+  g_assert_true(cache != NULL);
+
+  cache_stat_t *res_true = simulate_at_multi_sizes(reader, cache, n_sizes, cache_sizes, NULL, 0, 0, _n_cores(), false);
+  cache_stat_t *res = simulate_stack_policy_all_sizes(reader, cache, n_sizes, cache_sizes, NULL, 0, 0, _n_cores(), false);
+
+  for (int i = 0; i < n_sizes; i++) {
+    g_assert_cmpuint(res[i].cache_size, ==, cache_sizes[i]);
+    g_assert_cmpuint(res[i].n_req, ==, res_true[i].n_req);
+    g_assert_cmpuint(res[i].n_miss, ==, res_true[i].n_miss);
+    g_assert_cmpuint(res[i].n_obj, ==, res_true[i].n_obj);
+  }
+  g_free(res_true);
+  g_free(res);
+
+  cache->cache_free(cache);
+}
+
+/**
+ * the vscsi trace does not have the next access time, the simulator loads the
+ * distances till the next access for Belady, the result should be the same as
+ * Belady on the oracleGeneral version of the trace
+ * @param user_data
+ */
+static void test_simulator_next_access_dist(gconstpointer user_data) {
+  uint64_t cache_sizes[] = {100, 500, 1000, 2000, 4000};
+  int n_sizes = sizeof(cache_sizes) / sizeof(cache_sizes[0]);
+
+  reader_t *reader = (reader_t *)user_data;
+  reader_t *oracle_reader = setup_oracleGeneralBin_reader_with_ignored_obj_size();
+  common_cache_params_t cc_params = {.cache_size = 4000, .default_ttl = 0, .hashpower = 16};
+  cache_t *cache = Belady_init(cc_params, NULL);
+  g_assert_true(cache != NULL);
+
+  cache_stat_t *res_true =
+      simulate_at_multi_sizes(oracle_reader, cache, n_sizes, cache_sizes, NULL, 0, 0, _n_cores(), false);
+  cache_stat_t *res = simulate_at_multi_sizes(reader, cache, n_sizes, cache_sizes, NULL, 0, 0, _n_cores(), false);
+
+  for (int i = 0; i < n_sizes; i++) {
+    g_assert_cmpuint(res[i].n_req, ==, res_true[i].n_req);
+    g_assert_cmpuint(res[i].n_miss, ==, res_true[i].n_miss);
+  }
+  g_assert_true(cache->next_access_dist == NULL);
+  g_free(res_true);
+  g_free(res);
+
+  cache->cache_free(cache);
+  close_reader(oracle_reader);
+}
+
+static void test_simulator_offline_min(gconstpointer user_data) {
+  uint64_t cache_sizes[] = {100, 500, 1000, 2000, 4000};
+  int n_sizes = sizeof(cache_sizes) / sizeof(cache_sizes[0]);
+
+  reader_t *reader = (reader_t *)user_data;
+  common_cache_params_t cc_params = {.cache_size = 4000, .default_ttl = 0, .hashpower = 16};
+  cache_t *cache = Belady_init(cc_params, NULL);
+  g_assert_true(cache != NULL);
+
+  cache_stat_t *res_true = simulate_at_multi_sizes(reader, cache, n_sizes, cache_sizes, NULL, 0, 0, _n_cores(), false);
+  cache_stat_t *res = simulate_offline_belady(reader, n_sizes, cache_sizes, _n_cores());
+  cache_stat_t *res_bound = get_pfoo_lower_bound(reader, n_sizes, cache_sizes, _n_cores());
+
+  for (int i = 0; i < n_sizes; i++) {
+    g_assert_cmpuint(res[i].cache_size, ==, cache_sizes[i]);
+    g_assert_cmpuint(res[i].n_req, ==, res_true[i].n_req);
+    g_assert_cmpuint(res[i].n_miss, ==, res_true[i].n_miss);
+    g_assert_cmpuint(res[i].n_miss_byte, ==, res_true[i].n_miss_byte);
+    g_assert_cmpuint(res[i].n_obj, ==, res_true[i].n_obj);
+
+    /* all objects have the same size, so the bound is below Belady */
+    g_assert_cmpuint(res_bound[i].n_req, ==, res_true[i].n_req);
+    g_assert_cmpuint(res_bound[i].n_miss, <=, res_true[i].n_miss);
+    g_assert_cmpuint(res_bound[i].n_miss_byte, <=, res_true[i].n_miss_byte);
+    if (i > 0) {
+      g_assert_cmpuint(res_bound[i].n_miss, <=, res_bound[i - 1].n_miss);
+    }
+  }
+  g_free(res_true);
+  g_free(res);
+  g_free(res_bound);
+
+  cache->cache_free(cache);
+}
+
+/**
+ * the simulator uses the specialized get of FIFO, LRU, Clock, Sieve and
+ * S3FIFO, it should have the same miss count as cache->get
+ * @param user_data
+ */
+static void test_simulator_get_specialized(gconstpointer user_data) {
+  reader_t *reader = (reader_t *)user_data;
+  cache_t *(*init_funcs[])(const common_cache_params_t, const char *) = {FIFO_init, LRU_init, Clock_init, Sieve_init,
+                                                                          S3FIFO_init};
+  uint64_t cache_sizes[4];
+  for (uint64_t i = 0; i < 4; i++) {
+    cache_sizes[i] = STEP_SIZE * (i + 1);
+  }
+
+  request_t *req = new_request();
+  for (int f = 0; f < 5; f++) {
+    common_cache_params_t cc_params = {.cache_size = CACHE_SIZE, .hashpower = 20, .default_ttl = 0};
+    cache_t *cache = init_funcs[f](cc_params, NULL);
+    g_assert_true(cache->get_specialized != NULL);
+    g_assert_true(cache_get_func(cache) == cache->get_specialized);
+
+    cache_stat_t *res = simulate_at_multi_sizes(reader, cache, 4, cache_sizes, NULL, 0, 0, _n_cores(), false);
+
+    for (uint64_t i = 0; i < 4; i++) {
+      cc_params.cache_size = cache_sizes[i];
+      cache_t *ref_cache = init_funcs[f](cc_params, NULL);
+      uint64_t n_miss = 0;
+      reset_reader(reader);
+      read_one_req(reader, req);
+      while (req->valid) {
+        n_miss += ref_cache->get(ref_cache, req) ? 0 : 1;
+        read_one_req(reader, req);
+      }
+      g_assert_cmpuint(res[i].n_miss, ==, n_miss);
+      ref_cache->cache_free(ref_cache);
+    }
+    g_free(res);
+    cache->cache_free(cache);
+  }
+  free_request(req);
+}
+
+/**
+ * with one stripe and one client, the concurrent cache is the same as the
+ * cache, with more stripes the miss count is close, with more clients every
+ * request is counted once
+ * @param user_data
+ */
+static void test_simulator_concurrent_clients(gconstpointer user_data) {
+  reader_t *reader = (reader_t *)user_data;
+  common_cache_params_t cc_params = {.cache_size = CACHE_SIZE, .hashpower = 20, .default_ttl = 0};
+  cache_t *cache = S3FIFO_init(cc_params, NULL);
+  uint64_t req_cnt_true = 113872, req_byte_true = 4205978112;
+  uint64_t miss_cnt_true = 56051, miss_byte_true = 2331596800, striped_miss_cnt_true = 56447;
+  uint64_t n_obj_true = 48974;
+
+  cache_stat_t *res = simulate_with_concurrent_clients(reader, cache, 1, 1);
+  g_assert_cmpuint(res->n_req, ==, req_cnt_true);
+  g_assert_cmpuint(res->n_req_byte, ==, req_byte_true);
+  g_assert_cmpuint(res->n_miss, ==, miss_cnt_true);
+  g_assert_cmpuint(res->n_miss_byte, ==, miss_byte_true);
+  g_free(res);
+
+  /* the stripes evict independently, so the miss count is close to but not
+   * the same as one cache */
+  res = simulate_with_concurrent_clients(reader, cache, 16, 1);
+  g_assert_cmpuint(res->n_req, ==, req_cnt_true);
+  g_assert_cmpuint(res->n_miss, ==, striped_miss_cnt_true);
+  g_free(res);
+
+  /* the order of requests depends on the scheduling of the clients, but every
+   * request is counted once, each object misses at least once, and the
+   * cached objects were all brought in by misses */
+  res = simulate_with_concurrent_clients(reader, cache, 16, 4);
+  g_assert_cmpuint(res->n_req, ==, req_cnt_true);
+  g_assert_cmpuint(res->n_req_byte, ==, req_byte_true);
+  g_assert_cmpuint(res->n_miss, >=, n_obj_true);
+  g_assert_cmpuint(res->n_miss, <=, res->n_req);
+  g_assert_cmpuint(res->n_miss_byte, <=, res->n_req_byte);
+  g_assert_cmpuint(res->n_miss_byte, >=, res->occupied_byte);
+  g_assert_cmpuint(res->n_obj, <=, res->n_miss);
+  g_assert_cmpuint(res->cache_size, ==, CACHE_SIZE);
+  g_assert_cmpuint(res->occupied_byte, <=, CACHE_SIZE);
+  g_free(res);
+  cache->cache_free(cache);
+
+  /* a cache smaller than the number of stripes uses fewer stripes */
+  cc_params.cache_size = 4;
+  cache = LRU_init(cc_params, NULL);
+  res = simulate_with_concurrent_clients(reader, cache, 16, 1);
+  g_assert_cmpstr(res->cache_name, ==, "LRU-concurrent-4");
+  g_assert_cmpuint(res->n_req, ==, req_cnt_true);
+  g_assert_cmpuint(res->n_miss, ==, req_cnt_true);
+  g_assert_cmpuint(res->n_obj, ==, 0);
+  g_free(res);
+  cache->cache_free(cache);
+}
+
+/**
+ * the forked caches should have the same result as warming up each cache
+ * @param user_data
+ */
+static void test_simulator_shared_warmup(gconstpointer user_data) {
+  uint64_t req_cnt_true = 91098, req_byte_true = 3180282368;
+  uint64_t miss_cnt_true = 56720, miss_byte_true = 2241255936;
+
+  reader_t *reader = (reader_t *)user_data;
+  common_cache_params_t cc_params = {.cache_size = CACHE_SIZE, .default_ttl = 0};
+  cache_t *cache = LRU_init(cc_params, NULL);
+  g_assert_true(cache != NULL);
+
+  cache_stat_t *res = simulate_with_shared_warmup(reader, cache, 2, NULL, NULL, 0.2, 0, _n_cores(), false);
+  for (int i = 0; i < 2; i++) {
+    g_assert_cmpuint(res[i].n_req, ==, req_cnt_true);
+    g_assert_cmpuint(res[i].n_req_byte, ==, req_byte_true);
+    g_assert_cmpuint(res[i].n_miss, ==, miss_cnt_true);
+    g_assert_cmpuint(res[i].n_miss_byte, ==, miss_byte_true);
+  }
+  g_free(res);
+  cache->cache_free(cache);
+
+  /* S3FIFO forks its small, main and ghost FIFOs, each variant should have
+   * the misses of a cache that is warmed up with the default parameters,
+   * forked to the variant and replays the rest of the trace alone */
+  const char *variant_params[] = {"move-to-main-threshold=2", "move-to-main-threshold=1"};
+  uint64_t variant_miss_cnt_true[] = {41069, 42350};
+  uint64_t variant_miss_byte_true[] = {1513318400, 1569336832};
+  cache = S3FIFO_init(cc_params, NULL);
+  res = simulate_with_shared_warmup(reader, cache, 2, variant_params, NULL, 0.2, 0, _n_cores(), false);
+  cache->cache_free(cache);
+
+  request_t *req = new_request();
+  uint64_t n_warmup_req = (uint64_t)((double)get_num_of_req(reader) * 0.2);
+  for (int i = 0; i < 2; i++) {
+    cache_t *warm_cache = S3FIFO_init(cc_params, NULL);
+    reset_reader(reader);
+    for (uint64_t n = 0; n < n_warmup_req && read_one_req(reader, req) == 0; n++) {
+      warm_cache->get(warm_cache, req);
+    }
+    cache = fork_cache(warm_cache, variant_params[i]);
+    warm_cache->cache_free(warm_cache);
+
+    uint64_t n_req = 0, n_miss = 0, n_miss_byte = 0;
+    while (read_one_req(reader, req) == 0) {
+      n_req += 1;
+      if (!cache->get(cache, req)) {
+        n_miss += 1;
+        n_miss_byte += req->obj_size;
+      }
+    }
+    cache->cache_free(cache);
+
+    g_assert_cmpuint(res[i].n_req, ==, req_cnt_true);
+    g_assert_cmpuint(n_req, ==, req_cnt_true);
+    g_assert_cmpuint(res[i].n_miss, ==, variant_miss_cnt_true[i]);
+    g_assert_cmpuint(n_miss, ==, variant_miss_cnt_true[i]);
+    g_assert_cmpuint(res[i].n_miss_byte, ==, variant_miss_byte_true[i]);
+    g_assert_cmpuint(n_miss_byte, ==, variant_miss_byte_true[i]);
+  }
+  free_request(req);
+  g_free(res);
+
+  /* the first variant has the default parameters, so forking does not change
+   * the cache, and the simulator gets the same misses without sharing */
+  cache_t *caches[1] = {S3FIFO_init(cc_params, NULL)};
+  res = simulate_with_multi_caches(reader, caches, 1, NULL, 0.2, 0, _n_cores(), true, false);
+  g_assert_cmpuint(res[0].n_req, ==, req_cnt_true);
+  g_assert_cmpuint(res[0].n_miss, ==, variant_miss_cnt_true[0]);
+  g_assert_cmpuint(res[0].n_miss_byte, ==, variant_miss_byte_true[0]);
+  g_free(res);
+}
+
+/**
+ * the timing simulation has the same hits and misses as the simulation,
+ * without queueing and bandwidth limit each request costs the fixed latency
+ * of the tier serving it, queueing at the backend makes the tail longer
+ * @param user_data
+ */
+static void test_simulator_timing(gconstpointer user_data) {
+  uint64_t req_cnt_true = 113872, req_byte_true = 4205978112;
+  uint64_t miss_cnt_true = 93151, miss_byte_true = 4035348480;
+
+  reader_t *reader = (reader_t *)user_data;
+  common_cache_params_t cc_params = {.cache_size = STEP_SIZE, .default_ttl = 0};
+  cache_t *cache = LRU_init(cc_params, NULL);
+
+  timing_model_t model = default_timing_model();
+  parse_timing_model_params(&model, "tier-latency=1,tier-bw=0,backend-latency=1000,backend-bw=0,backend-channel=0");
+  timing_stat_t *res = simulate_with_timing(reader, cache, &model);
+  g_assert_cmpuint(res->n_req, ==, req_cnt_true);
+  g_assert_cmpuint(res->n_req_byte, ==, req_byte_true);
+  g_assert_cmpuint(res->n_miss, ==, miss_cnt_true);
+  g_assert_cmpuint(res->n_miss_byte, ==, miss_byte_true);
+  g_assert_cmpuint(res->n_served[0], ==, req_cnt_true - miss_cnt_true);
+  g_assert_cmpuint(res->n_served[1], ==, miss_cnt_true);
+  g_assert_cmpfloat(latency_hist_percentile(&res->tier_latency[0], 99.9), ==, 1);
+  g_assert_cmpfloat(latency_hist_percentile(&res->latency, 50), ==, 1001);
+  g_assert_cmpfloat(res->latency.sum_ns, ==, 1000.0 * (double)(req_cnt_true + miss_cnt_true * 1000));
+  g_assert_cmpfloat(res->queueing_us[1], ==, 0);
+
+  int64_t backend_byte = 0;
+  for (int64_t i = 0; i < res->n_bw_window; i++) {
+    backend_byte += res->backend_byte[i];
+  }
+  g_assert_cmpuint(backend_byte, ==, miss_byte_true);
+  free_timing_stat(res);
+  cache->cache_free(cache);
+
+  /* the backend serves one request at a time */
+  cache = LRU_init(cc_params, NULL);
+  parse_timing_model_params(&model, "backend-bw=200,backend-channel=1");
+  res = simulate_with_timing(reader, cache, &model);
+  g_assert_cmpuint(res->n_miss, ==, miss_cnt_true);
+  g_assert_cmpfloat(res->queueing_us[1], >, 0);
+  g_assert_cmpfloat(latency_hist_percentile(&res->tier_latency[1], 0), >=, 1001);
+  g_assert_cmpfloat(latency_hist_percentile(&res->latency, 99), <=, latency_hist_percentile(&res->latency, 99.9));
+  g_assert_cmpfloat(latency_hist_percentile(&res->latency, 99.9), <=, res->latency.max_ns / 1000.0);
+  free_timing_stat(res);
+  cache->cache_free(cache);
+
+  /* the tier that serves each hit is reported by tiered */
+  cache = tiered_init(cc_params, "tiers=LRU:LRU,tier-size-ratio=0.2:0.8");
+  parse_timing_model_params(&model, "tier-latency=1:100,tier-bw=0:0,tier-channel=0:0,backend-channel=0");
+  model.served_tier = tiered_served_tier;
+  res = simulate_with_timing(reader, cache, &model);
+  tiered_params_t *params = (tiered_params_t *)cache->eviction_params;
+  g_assert_cmpuint(res->n_served[0], ==, params->n_hit[0]);
+  g_assert_cmpuint(res->n_served[1], ==, params->n_hit[1]);
+  g_assert_cmpuint(res->n_served[2], ==, params->n_miss);
+  g_assert_cmpfloat(latency_hist_percentile(&res->tier_latency[1], 50), ==, 101);
+  free_timing_stat(res);
+  cache->cache_free(cache);
+}
+
+/**
+ * the percentiles of the bucketed histogram are within 1% of the exact ones
+ * @param user_data
+ */
+static void test_latency_hist(gconstpointer user_data) {
+  latency_hist_t *hist = g_new0(latency_hist_t, 1);
+  for (int64_t i = 1; i <= 1000000; i++) {
+    latency_hist_record(hist, i * 1000);
+  }
+  double percentiles[] = {0, 50, 90, 99, 99.9, 100};
+  for (int i = 0; i < 6; i++) {
+    double exact = percentiles[i] == 0 ? 1 : percentiles[i] * 10000;
+    g_assert_cmpfloat(fabs(latency_hist_percentile(hist, percentiles[i]) - exact) / exact, <, 0.01);
+  }
+  g_assert_cmpuint(hist->n, ==, 1000000);
+  g_assert_cmpuint(hist->max_ns, ==, 1000000000);
+  g_free(hist);
+}
+
 int main(int argc, char *argv[]) {
   g_test_init(&argc, &argv, NULL);
   reader_t *reader;
@@ -228,6 +636,40 @@ int main(int argc, char *argv[]) {
   reader = setup_vscsi_reader();
   g_test_add_data_func_full("/libCacheSim/simulator_warmup2", reader, test_simulator_with_warmup2, test_teardown);
 
+  reader = setup_plaintxt_reader_num();
+  g_test_add_data_func_full("/libCacheSim/simulator_stack_lru", reader, test_simulator_stack_lru, test_teardown);
+
+  reader = setup_vscsi_reader();
+  g_test_add_data_func_full("/libCacheSim/simulator_stack_lru_size", reader, test_simulator_stack_lru_size,
+                            test_teardown);
+
+  reader = setup_oracleGeneralBin_reader_with_ignored_obj_size();
+  g_test_add_data_func_full("/libCacheSim/simulator_stack_belady", reader, test_simulator_stack_belady, test_teardown);
+
+  reader = setup_vscsi_reader_with_ignored_obj_size();
+  g_test_add_data_func_full("/libCacheSim/simulator_next_access_dist", reader, test_simulator_next_access_dist,
+                            test_teardown);
+
+  reader = setup_oracleGeneralBin_reader_with_ignored_obj_size();
+  g_test_add_data_func_full("/libCacheSim/simulator_offline_min", reader, test_simulator_offline_min, test_teardown);
+
+  reader = setup_vscsi_reader();
+  g_test_add_data_func_full("/libCacheSim/simulator_get_specialized", reader, test_simulator_get_specialized,
+                            test_teardown);
+
+  reader = setup_vscsi_reader();
+  g_test_add_data_func_full("/libCacheSim/simulator_concurrent_clients", reader, test_simulator_concurrent_clients,
+                            test_teardown);
+
+  reader = setup_vscsi_reader();
+  g_test_add_data_func_full("/libCacheSim/simulator_shared_warmup", reader, test_simulator_shared_warmup,
+                            test_teardown);
+
+  reader = setup_vscsi_reader();
+  g_test_add_data_func_full("/libCacheSim/simulator_timing", reader, test_simulator_timing, test_teardown);
+
+  g_test_add_data_func("/libCacheSim/latency_hist", NULL, test_latency_hist);
+
 #ifdef SUPPORT_TTL
   reader = setup_vscsi_reader();
   g_test_add_data_func_full("/libCacheSim/simulator_with_ttl", reader, test_simulator_with_ttl, test_teardown);
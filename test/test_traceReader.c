@@ -143,6 +143,70 @@ void test_twr(gconstpointer user_data) {
   printf("%llu req %llu obj\n", (unsigned long long)n_req, (unsigned long long)n_obj);
 }
 
+/**
+ * write the trace to a request sink in each format, and read it back
+ * @param user_data
+ */
+void test_request_sink(gconstpointer user_data) {
+  reader_t *reader = (reader_t *)user_data;
+  const char *paths[] = {"test_sink.oracleGeneral", "test_sink.lcs", "test_sink.csv", "test_sink.oracleGeneral.zst",
+                         "test_sink.lcs.zst"};
+  trace_type_e formats[] = {ORACLE_GENERAL_TRACE, LCS_TRACE, CSV_TRACE, ORACLE_GENERAL_TRACE, LCS_TRACE};
+  int n_sink = 5;
+#ifndef SUPPORT_ZSTD_TRACE
+  n_sink = 3;
+#endif
+
+  request_t *req = new_request();
+  request_t *req_sink = new_request();
+  for (int i = 0; i < n_sink; i++) {
+    request_sink_t *sink = open_request_sink(paths[i], formats[i]);
+    reset_reader(reader);
+    read_one_req(reader, req);
+    while (req->valid) {
+      request_sink_write(sink, req);
+      read_one_req(reader, req);
+    }
+    g_assert_cmpuint(sink->n_req, ==, trace_length);
+    close_request_sink(sink);
+
+    reader_init_param_t init_params = {.delimiter = ',', .time_field = 1, .obj_id_field = 2, .obj_size_field = 3,
+                                       .obj_id_is_num = true, .has_header = false};
+    reader_t *reader_sink = setup_reader(paths[i], formats[i], &init_params);
+    g_assert_cmpuint(get_num_of_req(reader_sink), ==, trace_length);
+    reset_reader(reader);
+    read_one_req(reader, req);
+    read_one_req(reader_sink, req_sink);
+    while (req->valid) {
+      g_assert_true(req_sink->valid);
+      g_assert_cmpuint(req_sink->obj_id, ==, req->obj_id);
+      g_assert_cmpint(req_sink->obj_size, ==, req->obj_size);
+      g_assert_cmpint(req_sink->clock_time, ==, req->clock_time);
+      read_one_req(reader, req);
+      read_one_req(reader_sink, req_sink);
+    }
+    close_reader(reader_sink);
+    remove(paths[i]);
+  }
+
+  /* the CSV obj_id is unsigned, e.g., a hashed key */
+  request_sink_t *sink = open_request_sink("test_sink_id.csv", CSV_TRACE);
+  req->clock_time = 1;
+  req->obj_id = UINT64_MAX - 1;
+  req->obj_size = 4096;
+  request_sink_write(sink, req);
+  close_request_sink(sink);
+  char line[64] = {0};
+  FILE *file = fopen("test_sink_id.csv", "r");
+  g_assert_true(file != NULL && fgets(line, sizeof(line), file) != NULL);
+  fclose(file);
+  g_assert_cmpstr(line, ==, "1,18446744073709551614,4096\n");
+  remove("test_sink_id.csv");
+
+  free_request(req);
+  free_request(req_sink);
+}
+
 int main(int argc, char *argv[]) {
   g_test_init(&argc, &argv, NULL);
   reader_t *reader;
@@ -182,6 +246,9 @@ int main(int argc, char *argv[]) {
   g_test_add_data_func("/libCacheSim/reader_more1_oracleGeneral", reader, test_reader_more1);
   g_test_add_data_func_full("/libCacheSim/reader_more2_oracleGeneral", reader, test_reader_more2, test_teardown);
 
+  reader = setup_vscsi_reader();
+  g_test_add_data_func_full("/libCacheSim/request_sink", reader, test_request_sink, test_teardown);
+
   // g_test_add_data_func("/libCacheSim/test_twr", NULL, test_twr);
   return g_test_run();
 }
\ No newline at end of file